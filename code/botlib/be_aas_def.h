@@ -139,6 +139,21 @@ typedef struct aas_routingcache_s
 	unsigned short int traveltimes[1];			//travel time for every area (variable sized)
 } aas_routingcache_t;
 
+//maximum number of travel flag sets in a route table file
+#define MAX_ROUTETABLES			8
+
+//precomputed travel times for one set of travel flags, read from the
+//.rtb file next to the .aas; the arrays point into one flat block and
+//are laid out like the routing caches
+typedef struct aas_routetable_s
+{
+	int travelflags;							//the travel flags the tables are for
+	unsigned short int *areatraveltimes;		//per cluster numreachabilityareas rows of numreachabilityareas
+	unsigned char *areareachabilities;
+	unsigned short int *portaltraveltimes;		//numareas rows of numportals
+	unsigned char *portalreachabilities;
+} aas_routetable_t;
+
 //fields for the routing algorithm
 typedef struct aas_routingupdate_s
 {
@@ -258,6 +273,14 @@ typedef struct aas_s
 	//cache list sorted on time
 	aas_routingcache_t *oldestcache;		// start of cache list sorted on time
 	aas_routingcache_t *newestcache;		// end of cache list sorted on time
+	//precomputed route tables, only used while no area is disabled
+	int numroutetables;
+	aas_routetable_t routetables[MAX_ROUTETABLES];
+	int *routetableclusterrows;				//first area table entry of every cluster
+	byte *routetabledata;					//the route table file, on the hunk
+	int routetablesize;
+	int routetablealloc;					//hunk memory allocated for routetabledata
+	int numdisabledareas;					//areas with AREA_DISABLED set
 	//maximum travel time through portal areas
 	int *portalmaxtraveltimes;
 	//areas the reachabilities go through
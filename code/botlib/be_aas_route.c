@@ -82,7 +82,9 @@ int numportalcacheupdates;
 #endif //ROUTING_DEBUG
 
 int routingcachesize;
+int linkedcachesize;		//bytes of the cache in the time sorted list, the only cache that can be freed
 int max_routingcachesize;
+int max_routetablesize;
 
 //===========================================================================
 //
@@ -96,6 +98,8 @@ void AAS_RoutingInfo(void)
 	botimport.Print(PRT_MESSAGE, "%d area cache updates\n", numareacacheupdates);
 	botimport.Print(PRT_MESSAGE, "%d portal cache updates\n", numportalcacheupdates);
 	botimport.Print(PRT_MESSAGE, "%d bytes routing cache\n", routingcachesize);
+	botimport.Print(PRT_MESSAGE, "%d bytes routing cache that can be freed\n", linkedcachesize);
+	botimport.Print(PRT_MESSAGE, "%d bytes route table for %d travel flag sets\n", aasworld.routetablesize, aasworld.numroutetables);
 } //end of the function AAS_RoutingInfo
 #endif //ROUTING_DEBUG
 //===========================================================================
@@ -198,12 +202,15 @@ int AAS_TravelFlagForType(int traveltype)
 //===========================================================================
 void AAS_UnlinkCache(aas_routingcache_t *cache)
 {
+	//if the cache isn't in the list
+	if (!cache->time_prev && aasworld.oldestcache != cache) return;
 	if (cache->time_next) cache->time_next->time_prev = cache->time_prev;
 	else aasworld.newestcache = cache->time_prev;
 	if (cache->time_prev) cache->time_prev->time_next = cache->time_next;
 	else aasworld.oldestcache = cache->time_next;
 	cache->time_next = NULL;
 	cache->time_prev = NULL;
+	linkedcachesize -= cache->size;
 } //end of the function AAS_UnlinkCache
 //===========================================================================
 //
@@ -225,6 +232,7 @@ void AAS_LinkCache(aas_routingcache_t *cache)
 	} //end else
 	cache->time_next = NULL;
 	aasworld.newestcache = cache;
+	linkedcachesize += cache->size;
 } //end of the function AAS_LinkCache
 //===========================================================================
 //
@@ -327,6 +335,9 @@ int AAS_EnableRoutingArea(int areanum, int enable)
 	// if the status of the area changed
 	if ( (flags & AREA_DISABLED) != (aasworld.areasettings[areanum].areaflags & AREA_DISABLED) )
 	{
+		//the route tables are only valid while all areas are enabled
+		if (enable) aasworld.numdisabledareas--;
+		else aasworld.numdisabledareas++;
 		//remove all routing cache involving this area
 		AAS_RemoveRoutingCacheUsingArea( areanum );
 	} //end if
@@ -699,33 +710,26 @@ int AAS_FreeOldestCache(void)
 	int clusterareanum;
 	aas_routingcache_t *cache;
 
-	for (cache = aasworld.oldestcache; cache; cache = cache->time_next) {
-		// never free area cache leading towards a portal
-		if (cache->type == CACHETYPE_AREA && aasworld.areasettings[cache->areanum].cluster < 0) {
-			continue;
-		}
-		break;
+	//area cache leading towards a portal is never in the list
+	cache = aasworld.oldestcache;
+	if (!cache) return qfalse;
+	// unlink the cache
+	if (cache->type == CACHETYPE_AREA) {
+		//number of the area in the cluster
+		clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
+		// unlink from cluster area cache
+		if (cache->prev) cache->prev->next = cache->next;
+		else aasworld.clusterareacache[cache->cluster][clusterareanum] = cache->next;
+		if (cache->next) cache->next->prev = cache->prev;
 	}
-	if (cache) {
-		// unlink the cache
-		if (cache->type == CACHETYPE_AREA) {
-			//number of the area in the cluster
-			clusterareanum = AAS_ClusterAreaNum(cache->cluster, cache->areanum);
-			// unlink from cluster area cache
-			if (cache->prev) cache->prev->next = cache->next;
-			else aasworld.clusterareacache[cache->cluster][clusterareanum] = cache->next;
-			if (cache->next) cache->next->prev = cache->prev;
-		}
-		else {
-			// unlink from portal cache
-			if (cache->prev) cache->prev->next = cache->next;
-			else aasworld.portalcache[cache->areanum] = cache->next;
-			if (cache->next) cache->next->prev = cache->prev;
-		}
-		AAS_FreeRoutingCache(cache);
-		return qtrue;
+	else {
+		// unlink from portal cache
+		if (cache->prev) cache->prev->next = cache->next;
+		else aasworld.portalcache[cache->areanum] = cache->next;
+		if (cache->next) cache->next->prev = cache->prev;
 	}
-	return qfalse;
+	AAS_FreeRoutingCache(cache);
+	return qtrue;
 } //end of the function AAS_FreeOldestCache
 //===========================================================================
 //
@@ -1043,6 +1047,10 @@ aas_routingcache_t *AAS_ReadCache(fileHandle_t fp)
 	botimport.FS_Read((unsigned char *)cache + sizeof(size), size - sizeof(size), fp);
 	cache->reachabilities = (unsigned char *) cache + sizeof(aas_routingcache_t) - sizeof(unsigned short) +
 		(size - sizeof(aas_routingcache_t) + sizeof(unsigned short)) / 3 * 2;
+	//the list pointers were written as well
+	cache->time_prev = NULL;
+	cache->time_next = NULL;
+	routingcachesize += size;
 	return cache;
 } //end of the function AAS_ReadCache
 //===========================================================================
@@ -1107,6 +1115,7 @@ int AAS_ReadRouteCache(void)
 		if (aasworld.portalcache[cache->areanum])
 			aasworld.portalcache[cache->areanum]->prev = cache;
 		aasworld.portalcache[cache->areanum] = cache;
+		AAS_LinkCache(cache);
 	} //end for
 	//read all the cluster area cache
 	for (i = 0; i < routecacheheader.numareacache; i++)
@@ -1118,6 +1127,7 @@ int AAS_ReadRouteCache(void)
 		if (aasworld.clusterareacache[cache->cluster][clusterareanum])
 			aasworld.clusterareacache[cache->cluster][clusterareanum]->prev = cache;
 		aasworld.clusterareacache[cache->cluster][clusterareanum] = cache;
+		if (aasworld.areasettings[cache->areanum].cluster > 0) AAS_LinkCache(cache);
 	} //end for
 	// read the visareas
 	/*
@@ -1218,6 +1228,8 @@ void AAS_InitReachabilityAreas(void)
 //===========================================================================
 void AAS_InitRouting(void)
 {
+	int i;
+
 	AAS_InitTravelFlagFromType();
 	//
 	AAS_InitAreaContentsTravelFlags();
@@ -1235,6 +1247,12 @@ void AAS_InitRouting(void)
 	AAS_InitPortalMaxTravelTimes();
 	//get the areas reachabilities go through
 	AAS_InitReachabilityAreas();
+	//the route tables can only be used while no area is disabled
+	aasworld.numdisabledareas = 0;
+	for (i = 0; i < aasworld.numareas; i++)
+	{
+		if (aasworld.areasettings[i].areaflags & AREA_DISABLED) aasworld.numdisabledareas++;
+	} //end for
 	//
 #ifdef ROUTING_DEBUG
 	numareacacheupdates = 0;
@@ -1242,9 +1260,13 @@ void AAS_InitRouting(void)
 #endif //ROUTING_DEBUG
 	//
 	routingcachesize = 0;
+	linkedcachesize = 0;
 	max_routingcachesize = 1024 * (int) LibVarValue("max_routingcache", "4096");
+	max_routetablesize = 1024 * (int) LibVarValue("max_routetable", "32768");
 	// read any routing cache if available
 	AAS_ReadRouteCache();
+	// read the precomputed route tables if available
+	AAS_ReadRouteTable();
 } //end of the function AAS_InitRouting
 //===========================================================================
 //
@@ -1258,6 +1280,8 @@ void AAS_FreeRoutingCaches(void)
 	AAS_FreeAllClusterAreaCache();
 	// free all the existing portal cache
 	AAS_FreeAllPortalCache();
+	// free the route tables
+	AAS_FreeRouteTable();
 	// free cached travel times within areas
 	if (aasworld.areatraveltimes) FreeMemory(aasworld.areatraveltimes);
 	aasworld.areatraveltimes = NULL;
@@ -1430,17 +1454,69 @@ aas_routingcache_t *AAS_GetAreaRoutingCache(int clusternum, int areanum, int tra
 		aasworld.clusterareacache[clusternum][clusterareanum] = cache;
 		AAS_UpdateAreaRoutingCache(cache);
 	} //end if
-	else
-	{
-		AAS_UnlinkCache(cache);
-	} //end else
 	//the cache has been accessed
 	cache->time = AAS_RoutingTime();
 	cache->type = CACHETYPE_AREA;
-	AAS_LinkCache(cache);
+	//cache leading towards a portal is never freed so it stays out of the list
+	if (aasworld.areasettings[areanum].cluster > 0)
+	{
+		AAS_UnlinkCache(cache);
+		AAS_LinkCache(cache);
+	} //end if
 	return cache;
 } //end of the function AAS_GetAreaRoutingCache
 //===========================================================================
+// returns the route table for the travel flags if there is one that can
+// be used
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static ID_INLINE aas_routetable_t *AAS_RouteTable(int travelflags)
+{
+	int i;
+
+	//the tables were built with all areas enabled
+	if (aasworld.numdisabledareas) return NULL;
+	for (i = 0; i < aasworld.numroutetables; i++)
+	{
+		if (aasworld.routetables[i].travelflags == travelflags) return &aasworld.routetables[i];
+	} //end for
+	return NULL;
+} //end of the function AAS_RouteTable
+//===========================================================================
+// returns the travel times and reachabilities of all reachability areas
+// in the cluster towards the given area, from the route table when
+// possible and otherwise from the routing cache
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static unsigned short int *AAS_AreaRoutingTimes(int clusternum, int areanum, int travelflags, unsigned char **reachabilities)
+{
+	int clusterareanum, numreachabilityareas, entry;
+	aas_routetable_t *table;
+	aas_routingcache_t *cache;
+
+	table = AAS_RouteTable(travelflags);
+	if (table)
+	{
+		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+		numreachabilityareas = aasworld.clusters[clusternum].numreachabilityareas;
+		if (clusterareanum < numreachabilityareas)
+		{
+			entry = aasworld.routetableclusterrows[clusternum] + clusterareanum * numreachabilityareas;
+			*reachabilities = table->areareachabilities + entry;
+			return table->areatraveltimes + entry;
+		} //end if
+	} //end if
+	cache = AAS_GetAreaRoutingCache(clusternum, areanum, travelflags);
+	*reachabilities = cache->reachabilities;
+	return cache->traveltimes;
+} //end of the function AAS_AreaRoutingTimes
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1452,7 +1528,8 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 	unsigned short int t;
 	aas_portal_t *portal;
 	aas_cluster_t *cluster;
-	aas_routingcache_t *cache;
+	unsigned short int *traveltimes;
+	unsigned char *reachabilities;
 	aas_routingupdate_t *updateliststart, *updatelistend, *curupdate, *nextupdate;
 
 #ifdef ROUTING_DEBUG
@@ -1489,8 +1566,8 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 		//
 		cluster = &aasworld.clusters[curupdate->cluster];
 		//
-		cache = AAS_GetAreaRoutingCache(curupdate->cluster,
-								curupdate->areanum, portalcache->travelflags);
+		traveltimes = AAS_AreaRoutingTimes(curupdate->cluster,
+								curupdate->areanum, portalcache->travelflags, &reachabilities);
 		//take all portals of the cluster
 		for (i = 0; i < cluster->numportals; i++)
 		{
@@ -1502,7 +1579,7 @@ void AAS_UpdatePortalRoutingCache(aas_routingcache_t *portalcache)
 			clusterareanum = AAS_ClusterAreaNum(curupdate->cluster, portal->areanum);
 			if (clusterareanum >= cluster->numreachabilityareas) continue;
 			//
-			t = cache->traveltimes[clusterareanum];
+			t = traveltimes[clusterareanum];
 			if (!t) continue;
 			t += curupdate->tmptraveltime;
 			//
@@ -1581,6 +1658,30 @@ aas_routingcache_t *AAS_GetPortalRoutingCache(int clusternum, int areanum, int t
 	return cache;
 } //end of the function AAS_GetPortalRoutingCache
 //===========================================================================
+// returns the travel times and reachabilities of all portals towards
+// the given area, from the route table when possible and otherwise from
+// the routing cache
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static unsigned short int *AAS_PortalRoutingTimes(int clusternum, int areanum, int travelflags, unsigned char **reachabilities)
+{
+	aas_routetable_t *table;
+	aas_routingcache_t *cache;
+
+	table = AAS_RouteTable(travelflags);
+	if (table)
+	{
+		*reachabilities = table->portalreachabilities + areanum * aasworld.numportals;
+		return table->portaltraveltimes + areanum * aasworld.numportals;
+	} //end if
+	cache = AAS_GetPortalRoutingCache(clusternum, areanum, travelflags);
+	*reachabilities = cache->reachabilities;
+	return cache->traveltimes;
+} //end of the function AAS_PortalRoutingTimes
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -1590,9 +1691,10 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 {
 	int clusternum, goalclusternum, portalnum, i, clusterareanum, bestreachnum;
 	unsigned short int t, besttime;
+	unsigned short int *areatraveltimes, *portaltraveltimes;
+	unsigned char *areareachabilities, *portalreachabilities;
 	aas_portal_t *portal;
 	aas_cluster_t *cluster;
-	aas_routingcache_t *areacache, *portalcache;
 	aas_reachability_t *reach;
 
 	if (!aasworld.initialized) return qfalse;
@@ -1624,8 +1726,10 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	{
 		return qfalse;
 	} //end if
-	// make sure the routing cache doesn't grow to large
-	while(AvailableMemory() < 1 * 1024 * 1024) {
+	// keep the routing cache in the time sorted list within max_routingcache,
+	// the cache leading towards portals is never freed so it isn't counted,
+	// and never let it use up the last of the botlib memory
+	while(linkedcachesize > max_routingcachesize || AvailableMemory() < 1 * 1024 * 1024) {
 		if (!AAS_FreeOldestCache()) break;
 	}
 	//
@@ -1671,7 +1775,7 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	if (clusternum > 0 && goalclusternum > 0 && clusternum == goalclusternum)
 	{
 		//
-		areacache = AAS_GetAreaRoutingCache(clusternum, goalareanum, travelflags);
+		areatraveltimes = AAS_AreaRoutingTimes(clusternum, goalareanum, travelflags, &areareachabilities);
 		//the number of the area in the cluster
 		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
 		//the cluster the area is in
@@ -1679,16 +1783,16 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		//if the area is NOT a reachability area
 		if (clusterareanum >= cluster->numreachabilityareas) return 0;
 		//if it is possible to travel to the goal area through this cluster
-		if (areacache->traveltimes[clusterareanum] != 0)
+		if (areatraveltimes[clusterareanum] != 0)
 		{
 			*reachnum = aasworld.areasettings[areanum].firstreachablearea +
-							areacache->reachabilities[clusterareanum];
+							areareachabilities[clusterareanum];
 			if (!origin) {
-				*traveltime = areacache->traveltimes[clusterareanum];
+				*traveltime = areatraveltimes[clusterareanum];
 				return qtrue;
 			}
 			reach = &aasworld.reachability[*reachnum];
-			*traveltime = areacache->traveltimes[clusterareanum] +
+			*traveltime = areatraveltimes[clusterareanum] +
 							AAS_AreaTravelTime(areanum, origin, reach->start);
 			//
 			return qtrue;
@@ -1705,13 +1809,13 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		goalclusternum = portal->frontcluster;
 	} //end if
 	//get the portal routing cache
-	portalcache = AAS_GetPortalRoutingCache(goalclusternum, goalareanum, travelflags);
+	portaltraveltimes = AAS_PortalRoutingTimes(goalclusternum, goalareanum, travelflags, &portalreachabilities);
 	//if the area is a cluster portal, read directly from the portal cache
 	if (clusternum < 0)
 	{
-		*traveltime = portalcache->traveltimes[-clusternum];
+		*traveltime = portaltraveltimes[-clusternum];
 		*reachnum = aasworld.areasettings[areanum].firstreachablearea +
-						portalcache->reachabilities[-clusternum];
+						portalreachabilities[-clusternum];
 		return qtrue;
 	} //end if
 	//
@@ -1724,20 +1828,20 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 	{
 		portalnum = aasworld.portalindex[cluster->firstportal + i];
 		//if the goal area isn't reachable from the portal
-		if (!portalcache->traveltimes[portalnum]) continue;
+		if (!portaltraveltimes[portalnum]) continue;
 		//
 		portal = &aasworld.portals[portalnum];
 		//get the cache of the portal area
-		areacache = AAS_GetAreaRoutingCache(clusternum, portal->areanum, travelflags);
+		areatraveltimes = AAS_AreaRoutingTimes(clusternum, portal->areanum, travelflags, &areareachabilities);
 		//current area inside the current cluster
 		clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
 		//if the area is NOT a reachability area
 		if (clusterareanum >= cluster->numreachabilityareas) continue;
 		//if the portal is NOT reachable from this area
-		if (!areacache->traveltimes[clusterareanum]) continue;
+		if (!areatraveltimes[clusterareanum]) continue;
 		//total travel time is the travel time the portal area is from
 		//the goal area plus the travel time towards the portal area
-		t = portalcache->traveltimes[portalnum] + areacache->traveltimes[clusterareanum];
+		t = portaltraveltimes[portalnum] + areatraveltimes[clusterareanum];
 		//FIXME: add the exact travel time through the actual portal area
 		//NOTE: for now we just add the largest travel time through the portal area
 		//		because we can't directly calculate the exact travel time
@@ -1748,7 +1852,7 @@ int AAS_AreaRouteToGoalArea(int areanum, vec3_t origin, int goalareanum, int tra
 		if (origin)
 		{
 			*reachnum = aasworld.areasettings[areanum].firstreachablearea +
-							areacache->reachabilities[clusterareanum];
+							areareachabilities[clusterareanum];
 			reach = aasworld.reachability + *reachnum;
 			t += AAS_AreaTravelTime(areanum, origin, reach->start);
 		} //end if
@@ -1799,6 +1903,409 @@ int AAS_AreaReachabilityToGoalArea(int areanum, vec3_t origin, int goalareanum,
 	return 0;
 } //end of the function AAS_AreaReachabilityToGoalArea
 //===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+
+//the route table header
+//this header is followed by numtables tables, one for each travel flag set,
+//each with the area travel times and reachabilities of all clusters and
+//then the portal travel times and reachabilities towards every area, all
+//padded to four bytes. Nothing in the file needs to be fixed up after
+//loading, the tables are used right where they were read
+typedef struct routetableheader_s
+{
+	int ident;
+	int version;
+	int numareas;
+	int numclusters;
+	int numportals;
+	int areacrc;
+	int clustercrc;
+	int reachabilitycrc;
+	int numtables;
+	int travelflags[MAX_ROUTETABLES];
+} routetableheader_t;
+
+#define RTID						(('L'<<24)+('B'<<16)+('T'<<8)+'R')
+#define RTVERSION					1
+
+#define ROUTETABLE_ALIGN(x)			(((x) + 3) & ~3)
+
+//the travel flag sets the bots in the game module route with
+static int routetabletravelflags[] =
+{
+	TFL_DEFAULT,
+	TFL_DEFAULT|TFL_DONOTENTER,
+	TFL_DEFAULT|TFL_ROCKETJUMP,
+	TFL_DEFAULT|TFL_ROCKETJUMP|TFL_DONOTENTER
+};
+
+//===========================================================================
+// returns the size of the tables for one travel flag set and sets the
+// first area table entry of every cluster
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static int AAS_RouteTableSize(int *numareaentries)
+{
+	int i, numreachabilityareas, numportalentries;
+
+	if (!aasworld.routetableclusterrows)
+	{
+		aasworld.routetableclusterrows = (int *) GetMemory(aasworld.numclusters * sizeof(int));
+	} //end if
+	*numareaentries = 0;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		aasworld.routetableclusterrows[i] = *numareaentries;
+		numreachabilityareas = aasworld.clusters[i].numreachabilityareas;
+		*numareaentries += numreachabilityareas * numreachabilityareas;
+	} //end for
+	numportalentries = aasworld.numareas * aasworld.numportals;
+	return ROUTETABLE_ALIGN(*numareaentries * sizeof(unsigned short int)) +
+			ROUTETABLE_ALIGN(*numareaentries * sizeof(unsigned char)) +
+			ROUTETABLE_ALIGN(numportalentries * sizeof(unsigned short int)) +
+			ROUTETABLE_ALIGN(numportalentries * sizeof(unsigned char));
+} //end of the function AAS_RouteTableSize
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_SetRouteTable(aas_routetable_t *table, int travelflags, byte *data, int numareaentries)
+{
+	int numportalentries;
+
+	numportalentries = aasworld.numareas * aasworld.numportals;
+	table->travelflags = travelflags;
+	table->areatraveltimes = (unsigned short int *) data;
+	data += ROUTETABLE_ALIGN(numareaentries * sizeof(unsigned short int));
+	table->areareachabilities = (unsigned char *) data;
+	data += ROUTETABLE_ALIGN(numareaentries * sizeof(unsigned char));
+	table->portaltraveltimes = (unsigned short int *) data;
+	data += ROUTETABLE_ALIGN(numportalentries * sizeof(unsigned short int));
+	table->portalreachabilities = (unsigned char *) data;
+} //end of the function AAS_SetRouteTable
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_FreeRouteTable(void)
+{
+	//the file is on the hunk and goes away with the map
+	aasworld.routetabledata = NULL;
+	aasworld.routetablesize = 0;
+	aasworld.routetablealloc = 0;
+	if (aasworld.routetableclusterrows) FreeMemory(aasworld.routetableclusterrows);
+	aasworld.routetableclusterrows = NULL;
+	aasworld.numroutetables = 0;
+} //end of the function AAS_FreeRouteTable
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_RouteTableHeader(routetableheader_t *header, int numtables)
+{
+	Com_Memset(header, 0, sizeof(routetableheader_t));
+	header->ident = RTID;
+	header->version = RTVERSION;
+	header->numareas = aasworld.numareas;
+	header->numclusters = aasworld.numclusters;
+	header->numportals = aasworld.numportals;
+	header->areacrc = CRC_ProcessString( (unsigned char *)aasworld.areas, sizeof(aas_area_t) * aasworld.numareas );
+	header->clustercrc = CRC_ProcessString( (unsigned char *)aasworld.clusters, sizeof(aas_cluster_t) * aasworld.numclusters );
+	header->reachabilitycrc = CRC_ProcessString( (unsigned char *)aasworld.reachability, sizeof(aas_reachability_t) * aasworld.reachabilitysize );
+	header->numtables = numtables;
+} //end of the function AAS_RouteTableHeader
+//===========================================================================
+// fills the area table rows for the area in the cluster
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FillRouteTableAreaRow(aas_routetable_t *table, aas_routingcache_t *cache, int clusternum, int areanum)
+{
+	int clusterareanum, numreachabilityareas, entry;
+
+	numreachabilityareas = aasworld.clusters[clusternum].numreachabilityareas;
+	clusterareanum = AAS_ClusterAreaNum(clusternum, areanum);
+	if (clusterareanum >= numreachabilityareas) return;
+	//
+	Com_Memset(cache->traveltimes, 0, numreachabilityareas * sizeof(unsigned short int));
+	Com_Memset(cache->reachabilities, 0, numreachabilityareas * sizeof(unsigned char));
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = table->travelflags;
+	AAS_UpdateAreaRoutingCache(cache);
+	//
+	entry = aasworld.routetableclusterrows[clusternum] + clusterareanum * numreachabilityareas;
+	Com_Memcpy(table->areatraveltimes + entry, cache->traveltimes, numreachabilityareas * sizeof(unsigned short int));
+	Com_Memcpy(table->areareachabilities + entry, cache->reachabilities, numreachabilityareas * sizeof(unsigned char));
+} //end of the function AAS_FillRouteTableAreaRow
+//===========================================================================
+// fills the portal table row for the goal area
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+static void AAS_FillRouteTablePortalRow(aas_routetable_t *table, aas_routingcache_t *cache, int areanum)
+{
+	int clusternum;
+
+	clusternum = aasworld.areasettings[areanum].cluster;
+	//just like AAS_AreaRouteToGoalArea assume a portal is part of its front cluster
+	if (clusternum < 0) clusternum = aasworld.portals[-clusternum].frontcluster;
+	//
+	Com_Memset(cache->traveltimes, 0, aasworld.numportals * sizeof(unsigned short int));
+	Com_Memset(cache->reachabilities, 0, aasworld.numportals * sizeof(unsigned char));
+	cache->cluster = clusternum;
+	cache->areanum = areanum;
+	VectorCopy(aasworld.areas[areanum].center, cache->origin);
+	cache->starttraveltime = 1;
+	cache->travelflags = table->travelflags;
+	AAS_UpdatePortalRoutingCache(cache);
+	//
+	Com_Memcpy(table->portaltraveltimes + areanum * aasworld.numportals, cache->traveltimes, aasworld.numportals * sizeof(unsigned short int));
+	Com_Memcpy(table->portalreachabilities + areanum * aasworld.numportals, cache->reachabilities, aasworld.numportals * sizeof(unsigned char));
+} //end of the function AAS_FillRouteTablePortalRow
+//===========================================================================
+// calculates the complete area and portal routing for the common travel
+// flag sets and writes it to maps/<mapname>.rtb, this takes a while on
+// large maps and is meant to be done once for every map
+//
+// this runs after the server has set the hunk mark, so the tables are
+// calculated in zone memory one at a time, they're used right away only
+// if the loaded route table file left room for them on the hunk
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void AAS_WriteRouteTable(void)
+{
+	int i, j, areanum, clusternum, numtables, numareaentries, tablesize, length, numtraveltimes;
+	int numloadedtables, replace;
+	byte *data;
+	fileHandle_t fp;
+	char filename[MAX_QPATH];
+	routetableheader_t header;
+	aas_routetable_t *table, loadedtable;
+	aas_routingcache_t *cache;
+	aas_portal_t *portal;
+
+	if (!aasworld.initialized)
+	{
+		botimport.Print(PRT_ERROR, "AAS_WriteRouteTable: AAS not initialized\n");
+		return;
+	} //end if
+	if (aasworld.numdisabledareas)
+	{
+		botimport.Print(PRT_ERROR, "AAS_WriteRouteTable: can't write the route table with %d disabled areas\n", aasworld.numdisabledareas);
+		return;
+	} //end if
+	tablesize = AAS_RouteTableSize(&numareaentries);
+	numtables = ARRAY_LEN(routetabletravelflags);
+	length = sizeof(routetableheader_t) + numtables * tablesize;
+	if (length > max_routetablesize)
+	{
+		botimport.Print(PRT_ERROR, "AAS_WriteRouteTable: the route tables need %d KB, more than max_routetable\n", length / 1024);
+		return;
+	} //end if
+	//one routing cache and one table to calculate the rows with
+	numtraveltimes = aasworld.numportals;
+	for (i = 0; i < aasworld.numclusters; i++)
+	{
+		if (aasworld.clusters[i].numreachabilityareas > numtraveltimes)
+			numtraveltimes = aasworld.clusters[i].numreachabilityareas;
+	} //end for
+	cache = AAS_AllocRoutingCache(numtraveltimes);
+	data = (byte *) GetMemory(tablesize);
+	//
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rtb", aasworld.mapname);
+	botimport.FS_FOpenFile( filename, &fp, FS_WRITE );
+	if (!fp)
+	{
+		FreeMemory(data);
+		routingcachesize -= cache->size;
+		FreeMemory(cache);
+		AAS_Error("Unable to open file: %s\n", filename);
+		return;
+	} //end if
+	AAS_RouteTableHeader(&header, numtables);
+	for (i = 0; i < numtables; i++)
+	{
+		header.travelflags[i] = routetabletravelflags[i];
+	} //end for
+	botimport.FS_Write(&header, sizeof(routetableheader_t), fp);
+	//the new tables replace the loaded ones if they fit in their memory
+	replace = aasworld.routetabledata && aasworld.routetablealloc >= length;
+	//the table being calculated is the only one used while calculating
+	numloadedtables = aasworld.numroutetables;
+	loadedtable = aasworld.routetables[0];
+	table = &aasworld.routetables[0];
+	for (i = 0; i < numtables; i++)
+	{
+		botimport.Print(PRT_MESSAGE, "calculating route table %d of %d\n", i + 1, numtables);
+		Com_Memset(data, 0, tablesize);
+		AAS_SetRouteTable(table, routetabletravelflags[i], data, numareaentries);
+		//the area tables first
+		aasworld.numroutetables = 0;
+		for (areanum = 1; areanum < aasworld.numareas; areanum++)
+		{
+			clusternum = aasworld.areasettings[areanum].cluster;
+			if (clusternum > 0)
+			{
+				AAS_FillRouteTableAreaRow(table, cache, clusternum, areanum);
+			} //end if
+			else
+			{
+				//portals have rows in both clusters
+				portal = &aasworld.portals[-clusternum];
+				AAS_FillRouteTableAreaRow(table, cache, portal->frontcluster, areanum);
+				AAS_FillRouteTableAreaRow(table, cache, portal->backcluster, areanum);
+			} //end else
+		} //end for
+		//the portal routing is calculated from the area tables
+		aasworld.numroutetables = 1;
+		for (j = 1; j < aasworld.numareas; j++)
+		{
+			if (!aasworld.areasettings[j].numreachableareas) continue;
+			AAS_FillRouteTablePortalRow(table, cache, j);
+		} //end for
+		botimport.FS_Write(data, tablesize, fp);
+		if (replace)
+		{
+			Com_Memcpy(aasworld.routetabledata + sizeof(routetableheader_t) + i * tablesize, data, tablesize);
+		} //end if
+	} //end for
+	botimport.FS_FCloseFile(fp);
+	FreeMemory(data);
+	routingcachesize -= cache->size;
+	FreeMemory(cache);
+	//
+	botimport.Print(PRT_MESSAGE, "route table written to %s\n", filename);
+	botimport.Print(PRT_MESSAGE, "written %d bytes of route tables\n", length);
+	if (replace)
+	{
+		//use the tables right away
+		Com_Memcpy(aasworld.routetabledata, &header, sizeof(routetableheader_t));
+		for (i = 0; i < numtables; i++)
+		{
+			AAS_SetRouteTable(&aasworld.routetables[i], routetabletravelflags[i],
+					aasworld.routetabledata + sizeof(routetableheader_t) + i * tablesize, numareaentries);
+		} //end for
+		aasworld.numroutetables = numtables;
+		aasworld.routetablesize = length;
+	} //end if
+	else
+	{
+		//the hunk can't grow any more, the tables are loaded with the next map
+		aasworld.routetables[0] = loadedtable;
+		aasworld.numroutetables = numloadedtables;
+		botimport.Print(PRT_MESSAGE, "the route tables will be used from the next map load on\n");
+	} //end else
+} //end of the function AAS_WriteRouteTable
+//===========================================================================
+// reads maps/<mapname>.rtb in one piece if it matches the loaded AAS data
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+int AAS_ReadRouteTable(void)
+{
+	int i, length, alloc, numtables, numareaentries, tablesize;
+	byte *data;
+	fileHandle_t fp;
+	char filename[MAX_QPATH];
+	routetableheader_t header, expected;
+
+	AAS_FreeRouteTable();
+	Com_sprintf(filename, MAX_QPATH, "maps/%s.rtb", aasworld.mapname);
+	length = botimport.FS_FOpenFile( filename, &fp, FS_READ );
+	if (!fp)
+	{
+		return qfalse;
+	} //end if
+	if (length < (int) sizeof(routetableheader_t))
+	{
+		botimport.Print(PRT_WARNING, "%s is truncated\n", filename);
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	botimport.FS_Read(&header, sizeof(routetableheader_t), fp);
+	if (header.ident != RTID || header.version != RTVERSION)
+	{
+		botimport.Print(PRT_WARNING, "%s is not a version %d route table\n", filename, RTVERSION);
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	AAS_RouteTableHeader(&expected, header.numtables);
+	if (header.numareas != expected.numareas ||
+		header.numclusters != expected.numclusters ||
+		header.numportals != expected.numportals ||
+		header.areacrc != expected.areacrc ||
+		header.clustercrc != expected.clustercrc ||
+		header.reachabilitycrc != expected.reachabilitycrc)
+	{
+		botimport.Print(PRT_WARNING, "%s doesn't match the AAS file, ignored\n", filename);
+		botimport.FS_FCloseFile(fp);
+		return qfalse;
+	} //end if
+	tablesize = AAS_RouteTableSize(&numareaentries);
+	if (header.numtables < 0 || header.numtables > MAX_ROUTETABLES ||
+		length != (int) sizeof(routetableheader_t) + header.numtables * tablesize)
+	{
+		botimport.Print(PRT_WARNING, "%s has the wrong size\n", filename);
+		botimport.FS_FCloseFile(fp);
+		AAS_FreeRouteTable();
+		return qfalse;
+	} //end if
+	//keep the whole file as it is on the hunk, where it doesn't count
+	//towards the memory the routing cache is limited by, with room for
+	//the tables AAS_WriteRouteTable would write
+	numtables = header.numtables;
+	if (numtables < ARRAY_LEN(routetabletravelflags)) numtables = ARRAY_LEN(routetabletravelflags);
+	alloc = sizeof(routetableheader_t) + numtables * tablesize;
+	if (alloc > max_routetablesize)
+	{
+		botimport.Print(PRT_MESSAGE, "%s needs %d KB, more than max_routetable, using the routing cache\n", filename, alloc / 1024);
+		botimport.FS_FCloseFile(fp);
+		AAS_FreeRouteTable();
+		return qfalse;
+	} //end if
+	data = (byte *) GetHunkMemory(alloc);
+	aasworld.routetabledata = data;
+	aasworld.routetablealloc = alloc;
+	Com_Memcpy(data, &header, sizeof(routetableheader_t));
+	botimport.FS_Read(data + sizeof(routetableheader_t), length - sizeof(routetableheader_t), fp);
+	botimport.FS_FCloseFile(fp);
+	//
+	for (i = 0; i < header.numtables; i++)
+	{
+		AAS_SetRouteTable(&aasworld.routetables[i], header.travelflags[i],
+				data + sizeof(routetableheader_t) + i * tablesize, numareaentries);
+	} //end for
+	aasworld.numroutetables = header.numtables;
+	aasworld.routetablesize = length;
+	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
+	return qtrue;
+} //end of the function AAS_ReadRouteTable
+//===========================================================================
 // predict the route and stop on one of the stop events
 //
 // Parameter:			-
@@ -39,6 +39,10 @@ unsigned short int AAS_AreaTravelTime(int areanum, vec3_t start, vec3_t end);
 //
 void AAS_CreateAllRoutingCache(void);
 void AAS_WriteRouteCache(void);
+//precomputed route tables
+void AAS_WriteRouteTable(void);
+int AAS_ReadRouteTable(void);
+void AAS_FreeRouteTable(void);
 //
 void AAS_RoutingInfo(void);
 #endif //AASINTERN
@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "l_utils.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_compiled.h"
 #include "l_struct.h"
 #include "l_libvar.h"
 #include "aasfile.h"
@@ -71,6 +72,8 @@ typedef struct bot_character_s
 {
 	char filename[MAX_QPATH];
 	float skill;
+	int refcount;					//number of bots using the character
+	int keep;						//botlib holds a reference until BotShutdownCharacters
 	bot_characteristic_t c[1];		//variable sized
 } bot_character_t;
 
@@ -168,9 +171,56 @@ void BotFreeCharacter2(int handle)
 //========================================================================
 void BotFreeCharacter(int handle)
 {
-	if (!LibVarGetValue("bot_reloadcharacters")) return;
+	bot_character_t *ch;
+
+	ch = BotCharacterFromHandle(handle);
+	if (!ch) return;
+	//a character is freed when the last bot using it is gone
+	if (--ch->refcount > 0) return;
 	BotFreeCharacter2(handle);
 } //end of the function BotFreeCharacter
+//========================================================================
+// keeps a character loaded for the rest of the botlib session, used for
+// the default character and the skill files bots are interpolated from
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//========================================================================
+void BotKeepCharacter(int handle)
+{
+	bot_character_t *ch;
+
+	ch = BotCharacterFromHandle(handle);
+	if (!ch || ch->keep) return;
+	ch->keep = qtrue;
+	ch->refcount++;
+} //end of the function BotKeepCharacter
+//========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//========================================================================
+int BotFreeCharacterHandle(void)
+{
+	int handle;
+
+	for (handle = 1; handle <= MAX_CLIENTS; handle++)
+	{
+		if (!botcharacters[handle]) return handle;
+	} //end for
+	//make room by dropping a kept character no bot uses anymore
+	for (handle = 1; handle <= MAX_CLIENTS; handle++)
+	{
+		if (botcharacters[handle]->keep && botcharacters[handle]->refcount == 1)
+		{
+			BotFreeCharacter2(handle);
+			return handle;
+		} //end if
+	} //end for
+	return 0;
+} //end of the function BotFreeCharacterHandle
 //===========================================================================
 //
 // Parameter:			-
@@ -209,16 +259,105 @@ void BotDefaultCharacteristics(bot_character_t *ch, bot_character_t *defaultch)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledCharacter(compiledfile_t *cf, bot_character_t *ch)
+{
+	int i;
+
+	CF_WriteFloat(cf, ch->skill);
+	for (i = 0; i <= MAX_CHARACTERISTICS; i++)
+	{
+		if (!ch->c[i].type) continue;
+		CF_WriteInt(cf, i);
+		CF_WriteInt(cf, ch->c[i].type);
+		switch(ch->c[i].type)
+		{
+			case CT_INTEGER: CF_WriteInt(cf, ch->c[i].value.integer); break;
+			case CT_FLOAT: CF_WriteFloat(cf, ch->c[i].value._float); break;
+			case CT_STRING: CF_WriteString(cf, ch->c[i].value.string); break;
+		} //end switch
+	} //end for
+	CF_WriteInt(cf, -1);
+} //end of the function BotWriteCompiledCharacter
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+bot_character_t *BotReadCompiledCharacter(compiledfile_t *cf, char *charfile)
+{
+	int index;
+	char *string;
+	bot_character_t *ch;
+
+	ch = (bot_character_t *) GetClearedMemory(sizeof(bot_character_t) +
+					MAX_CHARACTERISTICS * sizeof(bot_characteristic_t));
+	strcpy(ch->filename, charfile);
+	ch->skill = CF_ReadFloat(cf);
+	while(!cf->error)
+	{
+		index = CF_ReadInt(cf);
+		if (index == -1) return ch;
+		if (index < 0 || index > MAX_CHARACTERISTICS || ch->c[index].type) break;
+		ch->c[index].type = CF_ReadInt(cf);
+		switch(ch->c[index].type)
+		{
+			case CT_INTEGER:
+			{
+				ch->c[index].value.integer = CF_ReadInt(cf);
+				break;
+			} //end case
+			case CT_FLOAT:
+			{
+				ch->c[index].value._float = CF_ReadFloat(cf);
+				break;
+			} //end case
+			case CT_STRING:
+			{
+				string = CF_ReadString(cf);
+				if (!string) string = "";
+				ch->c[index].value.string = GetMemory(strlen(string)+1);
+				strcpy(ch->c[index].value.string, string);
+				break;
+			} //end case
+			default:
+			{
+				ch->c[index].type = 0;
+				cf->error = qtrue;
+				break;
+			} //end default
+		} //end switch
+	} //end while
+	BotFreeCharacterStrings(ch);
+	FreeMemory(ch);
+	return NULL;
+} //end of the function BotReadCompiledCharacter
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 bot_character_t *BotLoadCharacterFromFile(char *charfile, int skill)
 {
 	int indent, index, foundcharacter;
+	char skillname[16];
 	bot_character_t *ch;
 	source_t *source;
 	token_t token;
+	compiledfile_t *cf;
 
 	foundcharacter = qfalse;
 	//a bot character is parsed in two phases
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	Com_sprintf(skillname, sizeof(skillname), "%d", skill);
+	cf = LoadCompiledFile(charfile, skillname, CF_CHARACTER);
+	if (cf)
+	{
+		ch = BotReadCompiledCharacter(cf, charfile);
+		FreeCompiledFile(cf);
+		if (ch) return ch;
+	} //end if
 	source = LoadSourceFile(charfile);
 	if (!source)
 	{
@@ -343,6 +482,17 @@ bot_character_t *BotLoadCharacterFromFile(char *charfile, int skill)
 			return NULL;
 		} //end else
 	} //end while
+	//store the compiled character, the files read up to the skill are all it depends on
+	if (foundcharacter)
+	{
+		cf = CreateCompiledFile(source, skillname, CF_CHARACTER);
+		if (cf)
+		{
+			BotWriteCompiledCharacter(cf, ch);
+			WriteCompiledFile(cf);
+			FreeCompiledFile(cf);
+		} //end if
+	} //end if
 	FreeSource(source);
 	//
 	if (!foundcharacter)
@@ -391,11 +541,8 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 #endif //DEBUG
 
 	//find a free spot for a character
-	for (handle = 1; handle <= MAX_CLIENTS; handle++)
-	{
-		if (!botcharacters[handle]) break;
-	} //end for
-	if (handle > MAX_CLIENTS) return 0;
+	handle = BotFreeCharacterHandle();
+	if (!handle) return 0;
 	//try to load a cached character with the given skill
 	if (!reload)
 	{
@@ -403,6 +550,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 		if (cachedhandle)
 		{
 			botimport.Print(PRT_MESSAGE, "loaded cached skill %f from %s\n", skill, charfile);
+			botcharacters[cachedhandle]->refcount++;
 			return cachedhandle;
 		} //end if
 	} //end else
@@ -413,6 +561,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 	if (ch)
 	{
 		botcharacters[handle] = ch;
+		ch->refcount = 1;
 		//
 		botimport.Print(PRT_MESSAGE, "loaded skill %d from %s\n", intskill, charfile);
 #ifdef DEBUG
@@ -433,6 +582,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 		if (cachedhandle)
 		{
 			botimport.Print(PRT_MESSAGE, "loaded cached default skill %d from %s\n", intskill, charfile);
+			botcharacters[cachedhandle]->refcount++;
 			return cachedhandle;
 		} //end if
 	} //end if
@@ -441,6 +591,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 	if (ch)
 	{
 		botcharacters[handle] = ch;
+		ch->refcount = 1;
 		botimport.Print(PRT_MESSAGE, "loaded default skill %d from %s\n", intskill, charfile);
 		return handle;
 	} //end if
@@ -452,6 +603,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 		if (cachedhandle)
 		{
 			botimport.Print(PRT_MESSAGE, "loaded cached skill %f from %s\n", botcharacters[cachedhandle]->skill, charfile);
+			botcharacters[cachedhandle]->refcount++;
 			return cachedhandle;
 		} //end if
 	} //end if
@@ -460,6 +612,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 	if (ch)
 	{
 		botcharacters[handle] = ch;
+		ch->refcount = 1;
 		botimport.Print(PRT_MESSAGE, "loaded skill %f from %s\n", ch->skill, charfile);
 		return handle;
 	} //end if
@@ -471,6 +624,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 		if (cachedhandle)
 		{
 			botimport.Print(PRT_MESSAGE, "loaded cached default skill %f from %s\n", botcharacters[cachedhandle]->skill, charfile);
+			botcharacters[cachedhandle]->refcount++;
 			return cachedhandle;
 		} //end if
 	} //end if
@@ -479,6 +633,7 @@ int BotLoadCachedCharacter(char *charfile, float skill, int reload)
 	if (ch)
 	{
 		botcharacters[handle] = ch;
+		ch->refcount = 1;
 		botimport.Print(PRT_MESSAGE, "loaded default skill %f from %s\n", ch->skill, charfile);
 		return handle;
 	} //end if
@@ -504,6 +659,13 @@ int BotLoadCharacterSkill(char *charfile, float skill)
 	{
 		BotDefaultCharacteristics(botcharacters[ch], botcharacters[defaultch]);
 	} //end if
+	//the default character is only used to fill in missing characteristics,
+	//but stays loaded so the next bot doesn't parse it again
+	if (defaultch)
+	{
+		BotKeepCharacter(defaultch);
+		BotFreeCharacter(defaultch);
+	} //end if
 
 	return ch;
 } //end of the function BotLoadCharacterSkill
@@ -524,15 +686,13 @@ int BotInterpolateCharacters(int handle1, int handle2, float desiredskill)
 	if (!ch1 || !ch2)
 		return 0;
 	//find a free spot for a character
-	for (handle = 1; handle <= MAX_CLIENTS; handle++)
-	{
-		if (!botcharacters[handle]) break;
-	} //end for
-	if (handle > MAX_CLIENTS) return 0;
+	handle = BotFreeCharacterHandle();
+	if (!handle) return 0;
 	out = (bot_character_t *) GetClearedMemory(sizeof(bot_character_t) +
 					MAX_CHARACTERISTICS * sizeof(bot_characteristic_t));
 	out->skill = desiredskill;
 	strcpy(out->filename, ch1->filename);
+	out->refcount = 1;
 	botcharacters[handle] = out;
 
 	scale = (float) (desiredskill - ch1->skill) / (ch2->skill - ch1->skill);
@@ -582,6 +742,7 @@ int BotLoadCharacter(char *charfile, float skill)
 	if (handle)
 	{
 		botimport.Print(PRT_MESSAGE, "loaded cached skill %f from %s\n", skill, charfile);
+		botcharacters[handle]->refcount++;
 		return handle;
 	} //end if
 	if (skill < 4.0)
@@ -602,6 +763,15 @@ int BotLoadCharacter(char *charfile, float skill)
 	} //end else
 	//interpolate between the two skills
 	handle = BotInterpolateCharacters(firstskill, secondskill, skill);
+	//the skills interpolated between aren't used by the bot, but are kept
+	//for the next bot with this character unless they're always reloaded
+	if (!LibVarGetValue("bot_reloadcharacters"))
+	{
+		BotKeepCharacter(firstskill);
+		BotKeepCharacter(secondskill);
+	} //end if
+	BotFreeCharacter(firstskill);
+	BotFreeCharacter(secondskill);
 	if (!handle) return 0;
 	//write the character to the log file
 	BotDumpCharacter(botcharacters[handle]);
@@ -776,6 +946,16 @@ void BotShutdownCharacters(void)
 {
 	int handle;
 
+	//release the references botlib kept
+	for (handle = 1; handle <= MAX_CLIENTS; handle++)
+	{
+		if (botcharacters[handle] && botcharacters[handle]->keep)
+		{
+			botcharacters[handle]->keep = qfalse;
+			BotFreeCharacter(handle);
+		} //end if
+	} //end for
+	//and free the characters of bots that are still around
 	for (handle = 1; handle <= MAX_CLIENTS; handle++)
 	{
 		if (botcharacters[handle])
@@ -34,6 +34,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "l_libvar.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_compiled.h"
 #include "l_struct.h"
 #include "l_utils.h"
 #include "l_log.h"
@@ -189,10 +190,14 @@ typedef struct bot_chatstate_s
 	bot_chat_t *chat;
 } bot_chatstate_t;
 
+//initial chat shared by the chat states that loaded it
 typedef struct {
 	bot_chat_t	*chat;
 	char		filename[MAX_QPATH];
 	char		chatname[MAX_QPATH];
+	int			refcount;			//number of chat states using the chat
+	int			datasize;			//size and crc of the compiled chat
+	unsigned short datacrc;
 } bot_ichatdata_t;
 
 bot_ichatdata_t	*ichatdata[MAX_CLIENTS];
@@ -605,6 +610,108 @@ void BotDumpSynonymList(bot_synonymlist_t *synlist)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledSynonyms(compiledfile_t *cf, bot_synonymlist_t *synlist)
+{
+	int size;
+	bot_synonymlist_t *syn;
+	bot_synonym_t *synonym;
+
+	size = 0;
+	for (syn = synlist; syn; syn = syn->next)
+	{
+		size += sizeof(bot_synonymlist_t);
+		for (synonym = syn->firstsynonym; synonym; synonym = synonym->next)
+		{
+			size += sizeof(bot_synonym_t) + PAD(strlen(synonym->string) + 1, sizeof(long));
+		} //end for
+	} //end for
+	CF_WriteInt(cf, size);
+	for (syn = synlist; syn; syn = syn->next)
+	{
+		CF_WriteInt(cf, qtrue);
+		CF_WriteInt(cf, syn->context);
+		for (synonym = syn->firstsynonym; synonym; synonym = synonym->next)
+		{
+			CF_WriteInt(cf, qtrue);
+			CF_WriteString(cf, synonym->string);
+			CF_WriteFloat(cf, synonym->weight);
+		} //end for
+		CF_WriteInt(cf, qfalse);
+	} //end for
+	CF_WriteInt(cf, qfalse);
+} //end of the function BotWriteCompiledSynonyms
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_synonymlist_t *BotReadCompiledSynonyms(compiledfile_t *cf)
+{
+	int size;
+	size_t len;
+	char *block, *ptr, *end, *string;
+	bot_synonymlist_t *synlist, *lastsyn, *syn;
+	bot_synonym_t *synonym, *lastsynonym;
+
+	size = CF_ReadBlockSize(cf);
+	if (!size) return NULL;
+	block = ptr = (char *) GetClearedHunkMemory(size);
+	end = block + size;
+	synlist = NULL;
+	lastsyn = NULL;
+	while(CF_ReadInt(cf) && !cf->error)
+	{
+		if (ptr + sizeof(bot_synonymlist_t) > end)
+		{
+			cf->error = qtrue;
+			break;
+		} //end if
+		syn = (bot_synonymlist_t *) ptr;
+		ptr += sizeof(bot_synonymlist_t);
+		syn->context = (unsigned int) CF_ReadInt(cf);
+		if (lastsyn) lastsyn->next = syn;
+		else synlist = syn;
+		lastsyn = syn;
+		lastsynonym = NULL;
+		while(CF_ReadInt(cf) && !cf->error)
+		{
+			string = CF_ReadString(cf);
+			if (!string) cf->error = qtrue;
+			if (cf->error) break;
+			len = PAD(strlen(string) + 1, sizeof(long));
+			if (ptr + sizeof(bot_synonym_t) + len > end)
+			{
+				cf->error = qtrue;
+				break;
+			} //end if
+			synonym = (bot_synonym_t *) ptr;
+			ptr += sizeof(bot_synonym_t);
+			synonym->string = ptr;
+			ptr += len;
+			strcpy(synonym->string, string);
+			synonym->weight = CF_ReadFloat(cf);
+			syn->totalweight += synonym->weight;
+			if (lastsynonym) lastsynonym->next = synonym;
+			else syn->firstsynonym = synonym;
+			lastsynonym = synonym;
+		} //end while
+		//every synonym list has at least two synonyms
+		if (!syn->firstsynonym || !syn->firstsynonym->next) cf->error = qtrue;
+	} //end while
+	if (cf->error || ptr != end)
+	{
+		FreeMemory(block);
+		return NULL;
+	} //end if
+	return synlist;
+} //end of the function BotReadCompiledSynonyms
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 bot_synonymlist_t *BotLoadSynonyms(char *filename)
 {
 	int pass, size, contextlevel, numsynonyms;
@@ -614,7 +721,21 @@ bot_synonymlist_t *BotLoadSynonyms(char *filename)
 	token_t token;
 	bot_synonymlist_t *synlist, *lastsyn, *syn;
 	bot_synonym_t *synonym, *lastsynonym;
+	compiledfile_t *cf;
 
+	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(filename, NULL, CF_SYNONYMS);
+	if (cf)
+	{
+		synlist = BotReadCompiledSynonyms(cf);
+		FreeCompiledFile(cf);
+		if (synlist)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
+			return synlist;
+		} //end if
+	} //end if
+	cf = NULL;
 	size = 0;
 	synlist = NULL; //make compiler happy
 	syn = NULL; //make compiler happy
@@ -753,6 +874,7 @@ bot_synonymlist_t *BotLoadSynonyms(char *filename)
 			} //end else if
 		} //end while
 		//
+		if (pass && !contextlevel) cf = CreateCompiledFile(source, NULL, CF_SYNONYMS);
 		FreeSource(source);
 		//
 		if (contextlevel > 0)
@@ -761,6 +883,12 @@ bot_synonymlist_t *BotLoadSynonyms(char *filename)
 			return NULL;
 		} //end if
 	} //end for
+	if (cf)
+	{
+		BotWriteCompiledSynonyms(cf, synlist);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
 	//
 	//BotDumpSynonymList(synlist);
@@ -958,6 +1086,102 @@ void BotDumpRandomStringList(bot_randomlist_t *randomlist)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledRandomStrings(compiledfile_t *cf, bot_randomlist_t *randomlist)
+{
+	int size;
+	bot_randomlist_t *random;
+	bot_randomstring_t *rs;
+
+	size = 0;
+	for (random = randomlist; random; random = random->next)
+	{
+		size += sizeof(bot_randomlist_t) + PAD(strlen(random->string) + 1, sizeof(long));
+		for (rs = random->firstrandomstring; rs; rs = rs->next)
+		{
+			size += sizeof(bot_randomstring_t) + PAD(strlen(rs->string) + 1, sizeof(long));
+		} //end for
+	} //end for
+	CF_WriteInt(cf, size);
+	for (random = randomlist; random; random = random->next)
+	{
+		CF_WriteString(cf, random->string);
+		for (rs = random->firstrandomstring; rs; rs = rs->next)
+		{
+			CF_WriteString(cf, rs->string);
+		} //end for
+		CF_WriteString(cf, NULL);
+	} //end for
+	CF_WriteString(cf, NULL);
+} //end of the function BotWriteCompiledRandomStrings
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_randomlist_t *BotReadCompiledRandomStrings(compiledfile_t *cf)
+{
+	int size;
+	size_t len;
+	char *block, *ptr, *end, *string;
+	bot_randomlist_t *randomlist, *lastrandom, *random;
+	bot_randomstring_t *randomstring, *lastrandomstring;
+
+	size = CF_ReadBlockSize(cf);
+	if (!size) return NULL;
+	block = ptr = (char *) GetClearedHunkMemory(size);
+	end = block + size;
+	randomlist = NULL;
+	lastrandom = NULL;
+	while((string = CF_ReadString(cf)) != NULL && !cf->error)
+	{
+		len = PAD(strlen(string) + 1, sizeof(long));
+		if (ptr + sizeof(bot_randomlist_t) + len > end)
+		{
+			cf->error = qtrue;
+			break;
+		} //end if
+		random = (bot_randomlist_t *) ptr;
+		ptr += sizeof(bot_randomlist_t);
+		random->string = ptr;
+		ptr += len;
+		strcpy(random->string, string);
+		if (lastrandom) lastrandom->next = random;
+		else randomlist = random;
+		lastrandom = random;
+		lastrandomstring = NULL;
+		while((string = CF_ReadString(cf)) != NULL && !cf->error)
+		{
+			len = PAD(strlen(string) + 1, sizeof(long));
+			if (ptr + sizeof(bot_randomstring_t) + len > end)
+			{
+				cf->error = qtrue;
+				break;
+			} //end if
+			randomstring = (bot_randomstring_t *) ptr;
+			ptr += sizeof(bot_randomstring_t);
+			randomstring->string = ptr;
+			ptr += len;
+			strcpy(randomstring->string, string);
+			if (lastrandomstring) lastrandomstring->next = randomstring;
+			else random->firstrandomstring = randomstring;
+			lastrandomstring = randomstring;
+			random->numstrings++;
+		} //end while
+	} //end while
+	if (cf->error || ptr != end)
+	{
+		FreeMemory(block);
+		return NULL;
+	} //end if
+	return randomlist;
+} //end of the function BotReadCompiledRandomStrings
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 bot_randomlist_t *BotLoadRandomStrings(char *filename)
 {
 	int pass, size;
@@ -966,11 +1190,25 @@ bot_randomlist_t *BotLoadRandomStrings(char *filename)
 	token_t token;
 	bot_randomlist_t *randomlist, *lastrandom, *random;
 	bot_randomstring_t *randomstring;
+	compiledfile_t *cf;
 
 #ifdef DEBUG
 	int starttime = Sys_MilliSeconds();
 #endif //DEBUG
 
+	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(filename, NULL, CF_RANDOMSTRINGS);
+	if (cf)
+	{
+		randomlist = BotReadCompiledRandomStrings(cf);
+		FreeCompiledFile(cf);
+		if (randomlist)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
+			return randomlist;
+		} //end if
+	} //end if
+	cf = NULL;
 	size = 0;
 	randomlist = NULL;
 	random = NULL;
@@ -1048,8 +1286,15 @@ bot_randomlist_t *BotLoadRandomStrings(char *filename)
 			} //end while
 		} //end while
 		//free the source after one pass
+		if (pass) cf = CreateCompiledFile(source, NULL, CF_RANDOMSTRINGS);
 		FreeSource(source);
 	} //end for
+	if (cf)
+	{
+		BotWriteCompiledRandomStrings(cf, randomlist);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
 	//
 #ifdef DEBUG
@@ -1156,6 +1401,89 @@ void BotFreeMatchPieces(bot_matchpiece_t *matchpieces)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledMatchPieces(compiledfile_t *cf, bot_matchpiece_t *matchpieces)
+{
+	bot_matchpiece_t *mp;
+	bot_matchstring_t *ms;
+
+	for (mp = matchpieces; mp; mp = mp->next)
+	{
+		CF_WriteInt(cf, mp->type);
+		if (mp->type == MT_STRING)
+		{
+			for (ms = mp->firststring; ms; ms = ms->next)
+			{
+				CF_WriteString(cf, ms->string);
+			} //end for
+			CF_WriteString(cf, NULL);
+		} //end if
+		else
+		{
+			CF_WriteInt(cf, mp->variable);
+		} //end else
+	} //end for
+	CF_WriteInt(cf, 0);
+} //end of the function BotWriteCompiledMatchPieces
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_matchpiece_t *BotReadCompiledMatchPieces(compiledfile_t *cf)
+{
+	int type;
+	char *string;
+	bot_matchpiece_t *matchpiece, *firstpiece, *lastpiece;
+	bot_matchstring_t *matchstring, *lastmatchstring;
+
+	firstpiece = NULL;
+	lastpiece = NULL;
+	while((type = CF_ReadInt(cf)) != 0 && !cf->error)
+	{
+		if (type != MT_STRING && type != MT_VARIABLE)
+		{
+			cf->error = qtrue;
+			break;
+		} //end if
+		matchpiece = (bot_matchpiece_t *) GetClearedHunkMemory(sizeof(bot_matchpiece_t));
+		matchpiece->type = type;
+		if (lastpiece) lastpiece->next = matchpiece;
+		else firstpiece = matchpiece;
+		lastpiece = matchpiece;
+		if (type == MT_STRING)
+		{
+			lastmatchstring = NULL;
+			while((string = CF_ReadString(cf)) != NULL && !cf->error)
+			{
+				matchstring = (bot_matchstring_t *) GetClearedHunkMemory(sizeof(bot_matchstring_t) + strlen(string) + 1);
+				matchstring->string = (char *) matchstring + sizeof(bot_matchstring_t);
+				strcpy(matchstring->string, string);
+				if (lastmatchstring) lastmatchstring->next = matchstring;
+				else matchpiece->firststring = matchstring;
+				lastmatchstring = matchstring;
+			} //end while
+			if (!matchpiece->firststring) cf->error = qtrue;
+		} //end if
+		else
+		{
+			matchpiece->variable = CF_ReadInt(cf);
+			if (matchpiece->variable < 0 || matchpiece->variable >= MAX_MATCHVARIABLES) cf->error = qtrue;
+		} //end else
+	} //end while
+	if (cf->error)
+	{
+		BotFreeMatchPieces(firstpiece);
+		return NULL;
+	} //end if
+	return firstpiece;
+} //end of the function BotReadCompiledMatchPieces
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 bot_matchpiece_t *BotLoadMatchPieces(source_t *source, char *endtoken)
 {
 	int lastwasvariable, emptystring;
@@ -1275,14 +1603,77 @@ void BotFreeMatchTemplates(bot_matchtemplate_t *mt)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledMatchTemplates(compiledfile_t *cf, bot_matchtemplate_t *matches)
+{
+	bot_matchtemplate_t *mt;
+
+	for (mt = matches; mt; mt = mt->next)
+	{
+		CF_WriteInt(cf, qtrue);
+		CF_WriteInt(cf, mt->context);
+		CF_WriteInt(cf, mt->type);
+		CF_WriteInt(cf, mt->subtype);
+		BotWriteCompiledMatchPieces(cf, mt->first);
+	} //end for
+	CF_WriteInt(cf, qfalse);
+} //end of the function BotWriteCompiledMatchTemplates
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_matchtemplate_t *BotReadCompiledMatchTemplates(compiledfile_t *cf)
+{
+	bot_matchtemplate_t *matchtemplate, *matches, *lastmatch;
+
+	matches = NULL;
+	lastmatch = NULL;
+	while(CF_ReadInt(cf) && !cf->error)
+	{
+		matchtemplate = (bot_matchtemplate_t *) GetClearedHunkMemory(sizeof(bot_matchtemplate_t));
+		matchtemplate->context = (unsigned int) CF_ReadInt(cf);
+		matchtemplate->type = CF_ReadInt(cf);
+		matchtemplate->subtype = CF_ReadInt(cf);
+		if (lastmatch) lastmatch->next = matchtemplate;
+		else matches = matchtemplate;
+		lastmatch = matchtemplate;
+		matchtemplate->first = BotReadCompiledMatchPieces(cf);
+		if (!matchtemplate->first) cf->error = qtrue;
+	} //end while
+	if (cf->error)
+	{
+		BotFreeMatchTemplates(matches);
+		return NULL;
+	} //end if
+	return matches;
+} //end of the function BotReadCompiledMatchTemplates
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 bot_matchtemplate_t *BotLoadMatchTemplates(char *matchfile)
 {
 	source_t *source;
 	token_t token;
 	bot_matchtemplate_t *matchtemplate, *matches, *lastmatch;
 	unsigned long int context;
+	compiledfile_t *cf;
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(matchfile, NULL, CF_MATCHTEMPLATES);
+	if (cf)
+	{
+		matches = BotReadCompiledMatchTemplates(cf);
+		FreeCompiledFile(cf);
+		if (matches)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", matchfile);
+			return matches;
+		} //end if
+	} //end if
 	source = LoadSourceFile(matchfile);
 	if (!source)
 	{
@@ -1360,6 +1751,14 @@ bot_matchtemplate_t *BotLoadMatchTemplates(char *matchfile)
 			} //end if
 		} //end while
 	} //end while
+	//store the compiled match templates
+	cf = CreateCompiledFile(source, NULL, CF_MATCHTEMPLATES);
+	if (cf)
+	{
+		BotWriteCompiledMatchTemplates(cf, matches);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	//free the source
 	FreeSource(source);
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", matchfile);
@@ -1844,6 +2243,99 @@ void BotCheckValidReplyChatKeySet(source_t *source, bot_replychatkey_t *keys)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledReplyChat(compiledfile_t *cf, bot_replychat_t *replychat)
+{
+	bot_replychat_t *rp;
+	bot_replychatkey_t *key;
+	bot_chatmessage_t *cm;
+
+	for (rp = replychat; rp; rp = rp->next)
+	{
+		CF_WriteInt(cf, qtrue);
+		for (key = rp->keys; key; key = key->next)
+		{
+			CF_WriteInt(cf, key->flags);
+			CF_WriteString(cf, key->string);
+			BotWriteCompiledMatchPieces(cf, key->match);
+		} //end for
+		CF_WriteInt(cf, 0);
+		CF_WriteFloat(cf, rp->priority);
+		for (cm = rp->firstchatmessage; cm; cm = cm->next)
+		{
+			CF_WriteString(cf, cm->chatmessage);
+		} //end for
+		CF_WriteString(cf, NULL);
+	} //end for
+	CF_WriteInt(cf, qfalse);
+} //end of the function BotWriteCompiledReplyChat
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+bot_replychat_t *BotReadCompiledReplyChat(compiledfile_t *cf)
+{
+	int flags;
+	char *string;
+	bot_replychat_t *replychat, *replychatlist, *lastreplychat;
+	bot_replychatkey_t *key, *lastkey;
+	bot_chatmessage_t *chatmessage, *lastchatmessage;
+
+	replychatlist = NULL;
+	lastreplychat = NULL;
+	while(CF_ReadInt(cf) && !cf->error)
+	{
+		replychat = GetClearedHunkMemory(sizeof(bot_replychat_t));
+		if (lastreplychat) lastreplychat->next = replychat;
+		else replychatlist = replychat;
+		lastreplychat = replychat;
+		//read the keys
+		lastkey = NULL;
+		while((flags = CF_ReadInt(cf)) != 0 && !cf->error)
+		{
+			key = (bot_replychatkey_t *) GetClearedHunkMemory(sizeof(bot_replychatkey_t));
+			key->flags = flags;
+			if (lastkey) lastkey->next = key;
+			else replychat->keys = key;
+			lastkey = key;
+			string = CF_ReadString(cf);
+			if (string)
+			{
+				key->string = (char *) GetClearedHunkMemory(strlen(string) + 1);
+				strcpy(key->string, string);
+			} //end if
+			key->match = BotReadCompiledMatchPieces(cf);
+			if ((key->flags & RCKFL_VARIABLES) && !key->match) cf->error = qtrue;
+		} //end while
+		replychat->priority = CF_ReadFloat(cf);
+		//read the chat messages
+		lastchatmessage = NULL;
+		while((string = CF_ReadString(cf)) != NULL && !cf->error)
+		{
+			chatmessage = (bot_chatmessage_t *) GetClearedHunkMemory(sizeof(bot_chatmessage_t) + strlen(string) + 1);
+			chatmessage->chatmessage = (char *) chatmessage + sizeof(bot_chatmessage_t);
+			strcpy(chatmessage->chatmessage, string);
+			chatmessage->time = -2*CHATMESSAGE_RECENTTIME;
+			if (lastchatmessage) lastchatmessage->next = chatmessage;
+			else replychat->firstchatmessage = chatmessage;
+			lastchatmessage = chatmessage;
+			replychat->numchatmessages++;
+		} //end while
+	} //end while
+	if (cf->error)
+	{
+		BotFreeReplyChat(replychatlist);
+		return NULL;
+	} //end if
+	return replychatlist;
+} //end of the function BotReadCompiledReplyChat
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 bot_replychat_t *BotLoadReplyChat(char *filename)
 {
 	char chatmessagestring[MAX_MESSAGE_SIZE];
@@ -1853,8 +2345,20 @@ bot_replychat_t *BotLoadReplyChat(char *filename)
 	bot_chatmessage_t *chatmessage = NULL;
 	bot_replychat_t *replychat, *replychatlist;
 	bot_replychatkey_t *key;
+	compiledfile_t *cf;
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(filename, NULL, CF_REPLYCHAT);
+	if (cf)
+	{
+		replychatlist = BotReadCompiledReplyChat(cf);
+		FreeCompiledFile(cf);
+		if (replychatlist)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
+			return replychatlist;
+		} //end if
+	} //end if
 	source = LoadSourceFile(filename);
 	if (!source)
 	{
@@ -1985,6 +2489,14 @@ bot_replychat_t *BotLoadReplyChat(char *filename)
 			replychat->numchatmessages++;
 		} //end while
 	} //end while
+	//store the compiled reply chats
+	cf = CreateCompiledFile(source, NULL, CF_REPLYCHAT);
+	if (cf)
+	{
+		BotWriteCompiledReplyChat(cf, replychatlist);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	FreeSource(source);
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
 	//
@@ -2029,6 +2541,102 @@ void BotDumpInitialChat(bot_chat_t *chat)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+void BotWriteCompiledInitialChat(compiledfile_t *cf, bot_chat_t *chat)
+{
+	int size;
+	bot_chattype_t *t;
+	bot_chatmessage_t *m;
+
+	size = sizeof(bot_chat_t);
+	for (t = chat->types; t; t = t->next)
+	{
+		size += sizeof(bot_chattype_t);
+		for (m = t->firstchatmessage; m; m = m->next)
+		{
+			size += sizeof(bot_chatmessage_t) + PAD(strlen(m->chatmessage) + 1, sizeof(long));
+		} //end for
+	} //end for
+	CF_WriteInt(cf, size);
+	for (t = chat->types; t; t = t->next)
+	{
+		CF_WriteString(cf, t->name);
+		for (m = t->firstchatmessage; m; m = m->next)
+		{
+			CF_WriteString(cf, m->chatmessage);
+		} //end for
+		CF_WriteString(cf, NULL);
+	} //end for
+	CF_WriteString(cf, NULL);
+} //end of the function BotWriteCompiledInitialChat
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_chat_t *BotReadCompiledInitialChat(compiledfile_t *cf)
+{
+	int size;
+	size_t len;
+	char *ptr, *end, *string;
+	bot_chat_t *chat;
+	bot_chattype_t *chattype, *lastchattype;
+	bot_chatmessage_t *chatmessage, *lastchatmessage;
+
+	size = CF_ReadBlockSize(cf);
+	if (size < (int) sizeof(bot_chat_t)) return NULL;
+	ptr = (char *) GetClearedMemory(size);
+	end = ptr + size;
+	chat = (bot_chat_t *) ptr;
+	ptr += sizeof(bot_chat_t);
+	lastchattype = NULL;
+	while((string = CF_ReadString(cf)) != NULL && !cf->error)
+	{
+		if (ptr + sizeof(bot_chattype_t) > end)
+		{
+			cf->error = qtrue;
+			break;
+		} //end if
+		chattype = (bot_chattype_t *) ptr;
+		ptr += sizeof(bot_chattype_t);
+		Q_strncpyz(chattype->name, string, MAX_CHATTYPE_NAME);
+		if (lastchattype) lastchattype->next = chattype;
+		else chat->types = chattype;
+		lastchattype = chattype;
+		lastchatmessage = NULL;
+		while((string = CF_ReadString(cf)) != NULL && !cf->error)
+		{
+			len = PAD(strlen(string) + 1, sizeof(long));
+			if (ptr + sizeof(bot_chatmessage_t) + len > end)
+			{
+				cf->error = qtrue;
+				break;
+			} //end if
+			chatmessage = (bot_chatmessage_t *) ptr;
+			ptr += sizeof(bot_chatmessage_t);
+			chatmessage->chatmessage = ptr;
+			ptr += len;
+			strcpy(chatmessage->chatmessage, string);
+			chatmessage->time = -2*CHATMESSAGE_RECENTTIME;
+			if (lastchatmessage) lastchatmessage->next = chatmessage;
+			else chattype->firstchatmessage = chatmessage;
+			lastchatmessage = chatmessage;
+			chattype->numchatmessages++;
+		} //end while
+	} //end while
+	if (cf->error || ptr != end)
+	{
+		FreeMemory(chat);
+		return NULL;
+	} //end if
+	return chat;
+} //end of the function BotReadCompiledInitialChat
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 {
 	int pass, foundchat, indent, size;
@@ -2039,12 +2647,26 @@ bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 	bot_chat_t *chat = NULL;
 	bot_chattype_t *chattype = NULL;
 	bot_chatmessage_t *chatmessage = NULL;
+	compiledfile_t *cf;
 #ifdef DEBUG
 	int starttime;
 
 	starttime = Sys_MilliSeconds();
 #endif //DEBUG
 	//
+	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(chatfile, chatname, CF_INITIALCHAT);
+	if (cf)
+	{
+		chat = BotReadCompiledInitialChat(cf);
+		FreeCompiledFile(cf);
+		if (chat)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s from %s\n", chatname, chatfile);
+			return chat;
+		} //end if
+	} //end if
+	cf = NULL;
 	size = 0;
 	foundchat = qfalse;
 	//a bot chat is parsed in two phases
@@ -2176,6 +2798,7 @@ bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 			} //end else
 		} //end while
 		//free the source
+		if (pass && foundchat) cf = CreateCompiledFile(source, chatname, CF_INITIALCHAT);
 		FreeSource(source);
 		//if the requested character is not found
 		if (!foundchat)
@@ -2184,6 +2807,12 @@ bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 			return NULL;
 		} //end if
 	} //end for
+	if (cf)
+	{
+		BotWriteCompiledInitialChat(cf, chat);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	//
 	botimport.Print(PRT_MESSAGE, "loaded %s from %s\n", chatname, chatfile);
 	//
@@ -2204,13 +2833,88 @@ bot_chat_t *BotLoadInitialChat(char *chatfile, char *chatname)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+void BotFreeInitialChatData(int n)
+{
+	int i;
+	bot_chat_t *chat;
+
+	chat = ichatdata[n]->chat;
+	FreeMemory(ichatdata[n]);
+	ichatdata[n] = NULL;
+	//the chat can also be shared under another file or chat name
+	for (i = 0; i < MAX_CLIENTS; i++)
+	{
+		if (ichatdata[i] && ichatdata[i]->chat == chat) return;
+	} //end for
+	FreeMemory(chat);
+} //end of the function BotFreeInitialChatData
+//===========================================================================
+// stores the chat in the initial chat list, when a chat with the same
+// contents is already loaded that one is shared and the new one freed
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+bot_chat_t *BotShareInitialChat(bot_chat_t *chat, char *chatfile, char *chatname, int avail)
+{
+	int n;
+	bot_ichatdata_t *icd;
+	compiledfile_t *contents, *othercontents;
+
+	contents = CreateCompiledData(CF_INITIALCHAT);
+	BotWriteCompiledInitialChat(contents, chat);
+	icd = (bot_ichatdata_t *) GetClearedMemory(sizeof(bot_ichatdata_t));
+	icd->chat = chat;
+	Q_strncpyz(icd->chatname, chatname, sizeof(icd->chatname));
+	Q_strncpyz(icd->filename, chatfile, sizeof(icd->filename));
+	icd->refcount = 1;
+	icd->datasize = contents->size;
+	icd->datacrc = CompiledDataCRC(contents);
+	for (n = 0; n < MAX_CLIENTS; n++)
+	{
+		if (!ichatdata[n]) continue;
+		if (ichatdata[n]->datasize != icd->datasize ||
+			ichatdata[n]->datacrc != icd->datacrc) continue;
+		othercontents = CreateCompiledData(CF_INITIALCHAT);
+		BotWriteCompiledInitialChat(othercontents, ichatdata[n]->chat);
+		if (CompiledDataEqual(contents, othercontents))
+		{
+			botimport.Print(PRT_MESSAGE, "sharing %s from %s with %s from %s\n", chatname, chatfile,
+								ichatdata[n]->chatname, ichatdata[n]->filename);
+			FreeMemory(chat);
+			icd->chat = ichatdata[n]->chat;
+			FreeCompiledFile(othercontents);
+			break;
+		} //end if
+		FreeCompiledFile(othercontents);
+	} //end for
+	FreeCompiledFile(contents);
+	ichatdata[avail] = icd;
+	return icd->chat;
+} //end of the function BotShareInitialChat
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 void BotFreeChatFile(int chatstate)
 {
+	int n;
 	bot_chatstate_t *cs;
 
 	cs = BotChatStateFromHandle(chatstate);
 	if (!cs) return;
-	if (cs->chat) FreeMemory(cs->chat);
+	if (!cs->chat) return;
+	for (n = 0; n < MAX_CLIENTS; n++)
+	{
+		if (!ichatdata[n] || ichatdata[n]->chat != cs->chat) continue;
+		//a shared chat is freed when the last chat state using it is gone
+		if (--ichatdata[n]->refcount <= 0) BotFreeInitialChatData(n);
+		break;
+	} //end for
+	if (n >= MAX_CLIENTS) FreeMemory(cs->chat);
 	cs->chat = NULL;
 } //end of the function BotFreeChatFile
 //===========================================================================
@@ -2245,6 +2949,7 @@ int BotLoadChatFile(int chatstate, char *chatfile, char *chatname)
 				continue;
 			}
 			cs->chat = ichatdata[n]->chat;
+			ichatdata[n]->refcount++;
 		//		botimport.Print( PRT_MESSAGE, "retained %s from %s\n", chatname, chatfile );
 			return BLERR_NOERROR;
 		}
@@ -2263,10 +2968,7 @@ int BotLoadChatFile(int chatstate, char *chatfile, char *chatname)
 	} //end if
 	if (!LibVarGetValue("bot_reloadcharacters"))
 	{
-		ichatdata[avail] = GetClearedMemory( sizeof(bot_ichatdata_t) );
-		ichatdata[avail]->chat = cs->chat;
-		Q_strncpyz( ichatdata[avail]->chatname, chatname, sizeof(ichatdata[avail]->chatname) );
-		Q_strncpyz( ichatdata[avail]->filename, chatfile, sizeof(ichatdata[avail]->filename) );
+		cs->chat = BotShareInitialChat(cs->chat, chatfile, chatname, avail);
 	} //end if
 
 	return BLERR_NOERROR;
@@ -2947,10 +3649,7 @@ void BotFreeChatState(int handle)
 		botimport.Print(PRT_FATAL, "invalid chat state %d\n", handle);
 		return;
 	} //end if
-	if (LibVarGetValue("bot_reloadcharacters"))
-	{
-		BotFreeChatFile(handle);
-	} //end if
+	BotFreeChatFile(handle);
 	//free all the console messages left in the chat state
 	for (h = BotNextConsoleMessage(handle, &m); h; h = BotNextConsoleMessage(handle, &m))
 	{
@@ -3017,9 +3716,7 @@ void BotShutdownChatAI(void)
 	{
 		if (ichatdata[i])
 		{
-			FreeMemory(ichatdata[i]->chat);
-			FreeMemory(ichatdata[i]);
-			ichatdata[i] = NULL;
+			BotFreeInitialChatData(i);
 		} //end if
 	} //end for
 	if (consolemessageheap) FreeMemory(consolemessageheap);
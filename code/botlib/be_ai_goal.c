@@ -36,6 +36,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "l_log.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_compiled.h"
 #include "l_struct.h"
 #include "aasfile.h"
 #include "botlib.h"
@@ -262,6 +263,45 @@ void BotMutateGoalFuzzyLogic(int goalstate, float range)
 	EvolveWeightConfig(gs->itemweightconfig);
 } //end of the function BotMutateGoalFuzzyLogic
 //===========================================================================
+// the item info has no pointers so it is stored as is
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void WriteCompiledItemConfig(compiledfile_t *cf, itemconfig_t *ic)
+{
+	CF_WriteInt(cf, sizeof(iteminfo_t));
+	CF_WriteInt(cf, ic->numiteminfo);
+	CF_WriteData(cf, ic->iteminfo, ic->numiteminfo * sizeof(iteminfo_t));
+} //end of the function WriteCompiledItemConfig
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+itemconfig_t *ReadCompiledItemConfig(compiledfile_t *cf, int max_iteminfo)
+{
+	int numiteminfo;
+	itemconfig_t *ic;
+
+	if (CF_ReadInt(cf) != sizeof(iteminfo_t)) return NULL;
+	numiteminfo = CF_ReadInt(cf);
+	if (cf->error || numiteminfo < 0 || numiteminfo > max_iteminfo) return NULL;
+	ic = (itemconfig_t *) GetClearedHunkMemory(sizeof(itemconfig_t) +
+														max_iteminfo * sizeof(iteminfo_t));
+	ic->iteminfo = (iteminfo_t *) ((char *) ic + sizeof(itemconfig_t));
+	ic->numiteminfo = numiteminfo;
+	CF_ReadData(cf, ic->iteminfo, numiteminfo * sizeof(iteminfo_t));
+	if (cf->error)
+	{
+		FreeMemory(ic);
+		return NULL;
+	} //end if
+	return ic;
+} //end of the function ReadCompiledItemConfig
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -275,6 +315,7 @@ itemconfig_t *LoadItemConfig(char *filename)
 	source_t *source;
 	itemconfig_t *ic;
 	iteminfo_t *ii;
+	compiledfile_t *cf;
 
 	max_iteminfo = (int) LibVarValue("max_iteminfo", "256");
 	if (max_iteminfo < 0)
@@ -286,6 +327,17 @@ itemconfig_t *LoadItemConfig(char *filename)
 
 	Q_strncpyz(path, filename, sizeof(path));
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(path, NULL, CF_ITEMCONFIG);
+	if (cf)
+	{
+		ic = ReadCompiledItemConfig(cf, max_iteminfo);
+		FreeCompiledFile(cf);
+		if (ic)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", path);
+			return ic;
+		} //end if
+	} //end if
 	source = LoadSourceFile( path );
 	if( !source ) {
 		botimport.Print( PRT_ERROR, "counldn't load %s\n", path );
@@ -335,6 +387,14 @@ itemconfig_t *LoadItemConfig(char *filename)
 			return NULL;
 		} //end else
 	} //end while
+	//store the compiled item config
+	cf = CreateCompiledFile(source, NULL, CF_ITEMCONFIG);
+	if (cf)
+	{
+		WriteCompiledItemConfig(cf, ic);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	FreeSource(source);
 	//
 	if (!ic->numiteminfo) botimport.Print(PRT_WARNING, "no item info loaded\n");
@@ -1700,6 +1760,7 @@ int BotLoadItemWeights(int goalstate, char *filename)
 
 	gs = BotGoalStateFromHandle(goalstate);
 	if (!gs) return BLERR_CANNOTLOADITEMWEIGHTS;
+	BotFreeItemWeights(goalstate);
 	//load the weight configuration
 	gs->itemweightconfig = ReadWeightConfig(filename);
 	if (!gs->itemweightconfig)
@@ -1728,6 +1789,8 @@ void BotFreeItemWeights(int goalstate)
 	if (!gs) return;
 	if (gs->itemweightconfig) FreeWeightConfig(gs->itemweightconfig);
 	if (gs->itemweightindex) FreeMemory(gs->itemweightindex);
+	gs->itemweightconfig = NULL;
+	gs->itemweightindex = NULL;
 } //end of the function BotFreeItemWeights
 //===========================================================================
 //
@@ -36,6 +36,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "l_utils.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_compiled.h"
 #include "l_struct.h"
 #include "aasfile.h"
 #include "botlib.h"
@@ -190,6 +191,70 @@ void DumpWeaponConfig(weaponconfig_t *wc)
 } //end of the function DumpWeaponConfig
 #endif //DEBUG_AI_WEAP
 //===========================================================================
+// the weapon and projectile info have no pointers so they are stored as is
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void WriteCompiledWeaponConfig(compiledfile_t *cf, weaponconfig_t *wc)
+{
+	int i;
+
+	CF_WriteInt(cf, sizeof(weaponinfo_t));
+	CF_WriteInt(cf, sizeof(projectileinfo_t));
+	for (i = 0; i < wc->numweapons; i++)
+	{
+		if (!wc->weaponinfo[i].valid) continue;
+		CF_WriteInt(cf, qtrue);
+		CF_WriteData(cf, &wc->weaponinfo[i], sizeof(weaponinfo_t));
+	} //end for
+	CF_WriteInt(cf, qfalse);
+	CF_WriteInt(cf, wc->numprojectiles);
+	CF_WriteData(cf, wc->projectileinfo, wc->numprojectiles * sizeof(projectileinfo_t));
+} //end of the function WriteCompiledWeaponConfig
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+weaponconfig_t *ReadCompiledWeaponConfig(compiledfile_t *cf, int max_weaponinfo, int max_projectileinfo)
+{
+	weaponconfig_t *wc;
+	weaponinfo_t weaponinfo;
+
+	if (CF_ReadInt(cf) != sizeof(weaponinfo_t)) return NULL;
+	if (CF_ReadInt(cf) != sizeof(projectileinfo_t)) return NULL;
+	if (cf->error) return NULL;
+	wc = (weaponconfig_t *) GetClearedHunkMemory(sizeof(weaponconfig_t) +
+										max_weaponinfo * sizeof(weaponinfo_t) +
+										max_projectileinfo * sizeof(projectileinfo_t));
+	wc->weaponinfo = (weaponinfo_t *) ((char *) wc + sizeof(weaponconfig_t));
+	wc->projectileinfo = (projectileinfo_t *) ((char *) wc->weaponinfo +
+										max_weaponinfo * sizeof(weaponinfo_t));
+	wc->numweapons = max_weaponinfo;
+	while(CF_ReadInt(cf) && !cf->error)
+	{
+		CF_ReadData(cf, &weaponinfo, sizeof(weaponinfo_t));
+		if (weaponinfo.number < 0 || weaponinfo.number >= max_weaponinfo)
+		{
+			cf->error = qtrue;
+			break;
+		} //end if
+		Com_Memcpy(&wc->weaponinfo[weaponinfo.number], &weaponinfo, sizeof(weaponinfo_t));
+	} //end while
+	wc->numprojectiles = CF_ReadInt(cf);
+	if (wc->numprojectiles < 0 || wc->numprojectiles > max_projectileinfo) cf->error = qtrue;
+	else CF_ReadData(cf, wc->projectileinfo, wc->numprojectiles * sizeof(projectileinfo_t));
+	if (cf->error)
+	{
+		FreeMemory(wc);
+		return NULL;
+	} //end if
+	return wc;
+} //end of the function ReadCompiledWeaponConfig
+//===========================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -204,6 +269,7 @@ weaponconfig_t *LoadWeaponConfig(char *filename)
 	source_t *source;
 	weaponconfig_t *wc;
 	weaponinfo_t weaponinfo;
+	compiledfile_t *cf;
 
 	max_weaponinfo = (int) LibVarValue("max_weaponinfo", "32");
 	if (max_weaponinfo < 0)
@@ -221,6 +287,17 @@ weaponconfig_t *LoadWeaponConfig(char *filename)
 	} //end if
 	Q_strncpyz(path, filename, sizeof(path));
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(path, NULL, CF_WEAPONCONFIG);
+	if (cf)
+	{
+		wc = ReadCompiledWeaponConfig(cf, max_weaponinfo, max_projectileinfo);
+		FreeCompiledFile(cf);
+		if (wc)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", path);
+			return wc;
+		} //end if
+	} //end if
 	source = LoadSourceFile(path);
 	if (!source)
 	{
@@ -284,6 +361,7 @@ weaponconfig_t *LoadWeaponConfig(char *filename)
 			return NULL;
 		} //end else
 	} //end while
+	cf = CreateCompiledFile(source, NULL, CF_WEAPONCONFIG);
 	FreeSource(source);
 	//fix up weapons
 	for (i = 0; i < wc->numweapons; i++)
@@ -292,12 +370,14 @@ weaponconfig_t *LoadWeaponConfig(char *filename)
 		if (!wc->weaponinfo[i].name[0])
 		{
 			botimport.Print(PRT_ERROR, "weapon %d has no name in %s\n", i, path);
+			if (cf) FreeCompiledFile(cf);
 			FreeMemory(wc);
 			return NULL;
 		} //end if
 		if (!wc->weaponinfo[i].projectile[0])
 		{
 			botimport.Print(PRT_ERROR, "weapon %s has no projectile in %s\n", wc->weaponinfo[i].name, path);
+			if (cf) FreeCompiledFile(cf);
 			FreeMemory(wc);
 			return NULL;
 		} //end if
@@ -313,10 +393,18 @@ weaponconfig_t *LoadWeaponConfig(char *filename)
 		if (j == wc->numprojectiles)
 		{
 			botimport.Print(PRT_ERROR, "weapon %s uses undefined projectile in %s\n", wc->weaponinfo[i].name, path);
+			if (cf) FreeCompiledFile(cf);
 			FreeMemory(wc);
 			return NULL;
 		} //end if
 	} //end for
+	//store the compiled weapon config
+	if (cf)
+	{
+		WriteCompiledWeaponConfig(cf, wc);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	if (!wc->numweapons) botimport.Print(PRT_WARNING, "no weapon info loaded\n");
 	botimport.Print(PRT_MESSAGE, "loaded %s\n", path);
 	return wc;
@@ -354,6 +442,8 @@ void BotFreeWeaponWeights(int weaponstate)
 	if (!ws) return;
 	if (ws->weaponweightconfig) FreeWeightConfig(ws->weaponweightconfig);
 	if (ws->weaponweightindex) FreeMemory(ws->weaponweightindex);
+	ws->weaponweightconfig = NULL;
+	ws->weaponweightindex = NULL;
 } //end of the function BotFreeWeaponWeights
 //===========================================================================
 //
@@ -35,6 +35,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "l_utils.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_compiled.h"
 #include "l_struct.h"
 #include "l_libvar.h"
 #include "aasfile.h"
@@ -48,7 +49,18 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define EVALUATERECURSIVELY
 
 #define MAX_WEIGHT_FILES			128
-weightconfig_t	*weightFileList[MAX_WEIGHT_FILES];
+
+//weight config shared by the weight states that loaded the file
+typedef struct weightfile_s
+{
+	char filename[MAX_QPATH];
+	weightconfig_t *config;
+	int refcount;						//number of weight states using the config
+	int datasize;						//size and crc of the compiled config
+	unsigned short datacrc;
+} weightfile_t;
+
+weightfile_t	*weightFileList[MAX_WEIGHT_FILES];
 
 //===========================================================================
 //
@@ -146,9 +158,38 @@ void FreeWeightConfig2(weightconfig_t *config)
 // Returns:				-
 // Changes Globals:		-
 //===========================================================================
+void FreeWeightFile(int n)
+{
+	int i;
+	weightconfig_t *config;
+
+	config = weightFileList[n]->config;
+	FreeMemory(weightFileList[n]);
+	weightFileList[n] = NULL;
+	//the config can also be shared under another file name
+	for (i = 0; i < MAX_WEIGHT_FILES; i++)
+	{
+		if (weightFileList[i] && weightFileList[i]->config == config) return;
+	} //end for
+	FreeWeightConfig2(config);
+} //end of the function FreeWeightFile
+//===========================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
 void FreeWeightConfig(weightconfig_t *config)
 {
-	if (!LibVarGetValue("bot_reloadcharacters")) return;
+	int n;
+
+	for (n = 0; n < MAX_WEIGHT_FILES; n++)
+	{
+		if (!weightFileList[n] || weightFileList[n]->config != config) continue;
+		//a shared config is freed when the last weight state using it is gone
+		if (--weightFileList[n]->refcount <= 0) FreeWeightFile(n);
+		return;
+	} //end for
 	FreeWeightConfig2(config);
 } //end of the function FreeWeightConfig
 //===========================================================================
@@ -282,6 +323,150 @@ fuzzyseperator_t *ReadFuzzySeperators_r(source_t *source)
 // Returns:					-
 // Changes Globals:		-
 //===========================================================================
+void WriteCompiledFuzzySeperators_r(compiledfile_t *cf, fuzzyseperator_t *fs)
+{
+	for (; fs; fs = fs->next)
+	{
+		CF_WriteInt(cf, qtrue);
+		CF_WriteInt(cf, fs->index);
+		CF_WriteInt(cf, fs->value);
+		CF_WriteInt(cf, fs->type);
+		CF_WriteFloat(cf, fs->weight);
+		CF_WriteFloat(cf, fs->minweight);
+		CF_WriteFloat(cf, fs->maxweight);
+		WriteCompiledFuzzySeperators_r(cf, fs->child);
+	} //end for
+	CF_WriteInt(cf, qfalse);
+} //end of the function WriteCompiledFuzzySeperators_r
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+fuzzyseperator_t *ReadCompiledFuzzySeperators_r(compiledfile_t *cf, int depth)
+{
+	fuzzyseperator_t *fs, *lastfs, *firstfs;
+
+	firstfs = NULL;
+	lastfs = NULL;
+	//the switches in a weight config are never nested this deep
+	if (depth > 64) cf->error = qtrue;
+	while(!cf->error && CF_ReadInt(cf))
+	{
+		fs = (fuzzyseperator_t *) GetClearedMemory(sizeof(fuzzyseperator_t));
+		if (lastfs) lastfs->next = fs;
+		else firstfs = fs;
+		lastfs = fs;
+		fs->index = CF_ReadInt(cf);
+		fs->value = CF_ReadInt(cf);
+		fs->type = CF_ReadInt(cf);
+		fs->weight = CF_ReadFloat(cf);
+		fs->minweight = CF_ReadFloat(cf);
+		fs->maxweight = CF_ReadFloat(cf);
+		fs->child = ReadCompiledFuzzySeperators_r(cf, depth + 1);
+	} //end while
+	return firstfs;
+} //end of the function ReadCompiledFuzzySeperators_r
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void WriteCompiledWeightConfig(compiledfile_t *cf, weightconfig_t *config)
+{
+	int i;
+
+	CF_WriteInt(cf, config->numweights);
+	for (i = 0; i < config->numweights; i++)
+	{
+		CF_WriteString(cf, config->weights[i].name);
+		WriteCompiledFuzzySeperators_r(cf, config->weights[i].firstseperator);
+	} //end for
+} //end of the function WriteCompiledWeightConfig
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+weightconfig_t *ReadCompiledWeightConfig(compiledfile_t *cf, char *filename)
+{
+	int numweights;
+	char *name;
+	weightconfig_t *config;
+
+	numweights = CF_ReadInt(cf);
+	if (cf->error || numweights < 0 || numweights > MAX_WEIGHTS) return NULL;
+	config = (weightconfig_t *) GetClearedMemory(sizeof(weightconfig_t));
+	Q_strncpyz(config->filename, filename, sizeof(config->filename));
+	while(config->numweights < numweights && !cf->error)
+	{
+		name = CF_ReadString(cf);
+		if (!name) name = "";
+		config->weights[config->numweights].name = (char *) GetClearedMemory(strlen(name) + 1);
+		strcpy(config->weights[config->numweights].name, name);
+		config->weights[config->numweights].firstseperator = ReadCompiledFuzzySeperators_r(cf, 0);
+		if (!config->weights[config->numweights].firstseperator) cf->error = qtrue;
+		config->numweights++;
+	} //end while
+	if (cf->error)
+	{
+		FreeWeightConfig2(config);
+		return NULL;
+	} //end if
+	return config;
+} //end of the function ReadCompiledWeightConfig
+//===========================================================================
+// stores the config in the weight file list, when a config with the same
+// contents is already loaded that one is shared and the new one freed
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+weightconfig_t *ShareWeightConfig(weightconfig_t *config, char *filename, int avail)
+{
+	int n;
+	weightfile_t *wf;
+	compiledfile_t *contents, *othercontents;
+
+	contents = CreateCompiledData(CF_WEIGHTCONFIG);
+	WriteCompiledWeightConfig(contents, config);
+	wf = (weightfile_t *) GetClearedMemory(sizeof(weightfile_t));
+	Q_strncpyz(wf->filename, filename, sizeof(wf->filename));
+	wf->config = config;
+	wf->refcount = 1;
+	wf->datasize = contents->size;
+	wf->datacrc = CompiledDataCRC(contents);
+	for (n = 0; n < MAX_WEIGHT_FILES; n++)
+	{
+		if (!weightFileList[n]) continue;
+		if (weightFileList[n]->datasize != wf->datasize ||
+			weightFileList[n]->datacrc != wf->datacrc) continue;
+		othercontents = CreateCompiledData(CF_WEIGHTCONFIG);
+		WriteCompiledWeightConfig(othercontents, weightFileList[n]->config);
+		if (CompiledDataEqual(contents, othercontents))
+		{
+			botimport.Print(PRT_MESSAGE, "sharing %s with %s\n", filename, weightFileList[n]->filename);
+			FreeWeightConfig2(config);
+			wf->config = weightFileList[n]->config;
+			FreeCompiledFile(othercontents);
+			break;
+		} //end if
+		FreeCompiledFile(othercontents);
+	} //end for
+	FreeCompiledFile(contents);
+	weightFileList[avail] = wf;
+	return wf->config;
+} //end of the function ShareWeightConfig
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
 weightconfig_t *ReadWeightConfig(char *filename)
 {
 	int newindent, avail = 0, n;
@@ -289,6 +474,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	source_t *source;
 	fuzzyseperator_t *fs;
 	weightconfig_t *config = NULL;
+	compiledfile_t *cf;
 #ifdef DEBUG
 	int starttime;
 
@@ -300,8 +486,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 		avail = -1;
 		for( n = 0; n < MAX_WEIGHT_FILES; n++ )
 		{
-			config = weightFileList[n];
-			if( !config )
+			if( !weightFileList[n] )
 			{
 				if( avail == -1 )
 				{
@@ -309,10 +494,11 @@ weightconfig_t *ReadWeightConfig(char *filename)
 				} //end if
 				continue;
 			} //end if
-			if( strcmp( filename, config->filename ) == 0 )
+			if( strcmp( filename, weightFileList[n]->filename ) == 0 )
 			{
 				//botimport.Print( PRT_MESSAGE, "retained %s\n", filename );
-				return config;
+				weightFileList[n]->refcount++;
+				return weightFileList[n]->config;
 			} //end if
 		} //end for
 
@@ -324,6 +510,21 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	} //end if
 
 	PC_SetBaseFolder(BOTFILESBASEFOLDER);
+	cf = LoadCompiledFile(filename, NULL, CF_WEIGHTCONFIG);
+	if (cf)
+	{
+		config = ReadCompiledWeightConfig(cf, filename);
+		FreeCompiledFile(cf);
+		if (config)
+		{
+			botimport.Print(PRT_MESSAGE, "loaded %s\n", filename);
+			if (!LibVarGetValue("bot_reloadcharacters"))
+			{
+				config = ShareWeightConfig(config, filename, avail);
+			} //end if
+			return config;
+		} //end if
+	} //end if
 	source = LoadSourceFile(filename);
 	if (!source)
 	{
@@ -423,6 +624,14 @@ weightconfig_t *ReadWeightConfig(char *filename)
 			return NULL;
 		} //end else
 	} //end while
+	//store the compiled weights
+	cf = CreateCompiledFile(source, NULL, CF_WEIGHTCONFIG);
+	if (cf)
+	{
+		WriteCompiledWeightConfig(cf, config);
+		WriteCompiledFile(cf);
+		FreeCompiledFile(cf);
+	} //end if
 	//free the source at the end of a pass
 	FreeSource(source);
 	//if the file was located in a pak file
@@ -436,7 +645,7 @@ weightconfig_t *ReadWeightConfig(char *filename)
 	//
 	if (!LibVarGetValue("bot_reloadcharacters"))
 	{
-		weightFileList[avail] = config;
+		config = ShareWeightConfig(config, filename, avail);
 	} //end if
 	//
 	return config;
@@ -917,8 +1126,7 @@ void BotShutdownWeights(void)
 	{
 		if (weightFileList[i])
 		{
-			FreeWeightConfig2(weightFileList[i]);
-			weightFileList[i] = NULL;
+			FreeWeightFile(i);
 		} //end if
 	} //end for
 } //end of the function BotShutdownWeights
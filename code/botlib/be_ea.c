@@ -39,9 +39,78 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "be_ea.h"
 
 #define MAX_USERMOVE				400
+//room for the client commands of one bot between two EA_GetInput calls
+#define MAX_EACOMMANDBUFFER			2048
 
 bot_input_t *botinputs;
 
+//client commands queued by the bots, each null terminated
+typedef struct ea_commands_s
+{
+	int thinking;			//between EA_ResetInput and EA_GetInput
+	int size;
+	char buffer[MAX_EACOMMANDBUFFER];
+} ea_commands_t;
+
+ea_commands_t *eacommands;
+
+//===========================================================================
+// executes the client commands the bot queued, in order
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void EA_FlushCommands(int client)
+{
+	ea_commands_t commands;
+	char *ptr;
+
+	if (!eacommands[client].size) return;
+	//a command could make the bot queue new ones
+	Com_Memcpy(&commands, &eacommands[client], sizeof(ea_commands_t));
+	eacommands[client].size = 0;
+	for (ptr = commands.buffer; ptr < commands.buffer + commands.size; ptr += strlen(ptr) + 1)
+	{
+		botimport.BotClientCommand(client, ptr);
+	} //end for
+} //end of the function EA_FlushCommands
+//===========================================================================
+// client commands aren't executed while the bot thinks but when its input
+// is collected, so every bot thinks against the same server state and the
+// commands of all bots are applied one after the other afterwards, outside
+// of a think, like the chat of a bot leaving the game, they're executed
+// right away
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+static void EA_QueueCommand(int client, char *command)
+{
+	ea_commands_t *commands;
+	int length;
+
+	commands = &eacommands[client];
+	if (!commands->thinking)
+	{
+		botimport.BotClientCommand(client, command);
+		return;
+	} //end if
+	length = strlen(command) + 1;
+	if (commands->size + length > MAX_EACOMMANDBUFFER)
+	{
+		EA_FlushCommands(client);
+		if (length > MAX_EACOMMANDBUFFER)
+		{
+			botimport.BotClientCommand(client, command);
+			return;
+		} //end if
+	} //end if
+	Com_Memcpy(commands->buffer + commands->size, command, length);
+	commands->size += length;
+} //end of the function EA_QueueCommand
+
 //===========================================================================
 //
 // Parameter:				-
@@ -50,7 +119,7 @@ bot_input_t *botinputs;
 //===========================================================================
 void EA_Say(int client, char *str)
 {
-	botimport.BotClientCommand(client, va("say %s", str) );
+	EA_QueueCommand(client, va("say %s", str) );
 } //end of the function EA_Say
 //===========================================================================
 //
@@ -60,7 +129,7 @@ void EA_Say(int client, char *str)
 //===========================================================================
 void EA_SayTeam(int client, char *str)
 {
-	botimport.BotClientCommand(client, va("say_team %s", str));
+	EA_QueueCommand(client, va("say_team %s", str));
 } //end of the function EA_SayTeam
 //===========================================================================
 //
@@ -70,7 +139,7 @@ void EA_SayTeam(int client, char *str)
 //===========================================================================
 void EA_Tell(int client, int clientto, char *str)
 {
-	botimport.BotClientCommand(client, va("tell %d, %s", clientto, str));
+	EA_QueueCommand(client, va("tell %d, %s", clientto, str));
 } //end of the function EA_SayTeam
 //===========================================================================
 //
@@ -80,7 +149,7 @@ void EA_Tell(int client, int clientto, char *str)
 //===========================================================================
 void EA_UseItem(int client, char *it)
 {
-	botimport.BotClientCommand(client, va("use %s", it));
+	EA_QueueCommand(client, va("use %s", it));
 } //end of the function EA_UseItem
 //===========================================================================
 //
@@ -90,7 +159,7 @@ void EA_UseItem(int client, char *it)
 //===========================================================================
 void EA_DropItem(int client, char *it)
 {
-	botimport.BotClientCommand(client, va("drop %s", it));
+	EA_QueueCommand(client, va("drop %s", it));
 } //end of the function EA_DropItem
 //===========================================================================
 //
@@ -100,7 +169,7 @@ void EA_DropItem(int client, char *it)
 //===========================================================================
 void EA_UseInv(int client, char *inv)
 {
-	botimport.BotClientCommand(client, va("invuse %s", inv));
+	EA_QueueCommand(client, va("invuse %s", inv));
 } //end of the function EA_UseInv
 //===========================================================================
 //
@@ -110,7 +179,7 @@ void EA_UseInv(int client, char *inv)
 //===========================================================================
 void EA_DropInv(int client, char *inv)
 {
-	botimport.BotClientCommand(client, va("invdrop %s", inv));
+	EA_QueueCommand(client, va("invdrop %s", inv));
 } //end of the function EA_DropInv
 //===========================================================================
 //
@@ -134,7 +203,7 @@ void EA_Gesture(int client)
 //===========================================================================
 void EA_Command(int client, char *command)
 {
-	botimport.BotClientCommand(client, command);
+	EA_QueueCommand(client, command);
 } //end of the function EA_Command
 //===========================================================================
 //
@@ -425,6 +494,9 @@ void EA_GetInput(int client, float thinktime, bot_input_t *input)
 {
 	bot_input_t *bi;
 
+	//apply the commands from the last think
+	EA_FlushCommands(client);
+	eacommands[client].thinking = qfalse;
 	bi = &botinputs[client];
 	bi->thinktime = thinktime;
 	Com_Memcpy(input, bi, sizeof(bot_input_t));
@@ -448,8 +520,24 @@ void EA_ResetInput(int client)
 	jumped = bi->actionflags & ACTION_JUMP;
 	bi->actionflags = 0;
 	if (jumped) bi->actionflags |= ACTION_JUMPEDLASTFRAME;
+	//the bot starts thinking, queue its commands until its input is collected
+	eacommands[client].thinking = qtrue;
 } //end of the function EA_ResetInput
 //===========================================================================
+// drops the commands of a bot client that is set up or freed, so they
+// can't end up being executed for the next bot in the same client slot
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//===========================================================================
+void EA_ClearCommands(int client)
+{
+	if (!eacommands) return;
+	eacommands[client].thinking = qfalse;
+	eacommands[client].size = 0;
+} //end of the function EA_ClearCommands
+//===========================================================================
 //
 // Parameter:			-
 // Returns:				-
@@ -460,6 +548,8 @@ int EA_Setup(void)
 	//initialize the bot inputs
 	botinputs = (bot_input_t *) GetClearedHunkMemory(
 									botlibglobals.maxclients * sizeof(bot_input_t));
+	eacommands = (ea_commands_t *) GetClearedHunkMemory(
+									botlibglobals.maxclients * sizeof(ea_commands_t));
 	return BLERR_NOERROR;
 } //end of the function EA_Setup
 //===========================================================================
@@ -472,4 +562,6 @@ void EA_Shutdown(void)
 {
 	FreeMemory(botinputs);
 	botinputs = NULL;
+	FreeMemory(eacommands);
+	eacommands = NULL;
 } //end of the function EA_Shutdown
@@ -61,6 +61,7 @@ void EA_View(int client, vec3_t viewangles);
 void EA_EndRegular(int client, float thinktime);
 void EA_GetInput(int client, float thinktime, bot_input_t *input);
 void EA_ResetInput(int client);
+void EA_ClearCommands(int client);
 //setup and shutdown routines
 int EA_Setup(void);
 void EA_Shutdown(void);
@@ -739,6 +739,7 @@ static void Init_EA_Export( ea_export_t *ea ) {
 	ea->EA_GetInput = EA_GetInput;
 	ea->EA_EndRegular = EA_EndRegular;
 	ea->EA_ResetInput = EA_ResetInput;
+	ea->EA_ClearCommands = EA_ClearCommands;
 }
 
 
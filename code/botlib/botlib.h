@@ -295,6 +295,7 @@ typedef struct ea_export_s
 	void	(*EA_EndRegular)(int client, float thinktime);
 	void	(*EA_GetInput)(int client, float thinktime, bot_input_t *input);
 	void	(*EA_ResetInput)(int client);
+	void	(*EA_ClearCommands)(int client);
 } ea_export_t;
 
 typedef struct ai_export_s
@@ -485,6 +486,7 @@ name:						default:			module(s):			description:
 
 "max_aaslinks"				"4096"				be_aas_sample.c		maximum links in the AAS
 "max_routingcache"			"4096"				be_aas_route.c		maximum routing cache size in KB
+"saveroutetable"			"0"					be_aas_main.c		calculate and save the route tables
 "forceclustering"			"0"					be_aas_main.c		force recalculation of clusters
 "forcereachability"			"0"					be_aas_main.c		force recalculation of reachabilities
 "forcewrite"				"0"					be_aas_main.c		force writing of aas file
@@ -493,6 +495,7 @@ name:						default:			module(s):			description:
 "bot_visualizejumppads"		"0"					be_aas_reach.c		visualize jump pads
 
 "bot_reloadcharacters"		"0"					-					reload bot character files
+"compiledscripts"			"1"					l_compiled.c		load and save compiled bot script files
 "ai_gametype"				"0"					be_ai_goal.c		game type
 "droppedweight"				"1000"				be_ai_goal.c		additional dropped item weight
 "weapindex_rocketlauncher"	"5"					be_ai_move.c		rl weapon index for rocket jumping
@@ -0,0 +1,427 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+/*****************************************************************************
+ * name:		l_compiled.c
+ *
+ * desc:		compiled bot script files
+ *
+ * $Archive: /MissionPack/code/botlib/l_compiled.c $
+ *
+ *****************************************************************************/
+
+#include "../qcommon/q_shared.h"
+#include "l_memory.h"
+#include "l_script.h"
+#include "l_precomp.h"
+#include "l_libvar.h"
+#include "l_crc.h"
+#include "l_compiled.h"
+#include "aasfile.h"
+#include "botlib.h"
+#include "be_aas.h"
+#include "be_aas_funcs.h"
+#include "be_interface.h"
+
+//the compiled files go under the home path next to the other written files
+//instead of into the bot files folder that is usually in a pak file
+//
+// a compiled file only stores the final data a script file loaded into
+// so loading it skips the pre compiler and the script parser, the crc and
+// length of the script file and every file it included are stored with it
+// and the compiled file is ignored as soon as one of them changes
+//
+// the same compiled form kept in memory identifies loaded data by its
+// contents, so identical data loaded from different files can be shared
+
+#define MAX_COMPILEDSOURCEFILES		64
+//memory blocks are never more than this many times the size of the compiled data
+#define MAX_COMPILEDBLOCKSCALE		16
+
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CF_CompiledFileName(char *filename, char *name, char *path)
+{
+	char base[MAX_QPATH];
+
+	COM_StripExtension(filename, base, sizeof(base));
+	if (name && *name)
+	{
+		Com_sprintf(path, MAX_QPATH, "%s/%s/%s_%s%s", COMPILEDFOLDER,
+						BOTFILESBASEFOLDER, base, name, COMPILEDEXTENSION);
+	} //end if
+	else
+	{
+		Com_sprintf(path, MAX_QPATH, "%s/%s/%s%s", COMPILEDFOLDER,
+						BOTFILESBASEFOLDER, base, COMPILEDEXTENSION);
+	} //end else
+} //end of the function CF_CompiledFileName
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int CF_ScriptFileChanged(compiledsourcefile_t *file)
+{
+	script_t *script;
+	int changed;
+
+	file->filename[MAX_QPATH-1] = '\0';
+	script = LoadScriptFile(file->filename);
+	if (!script) return qtrue;
+	changed = script->length != file->length ||
+		CRC_ProcessString((unsigned char *) script->buffer, script->length) != file->crc;
+	FreeScript(script);
+	return changed;
+} //end of the function CF_ScriptFileChanged
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+compiledfile_t *LoadCompiledFile(char *filename, char *name, int type)
+{
+	int length, i;
+	fileHandle_t fp;
+	char path[MAX_QPATH];
+	compiledheader_t header;
+	compiledfile_t *cf;
+
+	if (!LibVarValue("compiledscripts", "1")) return NULL;
+	CF_CompiledFileName(filename, name, path);
+	length = botimport.FS_FOpenFile(path, &fp, FS_READ);
+	if (!fp) return NULL;
+	if (length < (int) sizeof(compiledheader_t))
+	{
+		botimport.FS_FCloseFile(fp);
+		return NULL;
+	} //end if
+	botimport.FS_Read(&header, sizeof(compiledheader_t), fp);
+	if (header.ident != COMPILEDID || header.version != COMPILEDVERSION ||
+		header.type != type || header.definescrc != PC_GlobalDefinesCRC() ||
+		header.numfiles <= 0 || header.numfiles > MAX_COMPILEDSOURCEFILES ||
+		header.datasize < 0 || header.datasize > length ||
+		length != sizeof(compiledheader_t) +
+				header.numfiles * sizeof(compiledsourcefile_t) + header.datasize)
+	{
+		botimport.FS_FCloseFile(fp);
+		return NULL;
+	} //end if
+	cf = (compiledfile_t *) GetClearedMemory(sizeof(compiledfile_t) +
+						header.numfiles * sizeof(compiledsourcefile_t));
+	Q_strncpyz(cf->filename, path, sizeof(cf->filename));
+	cf->type = header.type;
+	cf->numfiles = header.numfiles;
+	cf->files = (compiledsourcefile_t *) ((char *) cf + sizeof(compiledfile_t));
+	cf->data = (char *) GetMemory(header.datasize + 1);
+	cf->size = header.datasize;
+	cf->maxsize = header.datasize + 1;
+	botimport.FS_Read(cf->files, cf->numfiles * sizeof(compiledsourcefile_t), fp);
+	botimport.FS_Read(cf->data, cf->size, fp);
+	botimport.FS_FCloseFile(fp);
+	//the first file is the script itself, the others are its includes
+	cf->files[0].filename[MAX_QPATH-1] = '\0';
+	if (CompiledDataCRC(cf) != header.datacrc ||
+		Q_stricmp(cf->files[0].filename, filename))
+	{
+		FreeCompiledFile(cf);
+		return NULL;
+	} //end if
+	for (i = 0; i < cf->numfiles; i++)
+	{
+		if (CF_ScriptFileChanged(&cf->files[i]))
+		{
+			FreeCompiledFile(cf);
+			return NULL;
+		} //end if
+	} //end for
+	return cf;
+} //end of the function LoadCompiledFile
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+compiledfile_t *CreateCompiledFile(source_t *source, char *name, int type)
+{
+	int numfiles;
+	sourcefile_t *file;
+	compiledfile_t *cf;
+
+	if (!LibVarValue("compiledscripts", "1")) return NULL;
+	//sources loaded from memory can't be compiled
+	if (!source->files || Q_stricmp(source->files->filename, source->filename)) return NULL;
+	numfiles = 0;
+	for (file = source->files; file; file = file->next) numfiles++;
+	if (numfiles > MAX_COMPILEDSOURCEFILES) return NULL;
+	cf = (compiledfile_t *) GetClearedMemory(sizeof(compiledfile_t) +
+						numfiles * sizeof(compiledsourcefile_t));
+	CF_CompiledFileName(source->filename, name, cf->filename);
+	cf->type = type;
+	cf->numfiles = numfiles;
+	cf->files = (compiledsourcefile_t *) ((char *) cf + sizeof(compiledfile_t));
+	for (numfiles = 0, file = source->files; file; file = file->next, numfiles++)
+	{
+		Q_strncpyz(cf->files[numfiles].filename, file->filename, MAX_QPATH);
+		cf->files[numfiles].length = file->length;
+		cf->files[numfiles].crc = file->crc;
+	} //end for
+	return cf;
+} //end of the function CreateCompiledFile
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+compiledfile_t *CreateCompiledData(int type)
+{
+	compiledfile_t *cf;
+
+	cf = (compiledfile_t *) GetClearedMemory(sizeof(compiledfile_t));
+	cf->type = type;
+	return cf;
+} //end of the function CreateCompiledData
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+unsigned short CompiledDataCRC(compiledfile_t *cf)
+{
+	return CRC_ProcessString((unsigned char *) cf->data, cf->size);
+} //end of the function CompiledDataCRC
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int CompiledDataEqual(compiledfile_t *cf1, compiledfile_t *cf2)
+{
+	if (cf1->type != cf2->type || cf1->size != cf2->size) return qfalse;
+	if (!cf1->size) return qtrue;
+	return !memcmp(cf1->data, cf2->data, cf1->size);
+} //end of the function CompiledDataEqual
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void WriteCompiledFile(compiledfile_t *cf)
+{
+	fileHandle_t fp;
+	compiledheader_t header;
+
+	botimport.FS_FOpenFile(cf->filename, &fp, FS_WRITE);
+	if (!fp)
+	{
+		botimport.Print(PRT_WARNING, "couldn't write %s\n", cf->filename);
+		return;
+	} //end if
+	header.ident = COMPILEDID;
+	header.version = COMPILEDVERSION;
+	header.type = cf->type;
+	header.definescrc = PC_GlobalDefinesCRC();
+	header.numfiles = cf->numfiles;
+	header.datasize = cf->size;
+	header.datacrc = CompiledDataCRC(cf);
+	botimport.FS_Write(&header, sizeof(compiledheader_t), fp);
+	botimport.FS_Write(cf->files, cf->numfiles * sizeof(compiledsourcefile_t), fp);
+	botimport.FS_Write(cf->data, cf->size, fp);
+	botimport.FS_FCloseFile(fp);
+} //end of the function WriteCompiledFile
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void FreeCompiledFile(compiledfile_t *cf)
+{
+	if (cf->data) FreeMemory(cf->data);
+	FreeMemory(cf);
+} //end of the function FreeCompiledFile
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CF_WriteData(compiledfile_t *cf, void *data, int size)
+{
+	char *newdata;
+	int newsize;
+
+	if (cf->size + size > cf->maxsize)
+	{
+		newsize = cf->maxsize * 2;
+		if (newsize < cf->size + size) newsize = cf->size + size;
+		if (newsize < 4096) newsize = 4096;
+		newdata = (char *) GetMemory(newsize);
+		if (cf->data)
+		{
+			Com_Memcpy(newdata, cf->data, cf->size);
+			FreeMemory(cf->data);
+		} //end if
+		cf->data = newdata;
+		cf->maxsize = newsize;
+	} //end if
+	Com_Memcpy(cf->data + cf->size, data, size);
+	cf->size += size;
+} //end of the function CF_WriteData
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CF_WriteInt(compiledfile_t *cf, int value)
+{
+	CF_WriteData(cf, &value, sizeof(int));
+} //end of the function CF_WriteInt
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CF_WriteFloat(compiledfile_t *cf, float value)
+{
+	CF_WriteData(cf, &value, sizeof(float));
+} //end of the function CF_WriteFloat
+//===========================================================================
+// a NULL string reads back as NULL
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CF_WriteString(compiledfile_t *cf, char *string)
+{
+	int length;
+
+	if (!string)
+	{
+		CF_WriteInt(cf, -1);
+		return;
+	} //end if
+	length = strlen(string);
+	CF_WriteInt(cf, length);
+	CF_WriteData(cf, string, length + 1);
+} //end of the function CF_WriteString
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+void CF_ReadData(compiledfile_t *cf, void *data, int size)
+{
+	if (cf->error || size < 0 || size > cf->size - cf->offset)
+	{
+		cf->error = qtrue;
+		if (size > 0) Com_Memset(data, 0, size);
+		return;
+	} //end if
+	Com_Memcpy(data, cf->data + cf->offset, size);
+	cf->offset += size;
+} //end of the function CF_ReadData
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int CF_ReadInt(compiledfile_t *cf)
+{
+	int value;
+
+	CF_ReadData(cf, &value, sizeof(int));
+	return value;
+} //end of the function CF_ReadInt
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+int CF_ReadBlockSize(compiledfile_t *cf)
+{
+	int size;
+
+	size = CF_ReadInt(cf);
+	if (cf->error) return 0;
+	if (size <= 0 || size / MAX_COMPILEDBLOCKSCALE > cf->size)
+	{
+		cf->error = qtrue;
+		return 0;
+	} //end if
+	return size;
+} //end of the function CF_ReadBlockSize
+//===========================================================================
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+float CF_ReadFloat(compiledfile_t *cf)
+{
+	float value;
+
+	CF_ReadData(cf, &value, sizeof(float));
+	return value;
+} //end of the function CF_ReadFloat
+//===========================================================================
+// returns a pointer into the compiled data, an empty string on errors
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//===========================================================================
+char *CF_ReadString(compiledfile_t *cf)
+{
+	int length;
+	char *string;
+
+	length = CF_ReadInt(cf);
+	if (cf->error) return "";
+	if (length == -1) return NULL;
+	if (length < 0 || length >= cf->size - cf->offset ||
+		cf->data[cf->offset + length] != '\0')
+	{
+		cf->error = qtrue;
+		return "";
+	} //end if
+	string = cf->data + cf->offset;
+	cf->offset += length + 1;
+	return string;
+} //end of the function CF_ReadString
@@ -0,0 +1,109 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+
+/*****************************************************************************
+ * name:		l_compiled.h
+ *
+ * desc:		compiled bot script files
+ *
+ * $Archive: /source/code/botlib/l_compiled.h $
+ *
+ *****************************************************************************/
+
+#define COMPILEDID				(('F'<<24)+('C'<<16)+('B'<<8)+'B')
+#define COMPILEDVERSION			1
+#define COMPILEDFOLDER			"cache"
+#define COMPILEDEXTENSION		".bcf"
+
+//types of compiled script files
+#define CF_CHARACTER			1		//bot character with one skill
+#define CF_INITIALCHAT			2		//initial chats of one bot
+#define CF_REPLYCHAT			3		//reply chats
+#define CF_MATCHTEMPLATES		4		//match templates
+#define CF_SYNONYMS				5		//synonyms
+#define CF_RANDOMSTRINGS		6		//random strings
+#define CF_WEIGHTCONFIG			7		//fuzzy weights
+#define CF_ITEMCONFIG			8		//item info
+#define CF_WEAPONCONFIG			9		//weapon and projectile info
+
+//compiled script file header
+typedef struct compiledheader_s
+{
+	int ident;
+	int version;
+	int type;								//CF_ type of the compiled data
+	int definescrc;							//crc of the global defines
+	int numfiles;							//number of script files compiled
+	int datasize;							//size of the compiled data
+	int datacrc;							//crc of the compiled data
+} compiledheader_t;
+
+//script file the data was compiled from, follows the header
+typedef struct compiledsourcefile_s
+{
+	char filename[MAX_QPATH];
+	int length;
+	int crc;
+} compiledsourcefile_t;
+
+//compiled script file
+typedef struct compiledfile_s
+{
+	char filename[MAX_QPATH];				//name of the compiled file
+	int type;								//CF_ type of the compiled data
+	int numfiles;							//number of script files compiled
+	compiledsourcefile_t *files;			//script files compiled
+	char *data;								//compiled data
+	int size;								//size of the compiled data
+	int maxsize;							//allocated size of the data
+	int offset;								//read offset in the data
+	int error;								//true if the data is too short
+} compiledfile_t;
+
+//loads the compiled form of a script file, name distinguishes the compiled
+//files of a script that is loaded in several ways, NULL if there is no
+//compiled file or when it is older than the script or one of its includes
+compiledfile_t *LoadCompiledFile(char *filename, char *name, int type);
+//starts compiling the data read from the source, NULL when not compiling
+compiledfile_t *CreateCompiledFile(source_t *source, char *name, int type);
+//starts compiling data that is only kept in memory, used to compare loaded data
+compiledfile_t *CreateCompiledData(int type);
+//crc of the compiled data
+unsigned short CompiledDataCRC(compiledfile_t *cf);
+//returns true if both hold the same compiled data
+int CompiledDataEqual(compiledfile_t *cf1, compiledfile_t *cf2);
+//writes the compiled file
+void WriteCompiledFile(compiledfile_t *cf);
+//frees the compiled file
+void FreeCompiledFile(compiledfile_t *cf);
+//write compiled data
+void CF_WriteInt(compiledfile_t *cf, int value);
+void CF_WriteFloat(compiledfile_t *cf, float value);
+void CF_WriteString(compiledfile_t *cf, char *string);
+void CF_WriteData(compiledfile_t *cf, void *data, int size);
+//read compiled data, cf->error is set when reading beyond the end
+int CF_ReadInt(compiledfile_t *cf);
+//reads the size of a memory block the data is placed in, 0 if invalid
+int CF_ReadBlockSize(compiledfile_t *cf);
+float CF_ReadFloat(compiledfile_t *cf);
+char *CF_ReadString(compiledfile_t *cf);
+void CF_ReadData(compiledfile_t *cf, void *data, int size);
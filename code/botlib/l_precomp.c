@@ -59,6 +59,7 @@ typedef enum {qfalse, qtrue}	qboolean;
 #include "l_memory.h"
 #include "l_script.h"
 #include "l_precomp.h"
+#include "l_crc.h"
 #include "l_log.h"
 #endif //BOTLIB
 
@@ -216,6 +217,24 @@ void PC_PopIndent(source_t *source, int *type, int *skip)
 // Returns:					-
 // Changes Globals:		-
 //============================================================================
+void PC_AddSourceFile(source_t *source, script_t *script)
+{
+	sourcefile_t *file, **last;
+
+	file = (sourcefile_t *) GetClearedMemory(sizeof(sourcefile_t));
+	Q_strncpyz(file->filename, script->filename, sizeof(file->filename));
+	file->length = script->length;
+	file->crc = CRC_ProcessString((unsigned char *) script->buffer, script->length);
+	//keep the files in load order
+	for (last = &source->files; *last; last = &(*last)->next) ;
+	*last = file;
+} //end of the function PC_AddSourceFile
+//============================================================================
+//
+// Parameter:			-
+// Returns:				-
+// Changes Globals:		-
+//============================================================================
 void PC_PushScript(source_t *source, script_t *script)
 {
 	script_t *s;
@@ -231,6 +250,7 @@ void PC_PushScript(source_t *source, script_t *script)
 	//push the script on the script stack
 	script->next = source->scriptstack;
 	source->scriptstack = script;
+	PC_AddSourceFile(source, script);
 } //end of the function PC_PushScript
 //============================================================================
 //
@@ -1436,6 +1456,34 @@ void PC_RemoveAllGlobalDefines(void)
 	} //end for
 } //end of the function PC_RemoveAllGlobalDefines
 //============================================================================
+// crc of the global defines, these change what a source file reads like
+//
+// Parameter:				-
+// Returns:					-
+// Changes Globals:		-
+//============================================================================
+unsigned short PC_GlobalDefinesCRC(void)
+{
+	define_t *define;
+	token_t *token;
+	unsigned short crc;
+
+	CRC_Init(&crc);
+	for (define = globaldefines; define; define = define->next)
+	{
+		CRC_ContinueProcessString(&crc, define->name, strlen(define->name) + 1);
+		for (token = define->parms; token; token = token->next)
+		{
+			CRC_ContinueProcessString(&crc, token->string, strlen(token->string) + 1);
+		} //end for
+		for (token = define->tokens; token; token = token->next)
+		{
+			CRC_ContinueProcessString(&crc, token->string, strlen(token->string) + 1);
+		} //end for
+	} //end for
+	return CRC_Value(crc);
+} //end of the function PC_GlobalDefinesCRC
+//============================================================================
 //
 // Parameter:				-
 // Returns:					-
@@ -3007,6 +3055,7 @@ source_t *LoadSourceFile(const char *filename)
 	source->defines = NULL;
 	source->indentstack = NULL;
 	source->skip = 0;
+	PC_AddSourceFile(source, script);
 
 #if DEFINEHASHING
 	source->definehash = GetClearedMemory(DEFINEHASHSIZE * sizeof(define_t *));
@@ -3059,6 +3108,7 @@ void FreeSource(source_t *source)
 	token_t *token;
 	define_t *define;
 	indent_t *indent;
+	sourcefile_t *file;
 	int i;
 
 	//PC_PrintDefineHashTable(source->definehash);
@@ -3102,6 +3152,13 @@ void FreeSource(source_t *source)
 		source->indentstack = source->indentstack->next;
 		FreeMemory(indent);
 	} //end for
+	//free the list with script files
+	while(source->files)
+	{
+		file = source->files;
+		source->files = source->files->next;
+		FreeMemory(file);
+	} //end for
 #if DEFINEHASHING
 	//
 	if (source->definehash) FreeMemory(source->definehash);
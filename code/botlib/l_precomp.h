@@ -88,6 +88,15 @@ typedef struct indent_s
 } indent_t;
 
 //source file
+//script file read into a source
+typedef struct sourcefile_s
+{
+	char filename[MAX_QPATH];				//name the file was loaded with
+	int length;								//length of the file
+	unsigned short crc;						//crc of the file contents
+	struct sourcefile_s *next;				//next file read into the source
+} sourcefile_t;
+
 typedef struct source_s
 {
 	char filename[1024];					//file name of the script
@@ -100,6 +109,7 @@ typedef struct source_s
 	indent_t *indentstack;					//stack with indents
 	int skip;								// > 0 if skipping conditional code
 	token_t token;							//last read token
+	sourcefile_t *files;					//script files read so far, in load order
 } source_t;
 
 
@@ -133,6 +143,7 @@ int PC_AddGlobalDefine(char *string);
 int PC_RemoveGlobalDefine(char *name);
 //remove all globals defines
 void PC_RemoveAllGlobalDefines(void);
+unsigned short PC_GlobalDefinesCRC(void);
 //add builtin defines
 void PC_AddBuiltinDefines(source_t *source);
 //set the source include path
@@ -71,6 +71,7 @@ int bot_interbreedmatchcount;
 vmCvar_t bot_thinktime;
 vmCvar_t bot_memorydump;
 vmCvar_t bot_saveroutingcache;
+vmCvar_t bot_saveroutetable;
 vmCvar_t bot_pause;
 vmCvar_t bot_report;
 vmCvar_t bot_testsolid;
@@ -1417,6 +1418,7 @@ int BotAIStartFrame(int time) {
 	trap_Cvar_Update(&bot_thinktime);
 	trap_Cvar_Update(&bot_memorydump);
 	trap_Cvar_Update(&bot_saveroutingcache);
+	trap_Cvar_Update(&bot_saveroutetable);
 	trap_Cvar_Update(&bot_pause);
 	trap_Cvar_Update(&bot_report);
 
@@ -1453,6 +1455,10 @@ int BotAIStartFrame(int time) {
 		trap_BotLibVarSet("saveroutingcache", "1");
 		trap_Cvar_Set("bot_saveroutingcache", "0");
 	}
+	if (bot_saveroutetable.integer) {
+		trap_BotLibVarSet("saveroutetable", "1");
+		trap_Cvar_Set("bot_saveroutetable", "0");
+	}
 	//check if bot interbreeding is activated
 	BotInterbreeding();
 	//cap the bot think time
@@ -1669,6 +1675,7 @@ int BotAISetup( int restart ) {
 	trap_Cvar_Register(&bot_thinktime, "bot_thinktime", "100", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_memorydump, "bot_memorydump", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_saveroutingcache, "bot_saveroutingcache", "0", CVAR_CHEAT);
+	trap_Cvar_Register(&bot_saveroutetable, "bot_saveroutetable", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_pause, "bot_pause", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_report, "bot_report", "0", CVAR_CHEAT);
 	trap_Cvar_Register(&bot_testsolid, "bot_testsolid", "0", CVAR_CHEAT);
@@ -230,6 +230,9 @@ typedef enum {
 	// 1.32
 	G_FS_SEEK,
 
+	G_TRACE_MANY,	// ( trace_t *results, const traceRequest_t *requests, int count, int passEntityNum, int contentmask, int capsule );
+	// not in original engines, check for it before use
+
 	BOTLIB_SETUP = 200,				// ( void );
 	BOTLIB_SHUTDOWN,				// ( void );
 	BOTLIB_LIBVAR_SET,
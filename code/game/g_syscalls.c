@@ -157,6 +157,10 @@ void trap_TraceCapsule( trace_t *results, const vec3_t start, const vec3_t mins,
 	syscall( G_TRACECAPSULE, results, start, mins, maxs, end, passEntityNum, contentmask );
 }
 
+void trap_TraceMany( trace_t *results, const traceRequest_t *requests, int count, int passEntityNum, int contentmask, qboolean capsule ) {
+	syscall( G_TRACE_MANY, results, requests, count, passEntityNum, contentmask, capsule );
+}
+
 int trap_PointContents( const vec3_t point, int passEntityNum ) {
 	return syscall( G_POINT_CONTENTS, point, passEntityNum );
 }
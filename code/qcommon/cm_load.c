@@ -22,6 +22,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 // cmodel.c -- model loading
 
 #include "cm_local.h"
+#include "cm_patch.h"
 
 #ifdef BSPC
 
@@ -48,12 +49,17 @@ void SetPlaneSignbits (cplane_t *out) {
 #define	BOX_LEAFS		2
 #define	BOX_PLANES		12
 
+// patch collide cache file: ident, version, bsp checksum, surface count
+#define	PATCH_CACHE_IDENT	(('L'<<24)+('O'<<16)+('C'<<8)+'P')		// "PCOL"
+#define	PATCH_CACHE_VERSION	1
+#define	PATCH_CACHE_HEADER	(4 * 4)
+
 #define	LL(x) x=LittleLong(x)
 
 
 clipMap_t	cm;
 int			c_pointcontents;
-int			c_traces, c_brush_traces, c_patch_traces;
+int			c_traces, c_brush_traces, c_brush_rejects, c_patch_traces;
 
 
 byte		*cmod_base;
@@ -62,6 +68,8 @@ byte		*cmod_base;
 cvar_t		*cm_noAreas;
 cvar_t		*cm_noCurves;
 cvar_t		*cm_playerCurveClip;
+cvar_t		*cm_patchCache;
+cvar_t		*cm_loadThreads;
 #endif
 
 cmodel_t	box_model;
@@ -71,6 +79,9 @@ cbrush_t	*box_brush;
 
 
 void	CM_InitBoxHull (void);
+void	CM_InitBrushPlanes (void);
+void	CM_InitFlatNodes (void);
+void	CM_InitLeafBrushBounds (void);
 void	CM_FloodAreaConnections (void);
 
 
@@ -206,6 +217,80 @@ void CMod_LoadNodes( lump_t *l ) {
 
 }
 
+/*
+=================
+CM_InitFlatNodes
+
+Renumbers the nodes depth first from the root and copies their split
+planes inline, so CM_PointLeafnum_r, CM_BoxLeafnums_r and
+CM_TraceThroughTree walk one compact array.  Node 0 stays the root.
+=================
+*/
+void CM_InitFlatNodes( void ) {
+	int			*remap, *stack;
+	int			i, j, num, child, next, depth;
+	cNode_t		*node;
+	cFlatNode_t	*out;
+	cplane_t	*plane;
+
+	remap = Hunk_AllocateTempMemory( cm.numNodes * sizeof( *remap ) );
+	// a node can be pushed once per parent before it is numbered
+	stack = Hunk_AllocateTempMemory( ( cm.numNodes * 2 + 1 ) * sizeof( *stack ) );
+
+	for ( i = 0 ; i < cm.numNodes ; i++ ) {
+		remap[i] = -1;
+		for ( j = 0 ; j < 2 ; j++ ) {
+			child = cm.nodes[i].children[j];
+			if ( child >= cm.numNodes || -1 - child >= cm.numLeafs ) {
+				Com_Error( ERR_DROP, "CM_InitFlatNodes: bad child %i on node %i", child, i );
+			}
+		}
+	}
+
+	// number the tree under the root first, then anything it can't reach,
+	// visiting the front child right after its parent
+	next = 0;
+	for ( i = 0 ; i < cm.numNodes ; i++ ) {
+		if ( remap[i] != -1 ) {
+			continue;
+		}
+		stack[0] = i;
+		depth = 1;
+		while ( depth ) {
+			num = stack[--depth];
+			if ( remap[num] != -1 ) {
+				continue;
+			}
+			remap[num] = next++;
+			node = &cm.nodes[num];
+			for ( j = 1 ; j >= 0 ; j-- ) {
+				if ( node->children[j] >= 0 && remap[node->children[j]] == -1 ) {
+					stack[depth++] = node->children[j];
+				}
+			}
+		}
+	}
+
+	cm.flatNodes = Hunk_Alloc( cm.numNodes * sizeof( *cm.flatNodes ), h_high );
+
+	for ( i = 0 ; i < cm.numNodes ; i++ ) {
+		node = &cm.nodes[i];
+		plane = node->plane;
+		out = &cm.flatNodes[remap[i]];
+
+		VectorCopy( plane->normal, out->normal );
+		out->dist = plane->dist;
+		out->type = plane->type;
+		for ( j = 0 ; j < 2 ; j++ ) {
+			child = node->children[j];
+			out->children[j] = child < 0 ? child : remap[child];
+		}
+	}
+
+	Hunk_FreeTempMemory( stack );
+	Hunk_FreeTempMemory( remap );
+}
+
 /*
 =================
 CM_BoundBrush
@@ -446,6 +531,37 @@ void CMod_LoadEntityString( lump_t *l ) {
 	Com_Memcpy (cm.entityString, cmod_base + l->fileofs, l->filelen);
 }
 
+/*
+=================
+CM_InitVisibilityWords
+
+Sets up the 64 bit word rows of CM_ClusterPVSWords.  q3map pads the
+rows to whole words already, so on little endian machines these are
+just the visibility lump.
+=================
+*/
+static void CM_InitVisibilityWords( int numRows ) {
+	int		i, j;
+	byte	*row;
+
+	cm.clusterWords = ( cm.clusterBytes + 7 ) >> 3;
+
+#ifdef Q3_LITTLE_ENDIAN
+	if ( !( cm.clusterBytes & 7 ) && !( (intptr_t)cm.visibility & 7 ) ) {
+		cm.visibilityWords = (uint64_t *)cm.visibility;
+		return;
+	}
+#endif
+
+	cm.visibilityWords = Hunk_Alloc( numRows * cm.clusterWords * sizeof( uint64_t ), h_high );
+	for ( i = 0 ; i < numRows ; i++ ) {
+		row = cm.visibility + i * cm.clusterBytes;
+		for ( j = 0 ; j < cm.clusterBytes ; j++ ) {
+			cm.visibilityWords[i * cm.clusterWords + ( j >> 3 )] |= (uint64_t)row[j] << ( ( j & 7 ) * 8 );
+		}
+	}
+}
+
 /*
 =================
 CMod_LoadVisibility
@@ -461,6 +577,7 @@ void CMod_LoadVisibility( lump_t *l ) {
 		cm.clusterBytes = ( cm.numClusters + 31 ) & ~31;
 		cm.visibility = Hunk_Alloc( cm.clusterBytes, h_high );
 		Com_Memset( cm.visibility, 255, cm.clusterBytes );
+		CM_InitVisibilityWords( 1 );
 		return;
 	}
 	buf = cmod_base + l->fileofs;
@@ -470,27 +587,213 @@ void CMod_LoadVisibility( lump_t *l ) {
 	cm.numClusters = LittleLong( ((int *)buf)[0] );
 	cm.clusterBytes = LittleLong( ((int *)buf)[1] );
 	Com_Memcpy (cm.visibility, buf + VIS_HEADER, len - VIS_HEADER );
+
+	if ( cm.numClusters < 0 || cm.clusterBytes < 0
+		|| (int64_t)cm.numClusters * cm.clusterBytes > len - VIS_HEADER ) {
+		Com_Error( ERR_DROP, "CMod_LoadVisibility: funny lump size" );
+	}
+	CM_InitVisibilityWords( cm.numClusters );
 }
 
 //==================================================================
 
 
+#ifndef BSPC
 /*
 =================
-CMod_LoadPatches
+CM_PatchCachePath
+
+The patch cache goes under the home path, next to the mod's other
+engine written files, so it is never looked up in a pak
+=================
+*/
+static void CM_PatchCachePath( const char *name, char *path, int size ) {
+	char	base[MAX_QPATH];
+
+	COM_StripExtension( name, base, sizeof( base ) );
+	Com_sprintf( path, size, "%s/cache/%s.pcol", FS_GetCurrentGameDir(), base );
+}
+
+/*
+=================
+CM_ReadPatchCache
+
+Returns the patch records of the cache for this map, or NULL if there is
+no cache or it was written for a different build of the map
 =================
 */
+static byte *CM_ReadPatchCache( const char *name, unsigned checksum, int numSurfaces, const byte **end ) {
+	char			path[MAX_QPATH];
+	fileHandle_t	f;
+	long			len;
+	byte			*buf;
+	const byte		*p;
+
+	CM_PatchCachePath( name, path, sizeof( path ) );
+	len = FS_SV_FOpenFileRead( path, &f );
+	if ( !f ) {
+		return NULL;
+	}
+	if ( len < PATCH_CACHE_HEADER ) {
+		FS_FCloseFile( f );
+		return NULL;
+	}
+
+	buf = Z_Malloc( len );
+	len = FS_Read( buf, len, f );
+	FS_FCloseFile( f );
+
+	p = buf;
+	if ( len < PATCH_CACHE_HEADER
+		|| LittleLong( ((int *)p)[0] ) != PATCH_CACHE_IDENT
+		|| LittleLong( ((int *)p)[1] ) != PATCH_CACHE_VERSION
+		|| (unsigned)LittleLong( ((int *)p)[2] ) != checksum
+		|| LittleLong( ((int *)p)[3] ) != numSurfaces ) {
+		Com_DPrintf( "Ignoring stale patch cache %s\n", path );
+		Z_Free( buf );
+		return NULL;
+	}
+
+	*end = buf + len;
+	return buf;
+}
+
+/*
+=================
+CM_WritePatchCache
+
+Saves the patch collides CMod_LoadPatches just generated
+=================
+*/
+static void CM_WritePatchCache( const char *name, unsigned checksum, dsurface_t *in, int count ) {
+	char			path[MAX_QPATH];
+	fileHandle_t	f;
+	byte			*buf, *out;
+	int				i, size;
+
+	size = PATCH_CACHE_HEADER;
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( cm.surfaces[i] ) {
+			size += 3 * 4 + CM_PatchCollideCacheSize( cm.surfaces[i]->pc );
+		}
+	}
+
+	buf = Z_Malloc( size );
+	((int *)buf)[0] = LittleLong( PATCH_CACHE_IDENT );
+	((int *)buf)[1] = LittleLong( PATCH_CACHE_VERSION );
+	((int *)buf)[2] = LittleLong( checksum );
+	((int *)buf)[3] = LittleLong( count );
+	out = buf + PATCH_CACHE_HEADER;
+
+	for ( i = 0 ; i < count ; i++, in++ ) {
+		if ( !cm.surfaces[i] ) {
+			continue;
+		}
+		((int *)out)[0] = LittleLong( i );
+		((int *)out)[1] = in->patchWidth;	// already little endian
+		((int *)out)[2] = in->patchHeight;
+		out = CM_WritePatchCollideCache( out + 3 * 4, cm.surfaces[i]->pc );
+	}
+
+	CM_PatchCachePath( name, path, sizeof( path ) );
+	f = FS_SV_FOpenFileWrite( path );
+	if ( !f ) {
+		Com_DPrintf( "Couldn't write patch cache %s\n", path );
+	} else {
+		FS_Write( buf, size, f );
+		FS_FCloseFile( f );
+	}
+
+	Z_Free( buf );
+}
+#endif
+
+typedef struct {
+	const dsurface_t	*surfaces;
+	const drawVert_t	*verts;
+	const int			*pending;		// surface numbers of the patches to generate
+	int					first;			// first pending patch of this batch
+	patchWork_t			*work;			// one per patch in the batch
+} patchJobs_t;
+
 #define	MAX_PATCH_VERTS		1024
-void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
-	drawVert_t	*dv, *dv_p;
+
+/*
+=================
+CM_GeneratePatchJob
+
+Generates one patch of a CMod_LoadPatches batch, may run on any thread
+=================
+*/
+static void CM_GeneratePatchJob( void *data, int index ) {
+	patchJobs_t			*jobs = data;
+	const dsurface_t	*in;
+	const drawVert_t	*dv_p;
+	vec3_t				points[MAX_PATCH_VERTS];
+	int					width, height;
+	int					j, c;
+
+	in = jobs->surfaces + jobs->pending[jobs->first + index];
+	width = LittleLong( in->patchWidth );
+	height = LittleLong( in->patchHeight );
+
+	// load the full drawverts onto the stack
+	c = width * height;
+	dv_p = jobs->verts + LittleLong( in->firstVert );
+	for ( j = 0 ; j < c ; j++, dv_p++ ) {
+		points[j][0] = LittleFloat( dv_p->xyz[0] );
+		points[j][1] = LittleFloat( dv_p->xyz[1] );
+		points[j][2] = LittleFloat( dv_p->xyz[2] );
+	}
+
+	CM_GeneratePatchWork( &jobs->work[index], width, height, points );
+}
+
+/*
+=================
+CM_LoadThreads
+=================
+*/
+static int CM_LoadThreads( void ) {
+#ifndef BSPC
+	if ( cm_loadThreads->integer < 0 ) {
+		return Sys_ProcessorCount();
+	}
+	if ( cm_loadThreads->integer > 1 ) {
+		return cm_loadThreads->integer;
+	}
+#endif
+	return 1;
+}
+
+/*
+=================
+CMod_LoadPatches
+
+Patch collides come from the cache when cm_patchCache is set and it
+matches the map, otherwise they are generated and the cache rewritten.
+
+Generation is the slow part of loading a map with many curves, so the
+patches left to generate are subdivided in batches spread over
+cm_loadThreads threads, and the results copied to the hunk in surface
+order on the main thread.
+=================
+*/
+void CMod_LoadPatches( lump_t *surfs, lump_t *verts, const char *name, unsigned checksum ) {
+	drawVert_t	*dv;
 	dsurface_t	*in;
 	int			count;
 	int			i, j;
 	int			c;
 	cPatch_t	*patch;
-	vec3_t		points[MAX_PATCH_VERTS];
 	int			width, height;
 	int			shaderNum;
+	byte		*cache;
+	const byte	*cacheRead, *cacheEnd;
+	int			*pending;
+	int			numPending;
+	int			numThreads, batch;
+	patchJobs_t	jobs;
 
 	in = (void *)(cmod_base + surfs->fileofs);
 	if (surfs->filelen % sizeof(*in))
@@ -502,6 +805,17 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 	if (verts->filelen % sizeof(*dv))
 		Com_Error (ERR_DROP, "MOD_LoadBmodel: funny lump size");
 
+	cache = NULL;
+	cacheRead = cacheEnd = NULL;
+#ifndef BSPC
+	if ( cm_patchCache->integer ) {
+		cache = CM_ReadPatchCache( name, checksum, count, &cacheEnd );
+		cacheRead = cache ? cache + PATCH_CACHE_HEADER : NULL;
+	}
+#endif
+	pending = Hunk_AllocateTempMemory( ( count + 1 ) * sizeof( *pending ) );
+	numPending = 0;
+
 	// scan through all the surfaces, but only load patches,
 	// not planar faces
 	for ( i = 0 ; i < count ; i++, in++ ) {
@@ -512,28 +826,90 @@ void CMod_LoadPatches( lump_t *surfs, lump_t *verts ) {
 
 		cm.surfaces[ i ] = patch = Hunk_Alloc( sizeof( *patch ), h_high );
 
-		// load the full drawverts onto the stack
 		width = LittleLong( in->patchWidth );
 		height = LittleLong( in->patchHeight );
+
+		shaderNum = LittleLong( in->shaderNum );
+		patch->contents = cm.shaders[shaderNum].contentFlags;
+		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
+
+		// take the facets from the cache while it keeps matching the map
+		if ( cacheRead ) {
+			if ( cacheEnd - cacheRead >= 3 * 4
+				&& LittleLong( ((int *)cacheRead)[0] ) == i
+				&& LittleLong( ((int *)cacheRead)[1] ) == width
+				&& LittleLong( ((int *)cacheRead)[2] ) == height ) {
+				cacheRead += 3 * 4;
+				patch->pc = CM_ReadPatchCollideCache( &cacheRead, cacheEnd );
+			}
+			if ( !patch->pc ) {
+				Com_DPrintf( "Patch cache doesn't match surface %i, regenerating\n", i );
+				cacheRead = NULL;
+			} else {
+				continue;
+			}
+		}
+
+		// everything that can error out is checked here, the jobs can't
 		c = width * height;
 		if ( c > MAX_PATCH_VERTS ) {
 			Com_Error( ERR_DROP, "ParseMesh: MAX_PATCH_VERTS" );
 		}
+		CM_CheckPatchSize( width, height );
+
+		pending[numPending++] = i;
+	}
 
-		dv_p = dv + LittleLong( in->firstVert );
-		for ( j = 0 ; j < c ; j++, dv_p++ ) {
-			points[j][0] = LittleFloat( dv_p->xyz[0] );
-			points[j][1] = LittleFloat( dv_p->xyz[1] );
-			points[j][2] = LittleFloat( dv_p->xyz[2] );
+#ifndef BSPC
+	if ( cache ) {
+		Z_Free( cache );
+	}
+#endif
+
+	// create the internal facet structures
+	if ( numPending ) {
+		numThreads = CM_LoadThreads();
+		if ( numThreads > MAX_JOB_THREADS ) {
+			numThreads = MAX_JOB_THREADS;
+		}
+		if ( numThreads > numPending ) {
+			numThreads = numPending;
 		}
 
-		shaderNum = LittleLong( in->shaderNum );
-		patch->contents = cm.shaders[shaderNum].contentFlags;
-		patch->surfaceFlags = cm.shaders[shaderNum].surfaceFlags;
+		jobs.surfaces = (void *)(cmod_base + surfs->fileofs);
+		jobs.verts = dv;
+		jobs.pending = pending;
+		jobs.work = Hunk_AllocateTempMemory( numThreads * sizeof( *jobs.work ) );
+
+		for ( jobs.first = 0 ; jobs.first < numPending ; jobs.first += batch ) {
+			batch = numPending - jobs.first;
+			if ( batch > numThreads ) {
+				batch = numThreads;
+			}
+
+#ifndef BSPC
+			if ( numThreads > 1 ) {
+				Com_RunJobs( CM_GeneratePatchJob, &jobs, batch, numThreads );
+			} else
+#endif
+			{
+				CM_GeneratePatchJob( &jobs, 0 );
+			}
 
-		// create the internal facet structure
-		patch->pc = CM_GeneratePatchCollide( width, height, points );
+			for ( j = 0 ; j < batch ; j++ ) {
+				cm.surfaces[ pending[jobs.first + j] ]->pc = CM_FinishPatchCollide( &jobs.work[j] );
+			}
+		}
+
+		Hunk_FreeTempMemory( jobs.work );
+	}
+	Hunk_FreeTempMemory( pending );
+
+#ifndef BSPC
+	if ( numPending && cm_patchCache->integer ) {
+		CM_WritePatchCache( name, checksum, (void *)(cmod_base + surfs->fileofs), count );
 	}
+#endif
 }
 
 //==================================================================
@@ -584,6 +960,8 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	cm_noAreas = Cvar_Get ("cm_noAreas", "0", CVAR_CHEAT);
 	cm_noCurves = Cvar_Get ("cm_noCurves", "0", CVAR_CHEAT);
 	cm_playerCurveClip = Cvar_Get ("cm_playerCurveClip", "1", CVAR_ARCHIVE|CVAR_CHEAT );
+	cm_patchCache = Cvar_Get ("cm_patchCache", "1", CVAR_ARCHIVE );
+	cm_loadThreads = Cvar_Get ("cm_loadThreads", "-1", CVAR_ARCHIVE );
 #endif
 	Com_DPrintf( "CM_LoadMap( %s, %i )\n", name, clientload );
 
@@ -645,13 +1023,19 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	CMod_LoadNodes (&header.lumps[LUMP_NODES]);
 	CMod_LoadEntityString (&header.lumps[LUMP_ENTITIES]);
 	CMod_LoadVisibility( &header.lumps[LUMP_VISIBILITY] );
-	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS] );
+	CMod_LoadPatches( &header.lumps[LUMP_SURFACES], &header.lumps[LUMP_DRAWVERTS], name, last_checksum );
 
 	// we are NOT freeing the file, because it is cached for the ref
 	FS_FreeFile (buf.v);
 
 	CM_InitBoxHull ();
 
+	CM_InitBrushPlanes ();
+
+	CM_InitLeafBrushBounds ();
+
+	CM_InitFlatNodes ();
+
 	CM_FloodAreaConnections ();
 
 	// allow this to be cached if it is loaded by the server
@@ -660,6 +1044,30 @@ void CM_LoadMap( const char *name, qboolean clientload, int *checksum ) {
 	}
 }
 
+/*
+==================
+CM_Stats_f
+
+Prints the trace counters gathered since the last cm_stats and clears them
+==================
+*/
+void CM_Stats_f( void ) {
+	int		brushes;
+
+	brushes = c_brush_traces + c_brush_rejects;
+
+	Com_Printf( "%i traces, %i point leaf lookups\n", c_traces, c_pointcontents );
+	Com_Printf( "%i brushes tested, %i rejected by leaf bounds (%.1f%%)\n",
+		c_brush_traces, c_brush_rejects, brushes ? 100.0f * c_brush_rejects / brushes : 0.0f );
+	Com_Printf( "%i patches tested\n", c_patch_traces );
+
+	c_traces = 0;
+	c_brush_traces = 0;
+	c_brush_rejects = 0;
+	c_patch_traces = 0;
+	c_pointcontents = 0;
+}
+
 /*
 ==================
 CM_ClearMap
@@ -711,6 +1119,10 @@ int		CM_NumClusters( void ) {
 	return cm.numClusters;
 }
 
+int		CM_NumAreas( void ) {
+	return cm.numAreas;
+}
+
 int		CM_NumInlineModels( void ) {
 	return cm.numSubModels;
 }
@@ -789,6 +1201,129 @@ void CM_InitBoxHull (void)
 	}	
 }
 
+/*
+===================
+CM_SetBrushPlanes
+
+Copies the side planes of a brush into its planes groups
+===================
+*/
+void CM_SetBrushPlanes( cbrush_t *b ) {
+	int				i, j;
+	cplane_t		*plane;
+	cbrushplanes_t	*group;
+
+	for ( i = 0 ; i < ( b->numsides + 3 ) / 4 * 4 ; i++ ) {
+		group = &b->planes[i >> 2];
+		if ( i < b->numsides ) {
+			plane = b->sides[i].plane;
+			for ( j = 0 ; j < 3 ; j++ ) {
+				group->normal[j][i & 3] = plane->normal[j];
+			}
+			group->dist[i & 3] = plane->dist;
+		} else {
+			// a plane every trace is 1 unit behind, so it never
+			// rejects the brush and is never crossed
+			for ( j = 0 ; j < 3 ; j++ ) {
+				group->normal[j][i & 3] = 0;
+			}
+			group->dist[i & 3] = 1;
+		}
+	}
+}
+
+/*
+===================
+CM_InitBrushPlanes
+
+Lays out the planes of every brush, including the box hull, for
+CM_TraceThroughBrush
+===================
+*/
+void CM_InitBrushPlanes( void ) {
+	int				i, numGroups;
+	cbrushplanes_t	*groups;
+
+	numGroups = 0;
+	for ( i = 0 ; i < cm.numBrushes + BOX_BRUSHES ; i++ ) {
+		numGroups += ( cm.brushes[i].numsides + 3 ) / 4;
+	}
+
+	groups = Hunk_Alloc( numGroups * sizeof( *groups ), h_high );
+
+	for ( i = 0 ; i < cm.numBrushes + BOX_BRUSHES ; i++ ) {
+		cm.brushes[i].planes = groups;
+		groups += ( cm.brushes[i].numsides + 3 ) / 4;
+
+		CM_SetBrushPlanes( &cm.brushes[i] );
+	}
+}
+
+/*
+===================
+CM_SetBrushBounds
+===================
+*/
+static void CM_SetBrushBounds( cbrushbounds_t *bb, int brushnum ) {
+	cbrush_t	*b;
+	int			i;
+
+	b = &cm.brushes[brushnum];
+	for ( i = 0 ; i < 3 ; i++ ) {
+		bb->mins[i] = b->bounds[0][i] - SURFACE_CLIP_EPSILON;
+		bb->maxs[i] = b->bounds[1][i] + SURFACE_CLIP_EPSILON;
+	}
+	bb->contents = b->contents;
+	bb->brushnum = brushnum;
+}
+
+/*
+===================
+CM_SetLeafBrushBounds
+===================
+*/
+static cbrushbounds_t *CM_SetLeafBrushBounds( cLeaf_t *leaf, cbrushbounds_t *bb ) {
+	int		i;
+
+	leaf->brushBounds = bb;
+	for ( i = 0 ; i < leaf->numLeafBrushes ; i++, bb++ ) {
+		CM_SetBrushBounds( bb, cm.leafbrushes[leaf->firstLeafBrush + i] );
+	}
+
+	return bb;
+}
+
+/*
+===================
+CM_InitLeafBrushBounds
+
+Gives every leaf, the submodel leafs and the box hull leaf a packed copy
+of its brush bounds
+===================
+*/
+void CM_InitLeafBrushBounds( void ) {
+	int				i, total;
+	cbrushbounds_t	*bb;
+
+	total = box_model.leaf.numLeafBrushes;
+	for ( i = 0 ; i < cm.numLeafs ; i++ ) {
+		total += cm.leafs[i].numLeafBrushes;
+	}
+	for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+		total += cm.cmodels[i].leaf.numLeafBrushes;
+	}
+
+	bb = Hunk_Alloc( total * sizeof( *bb ), h_high );
+
+	for ( i = 0 ; i < cm.numLeafs ; i++ ) {
+		bb = CM_SetLeafBrushBounds( &cm.leafs[i], bb );
+	}
+	for ( i = 1 ; i < cm.numSubModels ; i++ ) {
+		bb = CM_SetLeafBrushBounds( &cm.cmodels[i].leaf, bb );
+	}
+	CM_SetLeafBrushBounds( &box_model.leaf, bb );
+}
+
 /*
 ===================
 CM_TempBoxModel
@@ -820,8 +1355,11 @@ clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule
 	box_planes[10].dist = mins[2];
 	box_planes[11].dist = -mins[2];
 
+	CM_SetBrushPlanes( box_brush );
+
 	VectorCopy( mins, box_brush->bounds[0] );
 	VectorCopy( maxs, box_brush->bounds[1] );
+	CM_SetBrushBounds( box_model.leaf.brushBounds, cm.numBrushes );
 
 	return BOX_MODEL_HANDLE;
 }
@@ -34,12 +34,33 @@ typedef struct {
 	int			children[2];		// negative numbers are leafs
 } cNode_t;
 
+// the node tree as the traversals walk it, renumbered depth first at load
+// time so a front child usually follows its parent, with the split plane
+// stored inline; two nodes fit in a 64 byte cache line
+typedef struct {
+	float		normal[3];
+	float		dist;
+	int			type;				// PLANE_X, PLANE_Y, PLANE_Z or PLANE_NON_AXIAL
+	int			children[2];		// indexes into cm.flatNodes, negative numbers are leafs
+	int			pad;
+} cFlatNode_t;
+
+// a leaf brush as CM_TraceThroughLeaf first sees it, with the bounds
+// already spread by SURFACE_CLIP_EPSILON
+typedef struct {
+	vec3_t		mins;
+	vec3_t		maxs;
+	int			contents;
+	int			brushnum;
+} cbrushbounds_t;
+
 typedef struct {
 	int			cluster;
 	int			area;
 
 	int			firstLeafBrush;
 	int			numLeafBrushes;
+	cbrushbounds_t	*brushBounds;	// [numLeafBrushes], contiguous per leaf
 
 	int			firstLeafSurface;
 	int			numLeafSurfaces;
@@ -56,18 +77,23 @@ typedef struct {
 	int			shaderNum;
 } cbrushside_t;
 
+// brush side planes four at a time, so they can be tested together
+typedef struct {
+	float		normal[3][4];	// x, y and z of each plane
+	float		dist[4];
+} cbrushplanes_t;
+
 typedef struct {
 	int			shaderNum;		// the shader that determined the contents
 	int			contents;
 	vec3_t		bounds[2];
 	int			numsides;
 	cbrushside_t	*sides;
-	int			checkcount;		// to avoid repeated testings
+	cbrushplanes_t	*planes;	// ( numsides + 3 ) / 4 groups, unused lanes never clip
 } cbrush_t;
 
 
 typedef struct {
-	int			checkcount;				// to avoid repeated testings
 	int			surfaceFlags;
 	int			contents;
 	struct patchCollide_s	*pc;
@@ -93,6 +119,7 @@ typedef struct {
 
 	int			numNodes;
 	cNode_t		*nodes;
+	cFlatNode_t	*flatNodes;			// [numNodes], built from nodes by CM_InitFlatNodes
 
 	int			numLeafs;
 	cLeaf_t		*leafs;
@@ -113,6 +140,8 @@ typedef struct {
 	int			clusterBytes;
 	byte		*visibility;
 	qboolean	vised;			// if false, visibility is just a single cluster of ffs
+	int			clusterWords;
+	uint64_t	*visibilityWords;	// visibility rows as 64 bit words, bit n of word w is cluster w * 64 + n
 
 	int			numEntityChars;
 	char		*entityString;
@@ -125,7 +154,6 @@ typedef struct {
 	cPatch_t	**surfaces;			// non-patches will be NULL
 
 	int			floodvalid;
-	int			checkcount;					// incremented on each trace
 } clipMap_t;
 
 
@@ -135,13 +163,23 @@ typedef struct {
 
 extern	clipMap_t	cm;
 extern	int			c_pointcontents;
-extern	int			c_traces, c_brush_traces, c_patch_traces;
+extern	int			c_traces, c_brush_traces, c_brush_rejects, c_patch_traces;
 extern	cvar_t		*cm_noAreas;
 extern	cvar_t		*cm_noCurves;
 extern	cvar_t		*cm_playerCurveClip;
 
 // cm_test.c
 
+// brushes and patches already looked at by the current trace or brush
+// listing of one thread, see CM_NewVisits
+typedef struct {
+	int			stamp;			// of the current trace
+	int			maxBrushes;
+	int			maxPatches;
+	int			*brushes;		// [maxBrushes] stamp of the last look, indexed like cm.brushes
+	int			*patches;		// [maxPatches] indexed like cm.surfaces
+} cmVisits_t;
+
 // Used for oriented capsule collision detection
 typedef struct
 {
@@ -164,6 +202,8 @@ typedef struct {
 	qboolean	isPoint;	// optimized case
 	trace_t		trace;		// returned from trace call
 	sphere_t	sphere;		// sphere for oriendted capsule collision
+	cmVisits_t	*visits;	// see CM_NewVisits
+	int			checkcount;	// visits->stamp of this trace
 } traceWork_t;
 
 typedef struct leafList_s {
@@ -173,10 +213,13 @@ typedef struct leafList_s {
 	int		*list;
 	vec3_t	bounds[2];
 	int		lastLeaf;		// for overflows where each leaf can't be stored individually
+	cmVisits_t	*visits;	// for CM_StoreBrushes
+	int		checkcount;		// visits->stamp of this listing
 	void	(*storeLeafs)( struct leafList_s *ll, int nodenum );
 } leafList_t;
 
 
+cmVisits_t *CM_NewVisits( void );
 int CM_BoxBrushes( const vec3_t mins, const vec3_t maxs, cbrush_t **list, int listsize );
 
 void CM_StoreLeafs( leafList_t *ll, int nodenum );
@@ -185,6 +228,7 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum );
 void CM_BoxLeafnums_r( leafList_t *ll, int nodenum );
 
 cmodel_t	*CM_ClipHandleToModel( clipHandle_t handle );
+void CM_SetBrushPlanes( cbrush_t *b );
 qboolean CM_BoundsIntersect( const vec3_t mins, const vec3_t maxs, const vec3_t mins2, const vec3_t maxs2 );
 qboolean CM_BoundsIntersectPoint( const vec3_t mins, const vec3_t maxs, const vec3_t point );
 
@@ -194,3 +238,6 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 qboolean CM_PositionTestInPatchCollide( traceWork_t *tw, const struct patchCollide_s *pc );
 void CM_ClearLevelPatches( void );
+int CM_PatchCollideCacheSize( const struct patchCollide_s *pc );
+byte *CM_WritePatchCollideCache( byte *out, const struct patchCollide_s *pc );
+struct patchCollide_s *CM_ReadPatchCollideCache( const byte **in, const byte *end );
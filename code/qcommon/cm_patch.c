@@ -88,6 +88,9 @@ static const patchCollide_t	*debugPatchCollide;
 static const facet_t		*debugFacet;
 static qboolean		debugBlock;
 static vec3_t		debugBlockPoints[4];
+#ifndef BSPC
+static cvar_t		*debugSurfaceUpdate;	// registered here rather than on first hit, traces may be on any thread
+#endif
 
 /*
 =================
@@ -97,6 +100,9 @@ CM_ClearLevelPatches
 void CM_ClearLevelPatches( void ) {
 	debugPatchCollide = NULL;
 	debugFacet = NULL;
+#ifndef BSPC
+	debugSurfaceUpdate = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
+#endif
 }
 
 /*
@@ -414,15 +420,37 @@ PATCH COLLIDE GENERATION
 ================================================================================
 */
 
-static	int				numPlanes;
-static	patchPlane_t	planes[MAX_PATCH_PLANES];
-
-static	int				numFacets;
-static	facet_t			facets[MAX_FACETS];
-
 #define	NORMAL_EPSILON	0.0001
 #define	DIST_EPSILON	0.02
 
+/*
+==================
+CM_PatchWarning
+
+Keeps a message for CM_FinishPatchCollide, which prints it
+==================
+*/
+static void CM_PatchWarning( patchWork_t *pw, qboolean developer, const char *message ) {
+	if ( pw->numWarnings < MAX_PATCH_WARNINGS ) {
+		pw->warnings[pw->numWarnings] = message;
+		pw->developerWarning[pw->numWarnings] = developer;
+		pw->numWarnings++;
+	}
+}
+
+/*
+==================
+CM_PatchError
+
+Keeps the first error for CM_FinishPatchCollide, which raises it
+==================
+*/
+static void CM_PatchError( patchWork_t *pw, const char *message ) {
+	if ( !pw->error ) {
+		pw->error = message;
+	}
+}
+
 /*
 ==================
 CM_PlaneEqual
@@ -487,27 +515,29 @@ void CM_SnapVector(vec3_t normal) {
 CM_FindPlane2
 ==================
 */
-int CM_FindPlane2(float plane[4], int *flipped) {
+int CM_FindPlane2(patchWork_t *pw, float plane[4], int *flipped) {
 	int i;
 
 	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if (CM_PlaneEqual(&planes[i], plane, flipped)) return i;
+	for ( i = 0 ; i < pw->numPlanes ; i++ ) {
+		if (CM_PlaneEqual(&pw->planes[i], plane, flipped)) return i;
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( pw->numPlanes == MAX_PATCH_PLANES ) {
+		CM_PatchError( pw, "MAX_PATCH_PLANES" );
+		*flipped = qfalse;
+		return 0;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	Vector4Copy( plane, pw->planes[pw->numPlanes].plane );
+	pw->planes[pw->numPlanes].signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	pw->numPlanes++;
 
 	*flipped = qfalse;
 
-	return numPlanes-1;
+	return pw->numPlanes-1;
 }
 
 /*
@@ -515,7 +545,7 @@ int CM_FindPlane2(float plane[4], int *flipped) {
 CM_FindPlane
 ==================
 */
-static int CM_FindPlane( float *p1, float *p2, float *p3 ) {
+static int CM_FindPlane( patchWork_t *pw, float *p1, float *p2, float *p3 ) {
 	float	plane[4];
 	int		i;
 	float	d;
@@ -525,22 +555,22 @@ static int CM_FindPlane( float *p1, float *p2, float *p3 ) {
 	}
 
 	// see if the points are close enough to an existing plane
-	for ( i = 0 ; i < numPlanes ; i++ ) {
-		if ( DotProduct( plane, planes[i].plane ) < 0 ) {
+	for ( i = 0 ; i < pw->numPlanes ; i++ ) {
+		if ( DotProduct( plane, pw->planes[i].plane ) < 0 ) {
 			continue;	// allow backwards planes?
 		}
 
-		d = DotProduct( p1, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p1, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
 
-		d = DotProduct( p2, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p2, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
 
-		d = DotProduct( p3, planes[i].plane ) - planes[i].plane[3];
+		d = DotProduct( p3, pw->planes[i].plane ) - pw->planes[i].plane[3];
 		if ( d < -PLANE_TRI_EPSILON || d > PLANE_TRI_EPSILON ) {
 			continue;
 		}
@@ -550,16 +580,17 @@ static int CM_FindPlane( float *p1, float *p2, float *p3 ) {
 	}
 
 	// add a new plane
-	if ( numPlanes == MAX_PATCH_PLANES ) {
-		Com_Error( ERR_DROP, "MAX_PATCH_PLANES" );
+	if ( pw->numPlanes == MAX_PATCH_PLANES ) {
+		CM_PatchError( pw, "MAX_PATCH_PLANES" );
+		return -1;
 	}
 
-	Vector4Copy( plane, planes[numPlanes].plane );
-	planes[numPlanes].signbits = CM_SignbitsForNormal( plane );
+	Vector4Copy( plane, pw->planes[pw->numPlanes].plane );
+	pw->planes[pw->numPlanes].signbits = CM_SignbitsForNormal( plane );
 
-	numPlanes++;
+	pw->numPlanes++;
 
-	return numPlanes-1;
+	return pw->numPlanes-1;
 }
 
 /*
@@ -567,14 +598,14 @@ static int CM_FindPlane( float *p1, float *p2, float *p3 ) {
 CM_PointOnPlaneSide
 ==================
 */
-static int CM_PointOnPlaneSide( float *p, int planeNum ) {
+static int CM_PointOnPlaneSide( patchWork_t *pw, float *p, int planeNum ) {
 	float	*plane;
 	float	d;
 
 	if ( planeNum == -1 ) {
 		return SIDE_ON;
 	}
-	plane = planes[ planeNum ].plane;
+	plane = pw->planes[ planeNum ].plane;
 
 	d = DotProduct( p, plane ) - plane[3];
 
@@ -594,20 +625,20 @@ static int CM_PointOnPlaneSide( float *p, int planeNum ) {
 CM_GridPlane
 ==================
 */
-static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int tri ) {
+static int	CM_GridPlane( patchWork_t *pw, int i, int j, int tri ) {
 	int		p;
 
-	p = gridPlanes[i][j][tri];
+	p = pw->gridPlanes[i][j][tri];
 	if ( p != -1 ) {
 		return p;
 	}
-	p = gridPlanes[i][j][!tri];
+	p = pw->gridPlanes[i][j][!tri];
 	if ( p != -1 ) {
 		return p;
 	}
 
 	// should never happen
-	Com_Printf( "WARNING: CM_GridPlane unresolvable\n" );
+	CM_PatchWarning( pw, qfalse, "WARNING: CM_GridPlane unresolvable\n" );
 	return -1;
 }
 
@@ -616,75 +647,78 @@ static int	CM_GridPlane( int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i,
 CM_EdgePlaneNum
 ==================
 */
-static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2], int i, int j, int k ) {
+static int CM_EdgePlaneNum( patchWork_t *pw, int i, int j, int k ) {
+	cGrid_t		*grid;
 	float	*p1, *p2;
 	vec3_t		up;
 	int			p;
 
+	grid = &pw->grid;
+
 	switch ( k ) {
 	case 0:	// top border
 		p1 = grid->points[i][j];
 		p2 = grid->points[i+1][j];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 2:	// bottom border
 		p1 = grid->points[i][j+1];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p2, p1, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p2, p1, up );
 
 	case 3: // left border
 		p1 = grid->points[i][j];
 		p2 = grid->points[i][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p2, p1, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p2, p1, up );
 
 	case 1:	// right border
 		p1 = grid->points[i+1][j];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 4:	// diagonal out of triangle 0
 		p1 = grid->points[i+1][j+1];
 		p2 = grid->points[i][j];
-		p = CM_GridPlane( gridPlanes, i, j, 0 );
+		p = CM_GridPlane( pw, i, j, 0 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	case 5:	// diagonal out of triangle 1
 		p1 = grid->points[i][j];
 		p2 = grid->points[i+1][j+1];
-		p = CM_GridPlane( gridPlanes, i, j, 1 );
+		p = CM_GridPlane( pw, i, j, 1 );
 		if ( p == -1 ) {
 			return -1;
 		}
-		VectorMA( p1, 4, planes[ p ].plane, up );
-		return CM_FindPlane( p1, p2, up );
+		VectorMA( p1, 4, pw->planes[ p ].plane, up );
+		return CM_FindPlane( pw, p1, p2, up );
 
 	}
 
-	Com_Error( ERR_DROP, "CM_EdgePlaneNum: bad k" );
+	CM_PatchError( pw, "CM_EdgePlaneNum: bad k" );
 	return -1;
 }
 
@@ -693,12 +727,14 @@ static int CM_EdgePlaneNum( cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRI
 CM_SetBorderInward
 ===================
 */
-static void CM_SetBorderInward( facet_t *facet, cGrid_t *grid, int gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2],
-						  int i, int j, int which ) {
+static void CM_SetBorderInward( patchWork_t *pw, facet_t *facet, int i, int j, int which ) {
+	cGrid_t	*grid;
 	int		k, l;
 	float	*points[4];
 	int		numPoints;
 
+	grid = &pw->grid;
+
 	switch ( which ) {
 	case -1:
 		points[0] = grid->points[i][j];
@@ -720,7 +756,7 @@ static void CM_SetBorderInward( facet_t *facet, cGrid_t *grid, int gridPlanes[MA
 		numPoints = 3;
 		break;
 	default:
-		Com_Error( ERR_FATAL, "CM_SetBorderInward: bad parameter" );
+		CM_PatchError( pw, "CM_SetBorderInward: bad parameter" );
 		numPoints = 0;
 		break;
 	}
@@ -734,7 +770,7 @@ static void CM_SetBorderInward( facet_t *facet, cGrid_t *grid, int gridPlanes[MA
 		for ( l = 0 ; l < numPoints ; l++ ) {
 			int		side;
 
-			side = CM_PointOnPlaneSide( points[l], facet->borderPlanes[k] );
+			side = CM_PointOnPlaneSide( pw, points[l], facet->borderPlanes[k] );
 			if ( side == SIDE_FRONT ) {
 				front++;
 			} if ( side == SIDE_BACK ) {
@@ -751,14 +787,14 @@ static void CM_SetBorderInward( facet_t *facet, cGrid_t *grid, int gridPlanes[MA
 			facet->borderPlanes[k] = -1;
 		} else {
 			// bisecting side border
-			Com_DPrintf( "WARNING: CM_SetBorderInward: mixed plane sides\n" );
+			CM_PatchWarning( pw, qtrue, "WARNING: CM_SetBorderInward: mixed plane sides\n" );
 			facet->borderInward[k] = qfalse;
-			if ( !debugBlock ) {
-				debugBlock = qtrue;
-				VectorCopy( grid->points[i][j], debugBlockPoints[0] );
-				VectorCopy( grid->points[i+1][j], debugBlockPoints[1] );
-				VectorCopy( grid->points[i+1][j+1], debugBlockPoints[2] );
-				VectorCopy( grid->points[i][j+1], debugBlockPoints[3] );
+			if ( !pw->debugBlock ) {
+				pw->debugBlock = qtrue;
+				VectorCopy( grid->points[i][j], pw->debugBlockPoints[0] );
+				VectorCopy( grid->points[i+1][j], pw->debugBlockPoints[1] );
+				VectorCopy( grid->points[i+1][j+1], pw->debugBlockPoints[2] );
+				VectorCopy( grid->points[i][j+1], pw->debugBlockPoints[3] );
 			}
 		}
 	}
@@ -771,38 +807,43 @@ CM_ValidateFacet
 If the facet isn't bounded by its borders, we screwed up.
 ==================
 */
-static qboolean CM_ValidateFacet( facet_t *facet ) {
+static qboolean CM_ValidateFacet( patchWork_t *pw, facet_t *facet ) {
 	float		plane[4];
 	int			j;
-	winding_t	*w;
+	fixedWinding_t	w;
+	qboolean	valid;
 	vec3_t		bounds[2];
+	const char	*error;
 
 	if ( facet->surfacePlane == -1 ) {
 		return qfalse;
 	}
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
-	w = BaseWindingForPlane( plane,  plane[3] );
-	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
+	error = NULL;
+	Vector4Copy( pw->planes[ facet->surfacePlane ].plane, plane );
+	valid = BaseWindingForPlaneFixed( &w, plane,  plane[3], &error );
+	for ( j = 0 ; j < facet->numBorders && valid ; j++ ) {
 		if ( facet->borderPlanes[j] == -1 ) {
-			FreeWinding( w );
 			return qfalse;
 		}
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( pw->planes[ facet->borderPlanes[j] ].plane, plane );
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
 		}
-		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+		valid = ChopFixedWinding( &w, plane, plane[3], 0.1f, &error );
 	}
 
-	if ( !w ) {
+	if ( error ) {
+		CM_PatchError( pw, error );
+		return qfalse;
+	}
+	if ( !valid ) {
 		return qfalse;		// winding was completely chopped away
 	}
 
 	// see if the facet is unreasonably large
-	WindingBounds( w, bounds[0], bounds[1] );
-	FreeWinding( w );
+	WindingBounds( (winding_t *)&w, bounds[0], bounds[1] );
 	
 	for ( j = 0 ; j < 3 ; j++ ) {
 		if ( bounds[1][j] - bounds[0][j] > MAX_MAP_BOUNDS ) {
@@ -823,33 +864,40 @@ static qboolean CM_ValidateFacet( facet_t *facet ) {
 CM_AddFacetBevels
 ==================
 */
-void CM_AddFacetBevels( facet_t *facet ) {
+void CM_AddFacetBevels( patchWork_t *pw, facet_t *facet ) {
 
 	int i, j, k, l;
 	int axis, dir, flipped;
 	float plane[4], d, newplane[4];
-	winding_t *w, *w2;
+	fixedWinding_t w, w2;
+	qboolean valid;
 	vec3_t mins, maxs, vec, vec2;
+	const char *error;
 
-	Vector4Copy( planes[ facet->surfacePlane ].plane, plane );
+	error = NULL;
+	Vector4Copy( pw->planes[ facet->surfacePlane ].plane, plane );
 
-	w = BaseWindingForPlane( plane,  plane[3] );
-	for ( j = 0 ; j < facet->numBorders && w ; j++ ) {
+	valid = BaseWindingForPlaneFixed( &w, plane,  plane[3], &error );
+	for ( j = 0 ; j < facet->numBorders && valid ; j++ ) {
 		if (facet->borderPlanes[j] == facet->surfacePlane) continue;
-		Vector4Copy( planes[ facet->borderPlanes[j] ].plane, plane );
+		Vector4Copy( pw->planes[ facet->borderPlanes[j] ].plane, plane );
 
 		if ( !facet->borderInward[j] ) {
 			VectorSubtract( vec3_origin, plane, plane );
 			plane[3] = -plane[3];
 		}
 
-		ChopWindingInPlace( &w, plane, plane[3], 0.1f );
+		valid = ChopFixedWinding( &w, plane, plane[3], 0.1f, &error );
+	}
+	if ( error ) {
+		CM_PatchError( pw, error );
+		return;
 	}
-	if ( !w ) {
+	if ( !valid ) {
 		return;
 	}
 
-	WindingBounds(w, mins, maxs);
+	WindingBounds((winding_t *)&w, mins, maxs);
 
 	// add the axial planes
 	for ( axis = 0 ; axis < 3 ; axis++ )
@@ -865,21 +913,21 @@ void CM_AddFacetBevels( facet_t *facet ) {
 				plane[3] = -mins[axis];
 			}
 			//if it's the surface plane
-			if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+			if (CM_PlaneEqual(&pw->planes[facet->surfacePlane], plane, &flipped)) {
 				continue;
 			}
 			// see if the plane is already present
 			for ( i = 0 ; i < facet->numBorders ; i++ ) {
-				if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped))
+				if (CM_PlaneEqual(&pw->planes[facet->borderPlanes[i]], plane, &flipped))
 					break;
 			}
 
 			if ( i == facet->numBorders ) {
 				if ( facet->numBorders >= 4 + 6 + 16 ) {
-					Com_Printf( "ERROR: too many bevels\n" );
+					CM_PatchWarning( pw, qfalse, "ERROR: too many bevels\n" );
 					continue;
 				}
-				facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
+				facet->borderPlanes[facet->numBorders] = CM_FindPlane2(pw, plane, &flipped);
 				facet->borderNoAdjust[facet->numBorders] = 0;
 				facet->borderInward[facet->numBorders] = flipped;
 				facet->numBorders++;
@@ -890,10 +938,10 @@ void CM_AddFacetBevels( facet_t *facet ) {
 	// add the edge bevels
 	//
 	// test the non-axial plane edges
-	for ( j = 0 ; j < w->numpoints ; j++ )
+	for ( j = 0 ; j < w.numpoints ; j++ )
 	{
-		k = (j+1)%w->numpoints;
-		VectorSubtract (w->p[j], w->p[k], vec);
+		k = (j+1)%w.numpoints;
+		VectorSubtract (w.p[j], w.p[k], vec);
 		//if it's a degenerate edge
 		if (VectorNormalize (vec) < 0.5)
 			continue;
@@ -915,60 +963,60 @@ void CM_AddFacetBevels( facet_t *facet ) {
 				CrossProduct (vec, vec2, plane);
 				if (VectorNormalize (plane) < 0.5)
 					continue;
-				plane[3] = DotProduct (w->p[j], plane);
+				plane[3] = DotProduct (w.p[j], plane);
 
 				// if all the points of the facet winding are
 				// behind this plane, it is a proper edge bevel
-				for ( l = 0 ; l < w->numpoints ; l++ )
+				for ( l = 0 ; l < w.numpoints ; l++ )
 				{
-					d = DotProduct (w->p[l], plane) - plane[3];
+					d = DotProduct (w.p[l], plane) - plane[3];
 					if (d > 0.1)
 						break;	// point in front
 				}
-				if ( l < w->numpoints )
+				if ( l < w.numpoints )
 					continue;
 
 				//if it's the surface plane
-				if (CM_PlaneEqual(&planes[facet->surfacePlane], plane, &flipped)) {
+				if (CM_PlaneEqual(&pw->planes[facet->surfacePlane], plane, &flipped)) {
 					continue;
 				}
 				// see if the plane is already present
 				for ( i = 0 ; i < facet->numBorders ; i++ ) {
-					if (CM_PlaneEqual(&planes[facet->borderPlanes[i]], plane, &flipped)) {
+					if (CM_PlaneEqual(&pw->planes[facet->borderPlanes[i]], plane, &flipped)) {
 							break;
 					}
 				}
 
 				if ( i == facet->numBorders ) {
 					if ( facet->numBorders >= 4 + 6 + 16 ) {
-						Com_Printf( "ERROR: too many bevels\n" );
+						CM_PatchWarning( pw, qfalse, "ERROR: too many bevels\n" );
 						continue;
 					}
-					facet->borderPlanes[facet->numBorders] = CM_FindPlane2(plane, &flipped);
+					facet->borderPlanes[facet->numBorders] = CM_FindPlane2(pw, plane, &flipped);
 
 					for ( k = 0 ; k < facet->numBorders ; k++ ) {
 						if (facet->borderPlanes[facet->numBorders] ==
-							facet->borderPlanes[k]) Com_Printf("WARNING: bevel plane already used\n");
+							facet->borderPlanes[k]) CM_PatchWarning(pw, qfalse, "WARNING: bevel plane already used\n");
 					}
 
 					facet->borderNoAdjust[facet->numBorders] = 0;
 					facet->borderInward[facet->numBorders] = flipped;
 					//
-					w2 = CopyWinding(w);
-					Vector4Copy(planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
+					w2 = w;
+					Vector4Copy(pw->planes[facet->borderPlanes[facet->numBorders]].plane, newplane);
 					if (!facet->borderInward[facet->numBorders])
 					{
 						VectorNegate(newplane, newplane);
 						newplane[3] = -newplane[3];
 					} //end if
-					ChopWindingInPlace( &w2, newplane, newplane[3], 0.1f );
-					if (!w2) {
-						Com_DPrintf("WARNING: CM_AddFacetBevels... invalid bevel\n");
+					if (!ChopFixedWinding( &w2, newplane, newplane[3], 0.1f, &error )) {
+						if ( error ) {
+							CM_PatchError( pw, error );
+							return;
+						}
+						CM_PatchWarning(pw, qtrue, "WARNING: CM_AddFacetBevels... invalid bevel\n");
 						continue;
 					}
-					else {
-						FreeWinding(w2);
-					}
 					//
 					facet->numBorders++;
 					//already got a bevel
@@ -977,12 +1025,10 @@ void CM_AddFacetBevels( facet_t *facet ) {
 			}
 		}
 	}
-	FreeWinding( w );
-
 #ifndef BSPC
 	//add opposite plane
 	if ( facet->numBorders >= 4 + 6 + 16 ) {
-		Com_Printf( "ERROR: too many bevels\n" );
+		CM_PatchWarning( pw, qfalse, "ERROR: too many bevels\n" );
 		return;
 	}
 	facet->borderPlanes[facet->numBorders] = facet->surfacePlane;
@@ -1005,16 +1051,19 @@ typedef enum {
 CM_PatchCollideFromGrid
 ==================
 */
-static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
+static void CM_PatchCollideFromGrid( patchWork_t *pw ) {
 	int				i, j;
 	float			*p1, *p2, *p3;
-	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
+	cGrid_t			*grid;
+	int				(*gridPlanes)[MAX_GRID_SIZE][2];
 	facet_t			*facet;
 	int				borders[4];
 	int				noAdjust[4];
 
-	numPlanes = 0;
-	numFacets = 0;
+	grid = &pw->grid;
+	gridPlanes = pw->gridPlanes;
+	pw->numPlanes = 0;
+	pw->numFacets = 0;
 
 	// find the planes for each triangle of the grid
 	for ( i = 0 ; i < grid->width - 1 ; i++ ) {
@@ -1022,12 +1071,12 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 			p1 = grid->points[i][j];
 			p2 = grid->points[i+1][j];
 			p3 = grid->points[i+1][j+1];
-			gridPlanes[i][j][0] = CM_FindPlane( p1, p2, p3 );
+			gridPlanes[i][j][0] = CM_FindPlane( pw, p1, p2, p3 );
 
 			p1 = grid->points[i+1][j+1];
 			p2 = grid->points[i][j+1];
 			p3 = grid->points[i][j];
-			gridPlanes[i][j][1] = CM_FindPlane( p1, p2, p3 );
+			gridPlanes[i][j][1] = CM_FindPlane( pw, p1, p2, p3 );
 		}
 	}
 
@@ -1043,7 +1092,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 			} 
 			noAdjust[EN_TOP] = ( borders[EN_TOP] == gridPlanes[i][j][0] );
 			if ( borders[EN_TOP] == -1 || noAdjust[EN_TOP] ) {
-				borders[EN_TOP] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 0 );
+				borders[EN_TOP] = CM_EdgePlaneNum( pw, i, j, 0 );
 			}
 
 			borders[EN_BOTTOM] = -1;
@@ -1054,7 +1103,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_BOTTOM] = ( borders[EN_BOTTOM] == gridPlanes[i][j][1] );
 			if ( borders[EN_BOTTOM] == -1 || noAdjust[EN_BOTTOM] ) {
-				borders[EN_BOTTOM] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 2 );
+				borders[EN_BOTTOM] = CM_EdgePlaneNum( pw, i, j, 2 );
 			}
 
 			borders[EN_LEFT] = -1;
@@ -1065,7 +1114,7 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_LEFT] = ( borders[EN_LEFT] == gridPlanes[i][j][1] );
 			if ( borders[EN_LEFT] == -1 || noAdjust[EN_LEFT] ) {
-				borders[EN_LEFT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 3 );
+				borders[EN_LEFT] = CM_EdgePlaneNum( pw, i, j, 3 );
 			}
 
 			borders[EN_RIGHT] = -1;
@@ -1076,13 +1125,17 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 			}
 			noAdjust[EN_RIGHT] = ( borders[EN_RIGHT] == gridPlanes[i][j][0] );
 			if ( borders[EN_RIGHT] == -1 || noAdjust[EN_RIGHT] ) {
-				borders[EN_RIGHT] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 1 );
+				borders[EN_RIGHT] = CM_EdgePlaneNum( pw, i, j, 1 );
 			}
 
-			if ( numFacets == MAX_FACETS ) {
-				Com_Error( ERR_DROP, "MAX_FACETS" );
+			if ( pw->error ) {
+				return;
+			}
+			if ( pw->numFacets == MAX_FACETS ) {
+				CM_PatchError( pw, "MAX_FACETS" );
+				return;
 			}
-			facet = &facets[numFacets];
+			facet = &pw->facets[pw->numFacets];
 			Com_Memset( facet, 0, sizeof( *facet ) );
 
 			if ( gridPlanes[i][j][0] == gridPlanes[i][j][1] ) {
@@ -1099,10 +1152,10 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				facet->borderNoAdjust[2] = noAdjust[EN_BOTTOM];
 				facet->borderPlanes[3] = borders[EN_LEFT];
 				facet->borderNoAdjust[3] = noAdjust[EN_LEFT];
-				CM_SetBorderInward( facet, grid, gridPlanes, i, j, -1 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+				CM_SetBorderInward( pw, facet, i, j, -1 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 			} else {
 				// two separate triangles
@@ -1116,19 +1169,20 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				if ( facet->borderPlanes[2] == -1 ) {
 					facet->borderPlanes[2] = borders[EN_BOTTOM];
 					if ( facet->borderPlanes[2] == -1 ) {
-						facet->borderPlanes[2] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 4 );
+						facet->borderPlanes[2] = CM_EdgePlaneNum( pw, i, j, 4 );
 					}
 				}
- 				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 0 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+ 				CM_SetBorderInward( pw, facet, i, j, 0 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 
-				if ( numFacets == MAX_FACETS ) {
-					Com_Error( ERR_DROP, "MAX_FACETS" );
+				if ( pw->numFacets == MAX_FACETS ) {
+					CM_PatchError( pw, "MAX_FACETS" );
+					return;
 				}
-				facet = &facets[numFacets];
+				facet = &pw->facets[pw->numFacets];
 				Com_Memset( facet, 0, sizeof( *facet ) );
 
 				facet->surfacePlane = gridPlanes[i][j][1];
@@ -1141,46 +1195,32 @@ static void CM_PatchCollideFromGrid( cGrid_t *grid, patchCollide_t *pf ) {
 				if ( facet->borderPlanes[2] == -1 ) {
 					facet->borderPlanes[2] = borders[EN_TOP];
 					if ( facet->borderPlanes[2] == -1 ) {
-						facet->borderPlanes[2] = CM_EdgePlaneNum( grid, gridPlanes, i, j, 5 );
+						facet->borderPlanes[2] = CM_EdgePlaneNum( pw, i, j, 5 );
 					}
 				}
-				CM_SetBorderInward( facet, grid, gridPlanes, i, j, 1 );
-				if ( CM_ValidateFacet( facet ) ) {
-					CM_AddFacetBevels( facet );
-					numFacets++;
+				CM_SetBorderInward( pw, facet, i, j, 1 );
+				if ( CM_ValidateFacet( pw, facet ) ) {
+					CM_AddFacetBevels( pw, facet );
+					pw->numFacets++;
 				}
 			}
 		}
 	}
 
-	// copy the results out
-	pf->numPlanes = numPlanes;
-	pf->numFacets = numFacets;
-	pf->facets = Hunk_Alloc( numFacets * sizeof( *pf->facets ), h_high );
-	Com_Memcpy( pf->facets, facets, numFacets * sizeof( *pf->facets ) );
-	pf->planes = Hunk_Alloc( numPlanes * sizeof( *pf->planes ), h_high );
-	Com_Memcpy( pf->planes, planes, numPlanes * sizeof( *pf->planes ) );
 }
 
 
 /*
 ===================
-CM_GeneratePatchCollide
+CM_CheckPatchSize
 
-Creates an internal structure that will be used to perform
-collision detection with a patch mesh.
-
-Points is packed as concatenated rows.
+Errors out on patch dimensions CM_GeneratePatchWork can not handle
 ===================
 */
-struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
-	patchCollide_t	*pf;
-	cGrid_t			grid;
-	int				i, j;
-
-	if ( width <= 2 || height <= 2 || !points ) {
-		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
-			width, height, (void *)points );
+void CM_CheckPatchSize( int width, int height ) {
+	if ( width <= 2 || height <= 2 ) {
+		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i)",
+			width, height );
 	}
 
 	if ( !(width & 1) || !(height & 1) ) {
@@ -1190,44 +1230,113 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	if ( width > MAX_GRID_SIZE || height > MAX_GRID_SIZE ) {
 		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: source is > MAX_GRID_SIZE" );
 	}
+}
+
+
+/*
+===================
+CM_GeneratePatchWork
+
+Subdivides a patch mesh and builds its facets and planes into pw.
+The size must have passed CM_CheckPatchSize.
+
+This does not print, allocate or error, so it can be run from
+Com_RunJobs workers; problems are kept in pw for CM_FinishPatchCollide.
+===================
+*/
+void CM_GeneratePatchWork( patchWork_t *pw, int width, int height, vec3_t *points ) {
+	cGrid_t			*grid;
+	int				i, j;
+
+	pw->error = NULL;
+	pw->numWarnings = 0;
+	pw->debugBlock = qfalse;
+	pw->numPlanes = 0;
+	pw->numFacets = 0;
 
 	// build a grid
-	grid.width = width;
-	grid.height = height;
-	grid.wrapWidth = qfalse;
-	grid.wrapHeight = qfalse;
+	grid = &pw->grid;
+	grid->width = width;
+	grid->height = height;
+	grid->wrapWidth = qfalse;
+	grid->wrapHeight = qfalse;
 	for ( i = 0 ; i < width ; i++ ) {
 		for ( j = 0 ; j < height ; j++ ) {
-			VectorCopy( points[j*width + i], grid.points[i][j] );
+			VectorCopy( points[j*width + i], grid->points[i][j] );
 		}
 	}
 
 	// subdivide the grid
-	CM_SetGridWrapWidth( &grid );
-	CM_SubdivideGridColumns( &grid );
-	CM_RemoveDegenerateColumns( &grid );
+	CM_SetGridWrapWidth( grid );
+	CM_SubdivideGridColumns( grid );
+	CM_RemoveDegenerateColumns( grid );
 
-	CM_TransposeGrid( &grid );
+	CM_TransposeGrid( grid );
 
-	CM_SetGridWrapWidth( &grid );
-	CM_SubdivideGridColumns( &grid );
-	CM_RemoveDegenerateColumns( &grid );
+	CM_SetGridWrapWidth( grid );
+	CM_SubdivideGridColumns( grid );
+	CM_RemoveDegenerateColumns( grid );
 
 	// we now have a grid of points exactly on the curve
 	// the approximate surface defined by these points will be
 	// collided against
-	pf = Hunk_Alloc( sizeof( *pf ), h_high );
-	ClearBounds( pf->bounds[0], pf->bounds[1] );
-	for ( i = 0 ; i < grid.width ; i++ ) {
-		for ( j = 0 ; j < grid.height ; j++ ) {
-			AddPointToBounds( grid.points[i][j], pf->bounds[0], pf->bounds[1] );
+	ClearBounds( pw->bounds[0], pw->bounds[1] );
+	for ( i = 0 ; i < grid->width ; i++ ) {
+		for ( j = 0 ; j < grid->height ; j++ ) {
+			AddPointToBounds( grid->points[i][j], pw->bounds[0], pw->bounds[1] );
 		}
 	}
 
-	c_totalPatchBlocks += ( grid.width - 1 ) * ( grid.height - 1 );
+	pw->numBlocks = ( grid->width - 1 ) * ( grid->height - 1 );
 
 	// generate a bsp tree for the surface
-	CM_PatchCollideFromGrid( &grid, pf );
+	CM_PatchCollideFromGrid( pw );
+}
+
+
+/*
+===================
+CM_FinishPatchCollide
+
+Reports the problems found by CM_GeneratePatchWork and copies
+its results out to the hunk
+===================
+*/
+struct patchCollide_s *CM_FinishPatchCollide( patchWork_t *pw ) {
+	patchCollide_t	*pf;
+	int				i;
+
+	if ( pw->error ) {
+		Com_Error( ERR_DROP, "%s", pw->error );
+	}
+
+	for ( i = 0 ; i < pw->numWarnings ; i++ ) {
+		if ( pw->developerWarning[i] ) {
+			Com_DPrintf( "%s", pw->warnings[i] );
+		} else {
+			Com_Printf( "%s", pw->warnings[i] );
+		}
+	}
+
+	if ( pw->debugBlock && !debugBlock ) {
+		debugBlock = qtrue;
+		for ( i = 0 ; i < 4 ; i++ ) {
+			VectorCopy( pw->debugBlockPoints[i], debugBlockPoints[i] );
+		}
+	}
+
+	c_totalPatchBlocks += pw->numBlocks;
+
+	// copy the results out
+	pf = Hunk_Alloc( sizeof( *pf ), h_high );
+	VectorCopy( pw->bounds[0], pf->bounds[0] );
+	VectorCopy( pw->bounds[1], pf->bounds[1] );
+	pf->numPlanes = pw->numPlanes;
+	pf->numFacets = pw->numFacets;
+	pf->facets = Hunk_Alloc( pw->numFacets * sizeof( *pf->facets ), h_high );
+	Com_Memcpy( pf->facets, pw->facets, pw->numFacets * sizeof( *pf->facets ) );
+	pf->planes = Hunk_Alloc( pw->numPlanes * sizeof( *pf->planes ), h_high );
+	Com_Memcpy( pf->planes, pw->planes, pw->numPlanes * sizeof( *pf->planes ) );
 
 	// expand by one unit for epsilon purposes
 	pf->bounds[0][0] -= 1;
@@ -1241,6 +1350,209 @@ struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *p
 	return pf;
 }
 
+
+/*
+===================
+CM_GeneratePatchCollide
+
+Creates an internal structure that will be used to perform
+collision detection with a patch mesh.
+
+Points is packed as concatenated rows.
+===================
+*/
+struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points ) {
+	static patchWork_t	pw;
+
+	CM_CheckPatchSize( width, height );
+	if ( !points ) {
+		Com_Error( ERR_DROP, "CM_GeneratePatchFacets: bad parameters: (%i, %i, %p)",
+			width, height, (void *)points );
+	}
+
+	CM_GeneratePatchWork( &pw, width, height, points );
+
+	return CM_FinishPatchCollide( &pw );
+}
+
+/*
+================================================================================
+
+PATCH COLLIDE CACHE
+
+Generated patch collides are saved by CMod_LoadPatches, so later loads of
+the same map can read them back instead of subdividing every patch again.
+All values are stored little endian.
+
+================================================================================
+*/
+
+static byte *CM_CacheWriteInt( byte *out, int v ) {
+	v = LittleLong( v );
+	Com_Memcpy( out, &v, 4 );
+	return out + 4;
+}
+
+static byte *CM_CacheWriteFloat( byte *out, float v ) {
+	v = LittleFloat( v );
+	Com_Memcpy( out, &v, 4 );
+	return out + 4;
+}
+
+static int CM_CacheReadInt( const byte **in ) {
+	int		v;
+
+	Com_Memcpy( &v, *in, 4 );
+	*in += 4;
+	return LittleLong( v );
+}
+
+static float CM_CacheReadFloat( const byte **in ) {
+	float	v;
+
+	Com_Memcpy( &v, *in, 4 );
+	*in += 4;
+	return LittleFloat( v );
+}
+
+/*
+==================
+CM_PatchCollideCacheSize
+
+Bytes CM_WritePatchCollideCache will use for pc
+==================
+*/
+int CM_PatchCollideCacheSize( const struct patchCollide_s *pc ) {
+	int		i, size;
+
+	size = 8 * 4 + pc->numPlanes * 5 * 4;
+	for ( i = 0 ; i < pc->numFacets ; i++ ) {
+		size += 2 * 4 + pc->facets[i].numBorders * 3 * 4;
+	}
+
+	return size;
+}
+
+/*
+==================
+CM_WritePatchCollideCache
+==================
+*/
+byte *CM_WritePatchCollideCache( byte *out, const struct patchCollide_s *pc ) {
+	const facet_t	*facet;
+	int				i, j;
+
+	for ( i = 0 ; i < 3 ; i++ ) {
+		out = CM_CacheWriteFloat( out, pc->bounds[0][i] );
+		out = CM_CacheWriteFloat( out, pc->bounds[1][i] );
+	}
+	out = CM_CacheWriteInt( out, pc->numPlanes );
+	out = CM_CacheWriteInt( out, pc->numFacets );
+
+	for ( i = 0 ; i < pc->numPlanes ; i++ ) {
+		for ( j = 0 ; j < 4 ; j++ ) {
+			out = CM_CacheWriteFloat( out, pc->planes[i].plane[j] );
+		}
+		out = CM_CacheWriteInt( out, pc->planes[i].signbits );
+	}
+
+	for ( i = 0, facet = pc->facets ; i < pc->numFacets ; i++, facet++ ) {
+		out = CM_CacheWriteInt( out, facet->surfacePlane );
+		out = CM_CacheWriteInt( out, facet->numBorders );
+		for ( j = 0 ; j < facet->numBorders ; j++ ) {
+			out = CM_CacheWriteInt( out, facet->borderPlanes[j] );
+			out = CM_CacheWriteInt( out, facet->borderInward[j] );
+			out = CM_CacheWriteInt( out, facet->borderNoAdjust[j] );
+		}
+	}
+
+	return out;
+}
+
+/*
+==================
+CM_ReadPatchCollideCache
+
+Reads back one patch collide written by CM_WritePatchCollideCache and
+advances *in past it.  The record is checked before anything is allocated,
+so a truncated or damaged cache returns NULL without using any hunk.
+==================
+*/
+struct patchCollide_s *CM_ReadPatchCollideCache( const byte **in, const byte *end ) {
+	patchCollide_t	*pf;
+	facet_t			*facet;
+	const byte		*p;
+	int				i, j, numPlanes, numFacets, numBorders, planeNum;
+
+	// check the record
+	p = *in;
+	if ( end - p < 8 * 4 ) {
+		return NULL;
+	}
+	p += 6 * 4;
+	numPlanes = CM_CacheReadInt( &p );
+	numFacets = CM_CacheReadInt( &p );
+	if ( numPlanes < 0 || numPlanes > MAX_PATCH_PLANES || numFacets < 0 || numFacets > MAX_FACETS ) {
+		return NULL;
+	}
+	if ( end - p < numPlanes * 5 * 4 ) {
+		return NULL;
+	}
+	p += numPlanes * 5 * 4;
+	for ( i = 0 ; i < numFacets ; i++ ) {
+		if ( end - p < 2 * 4 ) {
+			return NULL;
+		}
+		planeNum = CM_CacheReadInt( &p );
+		numBorders = CM_CacheReadInt( &p );
+		if ( planeNum < 0 || planeNum >= numPlanes || numBorders < 0 || numBorders > 4+6+16 ) {
+			return NULL;
+		}
+		if ( end - p < numBorders * 3 * 4 ) {
+			return NULL;
+		}
+		for ( j = 0 ; j < numBorders ; j++ ) {
+			planeNum = CM_CacheReadInt( &p );
+			if ( planeNum < 0 || planeNum >= numPlanes ) {
+				return NULL;
+			}
+			p += 2 * 4;
+		}
+	}
+
+	// copy it out
+	p = *in;
+	pf = Hunk_Alloc( sizeof( *pf ), h_high );
+	for ( i = 0 ; i < 3 ; i++ ) {
+		pf->bounds[0][i] = CM_CacheReadFloat( &p );
+		pf->bounds[1][i] = CM_CacheReadFloat( &p );
+	}
+	pf->numPlanes = CM_CacheReadInt( &p );
+	pf->numFacets = CM_CacheReadInt( &p );
+
+	pf->planes = Hunk_Alloc( pf->numPlanes * sizeof( *pf->planes ), h_high );
+	for ( i = 0 ; i < pf->numPlanes ; i++ ) {
+		for ( j = 0 ; j < 4 ; j++ ) {
+			pf->planes[i].plane[j] = CM_CacheReadFloat( &p );
+		}
+		pf->planes[i].signbits = CM_CacheReadInt( &p ) & 7;
+	}
+
+	pf->facets = Hunk_Alloc( pf->numFacets * sizeof( *pf->facets ), h_high );
+	for ( i = 0, facet = pf->facets ; i < pf->numFacets ; i++, facet++ ) {
+		facet->surfacePlane = CM_CacheReadInt( &p );
+		facet->numBorders = CM_CacheReadInt( &p );
+		for ( j = 0 ; j < facet->numBorders ; j++ ) {
+			facet->borderPlanes[j] = CM_CacheReadInt( &p );
+			facet->borderInward[j] = CM_CacheReadInt( &p );
+			facet->borderNoAdjust[j] = CM_CacheReadInt( &p );
+		}
+	}
+
+	*in = p;
+	return pf;
+}
+
 /*
 ================================================================================
 
@@ -1265,9 +1577,6 @@ void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patchCollid
 	int			i, j, k;
 	float		offset;
 	float		d1, d2;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
 
 #ifndef BSPC
 	if ( !cm_playerCurveClip->integer || !tw->isPoint ) {
@@ -1325,10 +1634,7 @@ void CM_TracePointThroughPatchCollide( traceWork_t *tw, const struct patchCollid
 		if ( j == facet->numBorders ) {
 			// we hit this facet
 #ifndef BSPC
-			if (!cv) {
-				cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-			}
-			if (cv->integer) {
+			if (debugSurfaceUpdate && debugSurfaceUpdate->integer) {
 				debugPatchCollide = pc;
 				debugFacet = facet;
 			}
@@ -1409,9 +1715,6 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 	facet_t	*facet;
 	float plane[4] = {0, 0, 0, 0}, bestplane[4] = {0, 0, 0, 0};
 	vec3_t startp, endp;
-#ifndef BSPC
-	static cvar_t *cv;
-#endif //BSPC
 
 	if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1],
 				pc->bounds[0], pc->bounds[1] ) ) {
@@ -1512,10 +1815,7 @@ void CM_TraceThroughPatchCollide( traceWork_t *tw, const struct patchCollide_s *
 					enterFrac = 0;
 				}
 #ifndef BSPC
-				if (!cv) {
-					cv = Cvar_Get( "r_debugSurfaceUpdate", "1", 0 );
-				}
-				if (cv && cv->integer) {
+				if (debugSurfaceUpdate && debugSurfaceUpdate->integer) {
 					debugPatchCollide = pc;
 					debugFacet = facet;
 				}
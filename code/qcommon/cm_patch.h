@@ -99,5 +99,35 @@ typedef struct {
 #define	PLANE_TRI_EPSILON	0.1
 #define	WRAP_POINT_EPSILON	0.1
 
+#define	MAX_PATCH_WARNINGS	8
+
+// everything one patch collide is built in, so CM_GeneratePatchWork can run
+// on several threads at once; errors and warnings are kept for
+// CM_FinishPatchCollide to report on the main thread
+typedef struct {
+	cGrid_t			grid;
+	int				gridPlanes[MAX_GRID_SIZE][MAX_GRID_SIZE][2];
+
+	int				numPlanes;
+	patchPlane_t	planes[MAX_PATCH_PLANES];
+
+	int				numFacets;
+	facet_t			facets[MAX_FACETS];
+
+	vec3_t			bounds[2];
+	int				numBlocks;
+
+	const char		*error;
+	int				numWarnings;
+	const char		*warnings[MAX_PATCH_WARNINGS];
+	qboolean		developerWarning[MAX_PATCH_WARNINGS];
+
+	qboolean		debugBlock;
+	vec3_t			debugBlockPoints[4];
+} patchWork_t;
+
 
 struct patchCollide_s	*CM_GeneratePatchCollide( int width, int height, vec3_t *points );
+void CM_CheckPatchSize( int width, int height );
+void CM_GeneratePatchWork( patchWork_t *pw, int width, int height, vec3_t *points );
+struct patchCollide_s	*CM_FinishPatchCollide( patchWork_t *pw );
@@ -196,15 +196,16 @@ void	WindingCenter (winding_t *w, vec3_t center)
 
 /*
 =================
-BaseWindingForPlane
+BaseWindingForPlaneFixed
+
+Returns false and sets *error for a normal with no major axis
 =================
 */
-winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
+qboolean BaseWindingForPlaneFixed (fixedWinding_t *w, vec3_t normal, vec_t dist, const char **error)
 {
 	int		i, x;
 	vec_t	max, v;
 	vec3_t	org, vright, vup;
-	winding_t	*w;
 	
 // find the major axis
 
@@ -220,7 +221,11 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 		}
 	}
 	if (x==-1)
-		Com_Error (ERR_DROP, "BaseWindingForPlane: no axis found");
+	{
+		w->numpoints = 0;
+		*error = "BaseWindingForPlane: no axis found";
+		return qfalse;
+	}
 		
 	VectorCopy (vec3_origin, vup);	
 	switch (x)
@@ -246,8 +251,6 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 	VectorScale (vright, MAX_MAP_BOUNDS, vright);
 
 // project a really big	axis aligned box onto the plane
-	w = AllocWinding (4);
-	
 	VectorSubtract (org, vright, w->p[0]);
 	VectorAdd (w->p[0], vup, w->p[0]);
 	
@@ -262,6 +265,27 @@ winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
 	
 	w->numpoints = 4;
 	
+	return qtrue;
+}
+
+/*
+=================
+BaseWindingForPlane
+=================
+*/
+winding_t *BaseWindingForPlane (vec3_t normal, vec_t dist)
+{
+	fixedWinding_t	base;
+	winding_t	*w;
+	const char	*error;
+
+	if (!BaseWindingForPlaneFixed (&base, normal, dist, &error))
+		Com_Error (ERR_DROP, "%s", error);
+
+	w = AllocWinding (4);
+	Com_Memcpy (w->p, base.p, sizeof(w->p[0]) * 4);
+	w->numpoints = 4;
+	
 	return w;	
 }
 
@@ -415,23 +439,24 @@ void	ClipWindingEpsilon (winding_t *in, vec3_t normal, vec_t dist,
 
 /*
 =============
-ChopWindingInPlace
+ChopWindingPoints
+
+Writes the part of in that is on the front side of the plane to out.
+Returns the number of points written, 0 if nothing is in front, or -1
+if everything is and in can be kept as it is.
 =============
 */
-void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t epsilon)
+static int ChopWindingPoints (const winding_t *in, vec3_t normal, vec_t dist, vec_t epsilon,
+							  vec3_t out[MAX_POINTS_ON_WINDING+4])
 {
-	winding_t	*in;
 	vec_t	dists[MAX_POINTS_ON_WINDING+4] = { 0 };
 	int		sides[MAX_POINTS_ON_WINDING+4] = { 0 };
 	int		counts[3];
-	static	vec_t	dot;		// VC 4.2 optimizer bug if not static
-	int		i, j;
-	vec_t	*p1, *p2;
+	vec_t	dot;
+	int		i, j, numpoints;
+	const vec_t	*p1, *p2;
 	vec3_t	mid;
-	winding_t	*f;
-	int		maxpts;
 
-	in = *inout;
 	counts[0] = counts[1] = counts[2] = 0;
 
 // determine sides for each point
@@ -454,34 +479,26 @@ void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t eps
 	dists[i] = dists[0];
 	
 	if (!counts[0])
-	{
-		FreeWinding (in);
-		*inout = NULL;
-		return;
-	}
+		return 0;
 	if (!counts[1])
-		return;		// inout stays the same
-
-	maxpts = in->numpoints+4;	// can't use counts[0]+2 because
-								// of fp grouping errors
+		return -1;
 
-	f = AllocWinding (maxpts);
-		
+	numpoints = 0;
 	for (i=0 ; i<in->numpoints ; i++)
 	{
 		p1 = in->p[i];
 		
 		if (sides[i] == SIDE_ON)
 		{
-			VectorCopy (p1, f->p[f->numpoints]);
-			f->numpoints++;
+			VectorCopy (p1, out[numpoints]);
+			numpoints++;
 			continue;
 		}
 	
 		if (sides[i] == SIDE_FRONT)
 		{
-			VectorCopy (p1, f->p[f->numpoints]);
-			f->numpoints++;
+			VectorCopy (p1, out[numpoints]);
+			numpoints++;
 		}
 
 		if (sides[i+1] == SIDE_ON || sides[i+1] == sides[i])
@@ -501,19 +518,91 @@ void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t eps
 				mid[j] = p1[j] + dot*(p2[j]-p1[j]);
 		}
 			
-		VectorCopy (mid, f->p[f->numpoints]);
-		f->numpoints++;
+		VectorCopy (mid, out[numpoints]);
+		numpoints++;
 	}
-	
-	if (f->numpoints > maxpts)
+
+	return numpoints;
+}
+
+/*
+=============
+ChopWindingInPlace
+=============
+*/
+void ChopWindingInPlace (winding_t **inout, vec3_t normal, vec_t dist, vec_t epsilon)
+{
+	winding_t	*in;
+	vec3_t		points[MAX_POINTS_ON_WINDING+4];
+	int			numpoints;
+	winding_t	*f;
+	int			maxpts;
+
+	in = *inout;
+
+	numpoints = ChopWindingPoints (in, normal, dist, epsilon, points);
+	if (!numpoints)
+	{
+		FreeWinding (in);
+		*inout = NULL;
+		return;
+	}
+	if (numpoints < 0)
+		return;		// inout stays the same
+
+	maxpts = in->numpoints+4;	// can't use counts[0]+2 because
+								// of fp grouping errors
+
+	if (numpoints > maxpts)
 		Com_Error (ERR_DROP, "ClipWinding: points exceeded estimate");
-	if (f->numpoints > MAX_POINTS_ON_WINDING)
+	if (numpoints > MAX_POINTS_ON_WINDING)
 		Com_Error (ERR_DROP, "ClipWinding: MAX_POINTS_ON_WINDING");
 
+	f = AllocWinding (maxpts);
+	Com_Memcpy (f->p, points, sizeof(points[0]) * numpoints);
+	f->numpoints = numpoints;
+
 	FreeWinding (in);
 	*inout = f;
 }
 
+/*
+=============
+ChopFixedWinding
+
+ChopWindingInPlace for a fixedWinding_t.  Where ChopWindingInPlace drops
+the game, this empties the winding and sets *error.
+=============
+*/
+qboolean ChopFixedWinding (fixedWinding_t *w, vec3_t normal, vec_t dist, vec_t epsilon, const char **error)
+{
+	vec3_t		points[MAX_POINTS_ON_WINDING+4];
+	int			numpoints;
+
+	if (!w->numpoints)
+		return qfalse;
+
+	numpoints = ChopWindingPoints ((winding_t *)w, normal, dist, epsilon, points);
+	if (numpoints < 0)
+		return qtrue;		// nothing behind the plane
+
+	if (numpoints > w->numpoints+4)
+	{
+		*error = "ClipWinding: points exceeded estimate";
+		numpoints = 0;
+	}
+	else if (numpoints > MAX_POINTS_ON_WINDING)
+	{
+		*error = "ClipWinding: MAX_POINTS_ON_WINDING";
+		numpoints = 0;
+	}
+
+	Com_Memcpy (w->p, points, sizeof(points[0]) * numpoints);
+	w->numpoints = numpoints;
+
+	return numpoints != 0;
+}
+
 
 /*
 =================
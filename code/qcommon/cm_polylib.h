@@ -30,6 +30,14 @@ typedef struct
 
 #define	MAX_POINTS_ON_WINDING	64
 
+// a winding in caller storage, laid out like winding_t so it can be passed
+// to the functions below that don't free or resize their winding
+typedef struct
+{
+	int		numpoints;
+	vec3_t	p[MAX_POINTS_ON_WINDING];
+} fixedWinding_t;
+
 #define	SIDE_FRONT	0
 #define	SIDE_BACK	1
 #define	SIDE_ON		2
@@ -65,4 +73,11 @@ void	AddWindingToConvexHull( winding_t *w, winding_t **hull, vec3_t normal );
 void	ChopWindingInPlace (winding_t **w, vec3_t normal, vec_t dist, vec_t epsilon);
 // frees the original if clipped
 
+// these two don't allocate, print or raise errors, so any thread may use them;
+// instead of the ERR_DROP of the allocating versions they return false and
+// set *error, which the caller has to raise
+qboolean	BaseWindingForPlaneFixed (fixedWinding_t *w, vec3_t normal, vec_t dist, const char **error);
+qboolean	ChopFixedWinding (fixedWinding_t *w, vec3_t normal, vec_t dist, vec_t epsilon, const char **error);
+// false once the winding is chopped away
+
 void pw(winding_t *w);
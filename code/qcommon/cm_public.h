@@ -31,6 +31,7 @@ clipHandle_t CM_TempBoxModel( const vec3_t mins, const vec3_t maxs, int capsule
 void		CM_ModelBounds( clipHandle_t model, vec3_t mins, vec3_t maxs );
 
 int			CM_NumClusters (void);
+int			CM_NumAreas (void);
 int			CM_NumInlineModels( void );
 char		*CM_EntityString (void);
 
@@ -38,6 +39,9 @@ char		*CM_EntityString (void);
 int			CM_PointContents( const vec3_t p, clipHandle_t model );
 int			CM_TransformedPointContents( const vec3_t p, clipHandle_t model, const vec3_t origin, const vec3_t angles );
 
+// traces and point queries against the world and inline models may run on
+// several threads at once, as long as nothing loads or clears the map
+// meanwhile; CM_TempBoxModel handles share one model and stay single threaded
 void		CM_BoxTrace ( trace_t *results, const vec3_t start, const vec3_t end,
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask, int capsule );
@@ -45,8 +49,15 @@ void		CM_TransformedBoxTrace( trace_t *results, const vec3_t start, const vec3_t
 						  vec3_t mins, vec3_t maxs,
 						  clipHandle_t model, int brushmask,
 						  const vec3_t origin, const vec3_t angles, int capsule );
+// CM_BoxTrace for each of count requests, into results[0 .. count-1]
+void		CM_TraceMany( trace_t *results, const traceRequest_t *requests, int count,
+						  clipHandle_t model, int brushmask, int capsule );
 
 byte		*CM_ClusterPVS (int cluster);
+// the same row as aligned 64 bit words, for CM_ClusterListVisible
+const uint64_t	*CM_ClusterPVSWords( int cluster );
+// qtrue if any of the clusters is set in a CM_ClusterPVSWords row
+qboolean	CM_ClusterListVisible( const uint64_t *row, const int *clusters, int numClusters );
 
 int			CM_PointLeafnum( const vec3_t p );
 
@@ -63,5 +74,8 @@ qboolean	CM_AreasConnected( int area1, int area2 );
 
 int			CM_WriteAreaBits( byte *buffer, int area );
 
+// prints and clears the trace counters
+void		CM_Stats_f( void );
+
 // cm_patch.c
 void CM_DrawDebugSurface( void (*drawPoly)(int color, int numPoints, float *points) );
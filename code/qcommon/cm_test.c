@@ -30,18 +30,16 @@ CM_PointLeafnum_r
 */
 int CM_PointLeafnum_r( const vec3_t p, int num ) {
 	float		d;
-	cNode_t		*node;
-	cplane_t	*plane;
+	const cFlatNode_t	*node;
 
 	while (num >= 0)
 	{
-		node = cm.nodes + num;
-		plane = node->plane;
-		
-		if (plane->type < 3)
-			d = p[plane->type] - plane->dist;
+		node = cm.flatNodes + num;
+
+		if (node->type < 3)
+			d = p[node->type] - node->dist;
 		else
-			d = DotProduct (plane->normal, p) - plane->dist;
+			d = DotProduct (node->normal, p) - node->dist;
 		if (d < 0)
 			num = node->children[1];
 		else
@@ -69,6 +67,53 @@ LEAF LISTING
 ======================================================================
 */
 
+#ifdef _MSC_VER
+#define	CM_THREAD_LOCAL		__declspec( thread )
+#else
+#define	CM_THREAD_LOCAL		__thread
+#endif
+
+static CM_THREAD_LOCAL cmVisits_t	cm_visits;
+
+/*
+==================
+CM_NewVisits
+
+Brushes and patches are stamped when a trace or brush listing first looks
+at them, so one that sits in several leafs is only tested once.  The stamps
+live in arrays of the calling thread instead of the shared brushes, so
+traces on several threads never see or write each other's.
+
+Stamps only grow, so the arrays don't need clearing when a new map is
+loaded, only growing when it has more brushes or surfaces.  The arrays
+come from malloc as this can run on worker threads.
+==================
+*/
+cmVisits_t *CM_NewVisits( void ) {
+	cmVisits_t	*v;
+	int			numBrushes;
+
+	v = &cm_visits;
+
+	// the box model brush sits after the map brushes
+	numBrushes = cm.numBrushes + 1;
+
+	if ( v->maxBrushes < numBrushes || v->maxPatches < cm.numSurfaces || v->stamp == INT_MAX ) {
+		free( v->brushes );
+		free( v->patches );
+		v->maxBrushes = MAX( numBrushes, v->maxBrushes );
+		v->maxPatches = MAX( cm.numSurfaces, v->maxPatches );
+		v->brushes = calloc( v->maxBrushes, sizeof( *v->brushes ) );
+		v->patches = calloc( v->maxPatches + 1, sizeof( *v->patches ) );
+		if ( !v->brushes || !v->patches ) {
+			Com_Error( ERR_FATAL, "CM_NewVisits: out of memory" );
+		}
+		v->stamp = 0;
+	}
+
+	v->stamp++;
+	return v;
+}
 
 void CM_StoreLeafs( leafList_t *ll, int nodenum ) {
 	int		leafNum;
@@ -101,10 +146,10 @@ void CM_StoreBrushes( leafList_t *ll, int nodenum ) {
 	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
 		b = &cm.brushes[brushnum];
-		if ( b->checkcount == cm.checkcount ) {
+		if ( ll->visits->brushes[brushnum] == ll->checkcount ) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		ll->visits->brushes[brushnum] = ll->checkcount;
 		for ( i = 0 ; i < 3 ; i++ ) {
 			if ( b->bounds[0][i] >= ll->bounds[1][i] || b->bounds[1][i] <= ll->bounds[0][i] ) {
 				break;
@@ -138,9 +183,9 @@ Fills in a list of all the leafs touched
 =============
 */
 void CM_BoxLeafnums_r( leafList_t *ll, int nodenum ) {
-	cplane_t	*plane;
-	cNode_t		*node;
-	int			s;
+	const cFlatNode_t	*node;
+	float		dist1, dist2;
+	int			i, s;
 
 	while (1) {
 		if (nodenum < 0) {
@@ -148,9 +193,35 @@ void CM_BoxLeafnums_r( leafList_t *ll, int nodenum ) {
 			return;
 		}
 	
-		node = &cm.nodes[nodenum];
-		plane = node->plane;
-		s = BoxOnPlaneSide( ll->bounds[0], ll->bounds[1], plane );
+		node = &cm.flatNodes[nodenum];
+		if ( node->type < 3 ) {
+			if ( node->dist <= ll->bounds[0][node->type] ) {
+				s = 1;
+			} else if ( node->dist >= ll->bounds[1][node->type] ) {
+				s = 2;
+			} else {
+				s = 3;
+			}
+		} else {
+			// same corners as BoxOnPlaneSide, picked by normal sign
+			dist1 = dist2 = 0;
+			for ( i = 0 ; i < 3 ; i++ ) {
+				if ( node->normal[i] < 0 ) {
+					dist1 += node->normal[i] * ll->bounds[0][i];
+					dist2 += node->normal[i] * ll->bounds[1][i];
+				} else {
+					dist1 += node->normal[i] * ll->bounds[1][i];
+					dist2 += node->normal[i] * ll->bounds[0][i];
+				}
+			}
+			s = 0;
+			if ( dist1 >= node->dist ) {
+				s = 1;
+			}
+			if ( dist2 < node->dist ) {
+				s |= 2;
+			}
+		}
 		if (s == 1) {
 			nodenum = node->children[0];
 		} else if (s == 2) {
@@ -172,8 +243,6 @@ CM_BoxLeafnums
 int	CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsize, int *lastLeaf) {
 	leafList_t	ll;
 
-	cm.checkcount++;
-
 	VectorCopy( mins, ll.bounds[0] );
 	VectorCopy( maxs, ll.bounds[1] );
 	ll.count = 0;
@@ -182,6 +251,8 @@ int	CM_BoxLeafnums( const vec3_t mins, const vec3_t maxs, int *list, int listsiz
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
+	ll.visits = NULL;		// leafs aren't stamped
+	ll.checkcount = 0;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
@@ -197,13 +268,13 @@ CM_BoxBrushes
 int CM_BoxBrushes( const vec3_t mins, const vec3_t maxs, cbrush_t **list, int listsize ) {
 	leafList_t	ll;
 
-	cm.checkcount++;
-
 	VectorCopy( mins, ll.bounds[0] );
 	VectorCopy( maxs, ll.bounds[1] );
 	ll.count = 0;
 	ll.maxcount = listsize;
 	ll.list = (void *)list;
+	ll.visits = CM_NewVisits();
+	ll.checkcount = ll.visits->stamp;
 	ll.storeLeafs = CM_StoreBrushes;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
@@ -321,6 +392,38 @@ byte	*CM_ClusterPVS (int cluster) {
 	return cm.visibility + cluster * cm.clusterBytes;
 }
 
+/*
+=================
+CM_ClusterPVSWords
+=================
+*/
+const uint64_t *CM_ClusterPVSWords( int cluster ) {
+	if (cluster < 0 || cluster >= cm.numClusters || !cm.vised ) {
+		return cm.visibilityWords;
+	}
+
+	return cm.visibilityWords + cluster * cm.clusterWords;
+}
+
+/*
+=================
+CM_ClusterListVisible
+
+Clusters must be in [0, numClusters)
+=================
+*/
+qboolean CM_ClusterListVisible( const uint64_t *row, const int *clusters, int numClusters ) {
+	int		i;
+
+	for ( i = 0 ; i < numClusters ; i++ ) {
+		if ( row[clusters[i] >> 6] & ( (uint64_t)1 << ( clusters[i] & 63 ) ) ) {
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
 
 
 /*
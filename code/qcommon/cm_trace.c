@@ -28,6 +28,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 //#define CAPSULE_DEBUG
 
+// brush planes are tested four at a time where the instructions are always there
+#if !defined(C_ONLY) && ( defined(__SSE2__) || defined(_M_X64) || ( defined(_M_IX86_FP) && _M_IX86_FP >= 2 ) )
+#include <emmintrin.h>
+#define CM_SSE2
+#elif !defined(C_ONLY) && ( defined(__ARM_NEON) || defined(__ARM_NEON__) )
+#include <arm_neon.h>
+#define CM_NEON
+#endif
+
 /*
 ===============================================================================
 
@@ -241,7 +250,7 @@ CM_TestInLeaf
 */
 void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	int			k;
-	int			brushnum;
+	int			brushnum, patchnum;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
@@ -249,10 +258,10 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	for (k=0 ; k<leaf->numLeafBrushes ; k++) {
 		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
 		b = &cm.brushes[brushnum];
-		if (b->checkcount == cm.checkcount) {
+		if (tw->visits->brushes[brushnum] == tw->checkcount) {
 			continue;	// already checked this brush in another leaf
 		}
-		b->checkcount = cm.checkcount;
+		tw->visits->brushes[brushnum] = tw->checkcount;
 
 		if ( !(b->contents & tw->contents)) {
 			continue;
@@ -271,14 +280,15 @@ void CM_TestInLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif //BSPC
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( tw->visits->patches[patchnum] == tw->checkcount ) {
 				continue;	// already checked this brush in another leaf
 			}
-			patch->checkcount = cm.checkcount;
+			tw->visits->patches[patchnum] = tw->checkcount;
 
 			if ( !(patch->contents & tw->contents)) {
 				continue;
@@ -427,14 +437,11 @@ void CM_PositionTest( traceWork_t *tw ) {
 	ll.storeLeafs = CM_StoreLeafs;
 	ll.lastLeaf = 0;
 	ll.overflowed = qfalse;
-
-	cm.checkcount++;
+	ll.visits = tw->visits;
+	ll.checkcount = tw->checkcount;
 
 	CM_BoxLeafnums_r( &ll, 0 );
 
-
-	cm.checkcount++;
-
 	// test the contents of the leafs
 	for (i=0 ; i < ll.count ; i++) {
 		CM_TestInLeaf( tw, &cm.leafs[leafs[i]] );
@@ -474,13 +481,118 @@ void CM_TraceThroughPatch( traceWork_t *tw, cPatch_t *patch ) {
 	}
 }
 
+/*
+================
+CM_BrushPlaneDistances
+
+Distances of the trace start and end from four brush planes, pushed out
+by the box corner each plane meets first.  Returns qfalse if the trace is
+completely in front of one of them, and so misses the whole brush.
+================
+*/
+static qboolean CM_BrushPlaneDistances( const traceWork_t *tw, const cbrushplanes_t *planes, float *d1, float *d2 ) {
+#if defined(CM_SSE2)
+	__m128		nx, ny, nz, dist, zero, mask;
+	__m128		ox, oy, oz, v1, v2;
+
+	nx = _mm_loadu_ps( planes->normal[0] );
+	ny = _mm_loadu_ps( planes->normal[1] );
+	nz = _mm_loadu_ps( planes->normal[2] );
+	zero = _mm_setzero_ps();
+
+	// tw->offsets[signbits], the size[1] side where the normal is negative
+	mask = _mm_cmplt_ps( nx, zero );
+	ox = _mm_or_ps( _mm_and_ps( mask, _mm_set1_ps( tw->size[1][0] ) ), _mm_andnot_ps( mask, _mm_set1_ps( tw->size[0][0] ) ) );
+	mask = _mm_cmplt_ps( ny, zero );
+	oy = _mm_or_ps( _mm_and_ps( mask, _mm_set1_ps( tw->size[1][1] ) ), _mm_andnot_ps( mask, _mm_set1_ps( tw->size[0][1] ) ) );
+	mask = _mm_cmplt_ps( nz, zero );
+	oz = _mm_or_ps( _mm_and_ps( mask, _mm_set1_ps( tw->size[1][2] ) ), _mm_andnot_ps( mask, _mm_set1_ps( tw->size[0][2] ) ) );
+
+	dist = _mm_sub_ps( _mm_loadu_ps( planes->dist ),
+		_mm_add_ps( _mm_add_ps( _mm_mul_ps( ox, nx ), _mm_mul_ps( oy, ny ) ), _mm_mul_ps( oz, nz ) ) );
+
+	v1 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( tw->start[0] ), nx ),
+		_mm_mul_ps( _mm_set1_ps( tw->start[1] ), ny ) ), _mm_mul_ps( _mm_set1_ps( tw->start[2] ), nz ) );
+	v1 = _mm_sub_ps( v1, dist );
+	v2 = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_set1_ps( tw->end[0] ), nx ),
+		_mm_mul_ps( _mm_set1_ps( tw->end[1] ), ny ) ), _mm_mul_ps( _mm_set1_ps( tw->end[2] ), nz ) );
+	v2 = _mm_sub_ps( v2, dist );
+
+	mask = _mm_and_ps( _mm_cmpgt_ps( v1, zero ),
+		_mm_or_ps( _mm_cmpge_ps( v2, _mm_set1_ps( SURFACE_CLIP_EPSILON ) ), _mm_cmpge_ps( v2, v1 ) ) );
+	if ( _mm_movemask_ps( mask ) ) {
+		return qfalse;
+	}
+
+	_mm_storeu_ps( d1, v1 );
+	_mm_storeu_ps( d2, v2 );
+#elif defined(CM_NEON)
+	float32x4_t	nx, ny, nz, dist, zero;
+	float32x4_t	ox, oy, oz, v1, v2;
+	uint32x4_t	mask;
+	uint32x2_t	any;
+
+	nx = vld1q_f32( planes->normal[0] );
+	ny = vld1q_f32( planes->normal[1] );
+	nz = vld1q_f32( planes->normal[2] );
+	zero = vdupq_n_f32( 0 );
+
+	// tw->offsets[signbits], the size[1] side where the normal is negative
+	ox = vbslq_f32( vcltq_f32( nx, zero ), vdupq_n_f32( tw->size[1][0] ), vdupq_n_f32( tw->size[0][0] ) );
+	oy = vbslq_f32( vcltq_f32( ny, zero ), vdupq_n_f32( tw->size[1][1] ), vdupq_n_f32( tw->size[0][1] ) );
+	oz = vbslq_f32( vcltq_f32( nz, zero ), vdupq_n_f32( tw->size[1][2] ), vdupq_n_f32( tw->size[0][2] ) );
+
+	dist = vsubq_f32( vld1q_f32( planes->dist ),
+		vaddq_f32( vaddq_f32( vmulq_f32( ox, nx ), vmulq_f32( oy, ny ) ), vmulq_f32( oz, nz ) ) );
+
+	v1 = vaddq_f32( vaddq_f32( vmulq_f32( vdupq_n_f32( tw->start[0] ), nx ),
+		vmulq_f32( vdupq_n_f32( tw->start[1] ), ny ) ), vmulq_f32( vdupq_n_f32( tw->start[2] ), nz ) );
+	v1 = vsubq_f32( v1, dist );
+	v2 = vaddq_f32( vaddq_f32( vmulq_f32( vdupq_n_f32( tw->end[0] ), nx ),
+		vmulq_f32( vdupq_n_f32( tw->end[1] ), ny ) ), vmulq_f32( vdupq_n_f32( tw->end[2] ), nz ) );
+	v2 = vsubq_f32( v2, dist );
+
+	mask = vandq_u32( vcgtq_f32( v1, zero ),
+		vorrq_u32( vcgeq_f32( v2, vdupq_n_f32( SURFACE_CLIP_EPSILON ) ), vcgeq_f32( v2, v1 ) ) );
+	any = vorr_u32( vget_low_u32( mask ), vget_high_u32( mask ) );
+	if ( vget_lane_u32( any, 0 ) | vget_lane_u32( any, 1 ) ) {
+		return qfalse;
+	}
+
+	vst1q_f32( d1, v1 );
+	vst1q_f32( d2, v2 );
+#else
+	int			i, j;
+	vec3_t		normal, offset;
+	float		dist;
+
+	for ( i = 0 ; i < 4 ; i++ ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			normal[j] = planes->normal[j][i];
+			offset[j] = tw->size[normal[j] < 0][j];
+		}
+
+		dist = planes->dist[i] - DotProduct( offset, normal );
+		d1[i] = DotProduct( tw->start, normal ) - dist;
+		d2[i] = DotProduct( tw->end, normal ) - dist;
+
+		if ( d1[i] > 0 && ( d2[i] >= SURFACE_CLIP_EPSILON || d2[i] >= d1[i] ) ) {
+			return qfalse;
+		}
+	}
+#endif
+
+	return qtrue;
+}
+
 /*
 ================
 CM_TraceThroughBrush
 ================
 */
 void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
-	int			i;
+	int			i, j;
+	float		d1s[4], d2s[4];
 	cplane_t	*plane, *clipplane;
 	float		dist;
 	float		enterFrac, leaveFrac;
@@ -584,11 +696,15 @@ void CM_TraceThroughBrush( traceWork_t *tw, cbrush_t *brush ) {
 			side = brush->sides + i;
 			plane = side->plane;
 
-			// adjust the plane distance appropriately for mins/maxs
-			dist = plane->dist - DotProduct( tw->offsets[ plane->signbits ], plane->normal );
+			// the distances adjusted appropriately for mins/maxs,
+			// and the test for being in front of the face, four planes at a time
+			j = i & 3;
+			if ( !j && !CM_BrushPlaneDistances( tw, &brush->planes[i >> 2], d1s, d2s ) ) {
+				return;
+			}
 
-			d1 = DotProduct( tw->start, plane->normal ) - dist;
-			d2 = DotProduct( tw->end, plane->normal ) - dist;
+			d1 = d1s[j];
+			d2 = d2s[j];
 
 			if (d2 > 0) {
 				getout = qtrue;	// endpoint is not in solid
@@ -667,29 +783,31 @@ CM_TraceThroughLeaf
 ================
 */
 void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
-	int			k;
-	int			brushnum;
+	int			k, patchnum;
+	const cbrushbounds_t	*bb;
 	cbrush_t	*b;
 	cPatch_t	*patch;
 
-	// trace line against all brushes in the leaf
-	for ( k = 0 ; k < leaf->numLeafBrushes ; k++ ) {
-		brushnum = cm.leafbrushes[leaf->firstLeafBrush+k];
-
-		b = &cm.brushes[brushnum];
-		if ( b->checkcount == cm.checkcount ) {
-			continue;	// already checked this brush in another leaf
+	// trace line against all brushes in the leaf, rejecting the ones the
+	// swept box misses before touching the brush itself
+	bb = leaf->brushBounds;
+	for ( k = 0 ; k < leaf->numLeafBrushes ; k++, bb++ ) {
+		if ( !(bb->contents & tw->contents) ) {
+			continue;
 		}
-		b->checkcount = cm.checkcount;
 
-		if ( !(b->contents & tw->contents) ) {
+		if ( tw->bounds[1][0] < bb->mins[0] || tw->bounds[0][0] > bb->maxs[0]
+			|| tw->bounds[1][1] < bb->mins[1] || tw->bounds[0][1] > bb->maxs[1]
+			|| tw->bounds[1][2] < bb->mins[2] || tw->bounds[0][2] > bb->maxs[2] ) {
+			c_brush_rejects++;
 			continue;
 		}
 
-		if ( !CM_BoundsIntersect( tw->bounds[0], tw->bounds[1],
-					b->bounds[0], b->bounds[1] ) ) {
-			continue;
+		if ( tw->visits->brushes[bb->brushnum] == tw->checkcount ) {
+			continue;	// already checked this brush in another leaf
 		}
+		tw->visits->brushes[bb->brushnum] = tw->checkcount;
+		b = &cm.brushes[bb->brushnum];
 
 		CM_TraceThroughBrush( tw, b );
 		if ( !tw->trace.fraction ) {
@@ -704,14 +822,15 @@ void CM_TraceThroughLeaf( traceWork_t *tw, cLeaf_t *leaf ) {
 	if ( !cm_noCurves->integer ) {
 #endif
 		for ( k = 0 ; k < leaf->numLeafSurfaces ; k++ ) {
-			patch = cm.surfaces[ cm.leafsurfaces[ leaf->firstLeafSurface + k ] ];
+			patchnum = cm.leafsurfaces[ leaf->firstLeafSurface + k ];
+			patch = cm.surfaces[ patchnum ];
 			if ( !patch ) {
 				continue;
 			}
-			if ( patch->checkcount == cm.checkcount ) {
+			if ( tw->visits->patches[patchnum] == tw->checkcount ) {
 				continue;	// already checked this patch in another leaf
 			}
-			patch->checkcount = cm.checkcount;
+			tw->visits->patches[patchnum] = tw->checkcount;
 
 			if ( !(patch->contents & tw->contents) ) {
 				continue;
@@ -1033,8 +1152,7 @@ a smaller intercept fraction.
 ==================
 */
 void CM_TraceThroughTree( traceWork_t *tw, int num, float p1f, float p2f, vec3_t p1, vec3_t p2) {
-	cNode_t		*node;
-	cplane_t	*plane;
+	const cFlatNode_t	*node;
 	float		t1, t2, offset;
 	float		frac, frac2;
 	float		idist;
@@ -1056,17 +1174,16 @@ void CM_TraceThroughTree( traceWork_t *tw, int num, float p1f, float p2f, vec3_t
 	// find the point distances to the separating plane
 	// and the offset for the size of the box
 	//
-	node = cm.nodes + num;
-	plane = node->plane;
+	node = cm.flatNodes + num;
 
 	// adjust the plane distance appropriately for mins/maxs
-	if ( plane->type < 3 ) {
-		t1 = p1[plane->type] - plane->dist;
-		t2 = p2[plane->type] - plane->dist;
-		offset = tw->extents[plane->type];
+	if ( node->type < 3 ) {
+		t1 = p1[node->type] - node->dist;
+		t2 = p2[node->type] - node->dist;
+		offset = tw->extents[node->type];
 	} else {
-		t1 = DotProduct (plane->normal, p1) - plane->dist;
-		t2 = DotProduct (plane->normal, p2) - plane->dist;
+		t1 = DotProduct (node->normal, p1) - node->dist;
+		t2 = DotProduct (node->normal, p2) - node->dist;
 		if ( tw->isPoint ) {
 			offset = 0;
 		} else {
@@ -1154,12 +1271,12 @@ void CM_Trace( trace_t *results, const vec3_t start, const vec3_t end, vec3_t mi
 
 	cmod = CM_ClipHandleToModel( model );
 
-	cm.checkcount++;		// for multi-check avoidance
-
 	c_traces++;				// for statistics, may be zeroed
 
 	// fill in a default trace
 	Com_Memset( &tw, 0, sizeof(tw) );
+	tw.visits = CM_NewVisits();		// for multi-check avoidance
+	tw.checkcount = tw.visits->stamp;
 	tw.trace.fraction = 1;	// assume it goes the entire distance until shown otherwise
 	VectorCopy(origin, tw.modelOrigin);
 
@@ -1369,6 +1486,21 @@ void CM_BoxTrace( trace_t *results, const vec3_t start, const vec3_t end,
 	CM_Trace( results, start, end, mins, maxs, model, vec3_origin, brushmask, capsule, NULL );
 }
 
+/*
+==================
+CM_TraceMany
+==================
+*/
+void CM_TraceMany( trace_t *results, const traceRequest_t *requests, int count,
+						  clipHandle_t model, int brushmask, int capsule ) {
+	int		i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		CM_Trace( &results[i], requests[i].start, requests[i].end, (float *)requests[i].mins, (float *)requests[i].maxs,
+			model, vec3_origin, brushmask, capsule, NULL );
+	}
+}
+
 /*
 ==================
 CM_TransformedBoxTrace
@@ -113,6 +113,7 @@ int		time_frontend;		// renderer frontend time
 int		time_backend;		// renderer backend time
 
 int			com_frameTime;
+int			com_packetTime;
 int			com_frameNumber;
 
 qboolean	com_errorEntered = qfalse;
@@ -2201,6 +2202,9 @@ int Com_EventLoop( void ) {
 
 		// if no more events are available
 		if ( ev.evType == SE_NONE ) {
+			// packets the network thread read since NET_Sleep
+			NET_ThreadEvents();
+
 			// manually send packet events for the loopback channel
 			while ( NET_GetLoopPacket( NS_CLIENT, &evFrom, &buf ) ) {
 				CL_PacketEvent( evFrom, &buf );
@@ -2209,6 +2213,7 @@ int Com_EventLoop( void ) {
 			while ( NET_GetLoopPacket( NS_SERVER, &evFrom, &buf ) ) {
 				// if the server just shut down, flush the events
 				if ( com_sv_running->integer ) {
+					com_packetTime = Sys_Milliseconds();
 					Com_RunAndTimeServerPacket( &evFrom, &buf );
 				}
 			}
@@ -2652,6 +2657,154 @@ static void Com_InitRand(void)
 		srand(time(NULL));
 }
 
+/*
+==============================================================================
+
+						WORKER THREADS
+
+A small pool of threads that is started on first use.  Com_RunJobs hands
+out indices of a batch to the pool and to the calling thread, and only
+returns once the whole batch is done, so callers never see the threads.
+
+==============================================================================
+*/
+
+typedef struct {
+	void	(*function)( void *data, int index );
+	void	*data;
+	int		count;
+	int		next;				// next index to hand out, protected by com_jobMutex
+} jobBatch_t;
+
+static void			*com_jobThreads[MAX_JOB_THREADS];
+static int			com_numJobThreads;
+static void			*com_jobMutex;
+static void			*com_jobStart;		// posted once per worker for each batch
+static void			*com_jobDone;		// posted by each worker when the batch is empty
+static jobBatch_t	com_jobBatch;
+static qboolean		com_jobsQuit;
+
+/*
+=================
+Com_RunJobBatch
+
+Runs jobs of the current batch until there are none left
+=================
+*/
+static void Com_RunJobBatch( void ) {
+	int		index;
+
+	for ( ;; ) {
+		Sys_LockMutex( com_jobMutex );
+		index = com_jobBatch.next++;
+		Sys_UnlockMutex( com_jobMutex );
+
+		if ( index >= com_jobBatch.count ) {
+			break;
+		}
+		com_jobBatch.function( com_jobBatch.data, index );
+	}
+}
+
+/*
+=================
+Com_JobThread
+=================
+*/
+static void Com_JobThread( void *arg ) {
+	for ( ;; ) {
+		Sys_WaitSemaphore( com_jobStart );
+		if ( com_jobsQuit ) {
+			break;
+		}
+		Com_RunJobBatch();
+		Sys_PostSemaphore( com_jobDone );
+	}
+}
+
+/*
+=================
+Com_RunJobs
+=================
+*/
+void Com_RunJobs( void (*function)( void *data, int index ), void *data, int count, int numThreads ) {
+	int		i, workers;
+	void	*thread;
+
+	if ( numThreads > MAX_JOB_THREADS ) {
+		numThreads = MAX_JOB_THREADS;
+	}
+	if ( numThreads > count ) {
+		numThreads = count;
+	}
+
+	// start more workers if needed, the pool never shrinks
+	if ( numThreads > 1 && !com_jobMutex ) {
+		com_jobMutex = Sys_CreateMutex();
+		com_jobStart = Sys_CreateSemaphore();
+		com_jobDone = Sys_CreateSemaphore();
+	}
+	while ( com_numJobThreads < numThreads - 1 ) {
+		thread = Sys_CreateThread( Com_JobThread, NULL );
+		if ( !thread ) {
+			Com_Printf( S_COLOR_YELLOW "WARNING: couldn't start worker thread, using %i\n", com_numJobThreads );
+			break;
+		}
+		com_jobThreads[com_numJobThreads++] = thread;
+	}
+
+	workers = MIN( numThreads - 1, com_numJobThreads );
+	if ( workers <= 0 ) {
+		for ( i = 0 ; i < count ; i++ ) {
+			function( data, i );
+		}
+		return;
+	}
+
+	com_jobBatch.function = function;
+	com_jobBatch.data = data;
+	com_jobBatch.count = count;
+	com_jobBatch.next = 0;
+
+	for ( i = 0 ; i < workers ; i++ ) {
+		Sys_PostSemaphore( com_jobStart );
+	}
+
+	Com_RunJobBatch();
+
+	for ( i = 0 ; i < workers ; i++ ) {
+		Sys_WaitSemaphore( com_jobDone );
+	}
+}
+
+/*
+=================
+Com_ShutdownJobs
+=================
+*/
+void Com_ShutdownJobs( void ) {
+	int		i;
+
+	if ( !com_numJobThreads ) {
+		return;
+	}
+
+	com_jobsQuit = qtrue;
+	for ( i = 0 ; i < com_numJobThreads ; i++ ) {
+		Sys_PostSemaphore( com_jobStart );
+	}
+	for ( i = 0 ; i < com_numJobThreads ; i++ ) {
+		Sys_JoinThread( com_jobThreads[i] );
+	}
+	com_numJobThreads = 0;
+	com_jobsQuit = qfalse;
+
+	Sys_DestroySemaphore( com_jobDone );
+	Sys_DestroySemaphore( com_jobStart );
+	Sys_DestroyMutex( com_jobMutex );
+	com_jobMutex = NULL;
+}
+
 /*
 =================
 Com_Init
@@ -2721,6 +2874,7 @@ void Com_Init( char *commandLine ) {
 	Cmd_AddCommand ("writeconfig", Com_WriteConfig_f );
 	Cmd_SetCommandCompletionFunc( "writeconfig", Cmd_CompleteCfgName );
 	Cmd_AddCommand("game_restart", Com_GameRestart_f);
+	Cmd_AddCommand ("cm_stats", CM_Stats_f);
 
 	Com_ExecuteCfg();
 
@@ -3253,13 +3407,14 @@ void Com_Frame( void ) {
 	//
 	if ( com_showtrace->integer ) {
 	
-		extern	int c_traces, c_brush_traces, c_patch_traces;
+		extern	int c_traces, c_brush_traces, c_brush_rejects, c_patch_traces;
 		extern	int	c_pointcontents;
 
-		Com_Printf ("%4i traces  (%ib %ip) %4i points\n", c_traces,
-			c_brush_traces, c_patch_traces, c_pointcontents);
+		Com_Printf ("%4i traces  (%ib %ir %ip) %4i points\n", c_traces,
+			c_brush_traces, c_brush_rejects, c_patch_traces, c_pointcontents);
 		c_traces = 0;
 		c_brush_traces = 0;
+		c_brush_rejects = 0;
 		c_patch_traces = 0;
 		c_pointcontents = 0;
 	}
@@ -3275,6 +3430,8 @@ Com_Shutdown
 =================
 */
 void Com_Shutdown (void) {
+	Com_ShutdownJobs();
+
 	if (logfile) {
 		FS_FCloseFile (logfile);
 		logfile = 0;
@@ -562,16 +562,18 @@ qboolean FS_CreatePath (char *OSPath) {
 =================
 FS_CheckFilenameIsMutable
 
-ERR_FATAL if trying to maniuplate a file with the platform library, QVM, or pk3 extension
+ERR_FATAL if trying to maniuplate a file with the platform library, QVM, pk3,
+or compiled QVM extension
 =================
  */
 static void FS_CheckFilenameIsMutable( const char *filename,
 		const char *function )
 {
-	// Check if the filename ends with the library, QVM, or pk3 extension
+	// Check if the filename ends with the library, QVM, pk3 or compiled QVM extension
 	if( Sys_DllExtension( filename )
 		|| COM_CompareExtension( filename, ".qvm" )
-		|| COM_CompareExtension( filename, ".pk3" ) )
+		|| COM_CompareExtension( filename, ".pk3" )
+		|| COM_CompareExtension( filename, ".jit" ) )
 	{
 		Com_Error( ERR_FATAL, "%s: Not allowed to manipulate '%s' due "
 			"to %s extension", function, filename, COM_GetExtension( filename ) );
@@ -833,6 +835,53 @@ void FS_SV_Rename( const char *from, const char *to, qboolean safe ) {
 
 
 
+/*
+===========
+FS_SV_ReplaceFile
+
+Writes a whole file under the home path for the engine itself, also with
+the extensions FS_CheckFilenameIsMutable keeps everything else from
+writing.  The data goes to a temporary file that then replaces the old
+one, so a partly written file is never read back.
+===========
+*/
+qboolean FS_SV_ReplaceFile( const char *filename, const void *buffer, int size ) {
+	char			tempName[MAX_QPATH];
+	char			from_ospath[MAX_OSPATH], to_ospath[MAX_OSPATH];
+	fileHandle_t	f;
+	int				written;
+
+	Com_sprintf( tempName, sizeof( tempName ), "%s.tmp", filename );
+	f = FS_SV_FOpenFileWrite( tempName );
+	if ( !f ) {
+		return qfalse;
+	}
+	written = FS_Write( buffer, size, f );
+	FS_FCloseFile( f );
+
+	Q_strncpyz( from_ospath, FS_BuildOSPath( fs_homepath->string, tempName, "" ), sizeof( from_ospath ) );
+	Q_strncpyz( to_ospath, FS_BuildOSPath( fs_homepath->string, filename, "" ), sizeof( to_ospath ) );
+	from_ospath[strlen(from_ospath)-1] = '\0';
+	to_ospath[strlen(to_ospath)-1] = '\0';
+
+	if ( written != size ) {
+		remove( from_ospath );
+		return qfalse;
+	}
+
+	if ( fs_debug->integer ) {
+		Com_Printf( "FS_SV_ReplaceFile: %s --> %s\n", from_ospath, to_ospath );
+	}
+
+	// rename doesn't replace an existing file on windows
+	remove( to_ospath );
+	if ( rename( from_ospath, to_ospath ) ) {
+		remove( from_ospath );
+		return qfalse;
+	}
+	return qtrue;
+}
+
 /*
 ===========
 FS_Rename
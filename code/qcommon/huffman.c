@@ -29,14 +29,15 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 static int			bloc = 0;
 
+// the offset based functions below don't touch bloc, so
+// several messages can be written on different threads at once
 void	Huff_putBit( int bit, byte *fout, int *offset) {
-	bloc = *offset;
-	if ((bloc&7) == 0) {
-		fout[(bloc>>3)] = 0;
+	int pos = *offset;
+	if ((pos&7) == 0) {
+		fout[(pos>>3)] = 0;
 	}
-	fout[(bloc>>3)] |= bit << (bloc&7);
-	bloc++;
-	*offset = bloc;
+	fout[(pos>>3)] |= bit << (pos&7);
+	*offset = pos + 1;
 }
 
 int		Huff_getBloc(void)
@@ -51,10 +52,9 @@ void	Huff_setBloc(int _bloc)
 
 int		Huff_getBit( byte *fin, int *offset) {
 	int t;
-	bloc = *offset;
-	t = (fin[(bloc>>3)] >> (bloc&7)) & 0x1;
-	bloc++;
-	*offset = bloc;
+	int pos = *offset;
+	t = (fin[(pos>>3)] >> (pos&7)) & 0x1;
+	*offset = pos + 1;
 	return t;
 }
 
@@ -280,14 +280,14 @@ int Huff_Receive (node_t *node, int *ch, byte *fin) {
 
 /* Get a symbol */
 void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxoffset) {
-	bloc = *offset;
+	int pos = *offset;
 	while (node && node->symbol == INTERNAL_NODE) {
-		if (bloc >= maxoffset) {
+		if (pos >= maxoffset) {
 			*ch = 0;
 			*offset = maxoffset + 1;
 			return;
 		}
-		if (get_bit(fin)) {
+		if (Huff_getBit(fin, &pos)) {
 			node = node->right;
 		} else {
 			node = node->left;
@@ -299,23 +299,23 @@ void Huff_offsetReceive (node_t *node, int *ch, byte *fin, int *offset, int maxo
 //		Com_Error(ERR_DROP, "Illegal tree!");
 	}
 	*ch = node->symbol;
-	*offset = bloc;
+	*offset = pos;
 }
 
 /* Send the prefix code for this node */
-static void send(node_t *node, node_t *child, byte *fout, int maxoffset) {
+static void send(node_t *node, node_t *child, byte *fout, int *offset, int maxoffset) {
 	if (node->parent) {
-		send(node->parent, node, fout, maxoffset);
+		send(node->parent, node, fout, offset, maxoffset);
 	}
 	if (child) {
-		if (bloc >= maxoffset) {
-			bloc = maxoffset + 1;
+		if (*offset >= maxoffset) {
+			*offset = maxoffset + 1;
 			return;
 		}
 		if (node->right == child) {
-			add_bit(1, fout);
+			Huff_putBit(1, fout, offset);
 		} else {
-			add_bit(0, fout);
+			Huff_putBit(0, fout, offset);
 		}
 	}
 }
@@ -330,14 +330,128 @@ void Huff_transmit (huff_t *huff, int ch, byte *fout, int maxoffset) {
 			add_bit((char)((ch >> i) & 0x1), fout);
 		}
 	} else {
-		send(huff->loc[ch], NULL, fout, maxoffset);
+		send(huff->loc[ch], NULL, fout, &bloc, maxoffset);
 	}
 }
 
 void Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int maxoffset) {
-	bloc = *offset;
-	send(huff->loc[ch], NULL, fout, maxoffset);
-	*offset = bloc;
+	send(huff->loc[ch], NULL, fout, offset, maxoffset);
+}
+
+/*
+====================
+Huff_BuildTable
+
+Flattens a tree that won't be updated any more, like the static message
+tree, into a code per symbol for sending and a table indexed by the next
+HUFF_LOOKUP_BITS input bits for receiving.
+====================
+*/
+static void Huff_fillLookup( huffTable_t *table, const node_t *node, int code, int depth ) {
+	int		i;
+
+	if ( !node ) {
+		return;
+	}
+	if ( node->symbol != INTERNAL_NODE ) {
+		for ( i = code ; i < ( 1 << HUFF_LOOKUP_BITS ) ; i += 1 << depth ) {
+			table->lookupSymbol[i] = node->symbol;
+			table->lookupBits[i] = depth;
+		}
+		return;
+	}
+	if ( depth == HUFF_LOOKUP_BITS ) {
+		// longer codes are left to Huff_offsetReceive
+		return;
+	}
+	Huff_fillLookup( table, node->left, code, depth + 1 );
+	Huff_fillLookup( table, node->right, code | ( 1 << depth ), depth + 1 );
+}
+
+void Huff_BuildTable( huffTable_t *table, const huff_t *compressor, const huff_t *decompressor ) {
+	const node_t	*node;
+	unsigned int	code;
+	int				ch, depth;
+
+	Com_Memset( table, 0, sizeof( *table ) );
+
+	for ( ch = 0 ; ch <= HMAX ; ch++ ) {
+		node = compressor->loc[ch];
+		if ( !node ) {
+			continue;
+		}
+		// the code is sent root first, so the bit nearest the root ends up in bit 0
+		code = 0;
+		for ( depth = 0 ; node->parent && depth < 32 ; depth++ ) {
+			code = ( code << 1 ) | ( node->parent->right == node );
+			node = node->parent;
+		}
+		if ( node->parent ) {
+			continue;
+		}
+		table->code[ch] = code;
+		table->codeBits[ch] = depth;
+	}
+
+	Huff_fillLookup( table, decompressor->tree, 0, 0 );
+}
+
+/* Send a symbol using the flattened codes */
+void Huff_tableTransmit( const huffTable_t *table, huff_t *huff, int ch, byte *fout, int *offset, int maxoffset ) {
+	unsigned int	code;
+	int				bits, pos, n;
+
+	bits = table->codeBits[ch];
+	pos = *offset;
+	if ( !bits || pos + bits > maxoffset ) {
+		// let the tree walk handle running out of space
+		Huff_offsetTransmit( huff, ch, fout, offset, maxoffset );
+		return;
+	}
+
+	code = table->code[ch];
+	while ( bits > 0 ) {
+		// same as Huff_putBit: a byte is cleared when its first bit is written
+		if ( ( pos & 7 ) == 0 ) {
+			fout[pos >> 3] = 0;
+		}
+		fout[pos >> 3] |= ( code << ( pos & 7 ) ) & 0xff;
+		n = 8 - ( pos & 7 );
+		if ( n > bits ) {
+			n = bits;
+		}
+		code >>= n;
+		pos += n;
+		bits -= n;
+	}
+	*offset = pos;
+}
+
+/* Get a symbol using the lookup table */
+void Huff_tableReceive( const huffTable_t *table, node_t *node, int *ch, byte *fin, int *offset, int maxoffset ) {
+	const byte		*p;
+	unsigned int	v;
+	int				pos, shift, bits;
+
+	pos = *offset;
+	if ( pos + HUFF_LOOKUP_BITS <= maxoffset ) {
+		p = fin + ( pos >> 3 );
+		shift = pos & 7;
+		v = p[0] | ( p[1] << 8 );
+		if ( shift + HUFF_LOOKUP_BITS > 16 ) {
+			v |= p[2] << 16;
+		}
+		v = ( v >> shift ) & ( ( 1 << HUFF_LOOKUP_BITS ) - 1 );
+
+		bits = table->lookupBits[v];
+		if ( bits ) {
+			*ch = table->lookupSymbol[v];
+			*offset = pos + bits;
+			return;
+		}
+	}
+
+	Huff_offsetReceive( node, ch, fin, offset, maxoffset );
 }
 
 void Huff_Decompress(msg_t *mbuf, int offset) {
@@ -392,8 +506,6 @@ void Huff_Decompress(msg_t *mbuf, int offset) {
 	Com_Memcpy(mbuf->data + offset, seq, cch);
 }
 
-extern 	int oldsize;
-
 void Huff_Compress(msg_t *mbuf, int offset) {
 	int			i, ch, size;
 	byte		seq[65536];
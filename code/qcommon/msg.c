@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "qcommon.h"
 
 static huffman_t		msgHuff;
+static huffTable_t		msgHuffTable;
 
 static qboolean			msgInit = qfalse;
 
@@ -37,8 +38,6 @@ Handles byte ordering and avoids alignment errors
 ==============================================================================
 */
 
-int oldsize = 0;
-
 void MSG_initHuffman( void );
 
 void MSG_Init( msg_t *buf, byte *data, int length ) {
@@ -101,11 +100,76 @@ bit functions
 =============================================================================
 */
 
+/*
+=================
+MSG_BitsOverflow
+
+The one overflow rule for bit packed messages: bits written at msg->bit
+have to end at or before maxsize * 8.  Every field passes it on its own,
+and as fields only move msg->bit forward, a stream of fields passes it
+exactly when its last field does.
+=================
+*/
+static ID_INLINE qboolean MSG_BitsOverflow( const msg_t *msg, int bits ) {
+	return msg->bit + bits > msg->maxsize << 3;
+}
+
+/*
+=================
+MSG_PutBits
+
+Stores bits at msg->bit in the same layout as Huff_putBit.  The caller
+has already checked that they fit.
+=================
+*/
+static void MSG_PutBits( msg_t *msg, uint64_t value, int bits ) {
+	byte	*p;
+	int		shift;
+
+	if ( bits <= 0 ) {
+		return;
+	}
+
+	p = msg->data + ( msg->bit >> 3 );
+	shift = msg->bit & 7;
+	msg->bit += bits;
+
+	// a byte is cleared when its first bit is written
+	if ( shift ) {
+		*p++ |= ( value << shift ) & 0xff;
+		value >>= 8 - shift;
+		bits -= 8 - shift;
+	}
+	for ( ; bits > 0 ; bits -= 8 ) {
+		*p++ = value & 0xff;
+		value >>= 8;
+	}
+}
+
+/*
+=================
+MSG_PeekBits
+
+Returns the 57 or more bits that follow msg->bit.  The caller has
+already checked that eight bytes are left in the message.
+=================
+*/
+static uint64_t MSG_PeekBits( const msg_t *msg ) {
+	const byte	*p;
+	uint64_t	value;
+	int			i;
+
+	p = msg->data + ( msg->bit >> 3 );
+	value = 0;
+	for ( i = 0 ; i < 8 ; i++ ) {
+		value |= (uint64_t)p[i] << ( i * 8 );
+	}
+	return value >> ( msg->bit & 7 );
+}
+
 // negative bit values include signs
 void MSG_WriteBits( msg_t *msg, int value, int bits ) {
-	int	i;
-
-	oldsize += bits;
+	int	i, nbits;
 
 	if ( msg->overflowed ) {
 		return;
@@ -143,35 +207,97 @@ void MSG_WriteBits( msg_t *msg, int value, int bits ) {
 			Com_Error( ERR_DROP, "can't write %d bits", bits );
 		}
 	} else {
-		value &= (0xffffffff >> (32 - bits));
-		if ( bits&7 ) {
-			int nbits;
-			nbits = bits&7;
-			if ( msg->bit + nbits > msg->maxsize << 3 ) {
-				msg->overflowed = qtrue;
-				return;
-			}
-			for( i = 0; i < nbits; i++ ) {
-				Huff_putBit( (value & 1), msg->data, &msg->bit );
-				value = (value >> 1);
-			}
-			bits = bits - nbits;
+		uint64_t		acc;
+		unsigned int	v;
+		int				accBits, codeBits;
+
+		// the raw bits and the byte codes are gathered in acc and
+		// stored together, so a field costs a couple of memory writes
+		v = value & (0xffffffff >> (32 - bits));
+		nbits = bits&7;
+		if ( MSG_BitsOverflow( msg, nbits ) ) {
+			msg->overflowed = qtrue;
+			return;
 		}
-		if ( bits ) {
-			for( i = 0; i < bits; i += 8 ) {
-				Huff_offsetTransmit( &msgHuff.compressor, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3 );
-				value = (value >> 8);
-
-				if ( msg->bit > msg->maxsize << 3 ) {
+		acc = v & ( ( 1 << nbits ) - 1 );
+		accBits = nbits;
+		v >>= nbits;
+
+		for( i = nbits; i < bits; i += 8 ) {
+			codeBits = msgHuffTable.codeBits[v & 0xff];
+			if ( !codeBits || accBits + codeBits > 64 || MSG_BitsOverflow( msg, accBits + codeBits ) ) {
+				// let Huff_tableTransmit deal with long codes and running out of space
+				MSG_PutBits( msg, acc, accBits );
+				acc = 0;
+				accBits = 0;
+				Huff_tableTransmit( &msgHuffTable, &msgHuff.compressor, (v & 0xff), msg->data, &msg->bit, msg->maxsize << 3 );
+				if ( MSG_BitsOverflow( msg, 0 ) ) {
 					msg->overflowed = qtrue;
 					return;
 				}
+			} else {
+				acc |= (uint64_t)msgHuffTable.code[v & 0xff] << accBits;
+				accBits += codeBits;
 			}
+			v = (v >> 8);
 		}
+		MSG_PutBits( msg, acc, accBits );
 		msg->cursize = (msg->bit >> 3) + 1;
 	}
 }
 
+/*
+=================
+MSG_WriteBitstream
+
+Appends bits that were already written by MSG_WriteBits to another
+message starting at bit 0.  The Huffman codes don't depend on where they
+start, so the result is the same as repeating the original writes.
+=================
+*/
+void MSG_WriteBitstream( msg_t *msg, const byte *data, int bits ) {
+	int		i, n, b, pos, shift;
+
+	if ( msg->overflowed || bits <= 0 ) {
+		return;
+	}
+
+	if ( msg->oob ) {
+		Com_Error( ERR_DROP, "MSG_WriteBitstream: out of band message" );
+	}
+
+	// same rule as MSG_WriteBits, so a copied stream overflows
+	// exactly when writing its fields again would have
+	if ( MSG_BitsOverflow( msg, bits ) ) {
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	pos = msg->bit;
+	shift = pos & 7;
+	for ( i = 0 ; i < bits ; i += 8 ) {
+		n = bits - i;
+		if ( n > 8 ) {
+			n = 8;
+		}
+		b = data[i >> 3] & ( ( 1 << n ) - 1 );
+
+		// same as Huff_putBit: a byte is cleared when its first bit is written
+		if ( !shift ) {
+			msg->data[pos >> 3] = b;
+		} else {
+			msg->data[pos >> 3] |= ( b << shift ) & 0xff;
+			if ( shift + n > 8 ) {
+				msg->data[( pos >> 3 ) + 1] = b >> ( 8 - shift );
+			}
+		}
+		pos += n;
+	}
+
+	msg->bit = pos;
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
 int MSG_ReadBits( msg_t *msg, int bits ) {
 	int			value;
 	int			get;
@@ -222,31 +348,47 @@ int MSG_ReadBits( msg_t *msg, int bits ) {
 		else
 			Com_Error(ERR_DROP, "can't read %d bits", bits);
 	} else {
-		nbits = 0;
-		if (bits&7) {
-			nbits = bits&7;
-			if (msg->bit + nbits > msg->cursize << 3) {
-				msg->readcount = msg->cursize + 1;
-				return 0;
+		nbits = bits&7;
+		if (nbits && msg->bit + nbits > msg->cursize << 3) {
+			msg->readcount = msg->cursize + 1;
+			return 0;
+		}
+		bits = bits - nbits;
+		i = 0;
+		if ((msg->bit >> 3) + 8 <= msg->cursize) {
+			uint64_t	window;
+			int			used, index, codeBits;
+
+			// the raw bits and up to four codes of HUFF_LOOKUP_BITS
+			// or less always fit in the window
+			window = MSG_PeekBits(msg);
+			value = window & ((1 << nbits) - 1);
+			used = nbits;
+			for (; i < bits; i += 8) {
+				index = (window >> used) & ((1 << HUFF_LOOKUP_BITS) - 1);
+				codeBits = msgHuffTable.lookupBits[index];
+				if (!codeBits) {
+					break;
+				}
+				value = (unsigned int)value | ((unsigned int)msgHuffTable.lookupSymbol[index]<<(i+nbits));
+				used += codeBits;
 			}
+			msg->bit += used;
+		} else {
 			for(i=0;i<nbits;i++) {
 				value |= (Huff_getBit(msg->data, &msg->bit)<<i);
 			}
-			bits = bits - nbits;
+			i = 0;
 		}
-		if (bits) {
-//			fp = fopen("c:\\netchan.bin", "a");
-			for(i=0;i<bits;i+=8) {
-				Huff_offsetReceive (msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize<<3);
-//				fwrite(&get, 1, 1, fp);
-				value = (unsigned int)value | ((unsigned int)get<<(i+nbits));
-
-				if (msg->bit > msg->cursize<<3) {
-					msg->readcount = msg->cursize + 1;
-					return 0;
-				}
+		// long codes and the end of the message
+		for(;i<bits;i+=8) {
+			Huff_tableReceive( &msgHuffTable, msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize<<3);
+			value = (unsigned int)value | ((unsigned int)get<<(i+nbits));
+
+			if (msg->bit > msg->cursize<<3) {
+				msg->readcount = msg->cursize + 1;
+				return 0;
 			}
-//			fclose(fp);
 		}
 		msg->readcount = (msg->bit>>3)+1;
 	}
@@ -653,7 +795,6 @@ void MSG_WriteDeltaUsercmdKey( msg_t *msg, int key, usercmd_t *from, usercmd_t *
 		from->buttons == to->buttons &&
 		from->weapon == to->weapon) {
 			MSG_WriteBits( msg, 0, 1 );				// no change
-			oldsize += 7;
 			return;
 	}
 	key ^= to->serverTime;
@@ -872,8 +1013,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 	MSG_WriteByte( msg, lc );	// # of changes
 
-	oldsize += numFields;
-
 	for ( i = 0, field = entityStateFields ; i < lc ; i++, field++ ) {
 		fromF = (int *)( (byte *)from + field->offset );
 		toF = (int *)( (byte *)to + field->offset );
@@ -892,7 +1031,6 @@ void MSG_WriteDeltaEntity( msg_t *msg, struct entityState_s *from, struct entity
 
 			if (fullFloat == 0.0f) {
 					MSG_WriteBits( msg, 0, 1 );
-					oldsize += FLOAT_INT_BITS;
 			} else {
 				MSG_WriteBits( msg, 1, 1 );
 				if ( trunc == fullFloat && trunc + FLOAT_INT_BIAS >= 0 && 
@@ -1147,8 +1285,6 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 
 	MSG_WriteByte( msg, lc );	// # of changes
 
-	oldsize += numFields - lc;
-
 	for ( i = 0, field = playerStateFields ; i < lc ; i++, field++ ) {
 		fromF = (int *)( (byte *)from + field->offset );
 		toF = (int *)( (byte *)to + field->offset );
@@ -1213,7 +1349,6 @@ void MSG_WriteDeltaPlayerstate( msg_t *msg, struct playerState_s *from, struct p
 
 	if (!statsbits && !persistantbits && !ammobits && !powerupbits) {
 		MSG_WriteBits( msg, 0, 1 );	// no change
-		oldsize += 4;
 		return;
 	}
 	MSG_WriteBits( msg, 1, 1 );	// changed
@@ -1677,6 +1812,7 @@ void MSG_initHuffman( void ) {
 			Huff_addRef(&msgHuff.decompressor,	(byte)i);			// Do update
 		}
 	}
+	Huff_BuildTable(&msgHuffTable, &msgHuff.compressor, &msgHuff.decompressor);
 }
 
 /*
@@ -20,6 +20,14 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 ===========================================================================
 */
 
+#if defined(__linux__) && !defined(__ANDROID__)
+// recvmmsg and sendmmsg
+#	ifndef _GNU_SOURCE
+#		define _GNU_SOURCE
+#	endif
+#	define NET_USE_MMSG
+#endif
+
 #include "../qcommon/q_shared.h"
 #include "../qcommon/qcommon.h"
 
@@ -114,6 +122,7 @@ static cvar_t	*net_mcast6addr;
 static cvar_t	*net_mcast6iface;
 
 static cvar_t	*net_dropsim;
+static cvar_t	*net_thread;
 
 static struct sockaddr	socksRelayAddr;
 
@@ -151,6 +160,76 @@ typedef struct
 static nip_localaddr_t localIP[MAX_IPS];
 static int numIP;
 
+#define NET_THREAD_PACKETS	64
+
+// a packet read by the network thread
+typedef struct {
+	netadr_t	from;
+	int			time;		// Sys_Milliseconds when it was read
+	int			cursize;
+	int			readcount;
+	byte		data[MAX_MSGLEN + 1];
+} netThreadPacket_t;
+
+// the network thread is the only writer of head and the main thread
+// the only writer of tail, so the queue needs no lock
+typedef struct {
+	void				*thread;
+	void				*wake;			// posted when a packet lands in the empty queue while the main thread sleeps
+	void				*space;			// posted when the main thread frees a slot in the full queue
+	volatile qboolean	quit;
+	volatile qboolean	sleeping;
+	volatile qboolean	full;
+	volatile int		head;
+	volatile int		tail;
+	volatile qboolean	warningSet;
+	char				warning[MAX_STRING_CHARS];
+	netThreadPacket_t	*packets;
+} netThread_t;
+
+static netThread_t	net_recvThread;
+
+static void NET_StartThread(void);
+static void NET_StopThread(void);
+
+#ifdef _MSC_VER
+#	define NET_MemoryBarrier()	MemoryBarrier()
+#else
+#	define NET_MemoryBarrier()	__sync_synchronize()
+#endif
+
+#ifdef NET_USE_MMSG
+#define NET_RECV_BATCH		16
+#define NET_SEND_BATCH		64
+#define NET_SEND_PACKETLEN	1400	// MAX_PACKETLEN in net_chan.c
+
+// datagrams read from a socket by one recvmmsg
+typedef struct {
+	SOCKET					socket;
+	int						count;
+	int						next;
+	struct mmsghdr			msgs[NET_RECV_BATCH];
+	struct iovec			iov[NET_RECV_BATCH];
+	struct sockaddr_storage	from[NET_RECV_BATCH];
+	byte					data[NET_RECV_BATCH][MAX_MSGLEN + 1];
+} netRecvBatch_t;
+
+// datagrams waiting for Sys_EndPacketBatch
+typedef struct {
+	SOCKET					socket;
+	netadr_t				to;
+	struct sockaddr_storage	addr;
+	int						length;
+	byte					data[NET_SEND_PACKETLEN];
+} netSendPacket_t;
+
+static qboolean			net_mmsgFailed;
+static netRecvBatch_t	net_recvBatch[2];		// ip_socket, ip6_socket
+static qboolean			net_sendBatching;
+static int				net_numSendPackets;
+static netSendPacket_t	net_sendPackets[NET_SEND_BATCH];
+#endif
+
 
 //=============================================================================
 
@@ -543,26 +622,33 @@ qboolean NET_CompareBaseAdr (netadr_t a, netadr_t b)
 	return NET_CompareBaseAdrMask(a, b, -1);
 }
 
-const char	*NET_AdrToString (netadr_t a)
+static const char *NET_AdrToStringBuffer(netadr_t a, char *s, int size)
 {
-	static	char	s[NET_ADDRSTRMAXLEN];
+	*s = '\0';
 
 	if (a.type == NA_LOOPBACK)
-		Com_sprintf (s, sizeof(s), "loopback");
+		Com_sprintf (s, size, "loopback");
 	else if (a.type == NA_BOT)
-		Com_sprintf (s, sizeof(s), "bot");
+		Com_sprintf (s, size, "bot");
 	else if (a.type == NA_IP || a.type == NA_IP6)
 	{
 		struct sockaddr_storage sadr;
 	
 		memset(&sadr, 0, sizeof(sadr));
 		NetadrToSockadr(&a, (struct sockaddr *) &sadr);
-		Sys_SockaddrToString(s, sizeof(s), (struct sockaddr *) &sadr);
+		Sys_SockaddrToString(s, size, (struct sockaddr *) &sadr);
 	}
 
 	return s;
 }
 
+const char	*NET_AdrToString (netadr_t a)
+{
+	static	char	s[NET_ADDRSTRMAXLEN];
+
+	return NET_AdrToStringBuffer(a, s, sizeof(s));
+}
+
 const char	*NET_AdrToStringwPort (netadr_t a)
 {
 	static	char	s[NET_ADDRSTRMAXLEN];
@@ -603,6 +689,134 @@ qboolean	NET_IsLocalAddress( netadr_t adr ) {
 
 //=============================================================================
 
+/*
+==================
+NET_PacketWarning
+
+NET_GetPacket runs on the network thread when there is one, so its
+warnings are handed to the main thread to print
+==================
+*/
+static void QDECL NET_PacketWarning( const char *fmt, ... ) __attribute__ ((format (printf, 1, 2)));
+static void QDECL NET_PacketWarning( const char *fmt, ... ) {
+	va_list		argptr;
+	char		text[MAX_STRING_CHARS];
+
+	va_start( argptr, fmt );
+	Q_vsnprintf( text, sizeof( text ), fmt, argptr );
+	va_end( argptr );
+
+	if( !net_recvThread.thread ) {
+		Com_Printf( "%s", text );
+		return;
+	}
+
+	// only one is kept until the main thread gets to it
+	if( !net_recvThread.warningSet ) {
+		Q_strncpyz( net_recvThread.warning, text, sizeof( net_recvThread.warning ) );
+		NET_MemoryBarrier();
+		net_recvThread.warningSet = qtrue;
+	}
+}
+
+#ifdef NET_USE_MMSG
+/*
+==================
+NET_RecvFrom
+
+Same as recvfrom, but datagrams are read from the socket a batch at a
+time with recvmmsg
+==================
+*/
+static int NET_RecvFrom( SOCKET s, netRecvBatch_t *batch, byte *data, int maxsize, struct sockaddr_storage *from, socklen_t *fromlen )
+{
+	struct mmsghdr	*m;
+	int		i, ret;
+
+	if( net_mmsgFailed )
+		return recvfrom( s, (void *)data, maxsize, 0, (struct sockaddr *) from, fromlen );
+
+	if( batch->socket != s )
+	{
+		batch->socket = s;
+		batch->count = batch->next = 0;
+	}
+
+	if( batch->next >= batch->count )
+	{
+		batch->count = batch->next = 0;
+
+		for( i = 0; i < NET_RECV_BATCH; i++ )
+		{
+			batch->iov[i].iov_base = batch->data[i];
+			batch->iov[i].iov_len = sizeof( batch->data[i] );
+
+			m = &batch->msgs[i];
+			memset( m, 0, sizeof( *m ) );
+			m->msg_hdr.msg_name = &batch->from[i];
+			m->msg_hdr.msg_namelen = sizeof( batch->from[i] );
+			m->msg_hdr.msg_iov = &batch->iov[i];
+			m->msg_hdr.msg_iovlen = 1;
+		}
+
+		ret = recvmmsg( s, batch->msgs, NET_RECV_BATCH, 0, NULL );
+		if( ret == SOCKET_ERROR )
+		{
+			if( errno == ENOSYS )
+			{
+				net_mmsgFailed = qtrue;
+				return NET_RecvFrom( s, batch, data, maxsize, from, fromlen );
+			}
+			return SOCKET_ERROR;
+		}
+		batch->count = ret;
+	}
+
+	m = &batch->msgs[batch->next];
+	ret = m->msg_len;
+	if( ret > maxsize )
+		ret = maxsize;
+
+	memcpy( data, batch->data[batch->next], ret );
+	memcpy( from, &batch->from[batch->next], sizeof( *from ) );
+	*fromlen = m->msg_hdr.msg_namelen;
+	batch->next++;
+
+	return ret;
+}
+
+/*
+==================
+NET_SelectRecvBatches
+
+Datagrams left over in a recvmmsg batch are out of the socket, so select
+won't report them.  Adds the sockets that still have some to fdr, if it
+isn't NULL, and returns how many there are.
+==================
+*/
+static int NET_SelectRecvBatches( fd_set *fdr )
+{
+	netRecvBatch_t	*batch;
+	int		i, count;
+
+	count = 0;
+	for( i = 0; i < ARRAY_LEN( net_recvBatch ); i++ )
+	{
+		batch = &net_recvBatch[i];
+		if( batch->next >= batch->count )
+			continue;
+		if( batch->socket != ( i ? ip6_socket : ip_socket ) || batch->socket == INVALID_SOCKET )
+			continue;
+
+		if( fdr )
+			FD_SET( batch->socket, fdr );
+		count++;
+	}
+
+	return count;
+}
+#endif
+
 /*
 ==================
 NET_GetPacket
@@ -616,27 +830,35 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	struct sockaddr_storage from;
 	socklen_t	fromlen;
 	int		err;
+	char	adrString[NET_ADDRSTRMAXLEN];
 	
+	// a rejected datagram doesn't end the read, or the rest of a recvmmsg
+	// batch would wait behind it without select() seeing anything
 	if(ip_socket != INVALID_SOCKET && FD_ISSET(ip_socket, fdr))
 	{
-		fromlen = sizeof(from);
-		ret = recvfrom( ip_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen );
-		
-		if (ret == SOCKET_ERROR)
+		while(1)
 		{
-			err = socketError;
+			fromlen = sizeof(from);
+#ifdef NET_USE_MMSG
+			ret = NET_RecvFrom( ip_socket, &net_recvBatch[0], net_message->data, net_message->maxsize, &from, &fromlen );
+#else
+			ret = recvfrom( ip_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen );
+#endif
 
-			if( err != EAGAIN && err != ECONNRESET )
-				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
-		}
-		else
-		{
+			if (ret == SOCKET_ERROR)
+			{
+				err = socketError;
+
+				if( err != EAGAIN && err != ECONNRESET )
+					NET_PacketWarning( "NET_GetPacket: %s\n", NET_ErrorString() );
+				break;
+			}
 
 			memset( ((struct sockaddr_in *)&from)->sin_zero, 0, 8 );
-		
+
 			if ( usingSocks && memcmp( &from, &socksRelayAddr, fromlen ) == 0 ) {
 				if ( ret < 10 || net_message->data[0] != 0 || net_message->data[1] != 0 || net_message->data[2] != 0 || net_message->data[3] != 1 ) {
-					return qfalse;
+					continue;
 				}
 				net_from->type = NA_IP;
 				net_from->ip[0] = net_message->data[4];
@@ -650,12 +872,12 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 				SockadrToNetadr( (struct sockaddr *) &from, net_from );
 				net_message->readcount = 0;
 			}
-		
+
 			if( ret >= net_message->maxsize ) {
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
-				return qfalse;
+				NET_PacketWarning( "Oversize packet from %s\n", NET_AdrToStringBuffer( *net_from, adrString, sizeof( adrString ) ) );
+				continue;
 			}
-			
+
 			net_message->cursize = ret;
 			return qtrue;
 		}
@@ -663,27 +885,33 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 	
 	if(ip6_socket != INVALID_SOCKET && FD_ISSET(ip6_socket, fdr))
 	{
-		fromlen = sizeof(from);
-		ret = recvfrom(ip6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
-		
-		if (ret == SOCKET_ERROR)
+		while(1)
 		{
-			err = socketError;
+			fromlen = sizeof(from);
+#ifdef NET_USE_MMSG
+			ret = NET_RecvFrom( ip6_socket, &net_recvBatch[1], net_message->data, net_message->maxsize, &from, &fromlen );
+#else
+			ret = recvfrom(ip6_socket, (void *)net_message->data, net_message->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+#endif
+
+			if (ret == SOCKET_ERROR)
+			{
+				err = socketError;
+
+				if( err != EAGAIN && err != ECONNRESET )
+					NET_PacketWarning( "NET_GetPacket: %s\n", NET_ErrorString() );
+				break;
+			}
 
-			if( err != EAGAIN && err != ECONNRESET )
-				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
-		}
-		else
-		{
 			SockadrToNetadr((struct sockaddr *) &from, net_from);
 			net_message->readcount = 0;
-		
+
 			if(ret >= net_message->maxsize)
 			{
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
-				return qfalse;
+				NET_PacketWarning( "Oversize packet from %s\n", NET_AdrToStringBuffer( *net_from, adrString, sizeof( adrString ) ) );
+				continue;
 			}
-			
+
 			net_message->cursize = ret;
 			return qtrue;
 		}
@@ -699,7 +927,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 			err = socketError;
 
 			if( err != EAGAIN && err != ECONNRESET )
-				Com_Printf( "NET_GetPacket: %s\n", NET_ErrorString() );
+				NET_PacketWarning( "NET_GetPacket: %s\n", NET_ErrorString() );
 		}
 		else
 		{
@@ -708,7 +936,7 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 		
 			if(ret >= net_message->maxsize)
 			{
-				Com_Printf( "Oversize packet from %s\n", NET_AdrToString (*net_from) );
+				NET_PacketWarning( "Oversize packet from %s\n", NET_AdrToStringBuffer( *net_from, adrString, sizeof( adrString ) ) );
 				return qfalse;
 			}
 			
@@ -725,6 +953,110 @@ qboolean NET_GetPacket(netadr_t *net_from, msg_t *net_message, fd_set *fdr)
 
 static char socksBuf[4096];
 
+/*
+==================
+NET_SendError
+==================
+*/
+static void NET_SendError( netadr_t to ) {
+	int err = socketError;
+
+	// wouldblock is silent
+	if( err == EAGAIN ) {
+		return;
+	}
+
+	// some PPP links do not allow broadcasts and return an error
+	if( ( err == EADDRNOTAVAIL ) && ( ( to.type == NA_BROADCAST ) ) ) {
+		return;
+	}
+
+	Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+}
+
+#ifdef NET_USE_MMSG
+/*
+==================
+NET_FlushSendBatch
+
+Sends the queued packets with one sendmmsg per run of packets on the
+same socket
+==================
+*/
+static void NET_FlushSendBatch( void ) {
+	struct mmsghdr	msgs[NET_SEND_BATCH];
+	struct iovec	iov[NET_SEND_BATCH];
+	netSendPacket_t	*p;
+	int				i, start, count, ret;
+
+	for( start = 0; start < net_numSendPackets; start += count ) {
+		for( count = 0; start + count < net_numSendPackets; count++ ) {
+			p = &net_sendPackets[start + count];
+			if( p->socket != net_sendPackets[start].socket )
+				break;
+
+			iov[count].iov_base = p->data;
+			iov[count].iov_len = p->length;
+			memset( &msgs[count], 0, sizeof( msgs[count] ) );
+			msgs[count].msg_hdr.msg_name = &p->addr;
+			msgs[count].msg_hdr.msg_namelen = p->addr.ss_family == AF_INET6 ?
+				sizeof( struct sockaddr_in6 ) : sizeof( struct sockaddr_in );
+			msgs[count].msg_hdr.msg_iov = &iov[count];
+			msgs[count].msg_hdr.msg_iovlen = 1;
+		}
+
+		// sendmmsg stops at the first packet that fails
+		for( i = 0; i < count; ) {
+			p = &net_sendPackets[start + i];
+			if( net_mmsgFailed ) {
+				ret = sendto( p->socket, p->data, p->length, 0, (struct sockaddr *) &p->addr, msgs[i].msg_hdr.msg_namelen );
+				ret = ( ret == SOCKET_ERROR ) ? SOCKET_ERROR : 1;
+			} else {
+				ret = sendmmsg( p->socket, &msgs[i], count - i, 0 );
+				if( ret == SOCKET_ERROR && errno == ENOSYS ) {
+					net_mmsgFailed = qtrue;
+					continue;
+				}
+			}
+			if( ret == SOCKET_ERROR ) {
+				NET_SendError( p->to );
+				i++;
+			} else {
+				i += ret;
+			}
+		}
+	}
+
+	net_numSendPackets = 0;
+}
+#endif
+
+/*
+==================
+Sys_BeginPacketBatch
+
+Packets are queued until Sys_EndPacketBatch where the platform can send
+several with one system call
+==================
+*/
+void Sys_BeginPacketBatch( void ) {
+#ifdef NET_USE_MMSG
+	net_sendBatching = qtrue;
+#endif
+}
+
+/*
+==================
+Sys_EndPacketBatch
+==================
+*/
+void Sys_EndPacketBatch( void ) {
+#ifdef NET_USE_MMSG
+	NET_FlushSendBatch();
+	net_sendBatching = qfalse;
+#endif
+}
+
 /*
 ==================
 Sys_SendPacket
@@ -752,6 +1084,28 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 	memset(&addr, 0, sizeof(addr));
 	NetadrToSockadr( &to, (struct sockaddr *) &addr );
 
+#ifdef NET_USE_MMSG
+	if( net_sendBatching ) {
+		if( ( to.type == NA_IP || to.type == NA_IP6 ) && !usingSocks && length <= NET_SEND_PACKETLEN ) {
+			netSendPacket_t *p;
+
+			if( net_numSendPackets == NET_SEND_BATCH )
+				NET_FlushSendBatch();
+
+			p = &net_sendPackets[net_numSendPackets++];
+			p->socket = ( addr.ss_family == AF_INET ) ? ip_socket : ip6_socket;
+			p->to = to;
+			p->addr = addr;
+			p->length = length;
+			memcpy( p->data, data, length );
+			return;
+		}
+
+		// keep the order of packets to the same address
+		NET_FlushSendBatch();
+	}
+#endif
+
 	if( usingSocks && to.type == NA_IP ) {
 		socksBuf[0] = 0;	// reserved
 		socksBuf[1] = 0;
@@ -769,19 +1123,7 @@ void Sys_SendPacket( int length, const void *data, netadr_t to ) {
 			ret = sendto( ip6_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6) );
 	}
 	if( ret == SOCKET_ERROR ) {
-		int err = socketError;
-
-		// wouldblock is silent
-		if( err == EAGAIN ) {
-			return;
-		}
-
-		// some PPP links do not allow broadcasts and return an error
-		if( ( err == EADDRNOTAVAIL ) && ( ( to.type == NA_BROADCAST ) ) ) {
-			return;
-		}
-
-		Com_Printf( "Sys_SendPacket: %s\n", NET_ErrorString() );
+		NET_SendError( to );
 	}
 }
 
@@ -1573,6 +1915,10 @@ static qboolean NET_GetCvars( void ) {
 	modified += net_socksPassword->modified;
 	net_socksPassword->modified = qfalse;
 
+	net_thread = Cvar_Get( "net_thread", "0", CVAR_LATCH | CVAR_ARCHIVE );
+	modified += net_thread->modified;
+	net_thread->modified = qfalse;
+
 	net_dropsim = Cvar_Get("net_dropsim", "", CVAR_TEMP);
 
 	return modified ? qtrue : qfalse;
@@ -1624,6 +1970,15 @@ void NET_Config( qboolean enableNetworking ) {
 	}
 
 	if( stop ) {
+		NET_StopThread();
+
+#ifdef NET_USE_MMSG
+		// nothing queued may outlive its socket
+		NET_FlushSendBatch();
+		net_recvBatch[0].count = net_recvBatch[0].next = 0;
+		net_recvBatch[1].count = net_recvBatch[1].next = 0;
+#endif
+
 		if ( ip_socket != INVALID_SOCKET ) {
 			closesocket( ip_socket );
 			ip_socket = INVALID_SOCKET;
@@ -1655,6 +2010,9 @@ void NET_Config( qboolean enableNetworking ) {
 		{
 			NET_OpenIP();
 			NET_SetMulticast6();
+
+			if( net_thread->integer )
+				NET_StartThread();
 		}
 	}
 }
@@ -1703,6 +2061,26 @@ void NET_Shutdown( void ) {
 #endif
 }
 
+/*
+====================
+NET_DispatchPacket
+====================
+*/
+static void NET_DispatchPacket( netadr_t *from, msg_t *netmsg )
+{
+	if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
+	{
+		// com_dropsim->value percent of incoming packets get dropped.
+		if(rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value))
+			return;          // drop this packet
+	}
+
+	if(com_sv_running->integer)
+		Com_RunAndTimeServerPacket(from, netmsg);
+	else
+		CL_PacketEvent(*from, netmsg);
+}
+
 /*
 ====================
 NET_Event
@@ -1723,20 +2101,237 @@ void NET_Event(fd_set *fdr)
 
 		if(NET_GetPacket(&from, &netmsg, fdr))
 		{
-			if(net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
+			com_packetTime = Sys_Milliseconds();
+			NET_DispatchPacket(&from, &netmsg);
+		}
+		else
+			break;
+	}
+}
+
+/*
+====================
+NET_SelectSockets
+
+Fills fdr with the sockets to read and returns the highest one
+====================
+*/
+static SOCKET NET_SelectSockets(fd_set *fdr)
+{
+	SOCKET highestfd = INVALID_SOCKET;
+
+	FD_ZERO(fdr);
+
+	if(ip_socket != INVALID_SOCKET)
+	{
+		FD_SET(ip_socket, fdr);
+
+		highestfd = ip_socket;
+	}
+	if(ip6_socket != INVALID_SOCKET)
+	{
+		FD_SET(ip6_socket, fdr);
+
+		if(highestfd == INVALID_SOCKET || ip6_socket > highestfd)
+			highestfd = ip6_socket;
+	}
+
+	return highestfd;
+}
+
+/*
+====================
+NET_ThreadMain
+
+Reads packets as soon as they arrive so a long frame doesn't delay
+them, and timestamps them for SV_UserMove
+====================
+*/
+static void NET_ThreadMain(void *arg)
+{
+	netThread_t *t = arg;
+	netThreadPacket_t *p;
+	struct timeval timeout;
+	fd_set fdr;
+	SOCKET highestfd;
+	netadr_t from;
+	msg_t netmsg;
+	int retval;
+
+	while(!t->quit)
+	{
+		highestfd = NET_SelectSockets(&fdr);
+
+		// wake up now and then to see if we should quit
+		timeout.tv_sec = 0;
+		timeout.tv_usec = 100000;
+
+		retval = select(highestfd + 1, &fdr, NULL, NULL, &timeout);
+		if(retval == SOCKET_ERROR)
+		{
+			NET_PacketWarning("Warning: select() syscall failed: %s\n", NET_ErrorString());
+			Sys_Sleep(100);
+			continue;
+		}
+		if(retval == 0)
+			continue;
+
+		while(!t->quit)
+		{
+			// leave packets in the socket buffer while the queue is full
+			if(t->head - t->tail >= NET_THREAD_PACKETS)
 			{
-				// com_dropsim->value percent of incoming packets get dropped.
-				if(rand() < (int) (((double) RAND_MAX) / 100.0 * (double) net_dropsim->value))
-					continue;          // drop this packet
+				t->full = qtrue;
+				NET_MemoryBarrier();
+
+				// the main thread may have emptied a slot before it saw full
+				if(t->head - t->tail >= NET_THREAD_PACKETS)
+					Sys_TimedWaitSemaphore(t->space, 100);
+
+				t->full = qfalse;
+				continue;
 			}
 
-			if(com_sv_running->integer)
-				Com_RunAndTimeServerPacket(&from, &netmsg);
-			else
-				CL_PacketEvent(from, &netmsg);
+			p = &t->packets[t->head % NET_THREAD_PACKETS];
+			MSG_Init(&netmsg, p->data, sizeof(p->data));
+
+			if(!NET_GetPacket(&from, &netmsg, &fdr))
+				break;
+
+			p->from = from;
+			p->time = Sys_Milliseconds();
+			p->cursize = netmsg.cursize;
+			p->readcount = netmsg.readcount;
+
+			// the packet has to be complete before the main thread sees it
+			NET_MemoryBarrier();
+			t->head++;
+			NET_MemoryBarrier();
+
+			// a sleeping main thread only waits on an empty queue, so
+			// only the first packet has to wake it
+			if(t->sleeping && t->head - t->tail == 1)
+				Sys_PostSemaphore(t->wake);
 		}
-		else
-			break;
+	}
+}
+
+/*
+====================
+NET_StartThread
+====================
+*/
+static void NET_StartThread(void)
+{
+	netThread_t *t = &net_recvThread;
+
+	if(t->thread || (ip_socket == INVALID_SOCKET && ip6_socket == INVALID_SOCKET))
+		return;
+
+	t->quit = qfalse;
+	t->sleeping = qfalse;
+	t->full = qfalse;
+	t->head = t->tail = 0;
+	t->warningSet = qfalse;
+	t->packets = Z_Malloc(NET_THREAD_PACKETS * sizeof(*t->packets));
+	t->wake = Sys_CreateSemaphore();
+	t->space = Sys_CreateSemaphore();
+	t->thread = Sys_CreateThread(NET_ThreadMain, t);
+
+	if(!t->thread)
+	{
+		Com_Printf("WARNING: couldn't start the network thread\n");
+		Sys_DestroySemaphore(t->wake);
+		Sys_DestroySemaphore(t->space);
+		Z_Free(t->packets);
+		t->wake = NULL;
+		t->space = NULL;
+		t->packets = NULL;
+		return;
+	}
+
+	Com_Printf("Network thread started\n");
+}
+
+/*
+====================
+NET_StopThread
+
+Packets still in the queue are dropped along with the sockets
+====================
+*/
+static void NET_StopThread(void)
+{
+	netThread_t *t = &net_recvThread;
+
+	if(!t->thread)
+		return;
+
+	t->quit = qtrue;
+	Sys_PostSemaphore(t->space);
+	Sys_JoinThread(t->thread);
+	t->thread = NULL;
+
+	Sys_DestroySemaphore(t->wake);
+	Sys_DestroySemaphore(t->space);
+	Z_Free(t->packets);
+	t->wake = NULL;
+	t->space = NULL;
+	t->packets = NULL;
+}
+
+/*
+====================
+NET_ThreadEvents
+
+Runs the packets the network thread has queued.  Called from NET_Sleep
+and Com_EventLoop.
+====================
+*/
+void NET_ThreadEvents(void)
+{
+	netThread_t *t = &net_recvThread;
+	netThreadPacket_t *p;
+	byte bufData[MAX_MSGLEN + 1];
+	netadr_t from;
+	msg_t netmsg;
+
+	if(!t->thread)
+		return;
+
+	while(t->tail != t->head)
+	{
+		// copy it out and free the slot first, the packet may end in Com_Error
+		NET_MemoryBarrier();
+		p = &t->packets[t->tail % NET_THREAD_PACKETS];
+
+		MSG_Init(&netmsg, bufData, sizeof(bufData));
+		Com_Memcpy(bufData, p->data, p->cursize);
+		netmsg.cursize = p->cursize;
+		netmsg.readcount = p->readcount;
+		from = p->from;
+		com_packetTime = p->time;
+
+		NET_MemoryBarrier();
+		t->tail++;
+		NET_MemoryBarrier();
+
+		if(t->full)
+			Sys_PostSemaphore(t->space);
+
+		NET_DispatchPacket(&from, &netmsg);
+
+		// the server may have shut the network down
+		if(!t->thread)
+			return;
+	}
+
+	if(t->warningSet)
+	{
+		NET_MemoryBarrier();
+		Com_Printf("%s", t->warning);
+		NET_MemoryBarrier();
+		t->warningSet = qfalse;
 	}
 }
 
@@ -1752,27 +2347,33 @@ void NET_Sleep(int msec)
 	struct timeval timeout;
 	fd_set fdr;
 	int retval;
-	SOCKET highestfd = INVALID_SOCKET;
+	SOCKET highestfd;
 
 	if(msec < 0)
 		msec = 0;
 
-	FD_ZERO(&fdr);
-
-	if(ip_socket != INVALID_SOCKET)
+	if(net_recvThread.thread)
 	{
-		FD_SET(ip_socket, &fdr);
+		net_recvThread.sleeping = qtrue;
+		NET_MemoryBarrier();
 
-		highestfd = ip_socket;
-	}
-	if(ip6_socket != INVALID_SOCKET)
-	{
-		FD_SET(ip6_socket, &fdr);
+		if(msec > 0 && net_recvThread.tail == net_recvThread.head)
+			Sys_TimedWaitSemaphore(net_recvThread.wake, msec);
 
-		if(highestfd == INVALID_SOCKET || ip6_socket > highestfd)
-			highestfd = ip6_socket;
+		net_recvThread.sleeping = qfalse;
+		NET_MemoryBarrier();
+
+		// a packet that came in as the wait timed out still posted,
+		// which would cut the next sleep short
+		while(Sys_TimedWaitSemaphore(net_recvThread.wake, 0))
+			;
+
+		NET_ThreadEvents();
+		return;
 	}
 
+	highestfd = NET_SelectSockets(&fdr);
+
 #ifdef _WIN32
 	if(highestfd == INVALID_SOCKET)
 	{
@@ -1782,14 +2383,28 @@ void NET_Sleep(int msec)
 	}
 #endif
 
+#ifdef NET_USE_MMSG
+	// don't wait on the sockets with datagrams already read
+	if(NET_SelectRecvBatches(NULL))
+		msec = 0;
+#endif
+
 	timeout.tv_sec = msec/1000;
 	timeout.tv_usec = (msec%1000)*1000;
 
 	retval = select(highestfd + 1, &fdr, NULL, NULL, &timeout);
 
 	if(retval == SOCKET_ERROR)
+	{
 		Com_Printf("Warning: select() syscall failed: %s\n", NET_ErrorString());
-	else if(retval > 0)
+		return;
+	}
+
+#ifdef NET_USE_MMSG
+	retval += NET_SelectRecvBatches(&fdr);
+#endif
+
+	if(retval > 0)
 		NET_Event(&fdr);
 }
 
@@ -1030,6 +1030,14 @@ typedef struct {
 	int			entityNum;	// entity the contacted sirface is a part of
 } trace_t;
 
+// one box sweep of a batch, see CM_TraceMany and trap_TraceMany
+typedef struct {
+	vec3_t		start;
+	vec3_t		end;
+	vec3_t		mins;
+	vec3_t		maxs;
+} traceRequest_t;
+
 // trace->entityNum can also be 0 to (MAX_GENTITIES-1)
 // or ENTITYNUM_NONE, ENTITYNUM_WORLD
 
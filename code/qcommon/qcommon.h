@@ -67,6 +67,7 @@ struct entityState_s;
 struct playerState_s;
 
 void MSG_WriteBits( msg_t *msg, int value, int bits );
+void MSG_WriteBitstream( msg_t *msg, const byte *data, int bits );
 
 void MSG_WriteChar (msg_t *sb, int c);
 void MSG_WriteByte (msg_t *sb, int c);
@@ -186,6 +187,7 @@ qboolean	NET_GetLoopPacket (netsrc_t sock, netadr_t *net_from, msg_t *net_messag
 void		NET_JoinMulticast6(void);
 void		NET_LeaveMulticast6(void);
 void		NET_Sleep(int msec);
+void		NET_ThreadEvents(void);
 
 
 #define	MAX_MSGLEN				16384		// max length of a message, which may
@@ -372,6 +374,7 @@ void	VM_Debug( int level );
 
 void	*VM_ArgPtr( intptr_t intValue );
 void	*VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue );
+void	VM_CheckBlock( vm_t *vm, intptr_t vmAddr, int count, int size, const char *function );
 
 #define	VMA(x) VM_ArgPtr(args[x])
 static ID_INLINE float _vmf(intptr_t x)
@@ -647,6 +650,8 @@ fileHandle_t	FS_FCreateOpenPipeFile( const char *filename );
 fileHandle_t FS_SV_FOpenFileWrite( const char *filename );
 long		FS_SV_FOpenFileRead( const char *filename, fileHandle_t *fp );
 void	FS_SV_Rename( const char *from, const char *to, qboolean safe );
+qboolean	FS_SV_ReplaceFile( const char *filename, const void *buffer, int size );
+// writes a whole file under the home path, also files other writers may not touch
 long		FS_FOpenFileRead( const char *qpath, fileHandle_t *file, qboolean uniqueFILE );
 // if uniqueFILE is true, then a new FILE will be fopened even if the file
 // is found in an already open pak file.  If uniqueFILE is false, you must call
@@ -892,6 +897,7 @@ extern	int		time_frontend;
 extern	int		time_backend;		// renderer backend time
 
 extern	int		com_frameTime;
+extern	int		com_packetTime;		// Sys_Milliseconds when the packet being run arrived
 
 extern	qboolean	com_errorEntered;
 extern	qboolean	com_fullyInitialized;
@@ -965,6 +971,15 @@ void Com_Init( char *commandLine );
 void Com_Frame( void );
 void Com_Shutdown( void );
 
+#define	MAX_JOB_THREADS		16
+
+void Com_RunJobs( void (*function)( void *data, int index ), void *data, int count, int numThreads );
+// calls function( data, index ) for every index in [0, count) spread over
+// up to numThreads threads, including the calling one, and returns when all
+// of them are done.  Jobs must not print, call Com_Error, touch the zone or
+// hunk allocators, or call Com_RunJobs themselves.
+void Com_ShutdownJobs( void );
+
 
 /*
 ==============================================================
@@ -1111,6 +1126,8 @@ cpuFeatures_t Sys_GetProcessorFeatures( void );
 void	Sys_SetErrorText( const char *text );
 
 void	Sys_SendPacket( int length, const void *data, netadr_t to );
+void	Sys_BeginPacketBatch( void );
+void	Sys_EndPacketBatch( void );
 
 qboolean	Sys_StringToAdr( const char *s, netadr_t *a, netadrtype_t family );
 //Does NOT parse port numbers, only base addresses.
@@ -1141,6 +1158,20 @@ char **Sys_ListFiles( const char *directory, const char *extension, char *filter
 void	Sys_FreeFileList( char **list );
 void	Sys_Sleep(int msec);
 
+// threads and synchronization, see Com_RunJobs for the usual entry point
+int		Sys_ProcessorCount( void );
+void	*Sys_CreateThread( void (*function)( void *arg ), void *arg );
+void	Sys_JoinThread( void *thread );
+void	*Sys_CreateMutex( void );
+void	Sys_DestroyMutex( void *mutex );
+void	Sys_LockMutex( void *mutex );
+void	Sys_UnlockMutex( void *mutex );
+void	*Sys_CreateSemaphore( void );
+void	Sys_DestroySemaphore( void *sem );
+void	Sys_WaitSemaphore( void *sem );
+qboolean	Sys_TimedWaitSemaphore( void *sem, int msec );
+void	Sys_PostSemaphore( void *sem );
+
 qboolean Sys_LowPhysicalMemory( void );
 
 void Sys_SetEnv(const char *name, const char *value);
@@ -1214,6 +1245,20 @@ void	Huff_offsetTransmit (huff_t *huff, int ch, byte *fout, int *offset, int max
 void	Huff_putBit( int bit, byte *fout, int *offset);
 int		Huff_getBit( byte *fout, int *offset);
 
+// flattened form of a tree that is no longer updated
+#define HUFF_LOOKUP_BITS	11
+
+typedef struct {
+	unsigned int	code[HMAX+1];			// first bit sent in bit 0
+	byte			codeBits[HMAX+1];		// 0 when the symbol can't be sent from the table
+	short			lookupSymbol[1<<HUFF_LOOKUP_BITS];
+	byte			lookupBits[1<<HUFF_LOOKUP_BITS];	// 0 when the code is longer than HUFF_LOOKUP_BITS
+} huffTable_t;
+
+void	Huff_BuildTable( huffTable_t *table, const huff_t *compressor, const huff_t *decompressor );
+void	Huff_tableTransmit( const huffTable_t *table, huff_t *huff, int ch, byte *fout, int *offset, int maxoffset );
+void	Huff_tableReceive( const huffTable_t *table, node_t *node, int *ch, byte *fin, int *offset, int maxoffset );
+
 // don't use if you don't know what you're doing.
 int		Huff_getBloc(void);
 void	Huff_setBloc(int _bloc);
@@ -40,6 +40,8 @@ vm_t	*currentVM = NULL;
 vm_t	*lastVM    = NULL;
 int		vm_debugLevel;
 
+cvar_t	*vm_compileCache;
+
 // used by Com_Error to get rid of running vm's before longjmp
 static int forced_unload;
 
@@ -73,6 +75,7 @@ void VM_Init( void ) {
 	Cvar_Get( "vm_cgame", "2", CVAR_ARCHIVE );	// !@# SHIP WITH SET TO 2
 	Cvar_Get( "vm_game", "2", CVAR_ARCHIVE );	// !@# SHIP WITH SET TO 2
 	Cvar_Get( "vm_ui", "2", CVAR_ARCHIVE );		// !@# SHIP WITH SET TO 2
+	vm_compileCache = Cvar_Get( "vm_compileCache", "1", CVAR_ARCHIVE );
 
 	Cmd_AddCommand ("vmprofile", VM_VmProfile_f );
 	Cmd_AddCommand ("vminfo", VM_VmInfo_f );
@@ -521,6 +524,146 @@ vmHeader_t *VM_LoadQVM( vm_t *vm, qboolean alloc, qboolean unpure)
 	return header.h;
 }
 
+/*
+==============================================================
+
+COMPILE CACHE
+
+A bytecode compiler can save its output for a qvm under cache/ in the home
+path and load it back on the next VM_Create, instead of compiling the qvm
+again on every map change.  The file keeps a copy of the qvm code and jump
+table targets, so it is only ever used for the exact program it was built
+from.  The rest of the file belongs to the compiler, which names itself
+and its build so a changed compiler never loads an old file.
+
+Cache files are native byte order, they are tied to ARCH_STRING anyway.
+
+==============================================================
+*/
+
+#define	VM_CACHE_IDENT		(('C'<<24)+('M'<<16)+('V'<<8)+'Q')	// "QVMC"
+#define	VM_CACHE_VERSION	1
+
+typedef struct {
+	int		ident;
+	int		version;
+	char	compiler[64];
+	int		instructionCount;
+	int		codeLength;
+	int		jumpTableLength;
+	int		dataMask;
+	int		payloadLength;
+} vmCacheHeader_t;
+
+/*
+=================
+VM_CompileCachePath
+=================
+*/
+static void VM_CompileCachePath( const vm_t *vm, char *path, int size ) {
+	Com_sprintf( path, size, "%s/cache/%s.%s.jit", FS_GetCurrentGameDir(), vm->name, ARCH_STRING );
+}
+
+/*
+=================
+VM_ReadCompileCache
+
+Returns the compiler's part of the cache file for this qvm, or NULL if
+there is none for this exact qvm and compiler.  Free the returned
+buffer with Z_Free.
+=================
+*/
+byte *VM_ReadCompileCache( vm_t *vm, vmHeader_t *header, const char *compiler, byte **payload, int *payloadLength ) {
+	char			path[MAX_QPATH];
+	fileHandle_t	f;
+	long			len;
+	byte			*buf, *p;
+	vmCacheHeader_t	*cache;
+	int				jumpTableLength;
+
+	VM_CompileCachePath( vm, path, sizeof( path ) );
+	len = FS_SV_FOpenFileRead( path, &f );
+	if ( !f ) {
+		return NULL;
+	}
+	if ( len < sizeof( *cache ) ) {
+		FS_FCloseFile( f );
+		return NULL;
+	}
+
+	buf = Z_Malloc( len );
+	len = FS_Read( buf, len, f );
+	FS_FCloseFile( f );
+
+	cache = (vmCacheHeader_t *)buf;
+	jumpTableLength = vm->numJumpTableTargets * sizeof( int );
+	p = buf + sizeof( *cache );
+	if ( len < sizeof( *cache )
+		|| cache->ident != VM_CACHE_IDENT
+		|| cache->version != VM_CACHE_VERSION
+		|| strncmp( cache->compiler, compiler, sizeof( cache->compiler ) )
+		|| cache->instructionCount != header->instructionCount
+		|| cache->codeLength != header->codeLength
+		|| cache->jumpTableLength != jumpTableLength
+		|| cache->dataMask != vm->dataMask
+		|| cache->payloadLength < 0
+		|| len != sizeof( *cache ) + cache->codeLength + cache->jumpTableLength + cache->payloadLength
+		|| memcmp( p, (byte *)header + header->codeOffset, header->codeLength )
+		|| ( jumpTableLength && memcmp( p + header->codeLength, vm->jumpTableTargets, jumpTableLength ) ) ) {
+		Com_DPrintf( "Ignoring stale compile cache %s\n", path );
+		Z_Free( buf );
+		return NULL;
+	}
+
+	*payload = p + header->codeLength + jumpTableLength;
+	*payloadLength = cache->payloadLength;
+	return buf;
+}
+
+/*
+=================
+VM_WriteCompileCache
+
+Other writers can not create .jit files, see FS_CheckFilenameIsMutable
+=================
+*/
+void VM_WriteCompileCache( vm_t *vm, vmHeader_t *header, const char *compiler, const byte *payload, int payloadLength ) {
+	char			path[MAX_QPATH];
+	vmCacheHeader_t	*cache;
+	byte			*buf, *p;
+	int				size;
+
+	size = sizeof( *cache ) + header->codeLength + vm->numJumpTableTargets * sizeof( int ) + payloadLength;
+	buf = Z_Malloc( size );
+
+	cache = (vmCacheHeader_t *)buf;
+	cache->ident = VM_CACHE_IDENT;
+	cache->version = VM_CACHE_VERSION;
+	Q_strncpyz( cache->compiler, compiler, sizeof( cache->compiler ) );
+	cache->instructionCount = header->instructionCount;
+	cache->codeLength = header->codeLength;
+	cache->jumpTableLength = vm->numJumpTableTargets * sizeof( int );
+	cache->dataMask = vm->dataMask;
+	cache->payloadLength = payloadLength;
+
+	p = buf + sizeof( *cache );
+	Com_Memcpy( p, (byte *)header + header->codeOffset, header->codeLength );
+	p += header->codeLength;
+	if ( cache->jumpTableLength ) {
+		Com_Memcpy( p, vm->jumpTableTargets, cache->jumpTableLength );
+		p += cache->jumpTableLength;
+	}
+	Com_Memcpy( p, payload, payloadLength );
+
+	VM_CompileCachePath( vm, path, sizeof( path ) );
+	if ( !FS_SV_ReplaceFile( path, buf, size ) ) {
+		Com_DPrintf( "Couldn't write compile cache %s\n", path );
+	}
+
+	Z_Free( buf );
+}
+
+
 /*
 =================
 VM_Restart
@@ -779,6 +922,37 @@ void *VM_ExplicitArgPtr( vm_t *vm, intptr_t intValue ) {
 	}
 }
 
+/*
+============
+VM_CheckBlock
+
+Drops the game if an array that a system call is going to use doesn't
+fit in the vm data segment.  Native libraries aren't sandboxed anyway.
+============
+*/
+void VM_CheckBlock( vm_t *vm, intptr_t vmAddr, int count, int size, const char *function ) {
+	int		available;
+
+	if ( vm->entryPoint ) {
+		return;
+	}
+
+	if ( count < 0 ) {
+		Com_Error( ERR_DROP, "%s: negative count %i", function, count );
+	}
+	if ( !count ) {
+		return;
+	}
+	if ( !vmAddr ) {
+		Com_Error( ERR_DROP, "%s: NULL array", function );
+	}
+
+	available = vm->dataMask + 1 - ( vmAddr & vm->dataMask );
+	if ( size > available / count ) {
+		Com_Error( ERR_DROP, "%s: array of %i runs off the end of the vm", function, count );
+	}
+}
+
 
 /*
 ==============
@@ -0,0 +1,875 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+
+AArch64 VM, laid out after vm_armv7l.c
+
+The opstack lives in memory and grows upwards as in the ARMv7 compiler, but it
+is addressed through an index that wraps at 256 entries like the interpreter's
+uint8_t opStackOfs, so no opcode sequence can reach past the buffer.  The
+programStack and the data segment are addressed through 32 bit registers
+and every load and store address is masked with vm->dataMask first.  VM
+functions use the native stack for their return addresses, so OP_ENTER and
+OP_LEAVE are a stp/ldp of x29 and x30.
+
+Docu:
+Arm Architecture Reference Manual for A-profile architecture (DDI 0487)
+*/
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <stddef.h>
+
+#include "vm_local.h"
+
+// registers that survive calls into C, see the AAPCS64
+#define rOPSTACK	19		// w19, index of the top of the opstack, kept below 256
+#define rOPSTACKBASE	20	// x20, int *, the opstack buffer
+#define rCODEBASE	21		// x21, vm->codeBase
+#define rPSTACK		22		// w22, programStack
+#define rDATABASE	23		// x23, vm->dataBase
+#define rDATAMASK	24		// w24, vm->dataMask
+#define rINSTRUCTIONS	25	// x25, vm->instructionPointers
+#define rINSCOUNT	26		// w26, vm->instructionCount
+#define rPSTACKPTR	27		// x27, where to write back programStack on exit
+#define rOPSTACKPTR	28		// x28, where to write back the opstack index on exit
+
+// scratch
+#define R0	0
+#define R1	1
+#define R2	2
+#define R3	3
+#define R16	16				// ip0, holds call targets
+#define FP	29
+#define LR	30
+#define SP	31				// in address operands
+#define ZR	31				// in data operands
+
+#define S0	0
+#define S1	1
+
+/* exit() won't be called but use it because it is marked with noreturn */
+#define DIE( reason, args... ) \
+	do { \
+		Com_Error(ERR_DROP, "vm_aarch64 compiler error: " reason, ##args); \
+		exit(1); \
+	} while(0)
+
+// conditions
+#define EQ	0x0
+#define NE	0x1
+#define HS	0x2
+#define LO	0x3
+#define MI	0x4
+#define PL	0x5
+#define HI	0x8
+#define LS	0x9
+#define GE	0xa
+#define LT	0xb
+#define GT	0xc
+#define LE	0xd
+#define INVERT(c)	((c) ^ 1)
+
+// moves, imm16 shifted left by 16 * hw
+#define MOVZw(rd, imm16, hw)	(0x52800000 | ((hw)<<21) | (((imm16)&0xFFFF)<<5) | (rd))
+#define MOVNw(rd, imm16, hw)	(0x12800000 | ((hw)<<21) | (((imm16)&0xFFFF)<<5) | (rd))
+#define MOVKw(rd, imm16, hw)	(0x72800000 | ((hw)<<21) | (((imm16)&0xFFFF)<<5) | (rd))
+#define MOVZx(rd, imm16, hw)	(0xD2800000 | ((hw)<<21) | (((imm16)&0xFFFF)<<5) | (rd))
+#define MOVKx(rd, imm16, hw)	(0xF2800000 | ((hw)<<21) | (((imm16)&0xFFFF)<<5) | (rd))
+#define MOVw(rd, rm)			(0x2A0003E0 | ((rm)<<16) | (rd))
+#define MOVx(rd, rm)			(0xAA0003E0 | ((rm)<<16) | (rd))
+#define MOVx_SP(rd, rn)			(0x91000000 | ((rn)<<5) | (rd))	// add rd, rn, #0
+
+// arithmetic, imm12 is unsigned
+#define ADDwi(rd, rn, imm12)	(0x11000000 | ((imm12)<<10) | ((rn)<<5) | (rd))
+#define SUBwi(rd, rn, imm12)	(0x51000000 | ((imm12)<<10) | ((rn)<<5) | (rd))
+#define ADDw(rd, rn, rm)		(0x0B000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define SUBw(rd, rn, rm)		(0x4B000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define ADDx(rd, rn, rm)		(0x8B000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define CMPw(rn, rm)			(0x6B000000 | ((rm)<<16) | ((rn)<<5) | ZR)
+#define NEGw(rd, rm)			SUBw(rd, ZR, rm)
+#define ANDw(rd, rn, rm)		(0x0A000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define ORRw(rd, rn, rm)		(0x2A000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define EORw(rd, rn, rm)		(0x4A000000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define MVNw(rd, rm)			(0x2A2003E0 | ((rm)<<16) | (rd))
+#define UXTBw(rd, rn)			(0x53001C00 | ((rn)<<5) | (rd))	// ubfm rd, rn, #0, #7
+#define SXTBw(rd, rn)			(0x13001C00 | ((rn)<<5) | (rd))	// sbfm rd, rn, #0, #7
+#define SXTHw(rd, rn)			(0x13003C00 | ((rn)<<5) | (rd))	// sbfm rd, rn, #0, #15
+#define MULw(rd, rn, rm)		(0x1B007C00 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define MSUBw(rd, rn, rm, ra)	(0x1B008000 | ((rm)<<16) | ((ra)<<10) | ((rn)<<5) | (rd))	// rd = ra - rn * rm
+#define SDIVw(rd, rn, rm)		(0x1AC00C00 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define UDIVw(rd, rn, rm)		(0x1AC00800 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define LSLw(rd, rn, rm)		(0x1AC02000 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define LSRw(rd, rn, rm)		(0x1AC02400 | ((rm)<<16) | ((rn)<<5) | (rd))
+#define ASRw(rd, rn, rm)		(0x1AC02800 | ((rm)<<16) | ((rn)<<5) | (rd))
+
+// loads and stores, unsigned offsets are in bytes and must be aligned
+#define LDRwi(rt, rn, off)		(0xB9400000 | (((off)>>2)<<10) | ((rn)<<5) | (rt))
+#define STRwi(rt, rn, off)		(0xB9000000 | (((off)>>2)<<10) | ((rn)<<5) | (rt))
+#define LDRxi(rt, rn, off)		(0xF9400000 | (((off)>>3)<<10) | ((rn)<<5) | (rt))
+// [xn, wm, uxtw]
+#define LDRw_uxtw(rt, rn, rm)	(0xB8604800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define STRw_uxtw(rt, rn, rm)	(0xB8204800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define LDRHw_uxtw(rt, rn, rm)	(0x78604800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define STRHw_uxtw(rt, rn, rm)	(0x78204800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define LDRBw_uxtw(rt, rn, rm)	(0x38604800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define STRBw_uxtw(rt, rn, rm)	(0x38204800 | ((rm)<<16) | ((rn)<<5) | (rt))
+// [xn, wm, uxtw #2]
+#define LDRw_uxtw2(rt, rn, rm)	(0xB8605800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define STRw_uxtw2(rt, rn, rm)	(0xB8205800 | ((rm)<<16) | ((rn)<<5) | (rt))
+#define LDRs_uxtw2(st, rn, rm)	(0xBC605800 | ((rm)<<16) | ((rn)<<5) | (st))
+#define STRs_uxtw2(st, rn, rm)	(0xBC205800 | ((rm)<<16) | ((rn)<<5) | (st))
+// [xn, wm, uxtw #3]
+#define LDRx_uxtw3(rt, rn, rm)	(0xF8605800 | ((rm)<<16) | ((rn)<<5) | (rt))
+// pairs, offsets in bytes
+#define STPx(rt, rt2, rn, off)	(0xA9000000 | ((((off)>>3)&0x7F)<<15) | ((rt2)<<10) | ((rn)<<5) | (rt))
+#define LDPx(rt, rt2, rn, off)	(0xA9400000 | ((((off)>>3)&0x7F)<<15) | ((rt2)<<10) | ((rn)<<5) | (rt))
+#define STPx_pre(rt, rt2, rn, off)	(0xA9800000 | ((((off)>>3)&0x7F)<<15) | ((rt2)<<10) | ((rn)<<5) | (rt))
+#define LDPx_post(rt, rt2, rn, off)	(0xA8C00000 | ((((off)>>3)&0x7F)<<15) | ((rt2)<<10) | ((rn)<<5) | (rt))
+
+// single precision floating point
+#define FADDs(sd, sn, sm)		(0x1E202800 | ((sm)<<16) | ((sn)<<5) | (sd))
+#define FSUBs(sd, sn, sm)		(0x1E203800 | ((sm)<<16) | ((sn)<<5) | (sd))
+#define FMULs(sd, sn, sm)		(0x1E200800 | ((sm)<<16) | ((sn)<<5) | (sd))
+#define FDIVs(sd, sn, sm)		(0x1E201800 | ((sm)<<16) | ((sn)<<5) | (sd))
+#define FNEGs(sd, sn)			(0x1E214000 | ((sn)<<5) | (sd))
+#define FCMPs(sn, sm)			(0x1E202000 | ((sm)<<16) | ((sn)<<5))
+#define SCVTFsw(sd, rn)			(0x1E220000 | ((rn)<<5) | (sd))
+#define FCVTZSws(rd, sn)		(0x1E380000 | ((sn)<<5) | (rd))
+
+// branches, offsets in bytes relative to the branch itself
+#define Bi(off)					(0x14000000 | (((off)>>2)&0x3FFFFFF))
+#define BLi(off)				(0x94000000 | (((off)>>2)&0x3FFFFFF))
+#define Bcond(c, off)			(0x54000000 | ((((off)>>2)&0x7FFFF)<<5) | (c))
+#define TBNZw31(rt, off)		(0x37F80000 | ((((off)>>2)&0x3FFF)<<5) | (rt))
+#define BR(rn)					(0xD61F0000 | ((rn)<<5))
+#define BLR(rn)					(0xD63F0000 | ((rn)<<5))
+#define RET						0xD65F03C0
+#define BRK(imm16)				(0xD4200000 | ((imm16)<<5))
+
+/*
+ * opcode information table:
+ * - length of immediate value
+ */
+#define opImm0	0x0000 /* no immediate */
+#define opImm1	0x0001 /* 1 byte immadiate value after opcode */
+#define opImm4	0x0002 /* 4 bytes immediate value after opcode */
+
+static const unsigned char vm_opInfo[256] =
+{
+	[OP_ENTER]	= opImm4,
+	[OP_LEAVE]	= opImm4,
+	[OP_CONST]	= opImm4,
+	[OP_LOCAL]	= opImm4,
+	[OP_EQ]		= opImm4,
+	[OP_NE]		= opImm4,
+	[OP_LTI]	= opImm4,
+	[OP_LEI]	= opImm4,
+	[OP_GTI]	= opImm4,
+	[OP_GEI]	= opImm4,
+	[OP_LTU]	= opImm4,
+	[OP_LEU]	= opImm4,
+	[OP_GTU]	= opImm4,
+	[OP_GEU]	= opImm4,
+	[OP_EQF]	= opImm4,
+	[OP_NEF]	= opImm4,
+	[OP_LTF]	= opImm4,
+	[OP_LEF]	= opImm4,
+	[OP_GTF]	= opImm4,
+	[OP_GEF]	= opImm4,
+	[OP_ARG]	= opImm1,
+	[OP_BLOCK_COPY]	= opImm4,
+};
+
+static void VM_Destroy_Compiled(vm_t *vm)
+{
+	if (vm->codeBase) {
+		if (munmap(vm->codeBase, vm->codeLength))
+			Com_Printf(S_COLOR_RED "Memory unmap failed, possible memory leak\n");
+	}
+	vm->codeBase = NULL;
+}
+
+/*
+=================
+ErrJump
+Error handler for jump/call to invalid instruction number
+=================
+*/
+
+static void __attribute__((__noreturn__)) ErrJump(unsigned num)
+{
+	Com_Error(ERR_DROP, "program tried to execute code outside VM (%x)", num);
+}
+
+/*
+=================
+asmcall
+Called from compiled code for a system call, with the same arguments as on ARMv7
+=================
+*/
+
+static int asmcall(int call, int pstack)
+{
+	// save currentVM so as to allow for recursive VM entry
+	vm_t *savedVM = currentVM;
+	intptr_t args[MAX_VMSYSCALL_ARGS];
+	int *argPosition;
+	int i, ret;
+
+	// modify VM stack pointer for recursive VM entry
+	currentVM->programStack = pstack - 4;
+
+	args[0] = -1 - call;
+	argPosition = (int *)((byte *)currentVM->dataBase + pstack + 4);
+	for( i = 1; i < ARRAY_LEN(args); i++ )
+		args[i] = argPosition[i];
+
+	ret = currentVM->systemCall(args);
+
+	currentVM = savedVM;
+
+	return ret;
+}
+
+static void _emit(vm_t *vm, unsigned isn, int pass)
+{
+	if (pass)
+		memcpy(vm->codeBase+vm->codeLength, &isn, 4);
+	vm->codeLength+=4;
+}
+
+#define emit(isn) _emit(vm, isn, pass)
+
+// load a 32 bit constant, the length depends only on the value
+static void emit_MOVwi(vm_t *vm, int reg, unsigned val, int pass)
+{
+	if (val <= 0xFFFF)
+		emit(MOVZw(reg, val, 0));
+	else if (~val <= 0xFFFF)
+		emit(MOVNw(reg, ~val, 0));
+	else {
+		emit(MOVZw(reg, val & 0xFFFF, 0));
+		emit(MOVKw(reg, val >> 16, 1));
+	}
+}
+
+// load a pointer, always four instructions
+static void emit_MOVxi(vm_t *vm, int reg, void *ptr, int pass)
+{
+	uint64_t val = (uint64_t)(intptr_t)ptr;
+
+	emit(MOVZx(reg, val & 0xFFFF, 0));
+	emit(MOVKx(reg, (val >> 16) & 0xFFFF, 1));
+	emit(MOVKx(reg, (val >> 32) & 0xFFFF, 2));
+	emit(MOVKx(reg, (val >> 48) & 0xFFFF, 3));
+}
+
+// rd = rn + val or rd = rn - val, clobbers R16
+static void emit_ADDwi(vm_t *vm, int rd, int rn, unsigned val, qboolean sub, int pass)
+{
+	if (val < 4096)
+		emit(sub ? SUBwi(rd, rn, val) : ADDwi(rd, rn, val));
+	else {
+		emit_MOVwi(vm, R16, val, pass);
+		emit(sub ? SUBw(rd, rn, R16) : ADDw(rd, rn, R16));
+	}
+}
+
+static unsigned _j_rel(int x, int pc)
+{
+	if (x & 3 || x < -(1 << 27) || x >= (1 << 27))
+		DIE("jump %d out of range at %d", x, pc);
+	return x;
+}
+
+// check if instruction in R0 is within range, jumps to ErrJump otherwise
+#define CHECK_JUMP do { \
+	emit(CMPw(R0, rINSCOUNT)); \
+	emit(Bcond(LO, 8)); \
+	emit(Bi(j_rel(get_offset(OFF_ERRJUMP)-vm->codeLength))); \
+} while(0)
+
+// the mapping is only there in the second pass
+#define VMFREE_BUFFERS() do { \
+	if (vm->codeBase) { \
+		vm->codeLength = codeSize; \
+		VM_Destroy_Compiled(vm); \
+	} \
+} while(0)
+
+#define CHECK_CONST_JUMP(x) do { \
+	if ((x) < 0 || (x) >= vm->instructionCount) { \
+		VMFREE_BUFFERS(); \
+		Com_Error(ERR_DROP, "VM_CompileAArch64: jump target out of range at offset %d", pc); \
+	} \
+} while(0)
+
+#define IJ(comparator) do { \
+	CHECK_CONST_JUMP(arg.i); \
+	POPw(R0); \
+	POPw(R1); \
+	emit(CMPw(R1, R0)); \
+	emit(Bcond(INVERT(comparator), 8)); \
+	emit(Bi(j_rel(vm->instructionPointers[arg.i]-vm->codeLength))); \
+} while (0)
+
+// unordered compares fall through except for OP_NEF, like the C operators
+#define FJ(comparator) do { \
+	CHECK_CONST_JUMP(arg.i); \
+	POPs(S0); \
+	POPs(S1); \
+	emit(FCMPs(S1, S0)); \
+	emit(Bcond(INVERT(comparator), 8)); \
+	emit(Bi(j_rel(vm->instructionPointers[arg.i]-vm->codeLength))); \
+} while (0)
+
+// the opstack index wraps at 256 entries, clobbering lower slots rather than
+// running off the buffer, the same as opStackOfs in the interpreter
+#define INC_OPSTACK(n) do { \
+	emit(ADDwi(rOPSTACK, rOPSTACK, n)); \
+	emit(UXTBw(rOPSTACK, rOPSTACK)); \
+} while (0)
+
+#define DEC_OPSTACK(n) do { \
+	emit(SUBwi(rOPSTACK, rOPSTACK, n)); \
+	emit(UXTBw(rOPSTACK, rOPSTACK)); \
+} while (0)
+
+#define TOPw(r)		emit(LDRw_uxtw2(r, rOPSTACKBASE, rOPSTACK))
+#define SETTOPw(r)	emit(STRw_uxtw2(r, rOPSTACKBASE, rOPSTACK))
+#define TOPs(s)		emit(LDRs_uxtw2(s, rOPSTACKBASE, rOPSTACK))
+#define SETTOPs(s)	emit(STRs_uxtw2(s, rOPSTACKBASE, rOPSTACK))
+
+#define PUSHw(r) do { \
+	INC_OPSTACK(1); \
+	SETTOPw(r); \
+} while (0)
+
+#define POPw(r) do { \
+	TOPw(r); \
+	DEC_OPSTACK(1); \
+} while (0)
+
+#define POPs(s) do { \
+	TOPs(s); \
+	DEC_OPSTACK(1); \
+} while (0)
+
+// r0 = *opstack; opstack--; r1 = *opstack; r0 = r1 op r0; *opstack = r0
+#define BINOP(isn) do { \
+	TOPw(R0); \
+	DEC_OPSTACK(1); \
+	TOPw(R1); \
+	emit(isn); \
+	SETTOPw(R0); \
+} while (0)
+
+#define BINOPF(isn) do { \
+	TOPs(S0); \
+	DEC_OPSTACK(1); \
+	TOPs(S1); \
+	emit(isn); \
+	SETTOPs(S0); \
+} while (0)
+
+void VM_Compile(vm_t *vm, vmHeader_t *header)
+{
+	unsigned char *code;
+	int i_count, pc = 0;
+	int pass;
+	int codeoffsets[4] = { 0 };
+	int codeSize = 0;
+
+#define j_rel(x) (pass?_j_rel(x, pc):0)
+#define get_offset(i) (codeoffsets[i])
+#define save_offset(i) (codeoffsets[i] = vm->codeLength)
+#define OFF_CODE 0
+#define OFF_ERRJUMP 1
+#define OFF_SYSCALL 2
+#define OFF_BLOCKCOPY 3
+
+	if (offsetof(vm_t, instructionCount) >= 4096 * 4 || offsetof(vm_t, instructionPointers) >= 4096 * 8)
+		DIE("vm_t too large for unsigned offsets");
+
+	vm->compiled = qfalse;
+
+	vm->codeBase = NULL;
+	vm->codeLength = 0;
+
+	for (pass = 0; pass < 2; ++pass) {
+
+	if(pass)
+	{
+		codeSize = vm->codeLength;
+		vm->codeBase = mmap(NULL, codeSize, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+		if(vm->codeBase == MAP_FAILED)
+			Com_Error(ERR_FATAL, "VM_CompileAArch64: can't mmap memory");
+		vm->codeLength = 0;
+	}
+
+	//int (*entry)(vm_t*, int*, int*, int*);
+	emit(STPx_pre(FP, LR, SP, -96));
+	emit(MOVx_SP(FP, SP));
+	emit(STPx(19, 20, SP, 16));
+	emit(STPx(21, 22, SP, 32));
+	emit(STPx(23, 24, SP, 48));
+	emit(STPx(25, 26, SP, 64));
+	emit(STPx(27, 28, SP, 80));
+	emit(LDRxi(rCODEBASE, R0, offsetof(vm_t, codeBase)));
+	emit(LDRxi(rDATABASE, R0, offsetof(vm_t, dataBase)));
+	emit(LDRwi(rDATAMASK, R0, offsetof(vm_t, dataMask)));
+	emit(LDRxi(rINSTRUCTIONS, R0, offsetof(vm_t, instructionPointers)));
+	emit(LDRwi(rINSCOUNT, R0, offsetof(vm_t, instructionCount)));
+	emit(MOVx(rPSTACKPTR, R1));
+	emit(LDRwi(rPSTACK, R1, 0));
+	emit(MOVx(rOPSTACKBASE, R2));
+	emit(MOVx(rOPSTACKPTR, R3));
+	emit(MOVZw(rOPSTACK, 0, 0));
+
+	emit(BLi(j_rel(get_offset(OFF_CODE)-vm->codeLength)));
+
+	// return value in w0, programStack and the opstack index back to the caller
+	POPw(R0);  // r0 = *opstack; opstack--
+	emit(STRwi(rPSTACK, rPSTACKPTR, 0));
+	emit(STRwi(rOPSTACK, rOPSTACKPTR, 0));
+
+	emit(LDPx(27, 28, SP, 80));
+	emit(LDPx(25, 26, SP, 64));
+	emit(LDPx(23, 24, SP, 48));
+	emit(LDPx(21, 22, SP, 32));
+	emit(LDPx(19, 20, SP, 16));
+	emit(LDPx_post(FP, LR, SP, 96));
+	emit(RET);
+
+	// calls into C go through these, so the code itself only needs a bl or b
+	save_offset(OFF_ERRJUMP);
+	emit_MOVxi(vm, R16, ErrJump, pass);
+	emit(BR(R16));
+
+	save_offset(OFF_SYSCALL);
+	emit_MOVxi(vm, R16, asmcall, pass);
+	emit(BR(R16));
+
+	save_offset(OFF_BLOCKCOPY);
+	emit_MOVxi(vm, R16, VM_BlockCopy, pass);
+	emit(BR(R16));
+
+	save_offset(OFF_CODE);
+
+	code = (unsigned char *) header + header->codeOffset;
+	pc = 0;
+
+	for (i_count = 0; i_count < header->instructionCount; i_count++) {
+		union {
+			unsigned char b[4];
+			int i;
+		} arg;
+		unsigned char op = code[pc++];
+
+		arg.i = 0;
+		vm->instructionPointers[i_count] = vm->codeLength;
+
+		if (vm_opInfo[op] & opImm4)
+		{
+			memcpy(arg.b, &code[pc], 4);
+			pc += 4;
+		}
+		else if (vm_opInfo[op] & opImm1)
+		{
+			arg.i = code[pc];
+			++pc;
+		}
+
+		switch ( op )
+		{
+			case OP_UNDEF:
+			case OP_IGNORE:
+				break;
+
+			case OP_BREAK:
+				emit(BRK(0));
+				break;
+
+			case OP_ENTER:
+				emit(STPx_pre(FP, LR, SP, -16));
+				emit_ADDwi(vm, rPSTACK, rPSTACK, arg.i, qtrue, pass); // pstack -= arg
+				break;
+
+			case OP_LEAVE:
+				emit_ADDwi(vm, rPSTACK, rPSTACK, arg.i, qfalse, pass); // pstack += arg
+				emit(LDPx_post(FP, LR, SP, 16));
+				emit(RET);
+				break;
+
+			case OP_CALL:
+				// get instruction nr from stack
+				POPw(R0);  // r0 = *opstack; opstack--
+				emit(TBNZw31(R0, 8 * 4)); // negative means syscall
+					CHECK_JUMP;
+					emit(LDRx_uxtw3(R16, rINSTRUCTIONS, R0)); // r16 = instructionPointers[r0]
+					emit(ADDx(R16, rCODEBASE, R16)); // r16 = codeBase+r16
+					emit(BLR(R16));
+					emit(Bi(6 * 4)); // the callee left its result on the opstack
+				emit(MOVw(R1, rPSTACK));
+				emit(BLi(j_rel(get_offset(OFF_SYSCALL)-vm->codeLength)));
+				// store return value
+				PUSHw(R0);      // opstack++; *opstack = r0
+				break;
+
+			case OP_PUSH:
+				INC_OPSTACK(1);
+				break;
+
+			case OP_POP:
+				DEC_OPSTACK(1);
+				break;
+
+			case OP_CONST:
+				emit_MOVwi(vm, R0, arg.i, pass);
+				PUSHw(R0);      // opstack++; *opstack = r0
+				break;
+
+			case OP_LOCAL:
+				emit_ADDwi(vm, R0, rPSTACK, arg.i, qfalse, pass); // r0 = pstack+arg
+				PUSHw(R0);      // opstack++; *opstack = r0
+				break;
+
+			case OP_JUMP:
+				POPw(R0);  // r0 = *opstack; opstack--
+				CHECK_JUMP;
+				emit(LDRx_uxtw3(R16, rINSTRUCTIONS, R0)); // r16 = instructionPointers[r0]
+				emit(ADDx(R16, rCODEBASE, R16)); // r16 = codeBase+r16
+				emit(BR(R16));
+				break;
+
+			case OP_EQ:
+				IJ(EQ);
+				break;
+
+			case OP_NE:
+				IJ(NE);
+				break;
+
+			case OP_LTI:
+				IJ(LT);
+				break;
+
+			case OP_LEI:
+				IJ(LE);
+				break;
+
+			case OP_GTI:
+				IJ(GT);
+				break;
+
+			case OP_GEI:
+				IJ(GE);
+				break;
+
+			case OP_LTU:
+				IJ(LO);
+				break;
+
+			case OP_LEU:
+				IJ(LS);
+				break;
+
+			case OP_GTU:
+				IJ(HI);
+				break;
+
+			case OP_GEU:
+				IJ(HS);
+				break;
+
+			case OP_EQF:
+				FJ(EQ);
+				break;
+
+			case OP_NEF:
+				FJ(NE);
+				break;
+
+			case OP_LTF:
+				FJ(MI);
+				break;
+
+			case OP_LEF:
+				FJ(LS);
+				break;
+
+			case OP_GTF:
+				FJ(GT);
+				break;
+
+			case OP_GEF:
+				FJ(GE);
+				break;
+
+			case OP_LOAD1:
+				TOPw(R0);   // r0 = *opstack
+				emit(ANDw(R0, R0, rDATAMASK));    // r0 = r0 & rDATAMASK
+				emit(LDRBw_uxtw(R0, rDATABASE, R0));  // r0 = (unsigned char)dataBase[r0]
+				SETTOPw(R0);   // *opstack = r0
+				break;
+
+			case OP_LOAD2:
+				TOPw(R0);   // r0 = *opstack
+				emit(ANDw(R0, R0, rDATAMASK));    // r0 = r0 & rDATAMASK
+				emit(LDRHw_uxtw(R0, rDATABASE, R0));  // r0 = (unsigned short)dataBase[r0]
+				SETTOPw(R0);   // *opstack = r0
+				break;
+
+			case OP_LOAD4:
+				TOPw(R0);   // r0 = *opstack
+				emit(ANDw(R0, R0, rDATAMASK));    // r0 = r0 & rDATAMASK
+				emit(LDRw_uxtw(R0, rDATABASE, R0));  // r0 = dataBase[r0]
+				SETTOPw(R0);   // *opstack = r0
+				break;
+
+			case OP_STORE1:
+				POPw(R0);  // r0 = *opstack; opstack--
+				POPw(R1);  // r1 = *opstack; opstack--
+				emit(ANDw(R1, R1, rDATAMASK));    // r1 = r1 & rDATAMASK
+				emit(STRBw_uxtw(R0, rDATABASE, R1)); // database[r1] = r0
+				break;
+
+			case OP_STORE2:
+				POPw(R0);  // r0 = *opstack; opstack--
+				POPw(R1);  // r1 = *opstack; opstack--
+				emit(ANDw(R1, R1, rDATAMASK));    // r1 = r1 & rDATAMASK
+				emit(STRHw_uxtw(R0, rDATABASE, R1)); // database[r1] = r0
+				break;
+
+			case OP_STORE4:
+				POPw(R0);  // r0 = *opstack; opstack--
+				POPw(R1);  // r1 = *opstack; opstack--
+				emit(ANDw(R1, R1, rDATAMASK));    // r1 = r1 & rDATAMASK
+				emit(STRw_uxtw(R0, rDATABASE, R1)); // database[r1] = r0
+				break;
+
+			case OP_ARG:
+				POPw(R0);      // r0 = *opstack; opstack--
+				emit(ADDwi(R1, rPSTACK, arg.i));  // r1 = programStack+arg
+				emit(ANDw(R1, R1, rDATAMASK));       // r1 = r1 & rDATAMASK
+				emit(STRw_uxtw(R0, rDATABASE, R1));      // dataBase[r1] = r0
+				break;
+
+			case OP_BLOCK_COPY:
+				// VM_BlockCopy checks both ranges against the data mask
+				POPw(R1);  // src
+				POPw(R0);  // dest
+				emit_MOVwi(vm, R2, arg.i, pass);
+				emit(BLi(j_rel(get_offset(OFF_BLOCKCOPY)-vm->codeLength)));
+				break;
+
+			case OP_SEX8:
+				TOPw(R0);                      // r0 = *opstack
+				emit(SXTBw(R0, R0));           // sign extend the low byte
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			case OP_SEX16:
+				TOPw(R0);                      // r0 = *opstack
+				emit(SXTHw(R0, R0));           // sign extend the low half
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			case OP_NEGI:
+				TOPw(R0);  // r0 = *opstack
+				emit(NEGw(R0, R0));            // r0 = -r0
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			case OP_ADD:
+				BINOP(ADDw(R0, R1, R0));       // r0 = r1 + r0
+				break;
+
+			case OP_SUB:
+				BINOP(SUBw(R0, R1, R0));       // r0 = r1 - r0
+				break;
+
+			case OP_DIVI:
+				BINOP(SDIVw(R0, R1, R0));      // r0 = r1 / r0
+				break;
+
+			case OP_DIVU:
+				BINOP(UDIVw(R0, R1, R0));      // r0 = r1 / r0
+				break;
+
+			case OP_MODI:
+				TOPw(R0);  // r0 = *opstack
+				DEC_OPSTACK(1);                // opstack--
+				TOPw(R1);                      // r1 = *opstack
+				emit(SDIVw(R2, R1, R0));       // r2 = r1 / r0
+				emit(MSUBw(R0, R2, R0, R1));   // r0 = r1 - r2 * r0
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			case OP_MODU:
+				TOPw(R0);  // r0 = *opstack
+				DEC_OPSTACK(1);                // opstack--
+				TOPw(R1);                      // r1 = *opstack
+				emit(UDIVw(R2, R1, R0));       // r2 = r1 / r0
+				emit(MSUBw(R0, R2, R0, R1));   // r0 = r1 - r2 * r0
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			case OP_MULI:
+			case OP_MULU:
+				BINOP(MULw(R0, R1, R0));       // r0 = r1 * r0
+				break;
+
+			case OP_BAND:
+				BINOP(ANDw(R0, R1, R0));       // r0 = r1 & r0
+				break;
+
+			case OP_BOR:
+				BINOP(ORRw(R0, R1, R0));       // r0 = r1 | r0
+				break;
+
+			case OP_BXOR:
+				BINOP(EORw(R0, R1, R0));       // r0 = r1 ^ r0
+				break;
+
+			case OP_BCOM:
+				TOPw(R0);  // r0 = *opstack
+				emit(MVNw(R0, R0));            // r0 = ~r0
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			case OP_LSH:
+				BINOP(LSLw(R0, R1, R0));       // r0 = r1 << r0
+				break;
+
+			case OP_RSHI:
+				BINOP(ASRw(R0, R1, R0));       // r0 = r1 >> r0
+				break;
+
+			case OP_RSHU:
+				BINOP(LSRw(R0, R1, R0));       // r0 = (unsigned)r1 >> r0
+				break;
+
+			case OP_NEGF:
+				TOPs(S0);  // s0 = *((float*)opstack)
+				emit(FNEGs(S0, S0));           // s0 = -s0
+				SETTOPs(S0);  // *((float*)opstack) = s0
+				break;
+
+			case OP_ADDF:
+				BINOPF(FADDs(S0, S1, S0));     // s0 = s1 + s0
+				break;
+
+			case OP_SUBF:
+				BINOPF(FSUBs(S0, S1, S0));     // s0 = s1 - s0
+				break;
+
+			case OP_DIVF:
+				BINOPF(FDIVs(S0, S1, S0));     // s0 = s1 / s0
+				break;
+
+			case OP_MULF:
+				BINOPF(FMULs(S0, S1, S0));     // s0 = s1 * s0
+				break;
+
+			case OP_CVIF:
+				TOPw(R0);  // r0 = *opstack
+				emit(SCVTFsw(S0, R0));         // s0 = (float)r0
+				SETTOPs(S0);  // *((float*)opstack) = s0
+				break;
+
+			case OP_CVFI:
+				TOPs(S0);  // s0 = *((float*)opstack)
+				emit(FCVTZSws(R0, S0));        // r0 = (int)s0
+				SETTOPw(R0);  // *opstack = r0
+				break;
+
+			default:
+				VMFREE_BUFFERS();
+				Com_Error(ERR_DROP, "VM_CompileAArch64: bad opcode %i at offset %i", op, pc);
+		}
+	}
+
+	// never reached
+	emit(BRK(0));
+	} // pass
+
+	if (vm->codeLength != codeSize) {
+		VMFREE_BUFFERS();
+		DIE("code size changed between passes");
+	}
+
+	if (mprotect(vm->codeBase, vm->codeLength, PROT_READ|PROT_EXEC)) {
+		VM_Destroy_Compiled(vm);
+		DIE("mprotect failed");
+	}
+
+	__builtin___clear_cache((char *)vm->codeBase, (char *)vm->codeBase+vm->codeLength);
+
+	vm->destroy = VM_Destroy_Compiled;
+	vm->compiled = qtrue;
+}
+
+int VM_CallCompiled(vm_t *vm, int *args)
+{
+	byte	stack[OPSTACK_SIZE + 15];
+	int	*opStack;
+	int	opStackOfs;
+	int	programStack = vm->programStack;
+	int	stackOnEntry = programStack;
+	byte	*image = vm->dataBase;
+	int	*argPointer;
+	int	retVal;
+
+	currentVM = vm;
+
+	vm->currentlyInterpreting = qtrue;
+
+	programStack -= ( 8 + 4 * MAX_VMMAIN_ARGS );
+	argPointer = (int *)&image[ programStack + 8 ];
+	memcpy( argPointer, args, 4 * MAX_VMMAIN_ARGS );
+	argPointer[-1] = 0;
+	argPointer[-2] = -1;
+
+	opStack = PADP(stack, 16);
+	*opStack = 0xDEADBEEF;
+
+	/* call generated code */
+	{
+		int (*entry)(vm_t*, int*, int*, int*);
+
+		entry = (void *)(vm->codeBase);
+		retVal = entry(vm, &programStack, opStack, &opStackOfs);
+	}
+
+	if(opStackOfs != 0 || *opStack != 0xDEADBEEF)
+	{
+		Com_Error(ERR_DROP, "opStack corrupted in compiled code");
+	}
+
+	if(programStack != stackOnEntry - (8 + 4 * MAX_VMMAIN_ARGS))
+		Com_Error(ERR_DROP, "programStack corrupted in compiled code");
+
+	vm->programStack = stackOnEntry;
+	vm->currentlyInterpreting = qfalse;
+
+	return retVal;
+}
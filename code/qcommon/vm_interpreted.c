@@ -184,6 +184,7 @@ void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header ) {
 	instruction = 0;
 	code = (byte *)header + header->codeOffset;
 	codeBase = (int *)vm->codeBase;
+	vm->threadedCode = qfalse;
 
 	// Copy and expand instructions to words while building instruction table
 	while ( instruction < header->instructionCount ) {
@@ -315,6 +316,81 @@ locals from sp
 
 #define	DEBUGSTR va("%s%i", VM_Indent(vm), opStackOfs)
 
+/*
+With GCC style computed gotos, the first call replaces each opcode in the
+prepared image with the offset of its handler from vm_OP_UNDEF, so every
+handler jumps straight to the next one instead of going back through the
+switch.  The switch stays for other compilers and for DEBUG_VM.
+*/
+#if defined( __GNUC__ ) && !defined( DEBUG_VM ) && !defined( NO_VM_THREADED_CODE )
+#define VM_THREADED_CODE
+#endif
+
+#ifdef VM_THREADED_CODE
+#define VM_CASE( op )	vm_##op
+
+// opcode pairs that VM_ThreadCode runs as one handler, numbered after the opcodes
+enum {
+	OPF_CONST_LOAD4 = 256,
+	OPF_LOCAL_LOAD4,
+	OPF_CONST_CALL,
+
+	OPF_MAX
+};
+
+/*
+====================
+VM_ThreadCode
+
+Converts the opcodes in the prepared image to handler offsets, fusing
+CONST+LOAD4, LOCAL+LOAD4 and CONST+CALL.  The second instruction of a fused
+pair keeps its own handler, so jumps to it still work.
+====================
+*/
+static void VM_ThreadCode( vm_t *vm, void *const *handlers, void *base ) {
+	int		*codeBase;
+	int		instruction;
+	int		int_pc;
+	int		op, next, fused;
+
+	codeBase = (int *)vm->codeBase;
+
+	for ( instruction = 0; instruction < vm->instructionCount; instruction++ ) {
+		int_pc = vm->instructionPointers[ instruction ];
+		op = codeBase[ int_pc ];
+		fused = op;
+
+		// the next opcode hasn't been converted yet
+		if ( instruction + 1 < vm->instructionCount ) {
+			next = codeBase[ vm->instructionPointers[ instruction + 1 ] ];
+
+			if ( op == OP_CONST && next == OP_LOAD4 ) {
+				fused = OPF_CONST_LOAD4;
+			} else if ( op == OP_LOCAL && next == OP_LOAD4 ) {
+				fused = OPF_LOCAL_LOAD4;
+			} else if ( op == OP_CONST && next == OP_CALL ) {
+				// system calls stay negative, bad targets are left to OP_CALL
+				if ( codeBase[ int_pc + 1 ] < 0 ) {
+					fused = OPF_CONST_CALL;
+				} else if ( codeBase[ int_pc + 1 ] < vm->instructionCount ) {
+					codeBase[ int_pc + 1 ] = vm->instructionPointers[ codeBase[ int_pc + 1 ] ];
+					fused = OPF_CONST_CALL;
+				}
+			}
+		}
+
+		if ( (unsigned)fused >= OPF_MAX || !handlers[ fused ] ) {
+			fused = OP_UNDEF;
+		}
+		codeBase[ int_pc ] = (int)( (byte *)handlers[ fused ] - (byte *)base );
+	}
+
+	vm->threadedCode = qtrue;
+}
+#else
+#define VM_CASE( op )	case op
+#endif
+
 int	VM_CallInterpreted( vm_t *vm, int *args ) {
 	byte		stack[OPSTACK_SIZE + 15];
 	int		*opStack;
@@ -347,6 +423,76 @@ int	VM_CallInterpreted( vm_t *vm, int *args ) {
 	image = vm->dataBase;
 	codeImage = (int *)vm->codeBase;
 	dataMask = vm->dataMask;
+
+#ifdef VM_THREADED_CODE
+	if ( !vm->threadedCode ) {
+		static void *const handlers[ OPF_MAX ] = {
+			[ OP_BREAK ] = &&vm_OP_BREAK,
+			[ OP_ENTER ] = &&vm_OP_ENTER,
+			[ OP_LEAVE ] = &&vm_OP_LEAVE,
+			[ OP_CALL ] = &&vm_OP_CALL,
+			[ OP_PUSH ] = &&vm_OP_PUSH,
+			[ OP_POP ] = &&vm_OP_POP,
+			[ OP_CONST ] = &&vm_OP_CONST,
+			[ OP_LOCAL ] = &&vm_OP_LOCAL,
+			[ OP_JUMP ] = &&vm_OP_JUMP,
+			[ OP_EQ ] = &&vm_OP_EQ,
+			[ OP_NE ] = &&vm_OP_NE,
+			[ OP_LTI ] = &&vm_OP_LTI,
+			[ OP_LEI ] = &&vm_OP_LEI,
+			[ OP_GTI ] = &&vm_OP_GTI,
+			[ OP_GEI ] = &&vm_OP_GEI,
+			[ OP_LTU ] = &&vm_OP_LTU,
+			[ OP_LEU ] = &&vm_OP_LEU,
+			[ OP_GTU ] = &&vm_OP_GTU,
+			[ OP_GEU ] = &&vm_OP_GEU,
+			[ OP_EQF ] = &&vm_OP_EQF,
+			[ OP_NEF ] = &&vm_OP_NEF,
+			[ OP_LTF ] = &&vm_OP_LTF,
+			[ OP_LEF ] = &&vm_OP_LEF,
+			[ OP_GTF ] = &&vm_OP_GTF,
+			[ OP_GEF ] = &&vm_OP_GEF,
+			[ OP_LOAD1 ] = &&vm_OP_LOAD1,
+			[ OP_LOAD2 ] = &&vm_OP_LOAD2,
+			[ OP_LOAD4 ] = &&vm_OP_LOAD4,
+			[ OP_STORE1 ] = &&vm_OP_STORE1,
+			[ OP_STORE2 ] = &&vm_OP_STORE2,
+			[ OP_STORE4 ] = &&vm_OP_STORE4,
+			[ OP_ARG ] = &&vm_OP_ARG,
+			[ OP_BLOCK_COPY ] = &&vm_OP_BLOCK_COPY,
+			[ OP_SEX8 ] = &&vm_OP_SEX8,
+			[ OP_SEX16 ] = &&vm_OP_SEX16,
+			[ OP_NEGI ] = &&vm_OP_NEGI,
+			[ OP_ADD ] = &&vm_OP_ADD,
+			[ OP_SUB ] = &&vm_OP_SUB,
+			[ OP_DIVI ] = &&vm_OP_DIVI,
+			[ OP_DIVU ] = &&vm_OP_DIVU,
+			[ OP_MODI ] = &&vm_OP_MODI,
+			[ OP_MODU ] = &&vm_OP_MODU,
+			[ OP_MULI ] = &&vm_OP_MULI,
+			[ OP_MULU ] = &&vm_OP_MULU,
+			[ OP_BAND ] = &&vm_OP_BAND,
+			[ OP_BOR ] = &&vm_OP_BOR,
+			[ OP_BXOR ] = &&vm_OP_BXOR,
+			[ OP_BCOM ] = &&vm_OP_BCOM,
+			[ OP_LSH ] = &&vm_OP_LSH,
+			[ OP_RSHI ] = &&vm_OP_RSHI,
+			[ OP_RSHU ] = &&vm_OP_RSHU,
+			[ OP_NEGF ] = &&vm_OP_NEGF,
+			[ OP_ADDF ] = &&vm_OP_ADDF,
+			[ OP_SUBF ] = &&vm_OP_SUBF,
+			[ OP_DIVF ] = &&vm_OP_DIVF,
+			[ OP_MULF ] = &&vm_OP_MULF,
+			[ OP_CVIF ] = &&vm_OP_CVIF,
+			[ OP_CVFI ] = &&vm_OP_CVFI,
+			[ OPF_CONST_LOAD4 ] = &&vm_OPF_CONST_LOAD4,
+			[ OPF_LOCAL_LOAD4 ] = &&vm_OPF_LOCAL_LOAD4,
+			[ OPF_CONST_CALL ] = &&vm_OPF_CONST_CALL,
+		};
+
+		VM_ThreadCode( vm, handlers, &&vm_OP_UNDEF );
+	}
+#endif
 	
 	programCounter = 0;
 
@@ -374,7 +520,10 @@ int	VM_CallInterpreted( vm_t *vm, int *args ) {
 #define r2 codeImage[programCounter]
 
 	while ( 1 ) {
-		int		opcode,	r0, r1;
+#ifndef VM_THREADED_CODE
+		int		opcode;
+#endif
+		int		r0, r1;
 //		unsigned int	r2;
 
 nextInstruction:
@@ -402,25 +551,57 @@ nextInstruction2:
 		}
 		profileSymbol->profileCount++;
 #endif
+#ifdef VM_THREADED_CODE
+		goto *( (byte *)&&vm_OP_UNDEF + codeImage[ programCounter++ ] );
+
+		// also anything that isn't an opcode, like the switch below
+vm_OP_UNDEF:
+			goto nextInstruction;
+
+vm_OPF_CONST_LOAD4:
+			opStackOfs++;
+			r1 = r0;
+			r0 = opStack[opStackOfs] = *(int *) &image[ r2 & dataMask ];
+
+			programCounter += 2;
+			goto nextInstruction2;
+vm_OPF_LOCAL_LOAD4:
+			opStackOfs++;
+			r1 = r0;
+			r0 = opStack[opStackOfs] = *(int *) &image[ ( r2 + programStack ) & dataMask ];
+
+			programCounter += 2;
+			goto nextInstruction2;
+vm_OPF_CONST_CALL:
+			// r2 is a system call number or the checked target's code offset
+			*(int *)&image[ programStack ] = programCounter + 2;
+
+			programCounter = r2;
+			if ( programCounter < 0 ) {
+				goto systemCall;
+			}
+			goto nextInstruction;
+#else
 		opcode = codeImage[ programCounter++ ];
 
 		switch ( opcode ) {
+#endif
 #ifdef DEBUG_VM
 		default:
 			Com_Error( ERR_DROP, "Bad VM instruction" );  // this should be scanned on load!
 			return 0;
 #endif
-		case OP_BREAK:
+		VM_CASE( OP_BREAK ):
 			vm->breakCount++;
 			goto nextInstruction2;
-		case OP_CONST:
+		VM_CASE( OP_CONST ):
 			opStackOfs++;
 			r1 = r0;
 			r0 = opStack[opStackOfs] = r2;
 			
 			programCounter += 1;
 			goto nextInstruction2;
-		case OP_LOCAL:
+		VM_CASE( OP_LOCAL ):
 			opStackOfs++;
 			r1 = r0;
 			r0 = opStack[opStackOfs] = r2+programStack;
@@ -428,7 +609,7 @@ nextInstruction2:
 			programCounter += 1;
 			goto nextInstruction2;
 
-		case OP_LOAD4:
+		VM_CASE( OP_LOAD4 ):
 #ifdef DEBUG_VM
 			if(opStack[opStackOfs] & 3)
 			{
@@ -438,40 +619,40 @@ nextInstruction2:
 #endif
 			r0 = opStack[opStackOfs] = *(int *) &image[ r0 & dataMask ];
 			goto nextInstruction2;
-		case OP_LOAD2:
+		VM_CASE( OP_LOAD2 ):
 			r0 = opStack[opStackOfs] = *(unsigned short *)&image[ r0 & dataMask ];
 			goto nextInstruction2;
-		case OP_LOAD1:
+		VM_CASE( OP_LOAD1 ):
 			r0 = opStack[opStackOfs] = image[ r0 & dataMask ];
 			goto nextInstruction2;
 
-		case OP_STORE4:
+		VM_CASE( OP_STORE4 ):
 			*(int *)&image[ r1 & dataMask ] = r0;
 			opStackOfs -= 2;
 			goto nextInstruction;
-		case OP_STORE2:
+		VM_CASE( OP_STORE2 ):
 			*(short *)&image[ r1 & dataMask ] = r0;
 			opStackOfs -= 2;
 			goto nextInstruction;
-		case OP_STORE1:
+		VM_CASE( OP_STORE1 ):
 			image[ r1 & dataMask ] = r0;
 			opStackOfs -= 2;
 			goto nextInstruction;
 
-		case OP_ARG:
+		VM_CASE( OP_ARG ):
 			// single byte offset from programStack
 			*(int *)&image[ (codeImage[programCounter] + programStack) & dataMask ] = r0;
 			opStackOfs--;
 			programCounter += 1;
 			goto nextInstruction;
 
-		case OP_BLOCK_COPY:
+		VM_CASE( OP_BLOCK_COPY ):
 			VM_BlockCopy(r1, r0, r2);
 			programCounter += 1;
 			opStackOfs -= 2;
 			goto nextInstruction;
 
-		case OP_CALL:
+		VM_CASE( OP_CALL ):
 			// save current program counter
 			*(int *)&image[ programStack ] = programCounter;
 			
@@ -481,6 +662,9 @@ nextInstruction2:
 			if ( programCounter < 0 ) {
 				// system call
 				int		r;
+#ifdef VM_THREADED_CODE
+systemCall:
+#endif
 //				int		temp;
 #ifdef DEBUG_VM
 				int		stomped;
@@ -540,14 +724,14 @@ nextInstruction2:
 			goto nextInstruction;
 
 		// push and pop are only needed for discarded or bad function return values
-		case OP_PUSH:
+		VM_CASE( OP_PUSH ):
 			opStackOfs++;
 			goto nextInstruction;
-		case OP_POP:
+		VM_CASE( OP_POP ):
 			opStackOfs--;
 			goto nextInstruction;
 
-		case OP_ENTER:
+		VM_CASE( OP_ENTER ):
 #ifdef DEBUG_VM
 			profileSymbol = VM_ValueToFunctionSymbol( vm, programCounter );
 #endif
@@ -571,7 +755,7 @@ nextInstruction2:
 			}
 #endif
 			goto nextInstruction;
-		case OP_LEAVE:
+		VM_CASE( OP_LEAVE ):
 			// remove our stack frame
 			v1 = r2;
 
@@ -601,7 +785,7 @@ nextInstruction2:
 		===================================================================
 		*/
 
-		case OP_JUMP:
+		VM_CASE( OP_JUMP ):
 			if ( (unsigned)r0 >= vm->instructionCount )
 			{
 				Com_Error( ERR_DROP, "VM program counter out of range in OP_JUMP" );
@@ -613,7 +797,7 @@ nextInstruction2:
 			opStackOfs--;
 			goto nextInstruction;
 
-		case OP_EQ:
+		VM_CASE( OP_EQ ):
 			opStackOfs -= 2;
 			if ( r1 == r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -623,7 +807,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_NE:
+		VM_CASE( OP_NE ):
 			opStackOfs -= 2;
 			if ( r1 != r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -633,7 +817,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LTI:
+		VM_CASE( OP_LTI ):
 			opStackOfs -= 2;
 			if ( r1 < r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -643,7 +827,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LEI:
+		VM_CASE( OP_LEI ):
 			opStackOfs -= 2;
 			if ( r1 <= r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -653,7 +837,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GTI:
+		VM_CASE( OP_GTI ):
 			opStackOfs -= 2;
 			if ( r1 > r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -663,7 +847,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GEI:
+		VM_CASE( OP_GEI ):
 			opStackOfs -= 2;
 			if ( r1 >= r0 ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -673,7 +857,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LTU:
+		VM_CASE( OP_LTU ):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) < ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -683,7 +867,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LEU:
+		VM_CASE( OP_LEU ):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) <= ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -693,7 +877,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GTU:
+		VM_CASE( OP_GTU ):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) > ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -703,7 +887,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GEU:
+		VM_CASE( OP_GEU ):
 			opStackOfs -= 2;
 			if ( ((unsigned)r1) >= ((unsigned)r0) ) {
 				programCounter = r2;	//vm->instructionPointers[r2];
@@ -713,7 +897,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_EQF:
+		VM_CASE( OP_EQF ):
 			opStackOfs -= 2;
 			
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] == ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
@@ -725,7 +909,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_NEF:
+		VM_CASE( OP_NEF ):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] != ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
@@ -737,7 +921,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LTF:
+		VM_CASE( OP_LTF ):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] < ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
@@ -749,7 +933,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_LEF:
+		VM_CASE( OP_LEF ):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) ((uint8_t) (opStackOfs + 1))] <= ((float *) opStack)[(uint8_t) ((uint8_t) (opStackOfs + 2))])
@@ -761,7 +945,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GTF:
+		VM_CASE( OP_GTF ):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] > ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
@@ -773,7 +957,7 @@ nextInstruction2:
 				goto nextInstruction;
 			}
 
-		case OP_GEF:
+		VM_CASE( OP_GEF ):
 			opStackOfs -= 2;
 
 			if(((float *) opStack)[(uint8_t) (opStackOfs + 1)] >= ((float *) opStack)[(uint8_t) (opStackOfs + 2)])
@@ -788,104 +972,106 @@ nextInstruction2:
 
 		//===================================================================
 
-		case OP_NEGI:
+		VM_CASE( OP_NEGI ):
 			opStack[opStackOfs] = -r0;
 			goto nextInstruction;
-		case OP_ADD:
+		VM_CASE( OP_ADD ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 + r0;
 			goto nextInstruction;
-		case OP_SUB:
+		VM_CASE( OP_SUB ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 - r0;
 			goto nextInstruction;
-		case OP_DIVI:
+		VM_CASE( OP_DIVI ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 / r0;
 			goto nextInstruction;
-		case OP_DIVU:
+		VM_CASE( OP_DIVU ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) / ((unsigned) r0);
 			goto nextInstruction;
-		case OP_MODI:
+		VM_CASE( OP_MODI ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 % r0;
 			goto nextInstruction;
-		case OP_MODU:
+		VM_CASE( OP_MODU ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) % ((unsigned) r0);
 			goto nextInstruction;
-		case OP_MULI:
+		VM_CASE( OP_MULI ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 * r0;
 			goto nextInstruction;
-		case OP_MULU:
+		VM_CASE( OP_MULU ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) * ((unsigned) r0);
 			goto nextInstruction;
 
-		case OP_BAND:
+		VM_CASE( OP_BAND ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) & ((unsigned) r0);
 			goto nextInstruction;
-		case OP_BOR:
+		VM_CASE( OP_BOR ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) | ((unsigned) r0);
 			goto nextInstruction;
-		case OP_BXOR:
+		VM_CASE( OP_BXOR ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) ^ ((unsigned) r0);
 			goto nextInstruction;
-		case OP_BCOM:
+		VM_CASE( OP_BCOM ):
 			opStack[opStackOfs] = ~((unsigned) r0);
 			goto nextInstruction;
 
-		case OP_LSH:
+		VM_CASE( OP_LSH ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 << r0;
 			goto nextInstruction;
-		case OP_RSHI:
+		VM_CASE( OP_RSHI ):
 			opStackOfs--;
 			opStack[opStackOfs] = r1 >> r0;
 			goto nextInstruction;
-		case OP_RSHU:
+		VM_CASE( OP_RSHU ):
 			opStackOfs--;
 			opStack[opStackOfs] = ((unsigned) r1) >> r0;
 			goto nextInstruction;
 
-		case OP_NEGF:
+		VM_CASE( OP_NEGF ):
 			((float *) opStack)[opStackOfs] =  -((float *) opStack)[opStackOfs];
 			goto nextInstruction;
-		case OP_ADDF:
+		VM_CASE( OP_ADDF ):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] + ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
 			goto nextInstruction;
-		case OP_SUBF:
+		VM_CASE( OP_SUBF ):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] - ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
 			goto nextInstruction;
-		case OP_DIVF:
+		VM_CASE( OP_DIVF ):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] / ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
 			goto nextInstruction;
-		case OP_MULF:
+		VM_CASE( OP_MULF ):
 			opStackOfs--;
 			((float *) opStack)[opStackOfs] = ((float *) opStack)[opStackOfs] * ((float *) opStack)[(uint8_t) (opStackOfs + 1)];
 			goto nextInstruction;
 
-		case OP_CVIF:
+		VM_CASE( OP_CVIF ):
 			((float *) opStack)[opStackOfs] = (float) opStack[opStackOfs];
 			goto nextInstruction;
-		case OP_CVFI:
+		VM_CASE( OP_CVFI ):
 			opStack[opStackOfs] = Q_ftol(((float *) opStack)[opStackOfs]);
 			goto nextInstruction;
-		case OP_SEX8:
+		VM_CASE( OP_SEX8 ):
 			opStack[opStackOfs] = (signed char) opStack[opStackOfs];
 			goto nextInstruction;
-		case OP_SEX16:
+		VM_CASE( OP_SEX16 ):
 			opStack[opStackOfs] = (short) opStack[opStackOfs];
 			goto nextInstruction;
+#ifndef VM_THREADED_CODE
 		}
+#endif
 	}
 
 done:
@@ -159,6 +159,7 @@ struct vm_s {
 
 	// for interpreted modules
 	qboolean	currentlyInterpreting;
+	qboolean	threadedCode;		// codeBase holds handler offsets, see VM_ThreadCode
 
 	qboolean	compiled;
 	byte		*codeBase;
@@ -188,8 +189,13 @@ struct vm_s {
 
 extern	vm_t	*currentVM;
 extern	int		vm_debugLevel;
+extern	cvar_t	*vm_compileCache;
 
 void VM_Compile( vm_t *vm, vmHeader_t *header );
+
+// for bytecode compilers that keep their output on disk, see vm.c
+byte *VM_ReadCompileCache( vm_t *vm, vmHeader_t *header, const char *compiler, byte **payload, int *payloadLength );
+void VM_WriteCompileCache( vm_t *vm, vmHeader_t *header, const char *compiler, const byte *payload, int payloadLength );
 int	VM_CallCompiled( vm_t *vm, int *args );
 
 void VM_PrepareInterpreter( vm_t *vm, vmHeader_t *header );
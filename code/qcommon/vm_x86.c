@@ -43,6 +43,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #endif
 
 static void VM_Destroy_Compiled(vm_t* self);
+static void AddReloc(void *ptr);
+static void FreeRelocs(void);
 
 /*
 
@@ -58,7 +60,7 @@ x86_64:
 
 */
 
-#define VMFREE_BUFFERS() do {Z_Free(buf); Z_Free(jused);} while(0)
+#define VMFREE_BUFFERS() do {Z_Free(buf); Z_Free(jused); FreeRelocs();} while(0)
 static	byte	*buf = NULL;
 static	byte	*jused = NULL;
 static	int		jusedSize = 0;
@@ -149,6 +151,7 @@ static void EmitPtr(void *ptr)
 {
 	intptr_t v = (intptr_t) ptr;
 	
+	AddReloc(ptr);
 	Emit4(v);
 #if idx64
 	Emit1((v >> 32) & 0xFF);
@@ -460,6 +463,152 @@ static void DoSyscall(void)
 	currentVM = savedVM;
 }
 
+/*
+=================
+Relocations
+
+Every absolute address in the generated code is recorded, so the code can
+be saved to the compile cache and moved into another process.  Records
+are only kept for the final pass.
+=================
+*/
+
+// bump this with any change to the generated code or the relocations, so
+// cache files written by older builds are ignored; rebuilding the same
+// source keeps the cache valid
+#define VM_COMPILER_VERSION	1
+
+#define VM_COMPILER		"x86 " ARCH_STRING " " XSTRING( VM_COMPILER_VERSION )
+
+typedef enum
+{
+	RELOC_SYMBOL,			// value is an index for RelocSymbol()
+	RELOC_DATA,				// value is an offset from vm->dataBase
+	RELOC_INSTRUCTIONS		// vm->instructionPointers
+} relocType_t;
+
+#define	NUM_RELOC_SYMBOLS	7
+
+typedef struct
+{
+	int		offset;
+	int		type;
+	int		value;
+} vmReloc_t;
+
+static	vm_t		*relocVM;
+static	vmReloc_t	*relocs;
+static	int			numRelocs, maxRelocs;
+static	qboolean	relocsFailed;
+
+static void *RelocSymbol(int index)
+{
+	switch(index)
+	{
+	case 0: return (void *) DoSyscall;
+	case 1: return &vm_syscallNum;
+	case 2: return &vm_programStack;
+	case 3: return &vm_opStackOfs;
+	case 4: return &vm_opStackBase;
+	case 5: return &vm_arg;
+	case 6: return (void *) Q_VMftol;
+	}
+	return NULL;
+}
+
+static void *RelocTarget(vm_t *vm, const vmReloc_t *reloc)
+{
+	switch(reloc->type)
+	{
+	case RELOC_SYMBOL:
+		return RelocSymbol(reloc->value);
+	case RELOC_DATA:
+		return vm->dataBase + reloc->value;
+	case RELOC_INSTRUCTIONS:
+		return vm->instructionPointers;
+	}
+	return NULL;
+}
+
+/*
+=================
+AddReloc
+Record the address EmitPtr is about to write at compiledOfs
+=================
+*/
+
+static void AddReloc(void *ptr)
+{
+	vmReloc_t *reloc;
+	int i;
+
+	if(!relocVM)
+		return;
+
+	// drop records of code that has been taken back
+	while(numRelocs && relocs[numRelocs - 1].offset >= compiledOfs)
+		numRelocs--;
+
+	if(numRelocs == maxRelocs)
+	{
+		vmReloc_t *old = relocs;
+
+		maxRelocs = maxRelocs ? maxRelocs * 2 : 256;
+		relocs = Z_Malloc(maxRelocs * sizeof(*relocs));
+		if(old)
+		{
+			Com_Memcpy(relocs, old, numRelocs * sizeof(*relocs));
+			Z_Free(old);
+		}
+	}
+
+	reloc = &relocs[numRelocs++];
+	reloc->offset = compiledOfs;
+
+	for(i = 0; i < NUM_RELOC_SYMBOLS; i++)
+	{
+		if(ptr == RelocSymbol(i))
+		{
+			reloc->type = RELOC_SYMBOL;
+			reloc->value = i;
+			return;
+		}
+	}
+
+	if((byte *) ptr >= relocVM->dataBase && (byte *) ptr <= relocVM->dataBase + relocVM->dataAlloc)
+	{
+		reloc->type = RELOC_DATA;
+		reloc->value = (byte *) ptr - relocVM->dataBase;
+	}
+	else if(ptr == relocVM->instructionPointers)
+	{
+		reloc->type = RELOC_INSTRUCTIONS;
+		reloc->value = 0;
+	}
+	else
+	{
+		// can't be moved, so don't cache this compile
+		relocsFailed = qtrue;
+		numRelocs--;
+	}
+}
+
+/*
+=================
+FreeRelocs
+=================
+*/
+
+static void FreeRelocs(void)
+{
+	if(relocs)
+		Z_Free(relocs);
+
+	relocs = NULL;
+	numRelocs = maxRelocs = 0;
+	relocVM = NULL;
+}
+
 /*
 =================
 EmitCallRel
@@ -591,7 +740,7 @@ int EmitCallProcedure(vm_t *vm, int sysCallOfs)
 	EmitRexString(0x49, "FF 14 C0");	// call qword ptr [r8 + eax * 8]
 #else
 	EmitString("FF 14 85");			// call dword ptr [vm->instructionPointers + eax * 4]
-	Emit4((intptr_t) vm->instructionPointers);
+	EmitPtr(vm->instructionPointers);
 #endif
 	EmitString("8B 04 9F");			// mov eax, dword ptr [edi + ebx * 4]
 	EmitString("C3");			// ret
@@ -796,7 +945,7 @@ qboolean ConstOptimize(vm_t *vm, int callProcOfsSyscall)
 		Emit4(Constant4());
 #else
 		EmitString("C7 80");				// mov dword ptr [eax + 0x12345678], 0x12345678
-		Emit4((intptr_t) vm->dataBase);
+		EmitPtr(vm->dataBase);
 		Emit4(Constant4());
 #endif
 		EmitCommand(LAST_COMMAND_SUB_BL_1);		// sub bl, 1
@@ -812,7 +961,7 @@ qboolean ConstOptimize(vm_t *vm, int callProcOfsSyscall)
 		Emit2(Constant4());
 #else
 		EmitString("66 C7 80");				// mov word ptr [eax + 0x12345678], 0x1234
-		Emit4((intptr_t) vm->dataBase);
+		EmitPtr(vm->dataBase);
 		Emit2(Constant4());
 #endif
 		EmitCommand(LAST_COMMAND_SUB_BL_1);		// sub bl, 1
@@ -828,7 +977,7 @@ qboolean ConstOptimize(vm_t *vm, int callProcOfsSyscall)
 		Emit1(Constant4());
 #else
 		EmitString("C6 80");				// mov byte ptr [eax + 0x12345678], 0x12
-		Emit4((intptr_t) vm->dataBase);
+		EmitPtr(vm->dataBase);
 		Emit1(Constant4());
 #endif
 		EmitCommand(LAST_COMMAND_SUB_BL_1);		// sub bl, 1
@@ -1062,6 +1211,173 @@ qboolean ConstOptimize(vm_t *vm, int callProcOfsSyscall)
 	return qfalse;
 }
 
+/*
+=================
+VM_InstallCode
+
+Copy generated code to an exact sized buffer with the appropriate permission bits
+=================
+*/
+static void VM_InstallCode(vm_t *vm, const byte *src, int length)
+{
+	vm->codeLength = length;
+#ifdef VM_X86_MMAP
+	vm->codeBase = mmap(NULL, length, PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
+	if(vm->codeBase == MAP_FAILED)
+		Com_Error(ERR_FATAL, "VM_CompileX86: can't mmap memory");
+#elif _WIN32
+	// allocate memory with EXECUTE permissions under windows.
+	vm->codeBase = VirtualAlloc(NULL, length, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
+	if(!vm->codeBase)
+		Com_Error(ERR_FATAL, "VM_CompileX86: VirtualAlloc failed");
+#else
+	vm->codeBase = malloc(length);
+	if(!vm->codeBase)
+	        Com_Error(ERR_FATAL, "VM_CompileX86: malloc failed");
+#endif
+
+	Com_Memcpy( vm->codeBase, src, length );
+
+#ifdef VM_X86_MMAP
+	if(mprotect(vm->codeBase, length, PROT_READ|PROT_EXEC))
+		Com_Error(ERR_FATAL, "VM_CompileX86: mprotect failed");
+#elif _WIN32
+	{
+		DWORD oldProtect = 0;
+		
+		// remove write permissions.
+		if(!VirtualProtect(vm->codeBase, length, PAGE_EXECUTE_READ, &oldProtect))
+			Com_Error(ERR_FATAL, "VM_CompileX86: VirtualProtect failed");
+	}
+#endif
+}
+
+/*
+=================
+VM_SaveCompiled
+
+Save the code just generated in buf, with its relocations, to the compile
+cache.  The payload is the code length, entry offset and relocation count,
+then the instruction offsets, the relocations and the code.
+=================
+*/
+static void VM_SaveCompiled(vm_t *vm, vmHeader_t *header)
+{
+	byte *payload;
+	int *ints;
+	int size, i;
+	void *target;
+
+	// every relocation must still match the bytes it describes
+	for(i = 0; i < numRelocs; i++)
+	{
+		target = RelocTarget(vm, &relocs[i]);
+		if(relocs[i].offset + sizeof(target) > compiledOfs
+			|| memcmp(buf + relocs[i].offset, &target, sizeof(target)))
+		{
+			Com_DPrintf("VM_CompileX86: relocation mismatch, not caching %s\n", vm->name);
+			return;
+		}
+	}
+
+	size = 3 * sizeof(int) + header->instructionCount * sizeof(int) + numRelocs * sizeof(vmReloc_t) + compiledOfs;
+	payload = Z_Malloc(size);
+
+	ints = (int *) payload;
+	ints[0] = compiledOfs;
+	ints[1] = vm->entryOfs;
+	ints[2] = numRelocs;
+	ints += 3;
+	for(i = 0; i < header->instructionCount; i++)
+		ints[i] = vm->instructionPointers[i];
+	ints += header->instructionCount;
+
+	Com_Memcpy(ints, relocs, numRelocs * sizeof(vmReloc_t));
+	Com_Memcpy((byte *) ints + numRelocs * sizeof(vmReloc_t), buf, compiledOfs);
+
+	VM_WriteCompileCache(vm, header, VM_COMPILER, payload, size);
+	Z_Free(payload);
+}
+
+/*
+=================
+VM_LoadCompiled
+
+Map in the code VM_SaveCompiled stored for this qvm, if there is any
+=================
+*/
+static qboolean VM_LoadCompiled(vm_t *vm, vmHeader_t *header)
+{
+	byte *cache, *payload, *image;
+	int length, imageLength, entryOfs, count, i;
+	int *offsets;
+	vmReloc_t *reloc;
+	void *target;
+
+	cache = VM_ReadCompileCache(vm, header, VM_COMPILER, &payload, &length);
+	if(!cache)
+		return qfalse;
+
+	if(length < 3 * sizeof(int))
+		goto broken;
+
+	imageLength = ((int *) payload)[0];
+	entryOfs = ((int *) payload)[1];
+	count = ((int *) payload)[2];
+	if(imageLength <= 0 || entryOfs < 0 || entryOfs >= imageLength || count < 0 || count > imageLength
+		|| length != 3 * sizeof(int) + header->instructionCount * sizeof(int) + count * sizeof(vmReloc_t) + imageLength)
+		goto broken;
+
+	offsets = (int *) payload + 3;
+	reloc = (vmReloc_t *) (offsets + header->instructionCount);
+	image = (byte *) (reloc + count);
+
+	for(i = 0; i < header->instructionCount; i++)
+	{
+		if(offsets[i] < 0 || offsets[i] >= imageLength)
+			goto broken;
+	}
+
+	// point the absolute addresses at this process
+	for(i = 0; i < count; i++, reloc++)
+	{
+		if(reloc->offset < 0 || reloc->offset > imageLength - (int) sizeof(target))
+			goto broken;
+
+		if(reloc->type == RELOC_SYMBOL)
+		{
+			if(reloc->value < 0 || reloc->value >= NUM_RELOC_SYMBOLS)
+				goto broken;
+		}
+		else if(reloc->type == RELOC_DATA)
+		{
+			if(reloc->value < 0 || reloc->value > vm->dataAlloc)
+				goto broken;
+		}
+		else if(reloc->type != RELOC_INSTRUCTIONS)
+			goto broken;
+
+		target = RelocTarget(vm, reloc);
+		Com_Memcpy(image + reloc->offset, &target, sizeof(target));
+	}
+
+	VM_InstallCode(vm, image, imageLength);
+	vm->entryOfs = entryOfs;
+	for(i = 0; i < header->instructionCount; i++)
+		vm->instructionPointers[i] = offsets[i] + (intptr_t) vm->codeBase;
+
+	Z_Free(cache);
+	Com_Printf("VM file %s loaded %i bytes of code from the compile cache\n", vm->name, imageLength);
+
+	vm->destroy = VM_Destroy_Compiled;
+	return qtrue;
+
+broken:
+	Com_DPrintf("Ignoring broken compile cache for %s\n", vm->name);
+	Z_Free(cache);
+	return qfalse;
+}
+
 /*
 =================
 VM_Compile
@@ -1074,6 +1390,10 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 	int		v;
 	int		i;
         int		callProcOfsSyscall, callProcOfs, callDoSyscallOfs;
+	int		prologueRelocs;
+
+	if(vm_compileCache->integer && VM_LoadCompiled(vm, header))
+		return;
 
 	jusedSize = header->instructionCount + 2;
 
@@ -1099,6 +1419,11 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 		JUSED( *(int *)(vm->jumpTableTargets + ( i * sizeof( int ) ) ) );
 	}
 
+	// only keep track of the absolute addresses if the code is going to be cached
+	relocVM = vm_compileCache->integer ? vm : NULL;
+	relocsFailed = qfalse;
+	numRelocs = 0;
+
 	// Start buffer with x86-VM specific procedures
 	compiledOfs = 0;
 
@@ -1106,8 +1431,10 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 	callProcOfs = EmitCallDoSyscall(vm);
 	callProcOfsSyscall = EmitCallProcedure(vm, callDoSyscallOfs);
 	vm->entryOfs = compiledOfs;
+	prologueRelocs = numRelocs;
 
 	for(pass=0; pass < 3; pass++) {
+	numRelocs = prologueRelocs;
 	oc0 = -23423;
 	oc1 = -234354;
 	pop0 = -43435;
@@ -1187,7 +1514,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "89 04 11");		// mov dword ptr [r9 + edx], eax
 #else
 			EmitString("89 82");				// mov dword ptr [edx + 0x12345678], eax
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_SUB_BL_1);		// sub bl, 1
 			break;
@@ -1225,7 +1552,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 					EmitRexString(0x41, "FF 04 11");	// inc dword ptr [r9 + edx]
 #else
 					EmitString("FF 82");			// inc dword ptr [edx + 0x12345678]
-					Emit4((intptr_t) vm->dataBase);
+					EmitPtr(vm->dataBase);
 #endif
 				}
 				else
@@ -1234,7 +1561,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 					EmitRexString(0x41, "8B 04 11");	// mov eax, dword ptr [r9 + edx]
 #else
 					EmitString("8B 82");			// mov eax, dword ptr [edx + 0x12345678]
-					Emit4((intptr_t) vm->dataBase);
+					EmitPtr(vm->dataBase);
 #endif
 					EmitString("05");			// add eax, v
 					Emit4(v);
@@ -1245,7 +1572,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 						EmitRexString(0x41, "89 04 11");	// mov dword ptr [r9 + edx], eax
 #else
 						EmitString("89 82");			// mov dword ptr [edx + 0x12345678], eax
-						Emit4((intptr_t) vm->dataBase);
+						EmitPtr(vm->dataBase);
 #endif
 					}
 					else
@@ -1257,7 +1584,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 						EmitRexString(0x41, "89 04 11");	// mov dword ptr [r9 + edx], eax
 #else
 						EmitString("89 82");			// mov dword ptr [edx + 0x12345678], eax
-						Emit4((intptr_t) vm->dataBase);
+						EmitPtr(vm->dataBase);
 #endif
 					}
 				}
@@ -1287,7 +1614,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 					EmitRexString(0x41, "FF 0C 11");	// dec dword ptr [r9 + edx]
 #else
 					EmitString("FF 8A");			// dec dword ptr [edx + 0x12345678]
-					Emit4((intptr_t) vm->dataBase);
+					EmitPtr(vm->dataBase);
 #endif
 				}
 				else
@@ -1296,7 +1623,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 					EmitRexString(0x41, "8B 04 11");	// mov eax, dword ptr [r9 + edx]
 #else
 					EmitString("8B 82");			// mov eax, dword ptr [edx + 0x12345678]
-					Emit4((intptr_t) vm->dataBase);
+					EmitPtr(vm->dataBase);
 #endif
 					EmitString("2D");			// sub eax, v
 					Emit4(v);
@@ -1307,7 +1634,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 						EmitRexString(0x41, "89 04 11");	// mov dword ptr [r9 + edx], eax
 #else
 						EmitString("89 82");			// mov dword ptr [edx + 0x12345678], eax
-						Emit4((intptr_t) vm->dataBase);
+						EmitPtr(vm->dataBase);
 #endif
 					}
 					else
@@ -1319,7 +1646,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 						EmitRexString(0x41, "89 04 11");	// mov dword ptr [r9 + edx], eax
 #else
 						EmitString("89 82");			// mov dword ptr [edx + 0x12345678], eax
-						Emit4((intptr_t) vm->dataBase);
+						EmitPtr(vm->dataBase);
 #endif
 					}
 				}
@@ -1339,7 +1666,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 				EmitRexString(0x41, "8B 04 01");		// mov eax, dword ptr [r9 + eax]
 #else
 				EmitString("8B 80");				// mov eax, dword ptr [eax + 0x1234567]
-				Emit4((intptr_t) vm->dataBase);
+				EmitPtr(vm->dataBase);
 #endif
 				EmitCommand(LAST_COMMAND_MOV_STACK_EAX);	// mov dword ptr [edi + ebx * 4], eax
 				break;
@@ -1350,7 +1677,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "8B 04 01");		// mov eax, dword ptr [r9 + eax]
 #else
 			EmitString("8B 80");				// mov eax, dword ptr [eax + 0x12345678]
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_MOV_STACK_EAX);	// mov dword ptr [edi + ebx * 4], eax
 			break;
@@ -1360,7 +1687,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "0F B7 04 01");		// movzx eax, word ptr [r9 + eax]
 #else
 			EmitString("0F B7 80");				// movzx eax, word ptr [eax + 0x12345678]
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_MOV_STACK_EAX);	// mov dword ptr [edi + ebx * 4], eax
 			break;
@@ -1370,7 +1697,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "0F B6 04 01");		// movzx eax, byte ptr [r9 + eax]
 #else
 			EmitString("0F B6 80");				// movzx eax, byte ptr [eax + 0x12345678]
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_MOV_STACK_EAX);	// mov dword ptr [edi + ebx * 4], eax
 			break;
@@ -1382,7 +1709,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "89 04 11");		// mov dword ptr [r9 + edx], eax
 #else
 			EmitString("89 82");				// mov dword ptr [edx + 0x12345678], eax
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_SUB_BL_2);		// sub bl, 2
 			break;
@@ -1395,7 +1722,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "89 04 11");
 #else
 			EmitString("66 89 82");				// mov word ptr [edx + 0x12345678], eax
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_SUB_BL_2);		// sub bl, 2
 			break;
@@ -1407,7 +1734,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 			EmitRexString(0x41, "88 04 11");		// mov byte ptr [r9 + edx], eax
 #else
 			EmitString("88 82");				// mov byte ptr [edx + 0x12345678], eax
-			Emit4((intptr_t) vm->dataBase);
+			EmitPtr(vm->dataBase);
 #endif
 			EmitCommand(LAST_COMMAND_SUB_BL_2);		// sub bl, 2
 			break;
@@ -1632,7 +1959,7 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 #else
 			EmitString("73 07");			// jae +7
 			EmitString("FF 24 85");			// jmp dword ptr [instructionPointers + eax * 4]
-			Emit4((intptr_t) vm->instructionPointers);
+			EmitPtr(vm->instructionPointers);
 #endif
 			EmitCallErrJump(vm, callDoSyscallOfs);
 			break;
@@ -1645,41 +1972,15 @@ void VM_Compile(vm_t *vm, vmHeader_t *header)
 	}
 	}
 
-	// copy to an exact sized buffer with the appropriate permission bits
-	vm->codeLength = compiledOfs;
-#ifdef VM_X86_MMAP
-	vm->codeBase = mmap(NULL, compiledOfs, PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0);
-	if(vm->codeBase == MAP_FAILED)
-		Com_Error(ERR_FATAL, "VM_CompileX86: can't mmap memory");
-#elif _WIN32
-	// allocate memory with EXECUTE permissions under windows.
-	vm->codeBase = VirtualAlloc(NULL, compiledOfs, MEM_COMMIT, PAGE_EXECUTE_READWRITE);
-	if(!vm->codeBase)
-		Com_Error(ERR_FATAL, "VM_CompileX86: VirtualAlloc failed");
-#else
-	vm->codeBase = malloc(compiledOfs);
-	if(!vm->codeBase)
-	        Com_Error(ERR_FATAL, "VM_CompileX86: malloc failed");
-#endif
-
-	Com_Memcpy( vm->codeBase, buf, compiledOfs );
+	VM_InstallCode(vm, buf, compiledOfs);
 
-#ifdef VM_X86_MMAP
-	if(mprotect(vm->codeBase, compiledOfs, PROT_READ|PROT_EXEC))
-		Com_Error(ERR_FATAL, "VM_CompileX86: mprotect failed");
-#elif _WIN32
-	{
-		DWORD oldProtect = 0;
-		
-		// remove write permissions.
-		if(!VirtualProtect(vm->codeBase, compiledOfs, PAGE_EXECUTE_READ, &oldProtect))
-			Com_Error(ERR_FATAL, "VM_CompileX86: VirtualProtect failed");
-	}
-#endif
+	if(relocVM && !relocsFailed)
+		VM_SaveCompiled(vm, header);
 
 	Z_Free( code );
 	Z_Free( buf );
 	Z_Free( jused );
+	FreeRelocs();
 	Com_Printf( "VM file %s compiled to %i bytes of code\n", vm->name, compiledOfs );
 
 	vm->destroy = VM_Destroy_Compiled;
@@ -66,6 +66,11 @@ int SV_BotAllocateClient(void) {
 	cl->netchan.remoteAddress.type = NA_BOT;
 	cl->rate = 16384;
 
+	// drop client commands a bot that used the slot before may have left queued
+	if ( botlib_export ) {
+		botlib_export->ea.EA_ClearCommands( i );
+	}
+
 	return i;
 }
 
@@ -86,6 +91,10 @@ void SV_BotFreeClient( int clientNum ) {
 	if ( cl->gentity ) {
 		cl->gentity->r.svFlags &= ~SVF_BOT;
 	}
+
+	if ( botlib_export ) {
+		botlib_export->ea.EA_ClearCommands( clientNum );
+	}
 }
 
 /*
@@ -454,6 +463,9 @@ int SV_BotLibSetup( void ) {
 	}
 
 	botlib_export->BotLibVarSet( "basegame", com_basegame->string );
+	botlib_export->BotLibVarSet( "max_routingcache", Cvar_VariableString( "bot_maxroutingcache" ) );
+	botlib_export->BotLibVarSet( "max_routetable", Cvar_VariableString( "bot_maxroutetable" ) );
+	botlib_export->BotLibVarSet( "compiledscripts", Cvar_VariableString( "bot_compiledscripts" ) );
 
 	return botlib_export->BotLibSetup();
 }
@@ -494,8 +506,12 @@ void SV_BotInitCvars(void) {
 	Cvar_Get("bot_forcewrite", "0", 0);					//force writing aas file
 	Cvar_Get("bot_aasoptimize", "0", 0);				//no aas file optimisation
 	Cvar_Get("bot_saveroutingcache", "0", 0);			//save routing cache
+	Cvar_Get("bot_saveroutetable", "0", 0);				//calculate and save route tables
+	Cvar_Get("bot_maxroutingcache", "4096", 0);			//routing cache budget in KB
+	Cvar_Get("bot_maxroutetable", "32768", 0);			//largest route table file in KB
 	Cvar_Get("bot_thinktime", "100", CVAR_CHEAT);		//msec the bots thinks
 	Cvar_Get("bot_reloadcharacters", "0", 0);			//reload the bot characters each time
+	Cvar_Get("bot_compiledscripts", "1", 0);			//load and save compiled bot script files
 	Cvar_Get("bot_testichat", "0", 0);					//test ichats
 	Cvar_Get("bot_testrchat", "0", 0);					//test rchats
 	Cvar_Get("bot_testsolid", "0", CVAR_CHEAT);			//test for solid areas
@@ -1677,6 +1677,7 @@ static void SV_UserMove( client_t *cl, msg_t *msg, qboolean delta ) {
 	usercmd_t	nullcmd;
 	usercmd_t	cmds[MAX_PACKET_USERCMDS];
 	usercmd_t	*cmd, *oldcmd;
+	clientSnapshot_t	*frame;
 
 	if ( delta ) {
 		cl->deltaMessage = cl->messageAcknowledge;
@@ -1711,8 +1712,13 @@ static void SV_UserMove( client_t *cl, msg_t *msg, qboolean delta ) {
 		oldcmd = cmd;
 	}
 
-	// save time for ping calculation
-	cl->frames[ cl->messageAcknowledge & PACKET_MASK ].messageAcked = svs.time;
+	// save time for ping calculation, going by when the packet arrived
+	// in case a long frame kept it waiting
+	frame = &cl->frames[ cl->messageAcknowledge & PACKET_MASK ];
+	frame->messageAcked = svs.time - ( Sys_Milliseconds() - com_packetTime );
+	if ( frame->messageAcked < frame->messageSent ) {
+		frame->messageAcked = frame->messageSent;
+	}
 
 	// TTimo
 	// catch the no-cp-yet situation before SV_ClientEnterWorld
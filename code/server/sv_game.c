@@ -365,6 +365,11 @@ intptr_t SV_GameSystemCalls( intptr_t *args ) {
 	case G_TRACECAPSULE:
 		SV_Trace( VMA(1), VMA(2), VMA(3), VMA(4), VMA(5), args[6], args[7], /*int capsule*/ qtrue );
 		return 0;
+	case G_TRACE_MANY:
+		VM_CheckBlock( gvm, args[1], args[3], sizeof( trace_t ), "G_TRACE_MANY" );
+		VM_CheckBlock( gvm, args[2], args[3], sizeof( traceRequest_t ), "G_TRACE_MANY" );
+		SV_TraceMany( VMA(1), VMA(2), args[3], args[4], args[5], args[6] );
+		return 0;
 	case G_POINT_CONTENTS:
 		return SV_PointContents( VMA(1), args[2] );
 	case G_SET_BRUSH_MODEL:
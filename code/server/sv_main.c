@@ -58,6 +58,9 @@ cvar_t	*sv_gametype;
 cvar_t	*sv_pure;
 cvar_t	*sv_floodProtect;
 cvar_t	*sv_lanForceRate; // dedicated 1 (LAN) server forces local client rates to 99999 (bug #491)
+cvar_t	*sv_snapshotStats;		// print per-frame snapshot building counters
+cvar_t	*sv_snapshotThreads;	// build and encode snapshots on this many threads
+cvar_t	*sv_broadphase;			// 0 = area node tree, 1 = uniform grid
 #ifndef STANDALONE
 cvar_t	*sv_strictAuth;
 #endif
@@ -355,13 +358,28 @@ CONNECTIONLESS COMMANDS
 */
 
 // This is deliberately quite large to make it more of an effort to DoS
-#define MAX_BUCKETS			16384
-#define MAX_HASHES			1024
+#define MAX_BUCKETS			32768
+#define MAX_HASHES			( MAX_BUCKETS * 2 )	// open addressed, at most half full
 
 static leakyBucket_t buckets[ MAX_BUCKETS ];
-static leakyBucket_t *bucketHashes[ MAX_HASHES ];
+static int numBuckets;						// buckets handed out so far
+static int bucketHashes[ MAX_HASHES ];		// index into buckets + 1, 0 if empty
+static leakyBucket_t *bucketsNewest;		// most recently used
+static leakyBucket_t *bucketsOldest;		// least recently used, reclaimed first
 leakyBucket_t outboundLeakyBucket;
 
+typedef struct {
+	int		lookups;
+	int		probes;
+	int		newAddresses;
+	int		reclaimed;
+	int		refused;		// no bucket could be reclaimed
+	int		limited;		// dropped by SVC_RateLimitAddress
+	int		outboundLimited;
+} floodStats_t;
+
+static floodStats_t floodStats;
+
 /*
 ================
 SVC_HashForAddress
@@ -371,7 +389,7 @@ static long SVC_HashForAddress( netadr_t address ) {
 	byte 		*ip = NULL;
 	size_t	size = 0;
 	int			i;
-	long		hash = 0;
+	unsigned int	hash = 2166136261u;
 
 	switch ( address.type ) {
 		case NA_IP:  ip = address.ip;  size = 4; break;
@@ -379,14 +397,138 @@ static long SVC_HashForAddress( netadr_t address ) {
 		default: break;
 	}
 
+	// FNV-1a, so addresses that differ in one byte spread over the table
 	for ( i = 0; i < size; i++ ) {
-		hash += (long)( ip[ i ] ) * ( i + 119 );
+		hash = ( hash ^ ip[ i ] ) * 16777619u;
+	}
+
+	return (long)( hash & 0x7fffffff );
+}
+
+/*
+================
+SVC_BucketMatchesAddress
+================
+*/
+static qboolean SVC_BucketMatchesAddress( leakyBucket_t *bucket, netadr_t address ) {
+	if ( bucket->type != address.type ) {
+		return qfalse;
 	}
 
-	hash = ( hash ^ ( hash >> 10 ) ^ ( hash >> 20 ) );
-	hash &= ( MAX_HASHES - 1 );
+	switch ( bucket->type ) {
+		case NA_IP:
+			return memcmp( bucket->ipv._4, address.ip, 4 ) == 0;
+
+		case NA_IP6:
+			return memcmp( bucket->ipv._6, address.ip6, 16 ) == 0;
+
+		default:
+			return qfalse;
+	}
+}
+
+/*
+================
+SVC_FindBucketSlot
+
+Returns the slot in bucketHashes that holds the address, or the empty
+slot where it should go
+================
+*/
+static int SVC_FindBucketSlot( netadr_t address, long hash ) {
+	leakyBucket_t	*bucket;
+	int				slot;
+
+	for ( slot = hash & ( MAX_HASHES - 1 ); bucketHashes[ slot ]; slot = ( slot + 1 ) & ( MAX_HASHES - 1 ) ) {
+		floodStats.probes++;
+
+		bucket = &buckets[ bucketHashes[ slot ] - 1 ];
+		if ( bucket->hash == hash && SVC_BucketMatchesAddress( bucket, address ) ) {
+			break;
+		}
+	}
+
+	return slot;
+}
+
+/*
+================
+SVC_SlotForBucket
+================
+*/
+static int SVC_SlotForBucket( leakyBucket_t *bucket ) {
+	int		slot;
+	int		index = ( bucket - buckets ) + 1;
+
+	for ( slot = bucket->hash & ( MAX_HASHES - 1 ); bucketHashes[ slot ] != index; slot = ( slot + 1 ) & ( MAX_HASHES - 1 ) ) {
+	}
 
-	return hash;
+	return slot;
+}
+
+/*
+================
+SVC_RemoveBucketSlot
+
+Empties a slot and moves later entries of the probe sequence back so
+lookups never stop short at the hole
+================
+*/
+static void SVC_RemoveBucketSlot( int slot ) {
+	int		next, home;
+
+	for ( next = ( slot + 1 ) & ( MAX_HASHES - 1 ); bucketHashes[ next ]; next = ( next + 1 ) & ( MAX_HASHES - 1 ) ) {
+		home = buckets[ bucketHashes[ next ] - 1 ].hash & ( MAX_HASHES - 1 );
+
+		// leave entries whose home lies cyclically in (slot, next]
+		if ( slot <= next ? ( slot < home && home <= next ) : ( slot < home || home <= next ) ) {
+			continue;
+		}
+
+		bucketHashes[ slot ] = bucketHashes[ next ];
+		slot = next;
+	}
+
+	bucketHashes[ slot ] = 0;
+}
+
+/*
+================
+SVC_UnlinkBucket
+================
+*/
+static void SVC_UnlinkBucket( leakyBucket_t *bucket ) {
+	if ( bucket->prev != NULL ) {
+		bucket->prev->next = bucket->next;
+	} else {
+		bucketsNewest = bucket->next;
+	}
+
+	if ( bucket->next != NULL ) {
+		bucket->next->prev = bucket->prev;
+	} else {
+		bucketsOldest = bucket->prev;
+	}
+
+	bucket->prev = bucket->next = NULL;
+}
+
+/*
+================
+SVC_LinkBucket
+
+Makes the bucket the most recently used
+================
+*/
+static void SVC_LinkBucket( leakyBucket_t *bucket ) {
+	bucket->prev = NULL;
+	bucket->next = bucketsNewest;
+	if ( bucketsNewest != NULL ) {
+		bucketsNewest->prev = bucket;
+	} else {
+		bucketsOldest = bucket;
+	}
+	bucketsNewest = bucket;
 }
 
 /*
@@ -398,78 +540,73 @@ Find or allocate a bucket for an address
 */
 static leakyBucket_t *SVC_BucketForAddress( netadr_t address, int burst, int period ) {
 	leakyBucket_t	*bucket = NULL;
-	int						i;
-	long					hash = SVC_HashForAddress( address );
+	int						slot;
+	long					hash;
 	int						now = Sys_Milliseconds();
 
-	for ( bucket = bucketHashes[ hash ]; bucket; bucket = bucket->next ) {
-		switch ( bucket->type ) {
-			case NA_IP:
-				if ( memcmp( bucket->ipv._4, address.ip, 4 ) == 0 ) {
-					return bucket;
-				}
-				break;
+	if ( address.type != NA_IP && address.type != NA_IP6 ) {
+		static leakyBucket_t	unlimited;
 
-			case NA_IP6:
-				if ( memcmp( bucket->ipv._6, address.ip6, 16 ) == 0 ) {
-					return bucket;
-				}
-				break;
+		// only internet addresses are limited
+		Com_Memset( &unlimited, 0, sizeof( unlimited ) );
+		unlimited.type = address.type;
+		unlimited.lastTime = now;
+		return &unlimited;
+	}
 
-			default:
-				break;
-		}
+	floodStats.lookups++;
+
+	hash = SVC_HashForAddress( address );
+	slot = SVC_FindBucketSlot( address, hash );
+
+	if ( bucketHashes[ slot ] ) {
+		bucket = &buckets[ bucketHashes[ slot ] - 1 ];
+		SVC_UnlinkBucket( bucket );
+		SVC_LinkBucket( bucket );
+		return bucket;
 	}
 
-	for ( i = 0; i < MAX_BUCKETS; i++ ) {
+	if ( numBuckets < MAX_BUCKETS ) {
+		bucket = &buckets[ numBuckets++ ];
+	} else {
 		int interval;
 
-		bucket = &buckets[ i ];
+		// Reclaim the least recently used bucket if it has expired,
+		// otherwise none of them have
+		bucket = bucketsOldest;
 		interval = now - bucket->lastTime;
 
-		// Reclaim expired buckets
-		if ( bucket->lastTime > 0 && ( interval > ( burst * period ) ||
-					interval < 0 ) ) {
-			if ( bucket->prev != NULL ) {
-				bucket->prev->next = bucket->next;
-			} else {
-				bucketHashes[ bucket->hash ] = bucket->next;
-			}
-			
-			if ( bucket->next != NULL ) {
-				bucket->next->prev = bucket->prev;
-			}
-
-			Com_Memset( bucket, 0, sizeof( leakyBucket_t ) );
+		if ( interval <= ( burst * period ) && interval >= 0 ) {
+			// Couldn't allocate a bucket for this address
+			floodStats.refused++;
+			return NULL;
 		}
 
-		if ( bucket->type == NA_BAD ) {
-			bucket->type = address.type;
-			switch ( address.type ) {
-				case NA_IP:  Com_Memcpy( bucket->ipv._4, address.ip, 4 );   break;
-				case NA_IP6: Com_Memcpy( bucket->ipv._6, address.ip6, 16 ); break;
-				default: break;
-			}
+		SVC_UnlinkBucket( bucket );
+		SVC_RemoveBucketSlot( SVC_SlotForBucket( bucket ) );
+		floodStats.reclaimed++;
 
-			bucket->lastTime = now;
-			bucket->burst = 0;
-			bucket->hash = hash;
+		// the removal may have moved the free slot
+		slot = SVC_FindBucketSlot( address, hash );
+	}
 
-			// Add to the head of the relevant hash chain
-			bucket->next = bucketHashes[ hash ];
-			if ( bucketHashes[ hash ] != NULL ) {
-				bucketHashes[ hash ]->prev = bucket;
-			}
+	Com_Memset( bucket, 0, sizeof( leakyBucket_t ) );
+	bucket->type = address.type;
+	switch ( address.type ) {
+		case NA_IP:  Com_Memcpy( bucket->ipv._4, address.ip, 4 );   break;
+		case NA_IP6: Com_Memcpy( bucket->ipv._6, address.ip6, 16 ); break;
+		default: break;
+	}
 
-			bucket->prev = NULL;
-			bucketHashes[ hash ] = bucket;
+	bucket->lastTime = now;
+	bucket->burst = 0;
+	bucket->hash = hash;
 
-			return bucket;
-		}
-	}
+	bucketHashes[ slot ] = ( bucket - buckets ) + 1;
+	SVC_LinkBucket( bucket );
+	floodStats.newAddresses++;
 
-	// Couldn't allocate a bucket for this address
-	return NULL;
+	return bucket;
 }
 
 /*
@@ -499,6 +636,10 @@ qboolean SVC_RateLimit( leakyBucket_t *bucket, int burst, int period ) {
 		}
 	}
 
+	if ( bucket == &outboundLeakyBucket ) {
+		floodStats.outboundLimited++;
+	}
+
 	return qtrue;
 }
 
@@ -512,26 +653,177 @@ Rate limit for a particular address
 qboolean SVC_RateLimitAddress( netadr_t from, int burst, int period ) {
 	leakyBucket_t *bucket = SVC_BucketForAddress( from, burst, period );
 
-	return SVC_RateLimit( bucket, burst, period );
+	if ( SVC_RateLimit( bucket, burst, period ) ) {
+		floodStats.limited++;
+		return qtrue;
+	}
+
+	return qfalse;
 }
 
 /*
 ================
-SVC_Status
+SV_FloodStats_f
 
-Responds with all the info that qplug or qspy can see about the server
-and all connected players.  Used for getting detailed information after
-the simple info query.
+Prints how the connectionless rate limiter is coping
 ================
 */
-static void SVC_Status( netadr_t from ) {
+void SV_FloodStats_f( void ) {
+	Com_Printf( "%i of %i address buckets in use\n", numBuckets, MAX_BUCKETS );
+	Com_Printf( "%i lookups, %.2f probes per lookup\n", floodStats.lookups,
+		floodStats.lookups ? (float)floodStats.probes / floodStats.lookups : 0.0f );
+	Com_Printf( "%i new addresses, %i buckets reclaimed, %i addresses refused\n",
+		floodStats.newAddresses, floodStats.reclaimed, floodStats.refused );
+	Com_Printf( "%i requests over the address limit, %i over the outbound limit\n",
+		floodStats.limited, floodStats.outboundLimited );
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "reset" ) ) {
+		Com_Memset( &floodStats, 0, sizeof( floodStats ) );
+	}
+}
+
+/*
+==============================================================================
+
+Cached query responses
+
+getstatus and getinfo are answered from strings built the last time
+something in them changed, the echoed challenge is added per request
+==============================================================================
+*/
+
+typedef struct {
+	qboolean	listed;
+	int			score;
+	int			ping;
+	char		name[MAX_NAME_LENGTH];
+} statusCacheClient_t;
+
+typedef struct {
+	qboolean			valid;
+	int					maxclients;
+	char				infostring[MAX_INFO_STRING];	// serverinfo
+	char				players[MAX_MSGLEN];
+	statusCacheClient_t	clients[MAX_CLIENTS];
+} statusCache_t;
+
+typedef struct {
+	qboolean	valid;
+	int			count;
+	int			humans;
+	int			needpass;		// game cvar, not always serverinfo
+	int			cvarCount;		// modification counts of the cvars that aren't serverinfo or systeminfo
+	char		infostring[MAX_INFO_STRING];	// everything but the challenge
+} infoCache_t;
+
+static statusCache_t	svStatusCache;
+static infoCache_t		svInfoCache;
+
+/*
+================
+SV_ClearQueryCache
+
+Called when the serverinfo and systeminfo cvars have been dealt with
+================
+*/
+void SV_ClearQueryCache( void ) {
+	svStatusCache.valid = qfalse;
+	svInfoCache.valid = qfalse;
+}
+
+/*
+================
+SVC_StatusCacheValid
+================
+*/
+static qboolean SVC_StatusCacheValid( void ) {
+	int					i;
+	client_t			*cl;
+	statusCacheClient_t	*cached;
+
+	if ( !svStatusCache.valid || ( cvar_modifiedFlags & CVAR_SERVERINFO ) ||
+		svStatusCache.maxclients != sv_maxclients->integer ) {
+		return qfalse;
+	}
+
+	for ( i = 0 ; i < sv_maxclients->integer ; i++ ) {
+		cl = &svs.clients[i];
+		cached = &svStatusCache.clients[i];
+
+		if ( ( cl->state >= CS_CONNECTED ) != cached->listed ) {
+			return qfalse;
+		}
+		if ( !cached->listed ) {
+			continue;
+		}
+		if ( SV_GameClientNum( i )->persistant[PERS_SCORE] != cached->score ||
+			cl->ping != cached->ping || strcmp( cl->name, cached->name ) ) {
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+/*
+================
+SVC_BuildStatusCache
+================
+*/
+static void SVC_BuildStatusCache( void ) {
 	char	player[1024];
-	char	status[MAX_MSGLEN];
 	int		i;
 	client_t	*cl;
 	playerState_t	*ps;
 	int		statusLength;
 	int		playerLength;
+	statusCacheClient_t	*cached;
+
+	Q_strncpyz( svStatusCache.infostring, Cvar_InfoString( CVAR_SERVERINFO ), sizeof( svStatusCache.infostring ) );
+
+	svStatusCache.players[0] = 0;
+	statusLength = 0;
+
+	for (i=0 ; i < sv_maxclients->integer ; i++) {
+		cl = &svs.clients[i];
+		cached = &svStatusCache.clients[i];
+		cached->listed = ( cl->state >= CS_CONNECTED );
+		if ( cached->listed ) {
+			ps = SV_GameClientNum( i );
+			cached->score = ps->persistant[PERS_SCORE];
+			cached->ping = cl->ping;
+			Q_strncpyz( cached->name, cl->name, sizeof( cached->name ) );
+
+			if ( statusLength < 0 ) {
+				continue;		// full, but keep recording what to compare against
+			}
+
+			Com_sprintf (player, sizeof(player), "%i %i \"%s\"\n", 
+				ps->persistant[PERS_SCORE], cl->ping, cl->name);
+			playerLength = strlen(player);
+			if (statusLength + playerLength >= sizeof(svStatusCache.players) ) {
+				statusLength = -1;		// can't hold any more
+				continue;
+			}
+			strcpy (svStatusCache.players + statusLength, player);
+			statusLength += playerLength;
+		}
+	}
+
+	svStatusCache.maxclients = sv_maxclients->integer;
+	svStatusCache.valid = qtrue;
+}
+
+/*
+================
+SVC_Status
+
+Responds with all the info that qplug or qspy can see about the server
+and all connected players.  Used for getting detailed information after
+the simple info query.
+================
+*/
+static void SVC_Status( netadr_t from ) {
 	char	infostring[MAX_INFO_STRING];
 
 	// ignore if we are in single player
@@ -557,31 +849,81 @@ static void SVC_Status( netadr_t from ) {
 	if(strlen(Cmd_Argv(1)) > 128)
 		return;
 
-	strcpy( infostring, Cvar_InfoString( CVAR_SERVERINFO ) );
+	if ( !SVC_StatusCacheValid() ) {
+		SVC_BuildStatusCache();
+	}
+
+	Q_strncpyz( infostring, svStatusCache.infostring, sizeof( infostring ) );
 
 	// echo back the parameter to status. so master servers can use it as a challenge
 	// to prevent timed spoofed reply packets that add ghost servers
 	Info_SetValueForKey( infostring, "challenge", Cmd_Argv(1) );
 
-	status[0] = 0;
-	statusLength = 0;
+	NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, svStatusCache.players );
+}
 
-	for (i=0 ; i < sv_maxclients->integer ; i++) {
-		cl = &svs.clients[i];
-		if ( cl->state >= CS_CONNECTED ) {
-			ps = SV_GameClientNum( i );
-			Com_sprintf (player, sizeof(player), "%i %i \"%s\"\n", 
-				ps->persistant[PERS_SCORE], cl->ping, cl->name);
-			playerLength = strlen(player);
-			if (statusLength + playerLength >= sizeof(status) ) {
-				break;		// can't hold any more
-			}
-			strcpy (status + statusLength, player);
-			statusLength += playerLength;
-		}
+/*
+================
+SVC_InfoCvarCount
+================
+*/
+static int SVC_InfoCvarCount( void ) {
+	int		count;
+
+	count = com_gamename->modificationCount + com_protocol->modificationCount;
+#ifdef LEGACY_PROTOCOL
+	count += com_legacyprotocol->modificationCount;
+#endif
+
+	return count;
+}
+
+/*
+================
+SVC_SetInfoKeys
+
+Info_SetValueForKey puts new keys in front, so keys set on an empty
+string end up in front of the ones that were there, like the challenge
+================
+*/
+static void SVC_SetInfoKeys( char *infostring, int count, int humans, int needpass ) {
+	char	*gamedir;
+
+	Info_SetValueForKey( infostring, "gamename", com_gamename->string );
+
+#ifdef LEGACY_PROTOCOL
+	if(com_legacyprotocol->integer > 0)
+		Info_SetValueForKey(infostring, "protocol", va("%i", com_legacyprotocol->integer));
+	else
+#endif
+		Info_SetValueForKey(infostring, "protocol", va("%i", com_protocol->integer));
+
+	Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
+	Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
+	Info_SetValueForKey( infostring, "clients", va("%i", count) );
+	Info_SetValueForKey(infostring, "g_humanplayers", va("%i", humans));
+	Info_SetValueForKey( infostring, "sv_maxclients", 
+		va("%i", sv_maxclients->integer - sv_privateClients->integer ) );
+	Info_SetValueForKey( infostring, "gametype", va("%i", sv_gametype->integer ) );
+	Info_SetValueForKey( infostring, "pure", va("%i", sv_pure->integer ) );
+	Info_SetValueForKey(infostring, "g_needpass", va("%d", needpass));
+
+#ifdef USE_VOIP
+	if (sv_voipProtocol->string && *sv_voipProtocol->string) {
+		Info_SetValueForKey( infostring, "voip", sv_voipProtocol->string );
 	}
+#endif
 
-	NET_OutOfBandPrint( NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status );
+	if( sv_minPing->integer ) {
+		Info_SetValueForKey( infostring, "minPing", va("%i", sv_minPing->integer) );
+	}
+	if( sv_maxPing->integer ) {
+		Info_SetValueForKey( infostring, "maxPing", va("%i", sv_maxPing->integer) );
+	}
+	gamedir = Cvar_VariableString( "fs_game" );
+	if( *gamedir ) {
+		Info_SetValueForKey( infostring, "game", gamedir );
+	}
 }
 
 /*
@@ -593,9 +935,9 @@ if a user is interested in a server to do a full status
 ================
 */
 void SVC_Info( netadr_t from ) {
-	int		i, count, humans;
-	char	*gamedir;
+	int		i, count, humans, needpass;
 	char	infostring[MAX_INFO_STRING];
+	char	challenge[MAX_INFO_STRING];
 
 	// ignore if we are in single player
 	if ( Cvar_VariableValue( "g_gametype" ) == GT_SINGLE_PLAYER || Cvar_VariableValue("ui_singlePlayerActive")) {
@@ -636,46 +978,31 @@ void SVC_Info( netadr_t from ) {
 		}
 	}
 
-	infostring[0] = 0;
+	needpass = Cvar_VariableIntegerValue( "g_needpass" );
 
 	// echo back the parameter to status. so servers can use it as a challenge
 	// to prevent timed spoofed reply packets that add ghost servers
-	Info_SetValueForKey( infostring, "challenge", Cmd_Argv(1) );
-
-	Info_SetValueForKey( infostring, "gamename", com_gamename->string );
-
-#ifdef LEGACY_PROTOCOL
-	if(com_legacyprotocol->integer > 0)
-		Info_SetValueForKey(infostring, "protocol", va("%i", com_legacyprotocol->integer));
-	else
-#endif
-		Info_SetValueForKey(infostring, "protocol", va("%i", com_protocol->integer));
-
-	Info_SetValueForKey( infostring, "hostname", sv_hostname->string );
-	Info_SetValueForKey( infostring, "mapname", sv_mapname->string );
-	Info_SetValueForKey( infostring, "clients", va("%i", count) );
-	Info_SetValueForKey(infostring, "g_humanplayers", va("%i", humans));
-	Info_SetValueForKey( infostring, "sv_maxclients", 
-		va("%i", sv_maxclients->integer - sv_privateClients->integer ) );
-	Info_SetValueForKey( infostring, "gametype", va("%i", sv_gametype->integer ) );
-	Info_SetValueForKey( infostring, "pure", va("%i", sv_pure->integer ) );
-	Info_SetValueForKey(infostring, "g_needpass", va("%d", Cvar_VariableIntegerValue("g_needpass")));
-
-#ifdef USE_VOIP
-	if (sv_voipProtocol->string && *sv_voipProtocol->string) {
-		Info_SetValueForKey( infostring, "voip", sv_voipProtocol->string );
+	challenge[0] = 0;
+	Info_SetValueForKey( challenge, "challenge", Cmd_Argv(1) );
+
+	if ( !svInfoCache.valid || ( cvar_modifiedFlags & ( CVAR_SERVERINFO | CVAR_SYSTEMINFO ) ) ||
+		svInfoCache.count != count || svInfoCache.humans != humans ||
+		svInfoCache.needpass != needpass || svInfoCache.cvarCount != SVC_InfoCvarCount() ) {
+		svInfoCache.infostring[0] = 0;
+		SVC_SetInfoKeys( svInfoCache.infostring, count, humans, needpass );
+		svInfoCache.count = count;
+		svInfoCache.humans = humans;
+		svInfoCache.needpass = needpass;
+		svInfoCache.cvarCount = SVC_InfoCvarCount();
+		svInfoCache.valid = qtrue;
 	}
-#endif
 
-	if( sv_minPing->integer ) {
-		Info_SetValueForKey( infostring, "minPing", va("%i", sv_minPing->integer) );
-	}
-	if( sv_maxPing->integer ) {
-		Info_SetValueForKey( infostring, "maxPing", va("%i", sv_maxPing->integer) );
-	}
-	gamedir = Cvar_VariableString( "fs_game" );
-	if( *gamedir ) {
-		Info_SetValueForKey( infostring, "game", gamedir );
+	if ( strlen( svInfoCache.infostring ) + strlen( challenge ) < MAX_INFO_STRING ) {
+		Com_sprintf( infostring, sizeof( infostring ), "%s%s", svInfoCache.infostring, challenge );
+	} else {
+		// the keys would have been limited by the challenge too
+		Q_strncpyz( infostring, challenge, sizeof( infostring ) );
+		SVC_SetInfoKeys( infostring, count, humans, needpass );
 	}
 
 	NET_OutOfBandPrint( NS_SERVER, from, "infoResponse\n%s", infostring );
@@ -1116,10 +1443,12 @@ void SV_Frame( int msec ) {
 	if ( cvar_modifiedFlags & CVAR_SERVERINFO ) {
 		SV_SetConfigstring( CS_SERVERINFO, Cvar_InfoString( CVAR_SERVERINFO ) );
 		cvar_modifiedFlags &= ~CVAR_SERVERINFO;
+		SV_ClearQueryCache();
 	}
 	if ( cvar_modifiedFlags & CVAR_SYSTEMINFO ) {
 		SV_SetConfigstring( CS_SYSTEMINFO, Cvar_InfoString_Big( CVAR_SYSTEMINFO ) );
 		cvar_modifiedFlags &= ~CVAR_SYSTEMINFO;
+		SV_ClearQueryCache();
 	}
 
 	if ( com_speeds->integer ) {
@@ -45,6 +45,173 @@ A normal server packet will look like:
 =============================================================================
 */
 
+/*
+=============================================================================
+
+Shared delta entity cache
+
+Clients that acknowledged the same snapshot, or that see an entity for the
+first time, delta the entity from identical states.  The encoded bits are
+kept for the duration of SV_SendClientMessages and appended to the other
+clients' messages with MSG_WriteBitstream instead of being encoded again.
+Within that window every copy of an entity number in the new snapshots
+holds the same state, so the from state and the entity number are enough
+to identify a delta.
+
+=============================================================================
+*/
+
+#define	DELTA_CACHE_HASH		4096		// must be a power of two
+#define	DELTA_CACHE_ENTRIES		2048
+#define	DELTA_CACHE_BYTES		(512*1024)
+#define	DELTA_CACHE_MAXENTITY	1024		// largest single encoded delta
+
+typedef struct deltaCacheEntry_s {
+	entityState_t	from;
+	int				number;
+	qboolean		force;
+	int				numBits;
+	int				offset;			// into sv_deltaCache.data
+	struct deltaCacheEntry_s	*next;
+} deltaCacheEntry_t;
+
+typedef struct {
+	qboolean			active;
+	void				*mutex;			// only used while worker threads encode
+	qboolean			threaded;
+
+	deltaCacheEntry_t	*hash[DELTA_CACHE_HASH];
+	deltaCacheEntry_t	entries[DELTA_CACHE_ENTRIES];
+	int					numEntries;
+	byte				data[DELTA_CACHE_BYTES];
+	int					dataUsed;
+
+	int					hits;
+	int					misses;
+} deltaCache_t;
+
+static deltaCache_t		sv_deltaCache;
+
+/*
+=============
+SV_ClearDeltaCache
+=============
+*/
+static void SV_ClearDeltaCache( void ) {
+	Com_Memset( sv_deltaCache.hash, 0, sizeof( sv_deltaCache.hash ) );
+	sv_deltaCache.numEntries = 0;
+	sv_deltaCache.dataUsed = 0;
+	sv_deltaCache.hits = 0;
+	sv_deltaCache.misses = 0;
+}
+
+/*
+=============
+SV_DeltaCacheHash
+=============
+*/
+static unsigned SV_DeltaCacheHash( const entityState_t *from, int number, qboolean force ) {
+	const unsigned	*p = (const unsigned *)from;
+	unsigned		hash;
+	int				i;
+
+	hash = 2166136261u ^ ( number * 2 + force );
+	for ( i = 0 ; i < sizeof( *from ) / sizeof( *p ) ; i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619u;
+	}
+	return hash & ( DELTA_CACHE_HASH - 1 );
+}
+
+/*
+=============
+SV_FindDeltaCacheEntry
+=============
+*/
+static deltaCacheEntry_t *SV_FindDeltaCacheEntry( unsigned hash, const entityState_t *from, int number, qboolean force ) {
+	deltaCacheEntry_t	*entry;
+
+	for ( entry = sv_deltaCache.hash[hash] ; entry ; entry = entry->next ) {
+		if ( entry->number == number && entry->force == force
+			&& !memcmp( &entry->from, from, sizeof( *from ) ) ) {
+			return entry;
+		}
+	}
+	return NULL;
+}
+
+/*
+=============
+SV_WriteCachedDeltaEntity
+
+Same as MSG_WriteDeltaEntity for a non-NULL to state
+=============
+*/
+static void SV_WriteCachedDeltaEntity( msg_t *msg, entityState_t *from, entityState_t *to, qboolean force ) {
+	deltaCacheEntry_t	*entry;
+	unsigned			hash;
+	msg_t				delta;
+	byte				deltaBuf[DELTA_CACHE_MAXENTITY];
+
+	if ( !sv_deltaCache.active ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+
+	hash = SV_DeltaCacheHash( from, to->number, force );
+
+	// entries are never changed once they are linked in,
+	// so their bits can be copied without holding the lock
+	if ( sv_deltaCache.threaded ) {
+		Sys_LockMutex( sv_deltaCache.mutex );
+	}
+	entry = SV_FindDeltaCacheEntry( hash, from, to->number, force );
+	if ( entry ) {
+		sv_deltaCache.hits++;
+	} else {
+		sv_deltaCache.misses++;
+	}
+	if ( sv_deltaCache.threaded ) {
+		Sys_UnlockMutex( sv_deltaCache.mutex );
+	}
+
+	if ( entry ) {
+		MSG_WriteBitstream( msg, sv_deltaCache.data + entry->offset, entry->numBits );
+		return;
+	}
+
+	MSG_Init( &delta, deltaBuf, sizeof( deltaBuf ) );
+	MSG_WriteDeltaEntity( &delta, from, to, force );
+	if ( delta.overflowed ) {
+		MSG_WriteDeltaEntity( msg, from, to, force );
+		return;
+	}
+	MSG_WriteBitstream( msg, deltaBuf, delta.bit );
+
+	if ( sv_deltaCache.threaded ) {
+		Sys_LockMutex( sv_deltaCache.mutex );
+	}
+	// another thread may have added it in the meantime, and
+	// when the cache is full the rest of the frame goes uncached
+	if ( !SV_FindDeltaCacheEntry( hash, from, to->number, force )
+		&& sv_deltaCache.numEntries < DELTA_CACHE_ENTRIES
+		&& sv_deltaCache.dataUsed + ( ( delta.bit + 7 ) >> 3 ) <= DELTA_CACHE_BYTES ) {
+		entry = &sv_deltaCache.entries[sv_deltaCache.numEntries++];
+		entry->from = *from;
+		entry->number = to->number;
+		entry->force = force;
+		entry->numBits = delta.bit;
+		entry->offset = sv_deltaCache.dataUsed;
+		Com_Memcpy( sv_deltaCache.data + entry->offset, deltaBuf, ( delta.bit + 7 ) >> 3 );
+		sv_deltaCache.dataUsed += ( delta.bit + 7 ) >> 3;
+
+		entry->next = sv_deltaCache.hash[hash];
+		sv_deltaCache.hash[hash] = entry;
+	}
+	if ( sv_deltaCache.threaded ) {
+		Sys_UnlockMutex( sv_deltaCache.mutex );
+	}
+}
+
 /*
 =============
 SV_EmitPacketEntities
@@ -88,7 +255,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emitted if the entity has not changed at all
-			MSG_WriteDeltaEntity (msg, oldent, newent, qfalse );
+			SV_WriteCachedDeltaEntity (msg, oldent, newent, qfalse );
 			oldindex++;
 			newindex++;
 			continue;
@@ -96,7 +263,7 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 		if ( newnum < oldnum ) {
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
+			SV_WriteCachedDeltaEntity (msg, &sv.svEntities[newnum].baseline, newent, qtrue );
 			newindex++;
 			continue;
 		}
@@ -116,17 +283,16 @@ static void SV_EmitPacketEntities( clientSnapshot_t *from, clientSnapshot_t *to,
 
 /*
 ==================
-SV_WriteSnapshotToClient
+SV_SnapshotDeltaFrame
+
+Picks the frame the client's new snapshot will be delta compressed
+against.  Must be called after the new snapshot's entities have been
+stored, so the check for entities that rolled off the buffer is valid.
 ==================
 */
-static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
-	clientSnapshot_t	*frame, *oldframe;
+static clientSnapshot_t *SV_SnapshotDeltaFrame( client_t *client, int *lastframeOut ) {
+	clientSnapshot_t	*oldframe;
 	int					lastframe;
-	int					i;
-	int					snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if ( client->deltaMessage <= 0 || client->state != CS_ACTIVE ) {
@@ -152,6 +318,23 @@ static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg ) {
 		}
 	}
 
+	*lastframeOut = lastframe;
+	return oldframe;
+}
+
+/*
+==================
+SV_WriteSnapshotToClient
+==================
+*/
+static void SV_WriteSnapshotToClient( client_t *client, msg_t *msg, clientSnapshot_t *oldframe, int lastframe ) {
+	clientSnapshot_t	*frame;
+	int					i;
+	int					snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+
 	MSG_WriteByte (msg, svc_snapshot);
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -238,6 +421,14 @@ Build a client snapshot structure
 typedef struct {
 	int		numSnapshotEntities;
 	int		snapshotEntities[MAX_SNAPSHOT_ENTITIES];	
+	byte	added[MAX_GENTITIES/8];		// prevents double adding from portal views
+	int		ownNumber;					// set in added without being in snapshotEntities
+	qboolean	overflowed;				// entities were discarded, but set in added
+
+	// counters for sv_snapshotStats, summed up on the main thread
+	int		viewpoints;
+	int		tested;
+	int		fullScan;
 } snapshotEntityNumbers_t;
 
 /*
@@ -269,14 +460,31 @@ SV_AddEntToSnapshot
 ===============
 */
 static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapshotEntityNumbers_t *eNums ) {
+	int		num = gEnt->s.number;
+
 	// if we have already added this entity to this snapshot, don't add again
-	if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+	if ( eNums->added[num >> 3] & ( 1 << ( num & 7 ) ) ) {
 		return;
 	}
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	eNums->added[num >> 3] |= 1 << ( num & 7 );
 
-	// if we are full, silently discard entities
+	// if we are full, silently discard entities.  The candidate lists are
+	// walked by area, so keep the lowest entity numbers like a scan in
+	// entity order would, replacing the highest one already added
 	if ( eNums->numSnapshotEntities == MAX_SNAPSHOT_ENTITIES ) {
+		int		i, highest;
+
+		eNums->overflowed = qtrue;
+
+		highest = 0;
+		for ( i = 1 ; i < MAX_SNAPSHOT_ENTITIES ; i++ ) {
+			if ( eNums->snapshotEntities[i] > eNums->snapshotEntities[highest] ) {
+				highest = i;
+			}
+		}
+		if ( num < eNums->snapshotEntities[highest] ) {
+			eNums->snapshotEntities[highest] = num;
+		}
 		return;
 	}
 
@@ -284,37 +492,91 @@ static void SV_AddEntToSnapshot( svEntity_t *svEnt, sharedEntity_t *gEnt, snapsh
 	eNums->numSnapshotEntities++;
 }
 
+/*
+=============================================================================
+
+Per-frame snapshot candidates
+
+Entities that can never be sent to anyone (not linked, or SVF_NOCLIENT) are
+filtered out once per frame instead of once per client.  The remaining
+entities are grouped by area, so a viewpoint only walks the lists of areas
+that are connected to it.  Broadcast entities and entities without a single
+well defined area stay on a separate list that is tested entity by entity.
+
+=============================================================================
+*/
+
+typedef struct {
+	sharedEntity_t	*gEnt;
+	svEntity_t		*svEnt;
+	int				svFlags;
+	int				next;			// next candidate in the same list, -1 if last
+} snapshotCandidate_t;
+
+typedef struct {
+	int				snapshots;		// client snapshots built
+	int				viewpoints;		// including portal views
+	int				candidates;		// entities that passed the shared pre-pass
+	int				tested;			// candidates visited by per-client tests
+	int				fullScan;		// entities a scan of every entity would have visited
+	int				msec;
+} snapshotStats_t;
+
+static snapshotCandidate_t	sv_snapshotCandidates[MAX_GENTITIES];
+static int					sv_numSnapshotCandidates;
+static int					sv_snapshotCandidatesAreaList[MAX_MAP_AREAS];
+static int					sv_snapshotCandidatesGenericList;
+static qboolean				sv_snapshotCandidatesValid;
+static qboolean				sv_snapshotCandidatesClientMask;	// any candidate has SVF_CLIENTMASK
+static snapshotStats_t		sv_snapshotStatsFrame;
+
 /*
 ===============
-SV_AddEntitiesVisibleFromPoint
+SV_AppendSnapshotCandidate
 ===============
 */
-static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame, 
-									snapshotEntityNumbers_t *eNums, qboolean portal ) {
-	int		e, i;
-	sharedEntity_t *ent;
-	svEntity_t	*svEnt;
-	int		l;
-	int		clientarea, clientcluster;
-	int		leafnum;
-	byte	*clientpvs;
-	byte	*bitvector;
-
-	// during an error shutdown message we may need to transmit
-	// the shutdown message after the server has shutdown, so
-	// specfically check for it
-	if ( !sv.state ) {
-		return;
+static void SV_AppendSnapshotCandidate( int *head, int *tail, int index ) {
+	if ( *tail == -1 ) {
+		*head = index;
+	} else {
+		sv_snapshotCandidates[*tail].next = index;
 	}
+	*tail = index;
+}
 
-	leafnum = CM_PointLeafnum (origin);
-	clientarea = CM_LeafArea (leafnum);
-	clientcluster = CM_LeafCluster (leafnum);
+/*
+===============
+SV_BuildSnapshotCandidates
 
-	// calculate the visible areas
-	frame->areabytes = CM_WriteAreaBits( frame->areabits, clientarea );
+Builds the shared list of entities that may be sent this frame.
+Must be rebuilt whenever the game may have moved entities.
+===============
+*/
+static void SV_BuildSnapshotCandidates( void ) {
+	int				e, area, numAreas;
+	int				genericTail;
+	int				areaTail[MAX_MAP_AREAS];
+	sharedEntity_t	*ent;
+	svEntity_t		*svEnt;
+	snapshotCandidate_t	*cand;
+
+	sv_numSnapshotCandidates = 0;
+	sv_snapshotCandidatesGenericList = -1;
+	sv_snapshotCandidatesClientMask = qfalse;
+	genericTail = -1;
+
+	numAreas = CM_NumAreas();
+	if ( numAreas > MAX_MAP_AREAS ) {
+		numAreas = MAX_MAP_AREAS;
+	}
+	for ( area = 0 ; area < numAreas ; area++ ) {
+		sv_snapshotCandidatesAreaList[area] = -1;
+		areaTail[area] = -1;
+	}
 
-	clientpvs = CM_ClusterPVS (clientcluster);
+	if ( !sv.state ) {
+		return;
+	}
 
 	for ( e = 0 ; e < sv.num_entities ; e++ ) {
 		ent = SV_GentityNum(e);
@@ -334,42 +596,91 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			continue;
 		}
 
+		svEnt = SV_SvEntityForGentity( ent );
+
+		cand = &sv_snapshotCandidates[ sv_numSnapshotCandidates ];
+		cand->gEnt = ent;
+		cand->svEnt = svEnt;
+		cand->svFlags = ent->r.svFlags;
+		cand->next = -1;
+
+		if ( ent->r.svFlags & SVF_CLIENTMASK ) {
+			sv_snapshotCandidatesClientMask = qtrue;
+		}
+
+		area = svEnt->areanum;
+		if ( ( ent->r.svFlags & SVF_BROADCAST ) || area < 0 || area >= numAreas
+			|| ( svEnt->areanum2 != -1 && svEnt->areanum2 != area ) ) {
+			SV_AppendSnapshotCandidate( &sv_snapshotCandidatesGenericList, &genericTail, sv_numSnapshotCandidates );
+		} else {
+			SV_AppendSnapshotCandidate( &sv_snapshotCandidatesAreaList[area], &areaTail[area], sv_numSnapshotCandidates );
+		}
+		sv_numSnapshotCandidates++;
+	}
+
+	sv_snapshotStatsFrame.candidates = sv_numSnapshotCandidates;
+}
+
+static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame, 
+									snapshotEntityNumbers_t *eNums, qboolean portal );
+
+/*
+===============
+SV_AddCandidatesVisibleFromPoint
+
+Tests one candidate list against a viewpoint.  If checkArea is qfalse,
+the caller has already established that the list's area is connected.
+===============
+*/
+static void SV_AddCandidatesVisibleFromPoint( int index, vec3_t origin, clientSnapshot_t *frame,
+									snapshotEntityNumbers_t *eNums, int clientarea, const uint64_t *clientpvs,
+									qboolean checkArea ) {
+	int		l;
+	snapshotCandidate_t	*cand;
+	sharedEntity_t *ent;
+	svEntity_t	*svEnt;
+
+	for ( ; index != -1 ; index = cand->next ) {
+		cand = &sv_snapshotCandidates[index];
+		ent = cand->gEnt;
+		svEnt = cand->svEnt;
+
+		eNums->tested++;
+
 		// entities can be flagged to be sent to only one client
-		if ( ent->r.svFlags & SVF_SINGLECLIENT ) {
+		if ( cand->svFlags & SVF_SINGLECLIENT ) {
 			if ( ent->r.singleClient != frame->ps.clientNum ) {
 				continue;
 			}
 		}
 		// entities can be flagged to be sent to everyone but one client
-		if ( ent->r.svFlags & SVF_NOTSINGLECLIENT ) {
+		if ( cand->svFlags & SVF_NOTSINGLECLIENT ) {
 			if ( ent->r.singleClient == frame->ps.clientNum ) {
 				continue;
 			}
 		}
 		// entities can be flagged to be sent to a given mask of clients
-		if ( ent->r.svFlags & SVF_CLIENTMASK ) {
+		if ( cand->svFlags & SVF_CLIENTMASK ) {
 			if (frame->ps.clientNum >= 32)
 				Com_Error( ERR_DROP, "SVF_CLIENTMASK: clientNum >= 32" );
 			if (~ent->r.singleClient & (1 << frame->ps.clientNum))
 				continue;
 		}
 
-		svEnt = SV_SvEntityForGentity( ent );
-
 		// don't double add an entity through portals
-		if ( svEnt->snapshotCounter == sv.snapshotCounter ) {
+		if ( eNums->added[ent->s.number >> 3] & ( 1 << ( ent->s.number & 7 ) ) ) {
 			continue;
 		}
 
 		// broadcast entities are always sent
-		if ( ent->r.svFlags & SVF_BROADCAST ) {
+		if ( cand->svFlags & SVF_BROADCAST ) {
 			SV_AddEntToSnapshot( svEnt, ent, eNums );
 			continue;
 		}
 
 		// ignore if not touching a PV leaf
 		// check area
-		if ( !CM_AreasConnected( clientarea, svEnt->areanum ) ) {
+		if ( checkArea && !CM_AreasConnected( clientarea, svEnt->areanum ) ) {
 			// doors can legally straddle two areas, so
 			// we may need to check another one
 			if ( !CM_AreasConnected( clientarea, svEnt->areanum2 ) ) {
@@ -377,26 +688,17 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			}
 		}
 
-		bitvector = clientpvs;
-
 		// check individual leafs
 		if ( !svEnt->numClusters ) {
 			continue;
 		}
-		l = 0;
-		for ( i=0 ; i < svEnt->numClusters ; i++ ) {
-			l = svEnt->clusternums[i];
-			if ( bitvector[l >> 3] & (1 << (l&7) ) ) {
-				break;
-			}
-		}
 
 		// if we haven't found it to be visible,
 		// check overflow clusters that coudln't be stored
-		if ( i == svEnt->numClusters ) {
+		if ( !CM_ClusterListVisible( clientpvs, svEnt->clusternums, svEnt->numClusters ) ) {
 			if ( svEnt->lastCluster ) {
-				for ( ; l <= svEnt->lastCluster ; l++ ) {
-					if ( bitvector[l >> 3] & (1 << (l&7) ) ) {
+				for ( l = svEnt->clusternums[svEnt->numClusters - 1] ; l <= svEnt->lastCluster ; l++ ) {
+					if ( clientpvs[l >> 6] & ( (uint64_t)1 << ( l & 63 ) ) ) {
 						break;
 					}
 				}
@@ -412,7 +714,7 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 		SV_AddEntToSnapshot( svEnt, ent, eNums );
 
 		// if it's a portal entity, add everything visible from its camera position
-		if ( ent->r.svFlags & SVF_PORTAL ) {
+		if ( cand->svFlags & SVF_PORTAL ) {
 			if ( ent->s.generic1 ) {
 				vec3_t dir;
 				VectorSubtract(ent->s.origin, origin, dir);
@@ -422,8 +724,87 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 			}
 			SV_AddEntitiesVisibleFromPoint( ent->s.origin2, frame, eNums, qtrue );
 		}
+	}
+}
+
+/*
+===============
+SV_AddEntitiesVisibleFromPoint
+===============
+*/
+static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *frame, 
+									snapshotEntityNumbers_t *eNums, qboolean portal ) {
+	int		area, numAreas;
+	int		clientarea, clientcluster;
+	int		leafnum;
+	const uint64_t	*clientpvs;
 
+	// during an error shutdown message we may need to transmit
+	// the shutdown message after the server has shutdown, so
+	// specfically check for it
+	if ( !sv.state ) {
+		return;
+	}
+
+	leafnum = CM_PointLeafnum (origin);
+	clientarea = CM_LeafArea (leafnum);
+	clientcluster = CM_LeafCluster (leafnum);
+
+	// calculate the visible areas
+	frame->areabytes = CM_WriteAreaBits( frame->areabits, clientarea );
+
+	clientpvs = CM_ClusterPVSWords( clientcluster );
+
+	eNums->viewpoints++;
+	eNums->fullScan += sv.num_entities;
+
+	SV_AddCandidatesVisibleFromPoint( sv_snapshotCandidatesGenericList, origin, frame, eNums,
+		clientarea, clientpvs, qtrue );
+
+	// only walk the areas that can be seen from the viewpoint
+	numAreas = CM_NumAreas();
+	if ( numAreas > MAX_MAP_AREAS ) {
+		numAreas = MAX_MAP_AREAS;
+	}
+	for ( area = 0 ; area < numAreas ; area++ ) {
+		if ( sv_snapshotCandidatesAreaList[area] == -1 ) {
+			continue;
+		}
+		if ( !CM_AreasConnected( clientarea, area ) ) {
+			continue;		// blocked by a door
+		}
+		SV_AddCandidatesVisibleFromPoint( sv_snapshotCandidatesAreaList[area], origin, frame, eNums,
+			clientarea, clientpvs, qfalse );
+	}
+}
+
+/*
+=============
+SV_ClearEntityNumbers
+
+Clears what the previous snapshot built with entityNumbers left in it.  Unless
+entities were discarded, only the bytes of added that can have bits set are
+cleared instead of all of it, so entityNumbers has to start out zeroed
+=============
+*/
+static void SV_ClearEntityNumbers( snapshotEntityNumbers_t *entityNumbers ) {
+	int		i;
+
+	if ( entityNumbers->overflowed ) {
+		Com_Memset( entityNumbers->added, 0, sizeof( entityNumbers->added ) );
+	} else {
+		for ( i = 0 ; i < entityNumbers->numSnapshotEntities ; i++ ) {
+			entityNumbers->added[entityNumbers->snapshotEntities[i] >> 3] = 0;
+		}
+		entityNumbers->added[entityNumbers->ownNumber >> 3] = 0;
 	}
+
+	entityNumbers->numSnapshotEntities = 0;
+	entityNumbers->ownNumber = 0;
+	entityNumbers->overflowed = qfalse;
+	entityNumbers->viewpoints = 0;
+	entityNumbers->tested = 0;
+	entityNumbers->fullScan = 0;
 }
 
 /*
@@ -431,34 +812,30 @@ static void SV_AddEntitiesVisibleFromPoint( vec3_t origin, clientSnapshot_t *fra
 SV_BuildClientSnapshot
 
 Decides which entities are going to be visible to the client, and
-copies off the playerstate and areabits.
+copies off the playerstate and areabits.  Returns qfalse if the client
+has no entity, in which case nothing needs to be stored.
 
 This properly handles multiple recursive portals, but the render
 currently doesn't.
 
 For viewing through other player's eyes, clent can be something other than client->gentity
+
+Only touches the client's own frame, so it may run on a worker thread
 =============
 */
-static void SV_BuildClientSnapshot( client_t *client ) {
+static qboolean SV_BuildClientSnapshot( client_t *client, snapshotEntityNumbers_t *entityNumbers ) {
 	vec3_t						org;
 	clientSnapshot_t			*frame;
-	snapshotEntityNumbers_t		entityNumbers;
 	int							i;
-	sharedEntity_t				*ent;
-	entityState_t				*state;
-	svEntity_t					*svEnt;
 	sharedEntity_t				*clent;
 	int							clientNum;
 	playerState_t				*ps;
 
-	// bump the counter used to prevent double adding
-	sv.snapshotCounter++;
-
 	// this is the frame we are creating
 	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
 
 	// clear everything in this snapshot
-	entityNumbers.numSnapshotEntities = 0;
+	SV_ClearEntityNumbers( entityNumbers );
 	Com_Memset( frame->areabits, 0, sizeof( frame->areabits ) );
 
   // https://zerowing.idsoftware.com/bugzilla/show_bug.cgi?id=62
@@ -466,7 +843,7 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	
 	clent = client->gentity;
 	if ( !clent || client->state == CS_ZOMBIE ) {
-		return;
+		return qfalse;
 	}
 
 	// grab the current playerState_t
@@ -479,9 +856,8 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 	if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
 		Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
 	}
-	svEnt = &sv.svEntities[ clientNum ];
-
-	svEnt->snapshotCounter = sv.snapshotCounter;
+	entityNumbers->added[clientNum >> 3] |= 1 << ( clientNum & 7 );
+	entityNumbers->ownNumber = clientNum;
 
 	// find the client's viewpoint
 	VectorCopy( ps->origin, org );
@@ -489,14 +865,14 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 
 	// add all the entities directly visible to the eye, which
 	// may include portal entities that merge other viewpoints
-	SV_AddEntitiesVisibleFromPoint( org, frame, &entityNumbers, qfalse );
+	SV_AddEntitiesVisibleFromPoint( org, frame, entityNumbers, qfalse );
 
 	// if there were portals visible, there may be out of order entities
 	// in the list which will need to be resorted for the delta compression
 	// to work correctly.  This also catches the error condition
 	// of an entity being included twice.
-	qsort( entityNumbers.snapshotEntities, entityNumbers.numSnapshotEntities, 
-		sizeof( entityNumbers.snapshotEntities[0] ), SV_QsortEntityNumbers );
+	qsort( entityNumbers->snapshotEntities, entityNumbers->numSnapshotEntities, 
+		sizeof( entityNumbers->snapshotEntities[0] ), SV_QsortEntityNumbers );
 
 	// now that all viewpoint's areabits have been OR'd together, invert
 	// all of them to make it a mask vector, which is what the renderer wants
@@ -504,22 +880,59 @@ static void SV_BuildClientSnapshot( client_t *client ) {
 		((int *)frame->areabits)[i] = ((int *)frame->areabits)[i] ^ -1;
 	}
 
-	// copy the entity states out
-	frame->num_entities = 0;
+	return qtrue;
+}
+
+/*
+=============
+SV_AllocSnapshotEntities
+
+Reserves room for the frame's entities in the circular snapshot entity
+buffer.  Frames must be allocated in the same order as in the serial path.
+=============
+*/
+static void SV_AllocSnapshotEntities( clientSnapshot_t *frame, int numEntities ) {
 	frame->first_entity = svs.nextSnapshotEntities;
-	for ( i = 0 ; i < entityNumbers.numSnapshotEntities ; i++ ) {
-		ent = SV_GentityNum(entityNumbers.snapshotEntities[i]);
-		state = &svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities];
+	frame->num_entities = numEntities;
+	svs.nextSnapshotEntities += numEntities;
+
+	// this should never hit, map should always be restarted first in SV_Frame
+	if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
+		Com_Error(ERR_FATAL, "svs.nextSnapshotEntities wrapped");
+	}
+}
+
+/*
+=============
+SV_CopySnapshotEntities
+
+Copies the entity states out into the frame's reserved range
+=============
+*/
+static void SV_CopySnapshotEntities( clientSnapshot_t *frame, snapshotEntityNumbers_t *entityNumbers ) {
+	int				i;
+	sharedEntity_t	*ent;
+	entityState_t	*state;
+
+	for ( i = 0 ; i < frame->num_entities ; i++ ) {
+		ent = SV_GentityNum(entityNumbers->snapshotEntities[i]);
+		state = &svs.snapshotEntities[(frame->first_entity + i) % svs.numSnapshotEntities];
 		*state = ent->s;
-		svs.nextSnapshotEntities++;
-		// this should never hit, map should always be restarted first in SV_Frame
-		if ( svs.nextSnapshotEntities >= 0x7FFFFFFE ) {
-			Com_Error(ERR_FATAL, "svs.nextSnapshotEntities wrapped");
-		}
-		frame->num_entities++;
 	}
 }
 
+/*
+=============
+SV_AddSnapshotStats
+=============
+*/
+static void SV_AddSnapshotStats( snapshotEntityNumbers_t *entityNumbers ) {
+	sv_snapshotStatsFrame.snapshots++;
+	sv_snapshotStatsFrame.viewpoints += entityNumbers->viewpoints;
+	sv_snapshotStatsFrame.tested += entityNumbers->tested;
+	sv_snapshotStatsFrame.fullScan += entityNumbers->fullScan;
+}
+
 #ifdef USE_VOIP
 /*
 ==================
@@ -586,6 +999,48 @@ void SV_SendMessageToClient(msg_t *msg, client_t *client)
 }
 
 
+/*
+=======================
+SV_WriteClientSnapshotMessage
+
+Writes everything up to and including the snapshot itself.
+Only touches the client and its message, so it may run on a worker thread
+=======================
+*/
+static void SV_WriteClientSnapshotMessage( client_t *client, msg_t *msg, clientSnapshot_t *oldframe, int lastframe ) {
+	// NOTE, MRE: all server->client messages now acknowledge
+	// let the client know which reliable clientCommands we have received
+	MSG_WriteLong( msg, client->lastClientCommand );
+
+	// (re)send any reliable server commands
+	SV_UpdateServerCommandsToClient( client, msg );
+
+	// send over all the relevant entityState_t
+	// and the playerState_t
+	SV_WriteSnapshotToClient( client, msg, oldframe, lastframe );
+}
+
+/*
+=======================
+SV_FinishClientSnapshot
+
+Appends the queued VoIP data and sends the message
+=======================
+*/
+static void SV_FinishClientSnapshot( client_t *client, msg_t *msg ) {
+#ifdef USE_VOIP
+	SV_WriteVoipToClient( client, msg );
+#endif
+
+	// check for overflow
+	if ( msg->overflowed ) {
+		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
+		MSG_Clear (msg);
+	}
+
+	SV_SendMessageToClient( msg, client );
+}
+
 /*
 =======================
 SV_SendClientSnapshot
@@ -597,9 +1052,23 @@ Also called by SV_FinalMessage
 void SV_SendClientSnapshot( client_t *client ) {
 	byte		msg_buf[MAX_MSGLEN];
 	msg_t		msg;
+	clientSnapshot_t		*frame, *oldframe;
+	static snapshotEntityNumbers_t	entityNumbers;
+	int			lastframe;
+
+	// the shared candidate list is only valid inside SV_SendClientMessages,
+	// snapshots sent from anywhere else need a fresh one
+	if ( !sv_snapshotCandidatesValid ) {
+		SV_BuildSnapshotCandidates();
+	}
 
 	// build the snapshot
-	SV_BuildClientSnapshot( client );
+	frame = &client->frames[ client->netchan.outgoingSequence & PACKET_MASK ];
+	if ( SV_BuildClientSnapshot( client, &entityNumbers ) ) {
+		SV_AllocSnapshotEntities( frame, entityNumbers.numSnapshotEntities );
+		SV_CopySnapshotEntities( frame, &entityNumbers );
+		SV_AddSnapshotStats( &entityNumbers );
+	}
 
 	// bots need to have their snapshots build, but
 	// the query them directly without needing to be sent
@@ -610,28 +1079,175 @@ void SV_SendClientSnapshot( client_t *client ) {
 	MSG_Init (&msg, msg_buf, sizeof(msg_buf));
 	msg.allowoverflow = qtrue;
 
-	// NOTE, MRE: all server->client messages now acknowledge
-	// let the client know which reliable clientCommands we have received
-	MSG_WriteLong( &msg, client->lastClientCommand );
+	oldframe = SV_SnapshotDeltaFrame( client, &lastframe );
+	SV_WriteClientSnapshotMessage( client, &msg, oldframe, lastframe );
 
-	// (re)send any reliable server commands
-	SV_UpdateServerCommandsToClient( client, &msg );
+	SV_FinishClientSnapshot( client, &msg );
+}
 
-	// send over all the relevant entityState_t
-	// and the playerState_t
-	SV_WriteSnapshotToClient( client, &msg );
+/*
+=============================================================================
 
-#ifdef USE_VOIP
-	SV_WriteVoipToClient( client, &msg );
-#endif
+Threaded snapshots
 
-	// check for overflow
-	if ( msg.overflowed ) {
-		Com_Printf ("WARNING: msg overflowed for %s\n", client->name);
-		MSG_Clear (&msg);
+With sv_snapshotThreads above 1, the snapshots of all clients that are due
+this frame are built and delta encoded on worker threads.  Everything that
+is shared between clients (the snapshot entity buffer, printing, VoIP and
+the netchan) is handled on the main thread in client order, so the packets
+are the same as the ones SV_SendClientSnapshot produces.
+
+=============================================================================
+*/
+
+typedef struct {
+	client_t				*client;
+	qboolean				built;			// SV_BuildClientSnapshot returned qtrue
+	qboolean				bot;			// snapshot is built but not sent
+	snapshotEntityNumbers_t	entityNumbers;
+	clientSnapshot_t		*oldframe;
+	int						lastframe;
+	msg_t					msg;
+	byte					msgBuffer[MAX_MSGLEN];
+} snapshotJob_t;
+
+static snapshotJob_t	sv_snapshotJobs[MAX_CLIENTS];
+
+/*
+=======================
+SV_SnapshotThreads
+=======================
+*/
+static int SV_SnapshotThreads( void ) {
+	if ( sv_snapshotThreads->integer < 0 ) {
+		return Sys_ProcessorCount();
+	}
+	return sv_snapshotThreads->integer;
+}
+
+/*
+=======================
+SV_BuildSnapshotJob
+=======================
+*/
+static void SV_BuildSnapshotJob( void *data, int index ) {
+	snapshotJob_t	*job = (snapshotJob_t *)data + index;
+
+	job->built = SV_BuildClientSnapshot( job->client, &job->entityNumbers );
+}
+
+/*
+=======================
+SV_WriteSnapshotJob
+=======================
+*/
+static void SV_WriteSnapshotJob( void *data, int index ) {
+	snapshotJob_t		*job = (snapshotJob_t *)data + index;
+	clientSnapshot_t	*frame;
+
+	frame = &job->client->frames[ job->client->netchan.outgoingSequence & PACKET_MASK ];
+	if ( job->built ) {
+		SV_CopySnapshotEntities( frame, &job->entityNumbers );
+	}
+
+	if ( job->bot ) {
+		return;
+	}
+
+	MSG_Init( &job->msg, job->msgBuffer, sizeof( job->msgBuffer ) );
+	job->msg.allowoverflow = qtrue;
+
+	SV_WriteClientSnapshotMessage( job->client, &job->msg, job->oldframe, job->lastframe );
+}
+
+/*
+=======================
+SV_SendClientSnapshots
+
+Threaded version of calling SV_SendClientSnapshot for each job in order
+=======================
+*/
+static void SV_SendClientSnapshots( int numJobs ) {
+	int					i, first, limit;
+	int					numThreads;
+	int					clientNum;
+	snapshotJob_t		*job;
+	client_t			*c;
+	clientSnapshot_t	*frame;
+
+	numThreads = SV_SnapshotThreads();
+
+	// Com_Error can't be raised from a worker thread, so check
+	// for what SV_BuildClientSnapshot would complain about first
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		job = &sv_snapshotJobs[i];
+		c = job->client;
+		job->bot = ( c->gentity && c->gentity->r.svFlags & SVF_BOT ) ? qtrue : qfalse;
+
+		if ( !c->gentity || c->state == CS_ZOMBIE ) {
+			continue;
+		}
+
+		clientNum = SV_GameClientNum( c - svs.clients )->clientNum;
+		if ( clientNum < 0 || clientNum >= MAX_GENTITIES ) {
+			Com_Error( ERR_DROP, "SV_SvEntityForGentity: bad gEnt" );
+		}
+		if ( clientNum >= 32 && sv_snapshotCandidatesClientMask ) {
+			Com_Error( ERR_DROP, "SVF_CLIENTMASK: clientNum >= 32" );
+		}
+	}
+
+	Com_RunJobs( SV_BuildSnapshotJob, sv_snapshotJobs, numJobs, numThreads );
+
+	if ( !sv_deltaCache.mutex ) {
+		sv_deltaCache.mutex = Sys_CreateMutex();
+	}
+	sv_deltaCache.threaded = qtrue;
+
+	// store the entities and pick the delta frames in client order.  A client
+	// can't be encoded once a later client's entities have overwritten the
+	// frame it deltas from, so encode what we have before that would happen
+	first = 0;
+	limit = 0x7fffffff;
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		job = &sv_snapshotJobs[i];
+		c = job->client;
+		frame = &c->frames[ c->netchan.outgoingSequence & PACKET_MASK ];
+
+		if ( job->built ) {
+			if ( svs.nextSnapshotEntities + job->entityNumbers.numSnapshotEntities > limit ) {
+				Com_RunJobs( SV_WriteSnapshotJob, sv_snapshotJobs + first, i - first, numThreads );
+				first = i;
+				limit = 0x7fffffff;
+			}
+			SV_AllocSnapshotEntities( frame, job->entityNumbers.numSnapshotEntities );
+			SV_AddSnapshotStats( &job->entityNumbers );
+		}
+
+		if ( job->bot ) {
+			continue;
+		}
+
+		job->oldframe = SV_SnapshotDeltaFrame( c, &job->lastframe );
+		if ( job->oldframe && job->oldframe->first_entity + svs.numSnapshotEntities < limit ) {
+			limit = job->oldframe->first_entity + svs.numSnapshotEntities;
+		}
 	}
 
-	SV_SendMessageToClient( &msg, client );
+	Com_RunJobs( SV_WriteSnapshotJob, sv_snapshotJobs + first, numJobs - first, numThreads );
+
+	sv_deltaCache.threaded = qfalse;
+
+	// send in client order
+	for ( i = 0 ; i < numJobs ; i++ ) {
+		job = &sv_snapshotJobs[i];
+		c = job->client;
+
+		if ( !job->bot ) {
+			SV_FinishClientSnapshot( c, &job->msg );
+		}
+		c->lastSnapshotTime = svs.time;
+		c->rateDelayed = qfalse;
+	}
 }
 
 
@@ -644,6 +1260,24 @@ void SV_SendClientMessages(void)
 {
 	int		i;
 	client_t	*c;
+	int		startTime;
+	int		numJobs;
+
+	Com_Memset( &sv_snapshotStatsFrame, 0, sizeof( sv_snapshotStatsFrame ) );
+	startTime = Sys_Milliseconds();
+
+	// filter out entities that can't be sent to anyone once for all clients
+	SV_BuildSnapshotCandidates();
+	sv_snapshotCandidatesValid = qtrue;
+
+	// entity states don't change until we are done, so deltas can be shared
+	SV_ClearDeltaCache();
+	sv_deltaCache.active = qtrue;
+
+	numJobs = 0;
+
+	// snapshots go out together after the loop
+	Sys_BeginPacketBatch();
 
 	// send a message to each connected client
 	for(i=0; i < sv_maxclients->integer; i++)
@@ -677,9 +1311,35 @@ void SV_SendClientMessages(void)
 			}
 		}
 
+		// leave it to the worker threads
+		if(SV_SnapshotThreads() > 1)
+		{
+			sv_snapshotJobs[numJobs++].client = c;
+			continue;
+		}
+
 		// generate and send a new message
 		SV_SendClientSnapshot(c);
 		c->lastSnapshotTime = svs.time;
 		c->rateDelayed = qfalse;
 	}
+
+	if(numJobs)
+		SV_SendClientSnapshots(numJobs);
+
+	Sys_EndPacketBatch();
+
+	sv_snapshotCandidatesValid = qfalse;
+	sv_deltaCache.active = qfalse;
+
+	if ( sv_snapshotStats->integer && sv_snapshotStatsFrame.snapshots ) {
+		sv_snapshotStatsFrame.msec = Sys_Milliseconds() - startTime;
+		Com_Printf( "snapshots:%i views:%i candidates:%i/%i tested:%i skipped:%i deltas:%i/%i cached msec:%i\n",
+			sv_snapshotStatsFrame.snapshots, sv_snapshotStatsFrame.viewpoints,
+			sv_snapshotStatsFrame.candidates, sv.num_entities,
+			sv_snapshotStatsFrame.tested,
+			sv_snapshotStatsFrame.fullScan - sv_snapshotStatsFrame.tested,
+			sv_deltaCache.hits, sv_deltaCache.hits + sv_deltaCache.misses,
+			sv_snapshotStatsFrame.msec );
+	}
 }
@@ -58,6 +58,13 @@ the world is carved up with an evenly spaced, axially aligned bsp tree.  Entitie
 are kept in chains either at the final leafs, or at the first node that splits
 them, which prevents having to deal with multiple fragments of a single entity.
 
+With sv_broadphase 1 the world is instead covered by a loose uniform grid on
+the horizontal plane.  An entity goes in the single cell that holds the center
+of its box, and every box in a cell stays within one cell size of the cell's
+edges, so a query only has to look at the cells its box touches once grown by
+that much.  Entities too wide for that are kept in one extra chain that
+every query checks.
+
 ===============================================================================
 */
 
@@ -74,6 +81,29 @@ typedef struct worldSector_s {
 worldSector_t	sv_worldSectors[AREA_NODES];
 int			sv_numworldSectors;
 
+#define	GRID_SIZE			64		// maximum cells along each axis
+#define	GRID_MIN_CELLSIZE	128
+#define	GRID_CELLS			(GRID_SIZE*GRID_SIZE)
+
+typedef struct {
+	qboolean	active;
+	float		origin[2];
+	float		cellSize;		// also the loose margin around each cell
+	int			size[2];
+	worldSector_t	cells[GRID_CELLS];
+	worldSector_t	large;		// entities that don't fit a cell
+} worldGrid_t;
+
+static worldGrid_t	sv_worldGrid;
+
+// boxes given to SV_AreaEntities after "sv_broadphasebench record",
+// until the list is full
+#define	MAX_AREA_QUERIES	4096
+
+static vec3_t	sv_areaQueries[MAX_AREA_QUERIES][2];
+static int		sv_numAreaQueries;
+static qboolean	sv_recordAreaQueries;
+
 
 /*
 ===============
@@ -85,6 +115,26 @@ void SV_SectorList_f( void ) {
 	worldSector_t	*sec;
 	svEntity_t		*ent;
 
+	if ( sv_worldGrid.active ) {
+		for ( i = 0 ; i <= GRID_CELLS ; i++ ) {
+			sec = i == GRID_CELLS ? &sv_worldGrid.large : &sv_worldGrid.cells[i];
+
+			c = 0;
+			for ( ent = sec->entities ; ent ; ent = ent->nextEntityInWorldSector ) {
+				c++;
+			}
+			if ( !c ) {
+				continue;
+			}
+			if ( sec == &sv_worldGrid.large ) {
+				Com_Printf( "large: %i entities\n", c );
+			} else {
+				Com_Printf( "cell %i %i: %i entities\n", i % GRID_SIZE, i / GRID_SIZE, c );
+			}
+		}
+		return;
+	}
+
 	for ( i = 0 ; i < AREA_NODES ; i++ ) {
 		sec = &sv_worldSectors[i];
 
@@ -138,6 +188,38 @@ static worldSector_t *SV_CreateworldSector( int depth, vec3_t mins, vec3_t maxs
 	return anode;
 }
 
+/*
+===============
+SV_CreateWorldGrid
+
+Picks a cell size that covers the world with at most GRID_SIZE cells a side
+===============
+*/
+static void SV_CreateWorldGrid( vec3_t mins, vec3_t maxs ) {
+	int		i;
+	float	extent;
+
+	Com_Memset( &sv_worldGrid, 0, sizeof( sv_worldGrid ) );
+
+	extent = MAX( maxs[0] - mins[0], maxs[1] - mins[1] );
+	sv_worldGrid.cellSize = MAX( GRID_MIN_CELLSIZE, ceil( extent / GRID_SIZE ) );
+
+	for ( i = 0 ; i < 2 ; i++ ) {
+		sv_worldGrid.origin[i] = mins[i];
+		sv_worldGrid.size[i] = ceil( ( maxs[i] - mins[i] ) / sv_worldGrid.cellSize );
+		if ( sv_worldGrid.size[i] < 1 ) {
+			sv_worldGrid.size[i] = 1;
+		} else if ( sv_worldGrid.size[i] > GRID_SIZE ) {
+			sv_worldGrid.size[i] = GRID_SIZE;
+		}
+	}
+
+	for ( i = 0 ; i < GRID_CELLS ; i++ ) {
+		sv_worldGrid.cells[i].axis = -1;
+	}
+	sv_worldGrid.large.axis = -1;
+}
+
 /*
 ===============
 SV_ClearWorld
@@ -150,13 +232,77 @@ void SV_ClearWorld( void ) {
 
 	Com_Memset( sv_worldSectors, 0, sizeof(sv_worldSectors) );
 	sv_numworldSectors = 0;
+	sv_numAreaQueries = 0;
 
 	// get world map bounds
 	h = CM_InlineModel( 0 );
 	CM_ModelBounds( h, mins, maxs );
 	SV_CreateworldSector( 0, mins, maxs );
+	SV_CreateWorldGrid( mins, maxs );
+
+	sv_worldGrid.active = ( sv_broadphase->integer == 1 );
 }
 
+/*
+===============
+SV_GridCoord
+
+Cell index along an axis.  Anything off the grid goes in the edge cells,
+which keeps their boxes within reach of every query that gets clamped there
+===============
+*/
+static int SV_GridCoord( float v, int axis ) {
+	float	f;
+
+	f = ( v - sv_worldGrid.origin[axis] ) / sv_worldGrid.cellSize;
+	if ( f < 0 ) {
+		return 0;
+	}
+	if ( f >= sv_worldGrid.size[axis] ) {
+		return sv_worldGrid.size[axis] - 1;
+	}
+	return (int)f;
+}
+
+/*
+===============
+SV_SectorForBox
+
+Returns the world sector or grid cell that an absolute box gets chained in
+===============
+*/
+static worldSector_t *SV_SectorForBox( const vec3_t absmin, const vec3_t absmax ) {
+	worldSector_t	*node;
+	int				i, cell[2];
+	float			center;
+
+	if ( sv_worldGrid.active ) {
+		for ( i = 0 ; i < 2 ; i++ ) {
+			if ( absmax[i] - absmin[i] > 2 * sv_worldGrid.cellSize ) {
+				return &sv_worldGrid.large;
+			}
+			center = 0.5f * ( absmin[i] + absmax[i] );
+			cell[i] = SV_GridCoord( center, i );
+		}
+		return &sv_worldGrid.cells[cell[1] * GRID_SIZE + cell[0]];
+	}
+
+	// find the first world sector node that the box crosses
+	node = sv_worldSectors;
+	while (1)
+	{
+		if (node->axis == -1)
+			break;
+		if ( absmin[node->axis] > node->dist)
+			node = node->children[0];
+		else if ( absmax[node->axis] < node->dist)
+			node = node->children[1];
+		else
+			break;		// crosses the node
+	}
+
+	return node;
+}
 
 /*
 ===============
@@ -215,7 +361,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	ent = SV_SvEntityForGentity( gEnt );
 
-	if ( ent->worldSector ) {
+	// a grid cell usually stays the same as the entity moves,
+	// so it is only unlinked below if it has to change
+	if ( ent->worldSector && !sv_worldGrid.active ) {
 		SV_UnlinkEntity( gEnt );	// unlink from old position
 	}
 
@@ -291,6 +439,9 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 	// if none of the leafs were inside the map, the
 	// entity is outside the world and can be considered unlinked
 	if ( !num_leafs ) {
+		if ( ent->worldSector ) {
+			SV_UnlinkEntity( gEnt );
+		}
 		return;
 	}
 
@@ -332,24 +483,18 @@ void SV_LinkEntity( sharedEntity_t *gEnt ) {
 
 	gEnt->r.linkcount++;
 
-	// find the first world sector node that the ent's box crosses
-	node = sv_worldSectors;
-	while (1)
-	{
-		if (node->axis == -1)
-			break;
-		if ( gEnt->r.absmin[node->axis] > node->dist)
-			node = node->children[0];
-		else if ( gEnt->r.absmax[node->axis] < node->dist)
-			node = node->children[1];
-		else
-			break;		// crosses the node
+	node = SV_SectorForBox( gEnt->r.absmin, gEnt->r.absmax );
+
+	if ( ent->worldSector != node ) {
+		if ( ent->worldSector ) {
+			SV_UnlinkEntity( gEnt );
+		}
+
+		// link it in
+		ent->worldSector = node;
+		ent->nextEntityInWorldSector = node->entities;
+		node->entities = ent;
 	}
-	
-	// link it in
-	ent->worldSector = node;
-	ent->nextEntityInWorldSector = node->entities;
-	node->entities = ent;
 
 	gEnt->r.linked = qtrue;
 }
@@ -374,11 +519,12 @@ typedef struct {
 
 /*
 ====================
-SV_AreaEntities_r
+SV_AreaEntitiesInSector
 
+Returns qfalse if the list filled up
 ====================
 */
-static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
+static qboolean SV_AreaEntitiesInSector( worldSector_t *node, areaParms_t *ap ) {
 	svEntity_t	*check, *next;
 	sharedEntity_t *gcheck;
 
@@ -398,12 +544,26 @@ static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 
 		if ( ap->count == ap->maxcount ) {
 			Com_Printf ("SV_AreaEntities: MAXCOUNT\n");
-			return;
+			return qfalse;
 		}
 
 		ap->list[ap->count] = check - sv.svEntities;
 		ap->count++;
 	}
+
+	return qtrue;
+}
+
+/*
+====================
+SV_AreaEntities_r
+
+====================
+*/
+static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
+	if ( !SV_AreaEntitiesInSector( node, ap ) ) {
+		return;
+	}
 	
 	if (node->axis == -1) {
 		return;		// terminal node
@@ -418,12 +578,41 @@ static void SV_AreaEntities_r( worldSector_t *node, areaParms_t *ap ) {
 	}
 }
 
+/*
+====================
+SV_AreaEntitiesGrid
+
+====================
+*/
+static void SV_AreaEntitiesGrid( areaParms_t *ap ) {
+	int		x, y, mins[2], maxs[2];
+	int		i;
+
+	if ( !SV_AreaEntitiesInSector( &sv_worldGrid.large, ap ) ) {
+		return;
+	}
+
+	// a cell's entities reach up to a cell size beyond it
+	for ( i = 0 ; i < 2 ; i++ ) {
+		mins[i] = SV_GridCoord( ap->mins[i] - sv_worldGrid.cellSize, i );
+		maxs[i] = SV_GridCoord( ap->maxs[i] + sv_worldGrid.cellSize, i );
+	}
+
+	for ( y = mins[1] ; y <= maxs[1] ; y++ ) {
+		for ( x = mins[0] ; x <= maxs[0] ; x++ ) {
+			if ( !SV_AreaEntitiesInSector( &sv_worldGrid.cells[y * GRID_SIZE + x], ap ) ) {
+				return;
+			}
+		}
+	}
+}
+
 /*
 ================
-SV_AreaEntities
+SV_FindAreaEntities
 ================
 */
-int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
+static int SV_FindAreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
 	areaParms_t		ap;
 
 	ap.mins = mins;
@@ -432,11 +621,153 @@ int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int
 	ap.count = 0;
 	ap.maxcount = maxcount;
 
-	SV_AreaEntities_r( sv_worldSectors, &ap );
+	if ( sv_worldGrid.active ) {
+		SV_AreaEntitiesGrid( &ap );
+	} else {
+		SV_AreaEntities_r( sv_worldSectors, &ap );
+	}
 
 	return ap.count;
 }
 
+/*
+================
+SV_AreaEntities
+================
+*/
+int SV_AreaEntities( const vec3_t mins, const vec3_t maxs, int *entityList, int maxcount ) {
+	if ( sv_recordAreaQueries ) {
+		VectorCopy( mins, sv_areaQueries[sv_numAreaQueries][0] );
+		VectorCopy( maxs, sv_areaQueries[sv_numAreaQueries][1] );
+		if ( ++sv_numAreaQueries == MAX_AREA_QUERIES ) {
+			sv_recordAreaQueries = qfalse;
+		}
+	}
+
+	return SV_FindAreaEntities( mins, maxs, entityList, maxcount );
+}
+
+/*
+================
+SV_RelinkWorld
+
+Moves every linked entity over to the tree or the grid
+================
+*/
+static void SV_RelinkWorld( qboolean grid ) {
+	int				i;
+	svEntity_t		*ent;
+	sharedEntity_t	*gEnt;
+	worldSector_t	*node;
+
+	for ( i = 0 ; i < sv_numworldSectors ; i++ ) {
+		sv_worldSectors[i].entities = NULL;
+	}
+	for ( i = 0 ; i < GRID_CELLS ; i++ ) {
+		sv_worldGrid.cells[i].entities = NULL;
+	}
+	sv_worldGrid.large.entities = NULL;
+	sv_worldGrid.active = grid;
+
+	for ( i = 0 ; i < sv.num_entities ; i++ ) {
+		ent = &sv.svEntities[i];
+		if ( !ent->worldSector ) {
+			continue;
+		}
+		gEnt = SV_GentityNum( i );
+		node = SV_SectorForBox( gEnt->r.absmin, gEnt->r.absmax );
+		ent->worldSector = node;
+		ent->nextEntityInWorldSector = node->entities;
+		node->entities = ent;
+	}
+}
+
+/*
+================
+SV_ReplayAreaQueries
+
+Returns a checksum of the entities found, independent of their order
+================
+*/
+static unsigned SV_ReplayAreaQueries( int numQueries, int iterations, int *msec ) {
+	int			touch[MAX_GENTITIES];
+	int			i, j, k, num, start;
+	unsigned	sum;
+
+	sum = 0;
+	start = Sys_Milliseconds();
+	for ( i = 0 ; i < iterations ; i++ ) {
+		for ( j = 0 ; j < numQueries ; j++ ) {
+			num = SV_FindAreaEntities( sv_areaQueries[j][0], sv_areaQueries[j][1], touch, MAX_GENTITIES );
+			if ( i ) {
+				continue;
+			}
+			for ( k = 0 ; k < num ; k++ ) {
+				sum += ( touch[k] + 1 ) * 2654435761u ^ ( j + 1 );
+			}
+		}
+	}
+	*msec = Sys_Milliseconds() - start;
+
+	return sum;
+}
+
+/*
+================
+SV_BroadphaseBench_f
+
+With "record", keeps the next few thousand area queries.  Otherwise
+replays the recorded ones against the tree and the grid.
+================
+*/
+void SV_BroadphaseBench_f( void ) {
+	int			iterations, numQueries;
+	int			treeMsec, gridMsec;
+	unsigned	treeSum, gridSum;
+	qboolean	wasGrid;
+
+	if ( sv.state != SS_GAME ) {
+		Com_Printf( "Server is not running.\n" );
+		return;
+	}
+
+	if ( !Q_stricmp( Cmd_Argv( 1 ), "record" ) ) {
+		sv_numAreaQueries = 0;
+		sv_recordAreaQueries = qtrue;
+		Com_Printf( "Recording the next %i area queries.\n", MAX_AREA_QUERIES );
+		return;
+	}
+
+	sv_recordAreaQueries = qfalse;
+	numQueries = sv_numAreaQueries;
+	if ( !numQueries ) {
+		Com_Printf( "No area queries recorded, use \"sv_broadphasebench record\" first.\n" );
+		return;
+	}
+
+	iterations = 100;
+	if ( Cmd_Argc() > 1 ) {
+		iterations = atoi( Cmd_Argv( 1 ) );
+		if ( iterations < 1 ) {
+			iterations = 1;
+		}
+	}
+
+	wasGrid = sv_worldGrid.active;
+	SV_RelinkWorld( qfalse );
+	treeSum = SV_ReplayAreaQueries( numQueries, iterations, &treeMsec );
+	SV_RelinkWorld( qtrue );
+	gridSum = SV_ReplayAreaQueries( numQueries, iterations, &gridMsec );
+	SV_RelinkWorld( wasGrid );
+
+	Com_Printf( "%i queries x %i: tree %i msec, grid %i msec (cell size %g, %ix%i)\n",
+		numQueries, iterations, treeMsec, gridMsec,
+		sv_worldGrid.cellSize, sv_worldGrid.size[0], sv_worldGrid.size[1] );
+	if ( treeSum != gridSum ) {
+		Com_Printf( S_COLOR_YELLOW "WARNING: tree and grid found different entities\n" );
+	}
+}
+
 
 
 //===========================================================================
@@ -501,19 +832,18 @@ void SV_ClipToEntity( trace_t *trace, const vec3_t start, const vec3_t mins, con
 ====================
 SV_ClipMoveToEntities
 
+touchlist can hold more entities than the move's box touches, when it was
+gathered for a whole batch of moves
 ====================
 */
-static void SV_ClipMoveToEntities( moveclip_t *clip ) {
-	int			i, num;
-	int			touchlist[MAX_GENTITIES];
+static void SV_ClipMoveToEntities( moveclip_t *clip, const int *touchlist, int num ) {
+	int			i;
 	sharedEntity_t *touch;
 	int			passOwnerNum;
 	trace_t		trace;
 	clipHandle_t	clipHandle;
 	float		*origin, *angles;
 
-	num = SV_AreaEntities( clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
-
 	if ( clip->passEntityNum != ENTITYNUM_NONE ) {
 		passOwnerNum = ( SV_GentityNum( clip->passEntityNum ) )->r.ownerNum;
 		if ( passOwnerNum == ENTITYNUM_NONE ) {
@@ -529,6 +859,15 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 		}
 		touch = SV_GentityNum( touchlist[i] );
 
+		if ( touch->r.absmin[0] > clip->boxmaxs[0]
+			|| touch->r.absmin[1] > clip->boxmaxs[1]
+			|| touch->r.absmin[2] > clip->boxmaxs[2]
+			|| touch->r.absmax[0] < clip->boxmins[0]
+			|| touch->r.absmax[1] < clip->boxmins[1]
+			|| touch->r.absmax[2] < clip->boxmins[2] ) {
+			continue;	// not near this move
+		}
+
 		// see if we should ignore this entity
 		if ( clip->passEntityNum != ENTITYNUM_NONE ) {
 			if ( touchlist[i] == clip->passEntityNum ) {
@@ -585,6 +924,43 @@ static void SV_ClipMoveToEntities( moveclip_t *clip ) {
 }
 
 
+/*
+==================
+SV_InitMoveClip
+
+Sets up the entity pass for a move that has already been clipped to the world
+==================
+*/
+static void SV_InitMoveClip( moveclip_t *clip, const trace_t *worldTrace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
+	int			i;
+
+	Com_Memset ( clip, 0, sizeof ( moveclip_t ) );
+
+	clip->trace = *worldTrace;
+	clip->contentmask = contentmask;
+	clip->start = start;
+//	VectorCopy( clip->trace.endpos, clip->end );
+	VectorCopy( end, clip->end );
+	clip->mins = mins;
+	clip->maxs = maxs;
+	clip->passEntityNum = passEntityNum;
+	clip->capsule = capsule;
+
+	// create the bounding box of the entire move
+	// we can limit it to the part of the move not
+	// already clipped off by the world, which can be
+	// a significant savings for line of sight and shot traces
+	for ( i=0 ; i<3 ; i++ ) {
+		if ( end[i] > start[i] ) {
+			clip->boxmins[i] = clip->start[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->end[i] + clip->maxs[i] + 1;
+		} else {
+			clip->boxmins[i] = clip->end[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->start[i] + clip->maxs[i] + 1;
+		}
+	}
+}
+
 /*
 ==================
 SV_Trace
@@ -595,7 +971,8 @@ passEntityNum and entities owned by passEntityNum are explicitly not checked.
 */
 void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, int capsule ) {
 	moveclip_t	clip;
-	int			i;
+	int			touchlist[MAX_GENTITIES];
+	int			num;
 
 	if ( !mins ) {
 		mins = vec3_origin;
@@ -604,43 +981,65 @@ void SV_Trace( trace_t *results, const vec3_t start, vec3_t mins, vec3_t maxs, c
 		maxs = vec3_origin;
 	}
 
-	Com_Memset ( &clip, 0, sizeof ( moveclip_t ) );
-
 	// clip to world
-	CM_BoxTrace( &clip.trace, start, end, mins, maxs, 0, contentmask, capsule );
-	clip.trace.entityNum = clip.trace.fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
-	if ( clip.trace.fraction == 0 ) {
-		*results = clip.trace;
+	CM_BoxTrace( results, start, end, mins, maxs, 0, contentmask, capsule );
+	results->entityNum = results->fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+	if ( results->fraction == 0 ) {
 		return;		// blocked immediately by the world
 	}
 
-	clip.contentmask = contentmask;
-	clip.start = start;
-//	VectorCopy( clip.trace.endpos, clip.end );
-	VectorCopy( end, clip.end );
-	clip.mins = mins;
-	clip.maxs = maxs;
-	clip.passEntityNum = passEntityNum;
-	clip.capsule = capsule;
+	// clip to other solid entities
+	SV_InitMoveClip( &clip, results, start, mins, maxs, end, passEntityNum, contentmask, capsule );
+	num = SV_AreaEntities( clip.boxmins, clip.boxmaxs, touchlist, MAX_GENTITIES );
+	SV_ClipMoveToEntities( &clip, touchlist, num );
 
-	// create the bounding box of the entire move
-	// we can limit it to the part of the move not
-	// already clipped off by the world, which can be
-	// a significant savings for line of sight and shot traces
-	for ( i=0 ; i<3 ; i++ ) {
-		if ( end[i] > start[i] ) {
-			clip.boxmins[i] = clip.start[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.end[i] + clip.maxs[i] + 1;
-		} else {
-			clip.boxmins[i] = clip.end[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.start[i] + clip.maxs[i] + 1;
+	*results = clip.trace;
+}
+
+/*
+==================
+SV_TraceMany
+
+SV_Trace for a batch of moves that share the entity to skip and the contents.
+The entities are gathered once for the box around the whole batch, so it
+pays off for bursts of nearby moves like pellets or movement probes.
+==================
+*/
+void SV_TraceMany( trace_t *results, const traceRequest_t *requests, int count, int passEntityNum, int contentmask, int capsule ) {
+	moveclip_t	clip;
+	int			touchlist[MAX_GENTITIES];
+	int			i, num;
+	vec3_t		boxmins, boxmaxs;
+
+	// clip to world
+	CM_TraceMany( results, requests, count, 0, contentmask, capsule );
+
+	ClearBounds( boxmins, boxmaxs );
+	for ( i = 0 ; i < count ; i++ ) {
+		results[i].entityNum = results[i].fraction != 1.0 ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+		if ( results[i].fraction == 0 ) {
+			continue;	// blocked immediately by the world
 		}
+		SV_InitMoveClip( &clip, &results[i], requests[i].start, requests[i].mins, requests[i].maxs,
+			requests[i].end, passEntityNum, contentmask, capsule );
+		AddPointToBounds( clip.boxmins, boxmins, boxmaxs );
+		AddPointToBounds( clip.boxmaxs, boxmins, boxmaxs );
+	}
+	if ( boxmins[0] > boxmaxs[0] ) {
+		return;		// every move was blocked by the world
 	}
 
-	// clip to other solid entities
-	SV_ClipMoveToEntities ( &clip );
-
-	*results = clip.trace;
+	// clip to other solid entities, with one area query for the batch
+	num = SV_AreaEntities( boxmins, boxmaxs, touchlist, MAX_GENTITIES );
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( results[i].fraction == 0 ) {
+			continue;
+		}
+		SV_InitMoveClip( &clip, &results[i], requests[i].start, requests[i].mins, requests[i].maxs,
+			requests[i].end, passEntityNum, contentmask, capsule );
+		SV_ClipMoveToEntities( &clip, touchlist, num );
+		results[i] = clip.trace;
+	}
 }
 
 
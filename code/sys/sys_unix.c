@@ -38,6 +38,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <fcntl.h>
 #include <fenv.h>
 #include <sys/wait.h>
+#include <pthread.h>
 
 qboolean stdinIsATTY;
 
@@ -532,6 +533,191 @@ void Sys_Sleep( int msec )
 	}
 }
 
+/*
+==============================================================================
+
+Threads
+
+Thin wrappers around pthreads used by the Com_RunJobs worker pool.
+Handles are created and destroyed from the main thread only.
+
+==============================================================================
+*/
+
+typedef struct {
+	pthread_t	thread;
+	void		(*function)( void *arg );
+	void		*arg;
+} sysThread_t;
+
+typedef struct {
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	int				count;
+} sysSemaphore_t;
+
+/*
+==================
+Sys_ProcessorCount
+==================
+*/
+int Sys_ProcessorCount( void )
+{
+	long count = sysconf( _SC_NPROCESSORS_ONLN );
+
+	if( count < 1 )
+		return 1;
+
+	return (int)count;
+}
+
+static void *Sys_ThreadMain( void *data )
+{
+	sysThread_t *thread = data;
+
+	thread->function( thread->arg );
+	return NULL;
+}
+
+/*
+==================
+Sys_CreateThread
+
+Returns NULL if the thread could not be started
+==================
+*/
+void *Sys_CreateThread( void (*function)( void *arg ), void *arg )
+{
+	sysThread_t *thread = Z_Malloc( sizeof( *thread ) );
+
+	thread->function = function;
+	thread->arg = arg;
+
+	if( pthread_create( &thread->thread, NULL, Sys_ThreadMain, thread ) != 0 )
+	{
+		Z_Free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+==================
+Sys_JoinThread
+==================
+*/
+void Sys_JoinThread( void *handle )
+{
+	sysThread_t *thread = handle;
+
+	pthread_join( thread->thread, NULL );
+	Z_Free( thread );
+}
+
+void *Sys_CreateMutex( void )
+{
+	pthread_mutex_t *mutex = Z_Malloc( sizeof( *mutex ) );
+
+	pthread_mutex_init( mutex, NULL );
+	return mutex;
+}
+
+void Sys_DestroyMutex( void *mutex )
+{
+	pthread_mutex_destroy( mutex );
+	Z_Free( mutex );
+}
+
+void Sys_LockMutex( void *mutex )
+{
+	pthread_mutex_lock( mutex );
+}
+
+void Sys_UnlockMutex( void *mutex )
+{
+	pthread_mutex_unlock( mutex );
+}
+
+/*
+==================
+Sys_CreateSemaphore
+
+Unnamed POSIX semaphores are not available everywhere (OS X),
+so counting semaphores are built from a mutex and a condition
+==================
+*/
+void *Sys_CreateSemaphore( void )
+{
+	sysSemaphore_t *sem = Z_Malloc( sizeof( *sem ) );
+
+	pthread_mutex_init( &sem->mutex, NULL );
+	pthread_cond_init( &sem->cond, NULL );
+	sem->count = 0;
+	return sem;
+}
+
+void Sys_DestroySemaphore( void *handle )
+{
+	sysSemaphore_t *sem = handle;
+
+	pthread_cond_destroy( &sem->cond );
+	pthread_mutex_destroy( &sem->mutex );
+	Z_Free( sem );
+}
+
+void Sys_WaitSemaphore( void *handle )
+{
+	sysSemaphore_t *sem = handle;
+
+	pthread_mutex_lock( &sem->mutex );
+	while( sem->count <= 0 )
+		pthread_cond_wait( &sem->cond, &sem->mutex );
+	sem->count--;
+	pthread_mutex_unlock( &sem->mutex );
+}
+
+// returns qfalse if msec passed before the semaphore was posted
+qboolean Sys_TimedWaitSemaphore( void *handle, int msec )
+{
+	sysSemaphore_t *sem = handle;
+	struct timeval now;
+	struct timespec until;
+	qboolean posted;
+
+	gettimeofday( &now, NULL );
+	until.tv_sec = now.tv_sec + msec / 1000;
+	until.tv_nsec = ( now.tv_usec + ( msec % 1000 ) * 1000 ) * 1000;
+	if( until.tv_nsec >= 1000000000 )
+	{
+		until.tv_sec++;
+		until.tv_nsec -= 1000000000;
+	}
+
+	pthread_mutex_lock( &sem->mutex );
+	while( sem->count <= 0 )
+	{
+		if( pthread_cond_timedwait( &sem->cond, &sem->mutex, &until ) != 0 )
+			break;
+	}
+	posted = ( sem->count > 0 );
+	if( posted )
+		sem->count--;
+	pthread_mutex_unlock( &sem->mutex );
+
+	return posted;
+}
+
+void Sys_PostSemaphore( void *handle )
+{
+	sysSemaphore_t *sem = handle;
+
+	pthread_mutex_lock( &sem->mutex );
+	sem->count++;
+	pthread_cond_signal( &sem->cond );
+	pthread_mutex_unlock( &sem->mutex );
+}
+
 /*
 ==============
 Sys_ErrorDialog
@@ -658,6 +658,136 @@ void Sys_Sleep( int msec )
 #endif
 }
 
+/*
+==============================================================================
+
+Threads
+
+Thin wrappers around Win32 threads used by the Com_RunJobs worker pool.
+Handles are created and destroyed from the main thread only.
+
+==============================================================================
+*/
+
+typedef struct {
+	HANDLE		thread;
+	void		(*function)( void *arg );
+	void		*arg;
+} sysThread_t;
+
+/*
+==============
+Sys_ProcessorCount
+==============
+*/
+int Sys_ProcessorCount( void )
+{
+	SYSTEM_INFO info;
+
+	GetSystemInfo( &info );
+
+	if( info.dwNumberOfProcessors < 1 )
+		return 1;
+
+	return (int)info.dwNumberOfProcessors;
+}
+
+static DWORD WINAPI Sys_ThreadMain( LPVOID data )
+{
+	sysThread_t *thread = data;
+
+	thread->function( thread->arg );
+	return 0;
+}
+
+/*
+==============
+Sys_CreateThread
+
+Returns NULL if the thread could not be started
+==============
+*/
+void *Sys_CreateThread( void (*function)( void *arg ), void *arg )
+{
+	sysThread_t *thread = Z_Malloc( sizeof( *thread ) );
+
+	thread->function = function;
+	thread->arg = arg;
+	thread->thread = CreateThread( NULL, 0, Sys_ThreadMain, thread, 0, NULL );
+
+	if( !thread->thread )
+	{
+		Z_Free( thread );
+		return NULL;
+	}
+
+	return thread;
+}
+
+/*
+==============
+Sys_JoinThread
+==============
+*/
+void Sys_JoinThread( void *handle )
+{
+	sysThread_t *thread = handle;
+
+	WaitForSingleObject( thread->thread, INFINITE );
+	CloseHandle( thread->thread );
+	Z_Free( thread );
+}
+
+void *Sys_CreateMutex( void )
+{
+	CRITICAL_SECTION *mutex = Z_Malloc( sizeof( *mutex ) );
+
+	InitializeCriticalSection( mutex );
+	return mutex;
+}
+
+void Sys_DestroyMutex( void *mutex )
+{
+	DeleteCriticalSection( mutex );
+	Z_Free( mutex );
+}
+
+void Sys_LockMutex( void *mutex )
+{
+	EnterCriticalSection( mutex );
+}
+
+void Sys_UnlockMutex( void *mutex )
+{
+	LeaveCriticalSection( mutex );
+}
+
+void *Sys_CreateSemaphore( void )
+{
+	return CreateSemaphore( NULL, 0, 0x7fffffff, NULL );
+}
+
+void Sys_DestroySemaphore( void *sem )
+{
+	CloseHandle( sem );
+}
+
+void Sys_WaitSemaphore( void *sem )
+{
+	WaitForSingleObject( sem, INFINITE );
+}
+
+// returns qfalse if msec passed before the semaphore was posted
+qboolean Sys_TimedWaitSemaphore( void *sem, int msec )
+{
+	return WaitForSingleObject( sem, msec ) == WAIT_OBJECT_0;
+}
+
+void Sys_PostSemaphore( void *sem )
+{
+	ReleaseSemaphore( sem, 1, NULL );
+}
+
 /*
 ==============
 Sys_ErrorDialog
@@ -0,0 +1,172 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// cmstress.c -- runs the same random traces on several threads at once and
+// checks every result against the one a single thread got
+//
+#include "testmap.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+
+#define	NUM_QUERIES		20000
+#define	NUM_THREADS		8
+#define	NUM_PASSES		4
+
+typedef struct {
+	vec3_t		start, end;
+	vec3_t		mins, maxs;
+	int			capsule;
+} query_t;
+
+typedef struct {
+	trace_t		trace;
+	int			contents;
+	int			numBrushes;
+} answer_t;
+
+static query_t		queries[NUM_QUERIES];
+static answer_t		expected[NUM_QUERIES];
+static int			mismatches[NUM_THREADS];
+
+/*
+=================
+MakeQueries
+
+Point traces, box traces, capsule traces and zero length position tests
+=================
+*/
+static void MakeQueries( void ) {
+	query_t		*q;
+	float		size;
+	int			i, j;
+
+	for ( i = 0 ; i < NUM_QUERIES ; i++ ) {
+		q = &queries[i];
+		for ( j = 0 ; j < 3 ; j++ ) {
+			q->start[j] = TestMap_Random( -TESTMAP_SIZE, TESTMAP_SIZE );
+			q->end[j] = q->start[j] + TestMap_Random( -400, 400 );
+		}
+		switch ( i & 3 ) {
+		case 0:
+			break;
+		case 3:
+			VectorCopy( q->start, q->end );
+			// fall through
+		case 2:
+			q->capsule = ( i & 4 ) != 0;
+			// fall through
+		case 1:
+			size = TestMap_Random( 4, 32 );
+			VectorSet( q->mins, -size, -size, -TestMap_Random( 4, 32 ) );
+			VectorSet( q->maxs, size, size, TestMap_Random( 4, 48 ) );
+			break;
+		}
+	}
+}
+
+/*
+=================
+RunQuery
+=================
+*/
+static void RunQuery( const query_t *q, answer_t *a ) {
+	cbrush_t	*list[64];
+	vec3_t		mins, maxs;
+
+	memset( a, 0, sizeof( *a ) );
+	CM_BoxTrace( &a->trace, q->start, q->end, (float *)q->mins, (float *)q->maxs, 0, CONTENTS_SOLID, q->capsule );
+	a->contents = CM_PointContents( q->end, 0 );
+
+	VectorAdd( q->start, q->mins, mins );
+	VectorAdd( q->start, q->maxs, maxs );
+	mins[0] -= 64; mins[1] -= 64;
+	maxs[0] += 64; maxs[1] += 64;
+	a->numBrushes = CM_BoxBrushes( mins, maxs, list, ARRAY_LEN( list ) );
+}
+
+/*
+=================
+StressThread
+=================
+*/
+static void *StressThread( void *arg ) {
+	answer_t	a;
+	int			thread, pass, i, n;
+
+	thread = (int)(intptr_t)arg;
+	for ( pass = 0 ; pass < NUM_PASSES ; pass++ ) {
+		// each thread walks the queries from a different place
+		for ( n = 0 ; n < NUM_QUERIES ; n++ ) {
+			i = ( n + thread * ( NUM_QUERIES / NUM_THREADS ) ) % NUM_QUERIES;
+			RunQuery( &queries[i], &a );
+			if ( memcmp( &a, &expected[i], sizeof( a ) ) ) {
+				mismatches[thread]++;
+			}
+		}
+	}
+	return NULL;
+}
+
+int main( int argc, char **argv ) {
+	pthread_t	threads[NUM_THREADS];
+	double		start, serial, threaded;
+	int			i, hits, bad;
+
+	TestMap_Seed( 1 );
+	TestMap_Load( 1500, 48, 8 );
+	MakeQueries();
+
+	hits = 0;
+	start = TestMap_Milliseconds();
+	for ( i = 0 ; i < NUM_QUERIES ; i++ ) {
+		RunQuery( &queries[i], &expected[i] );
+		if ( expected[i].trace.fraction < 1 || expected[i].trace.startsolid ) {
+			hits++;
+		}
+	}
+	serial = TestMap_Milliseconds() - start;
+	printf( "%d of %d queries hit something\n", hits, NUM_QUERIES );
+	printf( "1 thread  %7.2f us/query\n", serial * 1000 / NUM_QUERIES );
+
+	start = TestMap_Milliseconds();
+	for ( i = 0 ; i < NUM_THREADS ; i++ ) {
+		if ( pthread_create( &threads[i], NULL, StressThread, (void *)(intptr_t)i ) ) {
+			printf( "pthread_create failed\n" );
+			return 1;
+		}
+	}
+	bad = 0;
+	for ( i = 0 ; i < NUM_THREADS ; i++ ) {
+		pthread_join( threads[i], NULL );
+		bad += mismatches[i];
+	}
+	threaded = TestMap_Milliseconds() - start;
+	printf( "%d threads %7.2f us/query\n", NUM_THREADS, threaded * 1000 / ( NUM_QUERIES * NUM_PASSES * NUM_THREADS ) );
+	printf( "%d of %d threaded queries differ\n", bad, NUM_QUERIES * NUM_PASSES * NUM_THREADS );
+
+	if ( bad || !hits ) {
+		printf( "FAILED\n" );
+		return 1;
+	}
+	return 0;
+}
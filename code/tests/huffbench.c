@@ -0,0 +1,173 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// huffbench.c -- compares the flattened message Huffman tables with the
+// tree walk they replace, then times both on a million symbols
+//
+// msg.c is included so the static message tree can be reached
+#include "../qcommon/msg.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define	NUM_SEQUENCES	200000
+#define	NUM_SYMBOLS		( 1 << 20 )
+
+cvar_t	*cl_shownet;
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+static double Milliseconds( void ) {
+	return clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/*
+=================
+CompareSequences
+
+Random symbols and offsets up to and past small buffer limits, then
+random garbage to decode.  Returns the number of mismatches.
+=================
+*/
+static int CompareSequences( void ) {
+	static byte	b1[512], b2[512];
+	int			iter, i, bad;
+	int			maxoffset, o1, o2, ch, c1, c2;
+
+	bad = 0;
+	for ( iter = 0 ; iter < NUM_SEQUENCES ; iter++ ) {
+		maxoffset = rand() % 400;
+		memset( b1, rand() & 0xff, sizeof( b1 ) );
+		memcpy( b2, b1, sizeof( b2 ) );
+
+		o1 = o2 = rand() % 8;
+		for ( i = 0 ; i < 40 ; i++ ) {
+			ch = rand() & 0xff;
+			Huff_offsetTransmit( &msgHuff.compressor, ch, b1, &o1, maxoffset );
+			Huff_tableTransmit( &msgHuffTable, &msgHuff.compressor, ch, b2, &o2, maxoffset );
+		}
+		if ( o1 != o2 || memcmp( b1, b2, sizeof( b1 ) ) ) {
+			bad++;
+		}
+
+		for ( i = 0 ; i < sizeof( b1 ) ; i++ ) {
+			b1[i] = rand();
+		}
+		o1 = o2 = rand() % 16;
+		for ( i = 0 ; i < 60 ; i++ ) {
+			c1 = c2 = -1;
+			Huff_offsetReceive( msgHuff.decompressor.tree, &c1, b1, &o1, maxoffset );
+			Huff_tableReceive( &msgHuffTable, msgHuff.decompressor.tree, &c2, b1, &o2, maxoffset );
+			if ( c1 != c2 || o1 != o2 ) {
+				bad++;
+				break;
+			}
+		}
+	}
+	return bad;
+}
+
+/*
+=================
+TimeSymbols
+
+Mostly zero bytes, like the delta fields that go through MSG_WriteBits.
+Returns the number of symbols that didn't decode back.
+=================
+*/
+static int TimeSymbols( void ) {
+	static byte	syms[NUM_SYMBOLS], buf[NUM_SYMBOLS * 2];
+	double		start;
+	int			i, o, ch, len, bad;
+
+	for ( i = 0 ; i < NUM_SYMBOLS ; i++ ) {
+		syms[i] = ( rand() % 4 ) ? 0 : rand();
+	}
+	bad = 0;
+
+	start = Milliseconds();
+	for ( i = 0, o = 0 ; i < NUM_SYMBOLS ; i++ ) {
+		Huff_offsetTransmit( &msgHuff.compressor, syms[i], buf, &o, sizeof( buf ) * 8 );
+	}
+	printf( "tree  encode %6.2f ns/symbol\n", ( Milliseconds() - start ) * 1e6 / NUM_SYMBOLS );
+	len = o;
+
+	start = Milliseconds();
+	for ( i = 0, o = 0 ; i < NUM_SYMBOLS ; i++ ) {
+		Huff_tableTransmit( &msgHuffTable, &msgHuff.compressor, syms[i], buf, &o, sizeof( buf ) * 8 );
+	}
+	printf( "table encode %6.2f ns/symbol\n", ( Milliseconds() - start ) * 1e6 / NUM_SYMBOLS );
+	if ( o != len ) {
+		bad++;
+	}
+
+	start = Milliseconds();
+	for ( i = 0, o = 0 ; i < NUM_SYMBOLS ; i++ ) {
+		Huff_offsetReceive( msgHuff.decompressor.tree, &ch, buf, &o, len );
+		if ( ch != syms[i] ) {
+			bad++;
+		}
+	}
+	printf( "tree  decode %6.2f ns/symbol\n", ( Milliseconds() - start ) * 1e6 / NUM_SYMBOLS );
+
+	start = Milliseconds();
+	for ( i = 0, o = 0 ; i < NUM_SYMBOLS ; i++ ) {
+		Huff_tableReceive( &msgHuffTable, msgHuff.decompressor.tree, &ch, buf, &o, len );
+		if ( ch != syms[i] ) {
+			bad++;
+		}
+	}
+	printf( "table decode %6.2f ns/symbol\n", ( Milliseconds() - start ) * 1e6 / NUM_SYMBOLS );
+
+	return bad;
+}
+
+int main( int argc, char **argv ) {
+	int		bad;
+
+	MSG_initHuffman();
+	srand( 1 );
+
+	bad = CompareSequences();
+	printf( "%d of %d random sequences differ\n", bad, NUM_SEQUENCES );
+	bad += TimeSymbols();
+
+	if ( bad ) {
+		printf( "FAILED\n" );
+		return 1;
+	}
+	return 0;
+}
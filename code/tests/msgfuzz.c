@@ -0,0 +1,402 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// msgfuzz.c -- round trips random MSG_WriteBits / MSG_ReadBits sequences
+// and compares them with the bit at a time tree walk they replaced
+//
+// msg.c is included so the static message tree can be reached
+#include "../qcommon/msg.c"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define	NUM_SEQUENCES	300000
+#define	NUM_DELTAS		300000
+#define	MAX_FIELDS		64
+
+cvar_t	*cl_shownet;
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+static double Milliseconds( void ) {
+	return clock() * 1000.0 / CLOCKS_PER_SEC;
+}
+
+/*
+=================
+RefWriteBits
+
+MSG_WriteBits for bit packed messages before the fields were gathered
+into a word, one Huff_putBit and one tree walk at a time
+=================
+*/
+static void RefWriteBits( msg_t *msg, int value, int bits ) {
+	int		i, nbits;
+
+	if ( msg->overflowed ) {
+		return;
+	}
+	if ( bits < 0 ) {
+		bits = -bits;
+	}
+
+	value &= ( 0xffffffff >> ( 32 - bits ) );
+	if ( bits & 7 ) {
+		nbits = bits & 7;
+		if ( msg->bit + nbits > msg->maxsize << 3 ) {
+			msg->overflowed = qtrue;
+			return;
+		}
+		for ( i = 0 ; i < nbits ; i++ ) {
+			Huff_putBit( ( value & 1 ), msg->data, &msg->bit );
+			value = ( value >> 1 );
+		}
+		bits = bits - nbits;
+	}
+	for ( i = 0 ; i < bits ; i += 8 ) {
+		Huff_offsetTransmit( &msgHuff.compressor, ( value & 0xff ), msg->data, &msg->bit, msg->maxsize << 3 );
+		value = ( value >> 8 );
+		if ( msg->bit > msg->maxsize << 3 ) {
+			msg->overflowed = qtrue;
+			return;
+		}
+	}
+	msg->cursize = ( msg->bit >> 3 ) + 1;
+}
+
+/*
+=================
+RefReadBits
+
+The matching MSG_ReadBits, including the sign extension that only
+looks at the Huffman coded part of a field
+=================
+*/
+static int RefReadBits( msg_t *msg, int bits ) {
+	int			value, get;
+	qboolean	sgn;
+	int			i, nbits;
+
+	if ( msg->readcount > msg->cursize ) {
+		return 0;
+	}
+
+	value = 0;
+	sgn = ( bits < 0 );
+	if ( bits < 0 ) {
+		bits = -bits;
+	}
+
+	nbits = 0;
+	if ( bits & 7 ) {
+		nbits = bits & 7;
+		if ( msg->bit + nbits > msg->cursize << 3 ) {
+			msg->readcount = msg->cursize + 1;
+			return 0;
+		}
+		for ( i = 0 ; i < nbits ; i++ ) {
+			value |= ( Huff_getBit( msg->data, &msg->bit ) << i );
+		}
+		bits = bits - nbits;
+	}
+	for ( i = 0 ; i < bits ; i += 8 ) {
+		Huff_offsetReceive( msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize << 3 );
+		value = (unsigned int)value | ( (unsigned int)get << ( i + nbits ) );
+		if ( msg->bit > msg->cursize << 3 ) {
+			msg->readcount = msg->cursize + 1;
+			return 0;
+		}
+	}
+	msg->readcount = ( msg->bit >> 3 ) + 1;
+
+	if ( sgn && bits > 0 && bits < 32 ) {
+		if ( value & ( 1 << ( bits - 1 ) ) ) {
+			value |= -1 ^ ( ( 1 << bits ) - 1 );
+		}
+	}
+	return value;
+}
+
+/*
+=================
+RandomField
+=================
+*/
+static void RandomField( int *value, int *bits ) {
+	*bits = 1 + rand() % 32;
+	if ( rand() & 1 ) {
+		*bits = -( *bits < 32 ? *bits : 31 );
+	}
+
+	switch ( rand() % 3 ) {
+	case 0:
+		*value = rand() ^ ( rand() << 16 );
+		break;
+	case 1:
+		*value = -( rand() % 200 );
+		break;
+	default:
+		*value = rand() % 256;
+		break;
+	}
+}
+
+/*
+=================
+ExpectedValue
+
+What a field reads back as when it was written whole.  Signed fields
+that aren't a multiple of eight bits only extend from the Huffman part.
+=================
+*/
+static int ExpectedValue( int value, int bits ) {
+	int		huffBits;
+
+	if ( bits < 0 ) {
+		bits = -bits;
+		huffBits = bits - ( bits & 7 );
+		value &= ( 0xffffffff >> ( 32 - bits ) );
+		if ( huffBits > 0 && huffBits < 32 && ( value & ( 1 << ( huffBits - 1 ) ) ) ) {
+			value |= -1 ^ ( ( 1 << huffBits ) - 1 );
+		}
+		return value;
+	}
+	return value & ( 0xffffffff >> ( 32 - bits ) );
+}
+
+/*
+=================
+FuzzSequences
+
+Random fields written to random sized messages, most of which overflow,
+then read back whole, with different widths, truncated or as garbage.
+Returns the number of sequences that differ.
+=================
+*/
+static int FuzzSequences( void ) {
+	static byte	b1[4096], b2[4096];
+	msg_t		m1, m2;
+	int			values[MAX_FIELDS], sizes[MAX_FIELDS];
+	int			iter, i, k, ops, maxsize, bits, v1, v2, bad;
+	qboolean	differ;
+
+	bad = 0;
+	for ( iter = 0 ; iter < NUM_SEQUENCES ; iter++ ) {
+		differ = qfalse;
+		ops = rand() % MAX_FIELDS;
+		maxsize = ( rand() % 3 ) ? 1 + rand() % 64 : 2048;
+		memset( b1, rand() & 0xff, maxsize );
+		memcpy( b2, b1, maxsize );
+		MSG_Init( &m1, b1, maxsize );
+		MSG_Init( &m2, b2, maxsize );
+
+		for ( i = 0 ; i < ops ; i++ ) {
+			RandomField( &values[i], &sizes[i] );
+			MSG_WriteBits( &m1, values[i], sizes[i] );
+			RefWriteBits( &m2, values[i], sizes[i] );
+		}
+		if ( m1.bit != m2.bit || m1.cursize != m2.cursize || m1.overflowed != m2.overflowed
+			|| memcmp( b1, b2, maxsize ) ) {
+			differ = qtrue;
+		}
+
+		m1.readcount = m2.readcount = 0;
+		m1.bit = m2.bit = 0;
+		if ( !m1.overflowed && !( rand() % 4 ) ) {
+			// the written fields read back whole
+			for ( i = 0 ; i < ops ; i++ ) {
+				if ( MSG_ReadBits( &m1, sizes[i] ) != ExpectedValue( values[i], sizes[i] ) ) {
+					differ = qtrue;
+				}
+			}
+		} else {
+			if ( !( rand() % 4 ) ) {
+				m1.cursize = m2.cursize = rand() % ( m1.cursize + 1 );
+			}
+			if ( !( rand() % 4 ) ) {
+				for ( k = 0 ; k < maxsize ; k++ ) {
+					b1[k] = b2[k] = rand();
+				}
+			}
+			for ( i = 0 ; i < ops + 5 ; i++ ) {
+				bits = ( i < ops && ( rand() % 4 ) ) ? sizes[i] : 1 + rand() % 32;
+				v1 = MSG_ReadBits( &m1, bits );
+				v2 = RefReadBits( &m2, bits );
+				if ( v1 != v2 || m1.bit != m2.bit || m1.readcount != m2.readcount ) {
+					differ = qtrue;
+				}
+			}
+		}
+
+		if ( differ ) {
+			bad++;
+		}
+	}
+	return bad;
+}
+
+/*
+=================
+RandomEntityPair
+=================
+*/
+static void RandomEntityPair( entityState_t *from, entityState_t *to ) {
+	int		k;
+
+	memset( from, 0, sizeof( *from ) );
+	for ( k = 0 ; k < sizeof( *from ) / 4 ; k++ ) {
+		if ( !( rand() % 3 ) ) {
+			( (int *)from )[k] = rand() % 1000 - 500;
+		}
+	}
+	*to = *from;
+	for ( k = 0 ; k < sizeof( *to ) / 4 ; k++ ) {
+		if ( !( rand() % 4 ) ) {
+			( (int *)to )[k] = ( rand() & 1 ) ? rand() : rand() % 100;
+		}
+	}
+	from->number = to->number = rand() % MAX_GENTITIES;
+}
+
+/*
+=================
+FuzzBitstreams
+
+A delta entity copied with MSG_WriteBitstream has to give the same bits
+and overflow as writing it again, close to the end of small messages.
+Returns the number of deltas that differ.
+=================
+*/
+static int FuzzBitstreams( void ) {
+	static byte		b1[4096], b2[4096], tmp[2048];
+	entityState_t	from, to;
+	msg_t			m1, m2, delta;
+	int				iter, i, pre, maxsize, value, bits, force, bad;
+
+	bad = 0;
+	for ( iter = 0 ; iter < NUM_DELTAS ; iter++ ) {
+		RandomEntityPair( &from, &to );
+		force = rand() & 1;
+		maxsize = 1 + rand() % 200;
+		memset( b1, 0, sizeof( b1 ) );
+		memset( b2, 0, sizeof( b2 ) );
+		MSG_Init( &m1, b1, maxsize );
+		MSG_Init( &m2, b2, maxsize );
+
+		for ( pre = rand() % 50, i = 0 ; i < pre ; i++ ) {
+			value = rand();
+			bits = 1 + rand() % 32;
+			MSG_WriteBits( &m1, value, bits );
+			MSG_WriteBits( &m2, value, bits );
+		}
+
+		MSG_WriteDeltaEntity( &m1, &from, &to, force );
+		MSG_Init( &delta, tmp, sizeof( tmp ) );
+		MSG_WriteDeltaEntity( &delta, &from, &to, force );
+		MSG_WriteBitstream( &m2, tmp, delta.bit );
+
+		if ( m1.overflowed != m2.overflowed ) {
+			bad++;
+		} else if ( !m1.overflowed && ( m1.bit != m2.bit || m1.cursize != m2.cursize
+			|| memcmp( b1, b2, maxsize ) ) ) {
+			bad++;
+		}
+	}
+	return bad;
+}
+
+/*
+=================
+TimeDeltas
+=================
+*/
+static void TimeDeltas( void ) {
+	static byte		buf[MAX_MSGLEN];
+	entityState_t	from, to, out;
+	playerState_t	ps1, ps2, psOut;
+	msg_t			msg;
+	double			start;
+	int				i, k;
+
+	RandomEntityPair( &from, &to );
+	memset( &ps1, 0, sizeof( ps1 ) );
+	ps2 = ps1;
+	for ( k = 0 ; k < sizeof( ps2 ) / 4 ; k++ ) {
+		if ( !( k % 3 ) ) {
+			( (int *)&ps2 )[k] = rand() % 300;
+		}
+	}
+
+	start = Milliseconds();
+	for ( i = 0 ; i < 1000000 ; i++ ) {
+		MSG_Init( &msg, buf, sizeof( buf ) );
+		MSG_WriteDeltaEntity( &msg, &from, &to, qfalse );
+		MSG_WriteDeltaPlayerstate( &msg, &ps1, &ps2 );
+	}
+	printf( "write delta entity+playerstate %6.1f ns\n", ( Milliseconds() - start ) * 1e6 / 1000000 );
+
+	start = Milliseconds();
+	for ( i = 0 ; i < 1000000 ; i++ ) {
+		msg.readcount = 0;
+		msg.bit = 0;
+		MSG_ReadDeltaEntity( &msg, &from, &out, MSG_ReadBits( &msg, GENTITYNUM_BITS ) );
+		MSG_ReadDeltaPlayerstate( &msg, &ps1, &psOut );
+	}
+	printf( "read delta entity+playerstate  %6.1f ns\n", ( Milliseconds() - start ) * 1e6 / 1000000 );
+}
+
+int main( int argc, char **argv ) {
+	int		bad, total;
+
+	MSG_initHuffman();
+	srand( 7 );
+
+	bad = FuzzSequences();
+	printf( "%d of %d random sequences differ\n", bad, NUM_SEQUENCES );
+	total = bad;
+
+	bad = FuzzBitstreams();
+	printf( "%d of %d copied deltas differ\n", bad, NUM_DELTAS );
+	total += bad;
+
+	TimeDeltas();
+
+	if ( total ) {
+		printf( "FAILED\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,506 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// testmap.c -- a random map built in memory for the collision tests
+//
+#include "testmap.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define	MAX_TEST_BRUSHES	4096
+#define	MAX_TEST_PATCHES	256
+#define	MAX_TEST_DEPTH		14
+#define	MAX_TEST_PLANES		( MAX_TEST_BRUSHES * 8 + ( 1 << MAX_TEST_DEPTH ) )
+#define	MAX_TEST_REFS		( 1 << 21 )
+
+static dshader_t	tm_shaders[2];
+static dplane_t		tm_planes[MAX_TEST_PLANES];
+static int			tm_numPlanes;
+static dnode_t		tm_nodes[1 << MAX_TEST_DEPTH];
+static int			tm_numNodes;
+static dleaf_t		tm_leafs[1 << MAX_TEST_DEPTH];
+static int			tm_numLeafs;
+static int			tm_leafBrushes[MAX_TEST_REFS];
+static int			tm_numLeafBrushes;
+static int			tm_leafSurfaces[MAX_TEST_REFS];
+static int			tm_numLeafSurfaces;
+static dbrush_t		tm_brushes[MAX_TEST_BRUSHES];
+static vec3_t		tm_brushBounds[MAX_TEST_BRUSHES][2];
+static int			tm_numBrushes;
+static dbrushside_t	tm_brushSides[MAX_TEST_BRUSHES * 8];
+static int			tm_numBrushSides;
+static dsurface_t	tm_surfaces[MAX_TEST_PATCHES];
+static vec3_t		tm_surfaceBounds[MAX_TEST_PATCHES][2];
+static int			tm_numSurfaces;
+static drawVert_t	tm_verts[MAX_TEST_PATCHES * 9];
+static int			tm_numVerts;
+static dmodel_t		tm_model;
+static const char	tm_entities[] = "{\n\"classname\" \"worldspawn\"\n}\n";
+
+static byte			*tm_file;
+static int			tm_fileLength;
+static unsigned		tm_seed;
+
+/*
+=================
+TestMap_Seed
+=================
+*/
+void TestMap_Seed( unsigned seed ) {
+	tm_seed = seed;
+}
+
+/*
+=================
+TestMap_Random
+=================
+*/
+float TestMap_Random( float min, float max ) {
+	tm_seed = tm_seed * 1103515245 + 12345;
+	return min + ( max - min ) * ( ( tm_seed >> 8 ) & 0xffff ) / 65535.0f;
+}
+
+/*
+=================
+TestMap_Milliseconds
+=================
+*/
+double TestMap_Milliseconds( void ) {
+	struct timespec	now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec * 1000.0 + now.tv_nsec / 1000000.0;
+}
+
+/*
+=================
+TestMap_AddPlane
+=================
+*/
+static int TestMap_AddPlane( const vec3_t normal, float dist ) {
+	if ( tm_numPlanes == MAX_TEST_PLANES ) {
+		Com_Error( ERR_FATAL, "TestMap_AddPlane: too many planes" );
+	}
+	VectorCopy( normal, tm_planes[tm_numPlanes].normal );
+	tm_planes[tm_numPlanes].dist = dist;
+	return tm_numPlanes++;
+}
+
+/*
+=================
+TestMap_AddBrush
+
+A box in the order CM_BoundBrush expects, with two slanted sides that cut
+off corners
+=================
+*/
+static void TestMap_AddBrush( void ) {
+	dbrush_t		*b;
+	dbrushside_t	*side;
+	vec3_t			mins, maxs, normal, corner;
+	float			center, half;
+	int				i, j;
+
+	b = &tm_brushes[tm_numBrushes];
+	for ( i = 0 ; i < 3 ; i++ ) {
+		center = TestMap_Random( -TESTMAP_SIZE + 24, TESTMAP_SIZE - 24 );
+		half = TestMap_Random( 8, i == 2 ? 64 : 300 );
+		mins[i] = center - half;
+		maxs[i] = center + half;
+	}
+	VectorCopy( mins, tm_brushBounds[tm_numBrushes][0] );
+	VectorCopy( maxs, tm_brushBounds[tm_numBrushes][1] );
+
+	b->firstSide = tm_numBrushSides;
+	b->numSides = 8;
+	b->shaderNum = 0;
+
+	for ( i = 0 ; i < 6 ; i++ ) {
+		side = &tm_brushSides[tm_numBrushSides++];
+		VectorClear( normal );
+		if ( i & 1 ) {
+			normal[i >> 1] = 1;
+			side->planeNum = TestMap_AddPlane( normal, maxs[i >> 1] );
+		} else {
+			normal[i >> 1] = -1;
+			side->planeNum = TestMap_AddPlane( normal, -mins[i >> 1] );
+		}
+		side->shaderNum = 0;
+	}
+
+	for ( ; i < 8 ; i++ ) {
+		side = &tm_brushSides[tm_numBrushSides++];
+		for ( j = 0 ; j < 3 ; j++ ) {
+			normal[j] = TestMap_Random( -1, 1 );
+		}
+		if ( VectorNormalize( normal ) < 0.1f ) {
+			VectorSet( normal, 0.6f, 0.8f, 0 );
+		}
+		for ( j = 0 ; j < 3 ; j++ ) {
+			corner[j] = normal[j] > 0 ? maxs[j] : mins[j];
+		}
+		side->planeNum = TestMap_AddPlane( normal, DotProduct( corner, normal ) - TestMap_Random( 0, 20 ) );
+		side->shaderNum = 0;
+	}
+
+	tm_numBrushes++;
+}
+
+/*
+=================
+TestMap_AddPatch
+
+A 3x3 patch with a bump or a dip in the middle
+=================
+*/
+static void TestMap_AddPatch( void ) {
+	dsurface_t	*surf;
+	drawVert_t	*v;
+	vec3_t		center, *bounds;
+	float		size, bump;
+	int			x, y;
+
+	surf = &tm_surfaces[tm_numSurfaces];
+	bounds = tm_surfaceBounds[tm_numSurfaces];
+	for ( x = 0 ; x < 3 ; x++ ) {
+		center[x] = TestMap_Random( -TESTMAP_SIZE + 200, TESTMAP_SIZE - 200 );
+	}
+	size = TestMap_Random( 32, 160 );
+	bump = TestMap_Random( -96, 96 );
+
+	memset( surf, 0, sizeof( *surf ) );
+	surf->shaderNum = 1;
+	surf->surfaceType = MST_PATCH;
+	surf->firstVert = tm_numVerts;
+	surf->numVerts = 9;
+	surf->patchWidth = 3;
+	surf->patchHeight = 3;
+
+	VectorCopy( center, bounds[0] );
+	VectorCopy( center, bounds[1] );
+	for ( y = 0 ; y < 3 ; y++ ) {
+		for ( x = 0 ; x < 3 ; x++ ) {
+			v = &tm_verts[tm_numVerts++];
+			memset( v, 0, sizeof( *v ) );
+			v->xyz[0] = center[0] + ( x - 1 ) * size;
+			v->xyz[1] = center[1] + ( y - 1 ) * size;
+			v->xyz[2] = center[2] + ( x == 1 && y == 1 ? bump : 0 );
+			AddPointToBounds( v->xyz, bounds[0], bounds[1] );
+		}
+	}
+
+	tm_numSurfaces++;
+}
+
+/*
+=================
+TestMap_BuildTree
+
+Returns the node or -1 - leaf number
+=================
+*/
+static int TestMap_BuildTree( int depth, int maxDepth, const vec3_t mins, const vec3_t maxs ) {
+	dnode_t		*node;
+	dleaf_t		*leaf;
+	vec3_t		normal, childMins, childMaxs;
+	int			num, axis, i, j;
+
+	if ( depth == maxDepth ) {
+		num = tm_numLeafs++;
+		leaf = &tm_leafs[num];
+		memset( leaf, 0, sizeof( *leaf ) );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			leaf->mins[i] = mins[i];
+			leaf->maxs[i] = maxs[i];
+		}
+
+		leaf->firstLeafBrush = tm_numLeafBrushes;
+		for ( i = 0 ; i < tm_numBrushes ; i++ ) {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				if ( tm_brushBounds[i][0][j] > maxs[j] || tm_brushBounds[i][1][j] < mins[j] ) {
+					break;
+				}
+			}
+			if ( j == 3 ) {
+				if ( tm_numLeafBrushes == MAX_TEST_REFS ) {
+					Com_Error( ERR_FATAL, "TestMap_BuildTree: too many leaf brushes" );
+				}
+				tm_leafBrushes[tm_numLeafBrushes++] = i;
+			}
+		}
+		leaf->numLeafBrushes = tm_numLeafBrushes - leaf->firstLeafBrush;
+
+		leaf->firstLeafSurface = tm_numLeafSurfaces;
+		for ( i = 0 ; i < tm_numSurfaces ; i++ ) {
+			for ( j = 0 ; j < 3 ; j++ ) {
+				if ( tm_surfaceBounds[i][0][j] > maxs[j] || tm_surfaceBounds[i][1][j] < mins[j] ) {
+					break;
+				}
+			}
+			if ( j == 3 ) {
+				if ( tm_numLeafSurfaces == MAX_TEST_REFS ) {
+					Com_Error( ERR_FATAL, "TestMap_BuildTree: too many leaf surfaces" );
+				}
+				tm_leafSurfaces[tm_numLeafSurfaces++] = i;
+			}
+		}
+		leaf->numLeafSurfaces = tm_numLeafSurfaces - leaf->firstLeafSurface;
+
+		return -1 - num;
+	}
+
+	num = tm_numNodes++;
+	node = &tm_nodes[num];
+	axis = depth % 3;
+
+	VectorClear( normal );
+	normal[axis] = 1;
+	node->planeNum = TestMap_AddPlane( normal, 0.5f * ( mins[axis] + maxs[axis] ) );
+	for ( i = 0 ; i < 3 ; i++ ) {
+		node->mins[i] = mins[i];
+		node->maxs[i] = maxs[i];
+	}
+
+	// front is the side the plane normal points to
+	VectorCopy( mins, childMins );
+	childMins[axis] = tm_planes[node->planeNum].dist;
+	node->children[0] = TestMap_BuildTree( depth + 1, maxDepth, childMins, maxs );
+
+	VectorCopy( maxs, childMaxs );
+	childMaxs[axis] = tm_planes[node->planeNum].dist;
+	tm_nodes[num].children[1] = TestMap_BuildTree( depth + 1, maxDepth, mins, childMaxs );
+
+	return num;
+}
+
+/*
+=================
+TestMap_AddLump
+=================
+*/
+static void TestMap_AddLump( dheader_t *header, int lump, const void *data, int length ) {
+	header->lumps[lump].fileofs = tm_fileLength;
+	header->lumps[lump].filelen = length;
+	Com_Memcpy( tm_file + tm_fileLength, data, length );
+	tm_fileLength += ( length + 3 ) & ~3;
+}
+
+/*
+=================
+TestMap_Load
+=================
+*/
+void TestMap_Load( int numBrushes, int numPatches, int depth ) {
+	dheader_t	*header;
+	vec3_t		mins, maxs;
+	int			checksum;
+	int			i;
+
+	if ( numBrushes > MAX_TEST_BRUSHES || numPatches > MAX_TEST_PATCHES || depth > MAX_TEST_DEPTH ) {
+		Com_Error( ERR_FATAL, "TestMap_Load: map too big" );
+	}
+
+	tm_numPlanes = tm_numNodes = tm_numLeafs = 0;
+	tm_numLeafBrushes = tm_numLeafSurfaces = 0;
+	tm_numBrushes = tm_numBrushSides = 0;
+	tm_numSurfaces = tm_numVerts = 0;
+
+	Q_strncpyz( tm_shaders[0].shader, "textures/test/solid", sizeof( tm_shaders[0].shader ) );
+	tm_shaders[0].contentFlags = CONTENTS_SOLID;
+	Q_strncpyz( tm_shaders[1].shader, "textures/test/curve", sizeof( tm_shaders[1].shader ) );
+	tm_shaders[1].contentFlags = CONTENTS_SOLID;
+
+	for ( i = 0 ; i < numBrushes ; i++ ) {
+		TestMap_AddBrush();
+	}
+	for ( i = 0 ; i < numPatches ; i++ ) {
+		TestMap_AddPatch();
+	}
+
+	VectorSet( mins, -TESTMAP_SIZE, -TESTMAP_SIZE, -TESTMAP_SIZE );
+	VectorSet( maxs, TESTMAP_SIZE, TESTMAP_SIZE, TESTMAP_SIZE );
+	TestMap_BuildTree( 0, depth, mins, maxs );
+
+	memset( &tm_model, 0, sizeof( tm_model ) );
+	VectorCopy( mins, tm_model.mins );
+	VectorCopy( maxs, tm_model.maxs );
+	tm_model.numSurfaces = tm_numSurfaces;
+	tm_model.numBrushes = tm_numBrushes;
+
+	free( tm_file );
+	tm_file = calloc( 1, sizeof( dheader_t ) + sizeof( tm_shaders ) + sizeof( tm_planes )
+		+ sizeof( tm_nodes ) + sizeof( tm_leafs ) + sizeof( tm_leafBrushes ) + sizeof( tm_leafSurfaces )
+		+ sizeof( tm_brushes ) + sizeof( tm_brushSides ) + sizeof( tm_surfaces ) + sizeof( tm_verts )
+		+ sizeof( tm_model ) + sizeof( tm_entities ) + 64 );
+	header = (dheader_t *)tm_file;
+	header->ident = BSP_IDENT;
+	header->version = BSP_VERSION;
+	tm_fileLength = sizeof( *header );
+
+	TestMap_AddLump( header, LUMP_ENTITIES, tm_entities, sizeof( tm_entities ) );
+	TestMap_AddLump( header, LUMP_SHADERS, tm_shaders, sizeof( tm_shaders ) );
+	TestMap_AddLump( header, LUMP_PLANES, tm_planes, tm_numPlanes * sizeof( tm_planes[0] ) );
+	TestMap_AddLump( header, LUMP_NODES, tm_nodes, tm_numNodes * sizeof( tm_nodes[0] ) );
+	TestMap_AddLump( header, LUMP_LEAFS, tm_leafs, tm_numLeafs * sizeof( tm_leafs[0] ) );
+	TestMap_AddLump( header, LUMP_LEAFSURFACES, tm_leafSurfaces, tm_numLeafSurfaces * sizeof( int ) );
+	TestMap_AddLump( header, LUMP_LEAFBRUSHES, tm_leafBrushes, tm_numLeafBrushes * sizeof( int ) );
+	TestMap_AddLump( header, LUMP_MODELS, &tm_model, sizeof( tm_model ) );
+	TestMap_AddLump( header, LUMP_BRUSHES, tm_brushes, tm_numBrushes * sizeof( tm_brushes[0] ) );
+	TestMap_AddLump( header, LUMP_BRUSHSIDES, tm_brushSides, tm_numBrushSides * sizeof( tm_brushSides[0] ) );
+	TestMap_AddLump( header, LUMP_DRAWVERTS, tm_verts, tm_numVerts * sizeof( tm_verts[0] ) );
+	TestMap_AddLump( header, LUMP_SURFACES, tm_surfaces, tm_numSurfaces * sizeof( tm_surfaces[0] ) );
+
+	CM_ClearMap();
+	CM_LoadMap( TESTMAP_NAME, qfalse, &checksum );
+}
+
+/*
+==============================================================================
+
+The engine functions the collision code calls, reduced to what a single
+loaded map needs
+
+==============================================================================
+*/
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+}
+
+void QDECL Com_DPrintf( const char *fmt, ... ) {
+}
+
+cvar_t *Cvar_Get( const char *name, const char *value, int flags ) {
+	static cvar_t	cvars[32];
+	static int		numCvars;
+	cvar_t			*var;
+	int				i;
+
+	for ( i = 0 ; i < numCvars ; i++ ) {
+		if ( !strcmp( cvars[i].name, name ) ) {
+			return &cvars[i];
+		}
+	}
+	if ( numCvars == ARRAY_LEN( cvars ) ) {
+		Com_Error( ERR_FATAL, "Cvar_Get: too many cvars" );
+	}
+
+	// no patch cache files and no load threads
+	if ( !strcmp( name, "cm_patchCache" ) || !strcmp( name, "cm_loadThreads" ) ) {
+		value = "0";
+	}
+
+	var = &cvars[numCvars++];
+	var->name = (char *)name;
+	var->string = (char *)value;
+	var->value = atof( value );
+	var->integer = atoi( value );
+	return var;
+}
+
+void *Hunk_Alloc( int size, ha_pref preference ) {
+	void	*p;
+
+	p = calloc( 1, size ? size : 1 );
+	if ( !p ) {
+		Com_Error( ERR_FATAL, "Hunk_Alloc: out of memory" );
+	}
+	return p;
+}
+
+void *Hunk_AllocateTempMemory( int size ) {
+	return Hunk_Alloc( size, h_high );
+}
+
+void Hunk_FreeTempMemory( void *buf ) {
+	free( buf );
+}
+
+void *Z_Malloc( int size ) {
+	return Hunk_Alloc( size, h_high );
+}
+
+void Z_Free( void *ptr ) {
+	free( ptr );
+}
+
+long FS_ReadFile( const char *qpath, void **buffer ) {
+	if ( strcmp( qpath, TESTMAP_NAME ) ) {
+		*buffer = NULL;
+		return -1;
+	}
+	*buffer = tm_file;
+	return tm_fileLength;
+}
+
+void FS_FreeFile( void *buffer ) {
+}
+
+void Com_RunJobs( void (*function)( void *data, int index ), void *data, int count, int numThreads ) {
+	int		i;
+
+	for ( i = 0 ; i < count ; i++ ) {
+		function( data, i );
+	}
+}
+
+int Sys_ProcessorCount( void ) {
+	return 1;
+}
+
+void BotDrawDebugPolygons( void (*drawPoly)( int color, int numPoints, float *points ), int value ) {
+}
+
+const char *FS_GetCurrentGameDir( void ) {
+	return "baseq3";
+}
+
+// cm_patchCache is off, so these only have to fail
+long FS_SV_FOpenFileRead( const char *filename, fileHandle_t *fp ) {
+	*fp = 0;
+	return -1;
+}
+
+fileHandle_t FS_SV_FOpenFileWrite( const char *filename ) {
+	return 0;
+}
+
+int FS_Read( void *buffer, int len, fileHandle_t f ) {
+	return 0;
+}
+
+int FS_Write( const void *buffer, int len, fileHandle_t f ) {
+	return 0;
+}
+
+void FS_FCloseFile( fileHandle_t f ) {
+}
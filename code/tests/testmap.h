@@ -0,0 +1,42 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// testmap.h -- a random map built in memory for the collision tests, and
+// the engine functions the collision code needs outside of it
+//
+#include "../qcommon/cm_local.h"
+
+#define	TESTMAP_NAME		"maps/test.bsp"
+
+// the map fills the cube from -TESTMAP_SIZE to TESTMAP_SIZE
+#define	TESTMAP_SIZE		1024
+
+// builds the map and loads it with CM_LoadMap: numBrushes boxes with two
+// extra slanted sides, numPatches 3x3 curved patches, and a BSP tree of
+// alternating axial splits depth levels deep
+void	TestMap_Load( int numBrushes, int numPatches, int depth );
+
+// repeatable random numbers, only for the main thread
+void	TestMap_Seed( unsigned seed );
+float	TestMap_Random( float min, float max );
+
+double	TestMap_Milliseconds( void );
@@ -0,0 +1,210 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// tracebench.c -- times CM_BoxTrace on a set of rays against a map, and
+// checks that tracing them again in the opposite order, or in batches
+// with CM_TraceMany, gives the same results
+//
+// The rays come from a file of "start end mins maxs" lines, 12 numbers
+// each, against the random test map, or are made up like the traces a
+// frame issues: bursts of pellets from one muzzle, a player's slide move
+// probes and the eye to target lines of a bot.
+//
+// The Makefile also builds it with C_ONLY, which tests the brush planes
+// one at a time in plain C instead of four at a time with SSE2 or NEON.
+// Both print a checksum of the traces so the two can be compared.
+//
+#include "testmap.h"
+
+#include <stdlib.h>
+
+#define	MAX_RAYS		65536
+#define	NUM_ROUNDS		20
+#define	BURST_SIZE		32
+
+static traceRequest_t	rays[MAX_RAYS];
+static int		numRays;
+static trace_t	forward[MAX_RAYS];
+static trace_t	backward[MAX_RAYS];
+static trace_t	batched[MAX_RAYS];
+
+/*
+=================
+Checksum
+
+FNV-1a over every trace result
+=================
+*/
+static unsigned Checksum( const trace_t *traces, int count ) {
+	const byte	*p;
+	unsigned	hash;
+	int			i;
+
+	hash = 2166136261u;
+	p = (const byte *)traces;
+	for ( i = 0 ; i < count * (int)sizeof( trace_t ) ; i++ ) {
+		hash = ( hash ^ p[i] ) * 16777619u;
+	}
+	return hash;
+}
+
+/*
+=================
+ReadRays
+=================
+*/
+static void ReadRays( const char *filename ) {
+	FILE			*f;
+	traceRequest_t	*r;
+
+	f = fopen( filename, "r" );
+	if ( !f ) {
+		Com_Error( ERR_FATAL, "couldn't open %s", filename );
+	}
+	while ( numRays < MAX_RAYS ) {
+		r = &rays[numRays];
+		if ( fscanf( f, "%f %f %f %f %f %f %f %f %f %f %f %f",
+			&r->start[0], &r->start[1], &r->start[2], &r->end[0], &r->end[1], &r->end[2],
+			&r->mins[0], &r->mins[1], &r->mins[2], &r->maxs[0], &r->maxs[1], &r->maxs[2] ) != 12 ) {
+			break;
+		}
+		numRays++;
+	}
+	fclose( f );
+}
+
+/*
+=================
+MakeRays
+=================
+*/
+static void MakeRays( void ) {
+	traceRequest_t	*r;
+	vec3_t			origin, dir, end;
+	float			size;
+	int				i, j, kind;
+
+	while ( numRays + BURST_SIZE <= MAX_RAYS ) {
+		for ( j = 0 ; j < 3 ; j++ ) {
+			origin[j] = TestMap_Random( -TESTMAP_SIZE, TESTMAP_SIZE );
+			dir[j] = TestMap_Random( -1, 1 );
+		}
+		VectorNormalize( dir );
+		kind = numRays / BURST_SIZE % 3;
+
+		for ( i = 0 ; i < BURST_SIZE ; i++ ) {
+			r = &rays[numRays++];
+			VectorCopy( origin, r->start );
+			switch ( kind ) {
+			case 0:
+				// pellets spread around one direction
+				for ( j = 0 ; j < 3 ; j++ ) {
+					end[j] = dir[j] + TestMap_Random( -0.05f, 0.05f );
+				}
+				VectorMA( origin, 2048, end, r->end );
+				break;
+			case 1:
+				// short box moves from nearly the same spot
+				for ( j = 0 ; j < 3 ; j++ ) {
+					r->start[j] += TestMap_Random( -4, 4 );
+					end[j] = dir[j] + TestMap_Random( -0.3f, 0.3f );
+				}
+				VectorMA( r->start, 64, end, r->end );
+				VectorSet( r->mins, -15, -15, -24 );
+				VectorSet( r->maxs, 15, 15, 32 );
+				break;
+			default:
+				// lines to points around one target
+				size = TestMap_Random( 16, 48 );
+				for ( j = 0 ; j < 3 ; j++ ) {
+					r->end[j] = origin[j] + dir[j] * 600 + TestMap_Random( -size, size );
+				}
+				break;
+			}
+		}
+	}
+}
+
+int main( int argc, char **argv ) {
+	double	start, msec, msecMany;
+	int		i, round, hits, bad, badMany;
+
+	TestMap_Seed( 1 );
+	TestMap_Load( 2000, 64, 14 );
+	if ( argc > 1 ) {
+		ReadRays( argv[1] );
+	} else {
+		MakeRays();
+	}
+
+	msec = 0;
+	for ( round = 0 ; round < NUM_ROUNDS ; round++ ) {
+		start = TestMap_Milliseconds();
+		for ( i = 0 ; i < numRays ; i++ ) {
+			CM_BoxTrace( &forward[i], rays[i].start, rays[i].end, rays[i].mins, rays[i].maxs, 0, CONTENTS_SOLID, qfalse );
+		}
+		msec += TestMap_Milliseconds() - start;
+	}
+
+	msecMany = 0;
+	for ( round = 0 ; round < NUM_ROUNDS ; round++ ) {
+		start = TestMap_Milliseconds();
+		for ( i = 0 ; i < numRays ; i += BURST_SIZE ) {
+			CM_TraceMany( &batched[i], &rays[i], MIN( BURST_SIZE, numRays - i ), 0, CONTENTS_SOLID, qfalse );
+		}
+		msecMany += TestMap_Milliseconds() - start;
+	}
+
+	for ( i = numRays - 1 ; i >= 0 ; i-- ) {
+		CM_BoxTrace( &backward[i], rays[i].start, rays[i].end, rays[i].mins, rays[i].maxs, 0, CONTENTS_SOLID, qfalse );
+	}
+
+	hits = bad = badMany = 0;
+	for ( i = 0 ; i < numRays ; i++ ) {
+		if ( forward[i].fraction < 1 ) {
+			hits++;
+		}
+		if ( memcmp( &forward[i], &backward[i], sizeof( trace_t ) ) ) {
+			bad++;
+		}
+		if ( memcmp( &forward[i], &batched[i], sizeof( trace_t ) ) ) {
+			badMany++;
+		}
+	}
+
+	printf( "%d rays, %d hit something, checksum %08x\n", numRays, hits, Checksum( forward, numRays ) );
+#ifdef C_ONLY
+	printf( "brush planes one at a time\n" );
+#else
+	printf( "brush planes four at a time\n" );
+#endif
+	printf( "CM_BoxTrace %6.3f us/ray\n", msec * 1000 / ( numRays * NUM_ROUNDS ) );
+	printf( "CM_TraceMany %6.3f us/ray in batches of %d\n", msecMany * 1000 / ( numRays * NUM_ROUNDS ), BURST_SIZE );
+	printf( "%d of %d traces differ in the opposite order\n", bad, numRays );
+	printf( "%d of %d traces differ in batches\n", badMany, numRays );
+
+	if ( bad || badMany ) {
+		printf( "FAILED\n" );
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,370 @@
+/*
+===========================================================================
+Copyright (C) 1999-2005 Id Software, Inc.
+
+This file is part of Quake III Arena source code.
+
+Quake III Arena source code is free software; you can redistribute it
+and/or modify it under the terms of the GNU General Public License as
+published by the Free Software Foundation; either version 2 of the License,
+or (at your option) any later version.
+
+Quake III Arena source code is distributed in the hope that it will be
+useful, but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with Quake III Arena source code; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+===========================================================================
+*/
+//
+// vm_interpret_bench.c -- runs a small program through VM_CallInterpreted,
+// checks its result against the same loop in C and times it
+//
+// The program is assembled here the way q3lcc would emit it: globals loaded
+// with CONST+LOAD4, locals with LOCAL+LOAD4, and calls to a function and to
+// a system call with CONST+CALL, so every fused handler runs.  The Makefile
+// builds it once with threaded dispatch and once with NO_VM_THREADED_CODE
+// so the two timings can be compared.
+//
+#include "vm_local.h"
+
+#include <stdlib.h>
+#include <time.h>
+
+#define	NUM_CALLS		200
+#define	NUM_LOOPS		20000
+
+#define	DATA_TABLE		0			// 256 ints
+#define	DATA_SCALE		1024		// one int
+#define	DATA_LENGTH		( 1 << 17 )	// globals and the program stack
+
+#define	MAX_CODE		4096
+#define	MAX_LABELS		16
+
+enum {
+	L_FUNC,
+	L_BODY,
+	L_SKIP,
+	L_COND
+};
+
+static byte		code[MAX_CODE];
+static int		codeLength;
+static int		instructionCount;
+static int		labels[MAX_LABELS];
+static int		fixups[MAX_CODE];
+static int		fixupLabels[MAX_CODE];
+static int		numFixups;
+
+static int		table[256];
+
+void QDECL Com_Error( int level, const char *fmt, ... ) {
+	va_list		argptr;
+
+	va_start( argptr, fmt );
+	vprintf( fmt, argptr );
+	va_end( argptr );
+	printf( "\n" );
+	exit( 1 );
+}
+
+void QDECL Com_Printf( const char *fmt, ... ) {
+}
+
+void *Hunk_Alloc( int size, ha_pref preference ) {
+	return calloc( 1, size );
+}
+
+void VM_Debug( int level ) {
+}
+
+const char *VM_ValueToSymbol( vm_t *vm, int value ) {
+	return "";
+}
+
+vmSymbol_t *VM_ValueToFunctionSymbol( vm_t *vm, int value ) {
+	static vmSymbol_t	sym;
+
+	return &sym;
+}
+
+long Q_ftol( float f ) {
+	return (long)f;
+}
+
+void VM_BlockCopy( unsigned int dest, unsigned int src, size_t n ) {
+	Com_Error( ERR_DROP, "VM_BlockCopy: not used by the bench program" );
+}
+
+static double Milliseconds( void ) {
+	struct timespec	ts;
+
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+/*
+=================
+Emit
+
+Assembles one instruction, with a four byte operand for the opcodes that
+take one and a one byte operand for OP_ARG
+=================
+*/
+static void Emit( int op, int operand ) {
+	code[codeLength++] = op;
+	if ( op == OP_ARG ) {
+		code[codeLength++] = operand;
+	} else if ( op == OP_ENTER || op == OP_LEAVE || op == OP_CONST || op == OP_LOCAL
+		|| ( op >= OP_EQ && op <= OP_GEF ) ) {
+		code[codeLength++] = operand & 0xff;
+		code[codeLength++] = ( operand >> 8 ) & 0xff;
+		code[codeLength++] = ( operand >> 16 ) & 0xff;
+		code[codeLength++] = ( operand >> 24 ) & 0xff;
+	}
+	instructionCount++;
+}
+
+/*
+=================
+EmitLabel
+
+An instruction whose operand is the instruction number of a label
+=================
+*/
+static void EmitLabel( int op, int label ) {
+	fixups[numFixups] = codeLength + 1;
+	fixupLabels[numFixups] = label;
+	numFixups++;
+	Emit( op, 0 );
+}
+
+static void Label( int label ) {
+	labels[label] = instructionCount;
+}
+
+/*
+=================
+Assemble
+
+int f( int x ) {
+	return x * 3 ^ x >> 2;
+}
+
+int vmMain( int n ) {
+	int i, sum;
+
+	sum = 0;
+	for ( i = 0 ; i < n ; i++ ) {
+		sum += table[i & 255] * scale;
+		sum += f( sum );
+		if ( ( i & 63 ) == 0 ) {
+			sum ^= trap_Mix( i );
+		}
+	}
+	return sum;
+}
+=================
+*/
+static void Assemble( void ) {
+	int		i, v;
+
+	// vmMain has to be instruction 0
+	Emit( OP_ENTER, 24 );		// 0 return address, 8 outgoing arg, 12 i, 16 sum
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_CONST, 0 );
+	Emit( OP_STORE4, 0 );
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_CONST, 0 );
+	Emit( OP_STORE4, 0 );
+	EmitLabel( OP_CONST, L_COND );
+	Emit( OP_JUMP, 0 );
+
+	Label( L_BODY );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, 255 );
+	Emit( OP_BAND, 0 );
+	Emit( OP_CONST, 2 );
+	Emit( OP_LSH, 0 );
+	Emit( OP_CONST, DATA_TABLE );
+	Emit( OP_ADD, 0 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, DATA_SCALE );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_MULI, 0 );
+	Emit( OP_ADD, 0 );
+	Emit( OP_STORE4, 0 );
+
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_ARG, 8 );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOAD4, 0 );
+	EmitLabel( OP_CONST, L_FUNC );
+	Emit( OP_CALL, 0 );
+	Emit( OP_ADD, 0 );
+	Emit( OP_STORE4, 0 );
+
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, 63 );
+	Emit( OP_BAND, 0 );
+	Emit( OP_CONST, 0 );
+	EmitLabel( OP_NE, L_SKIP );
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_ARG, 8 );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, -1 );
+	Emit( OP_CALL, 0 );
+	Emit( OP_BXOR, 0 );
+	Emit( OP_STORE4, 0 );
+
+	Label( L_SKIP );
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, 1 );
+	Emit( OP_ADD, 0 );
+	Emit( OP_STORE4, 0 );
+
+	Label( L_COND );
+	Emit( OP_LOCAL, 12 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_LOCAL, 32 );		// n, past the frame and the return slots
+	Emit( OP_LOAD4, 0 );
+	EmitLabel( OP_LTI, L_BODY );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_LEAVE, 24 );
+
+	Label( L_FUNC );
+	Emit( OP_ENTER, 8 );
+	Emit( OP_LOCAL, 16 );		// x
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, 3 );
+	Emit( OP_MULI, 0 );
+	Emit( OP_LOCAL, 16 );
+	Emit( OP_LOAD4, 0 );
+	Emit( OP_CONST, 2 );
+	Emit( OP_RSHI, 0 );
+	Emit( OP_BXOR, 0 );
+	Emit( OP_LEAVE, 8 );
+
+	for ( i = 0 ; i < numFixups ; i++ ) {
+		v = labels[fixupLabels[i]];
+		code[fixups[i]] = v & 0xff;
+		code[fixups[i] + 1] = ( v >> 8 ) & 0xff;
+		code[fixups[i] + 2] = ( v >> 16 ) & 0xff;
+		code[fixups[i] + 3] = ( v >> 24 ) & 0xff;
+	}
+}
+
+static int Mix( int x ) {
+	return (int)( (unsigned)x * 2654435761u ) ^ 0x55;
+}
+
+static intptr_t SystemCall( intptr_t *args ) {
+	if ( args[0] != 0 ) {
+		Com_Error( ERR_DROP, "bad system call %d", (int)args[0] );
+	}
+	return Mix( args[1] );
+}
+
+/*
+=================
+NativeMain
+
+The bench program in C, with the same wrapping arithmetic
+=================
+*/
+static int NativeMain( int n, int scale ) {
+	unsigned	sum, f;
+	int			i;
+
+	sum = 0;
+	for ( i = 0 ; i < n ; i++ ) {
+		sum += (unsigned)table[i & 255] * scale;
+		f = ( sum * 3 ) ^ (unsigned)( (int)sum >> 2 );
+		sum += f;
+		if ( ( i & 63 ) == 0 ) {
+			sum ^= Mix( i );
+		}
+	}
+	return sum;
+}
+
+int main( int argc, char **argv ) {
+	vmHeader_t	*header;
+	vm_t		vm;
+	int			args[MAX_VMMAIN_ARGS];
+	int			scale, expected, result, i;
+	double		start, msec;
+
+	Assemble();
+
+	header = calloc( 1, sizeof( *header ) + codeLength );
+	header->instructionCount = instructionCount;
+	header->codeOffset = sizeof( *header );
+	header->codeLength = codeLength;
+	memcpy( header + 1, code, codeLength );
+
+	memset( &vm, 0, sizeof( vm ) );
+	vm.dataAlloc = DATA_LENGTH + 4;
+	vm.dataBase = calloc( 1, vm.dataAlloc );
+	vm.dataMask = DATA_LENGTH - 1;
+	vm.systemCall = SystemCall;
+	vm.instructionCount = instructionCount;
+	vm.instructionPointers = calloc( instructionCount, sizeof( *vm.instructionPointers ) );
+	vm.codeLength = codeLength;
+	VM_PrepareInterpreter( &vm, header );
+	vm.programStack = DATA_LENGTH;
+	vm.stackBottom = vm.programStack - PROGRAM_STACK_SIZE;
+
+	srand( 1 );
+	for ( i = 0 ; i < 256 ; i++ ) {
+		table[i] = rand() - RAND_MAX / 2;
+	}
+	memcpy( vm.dataBase + DATA_TABLE, table, sizeof( table ) );
+	scale = 7;
+	*(int *)( vm.dataBase + DATA_SCALE ) = scale;
+
+	memset( args, 0, sizeof( args ) );
+	args[0] = NUM_LOOPS;
+	expected = NativeMain( NUM_LOOPS, scale );
+
+	// the first call threads the code
+	result = VM_CallInterpreted( &vm, args );
+
+	start = Milliseconds();
+	for ( i = 0 ; i < NUM_CALLS ; i++ ) {
+		if ( VM_CallInterpreted( &vm, args ) != result ) {
+			break;
+		}
+	}
+	msec = Milliseconds() - start;
+
+#ifdef NO_VM_THREADED_CODE
+	printf( "switch dispatch   " );
+#else
+	printf( "threaded dispatch " );
+#endif
+	printf( "%6.3f ms/call, %d loop iterations\n", msec / NUM_CALLS, NUM_LOOPS );
+	printf( "vmMain returned %d, expected %d\n", result, expected );
+
+	if ( result != expected || i != NUM_CALLS ) {
+		printf( "FAILED\n" );
+		return 1;
+	}
+	return 0;
+}